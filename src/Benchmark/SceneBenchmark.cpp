@@ -0,0 +1,283 @@
+#include "SceneBenchmark.h"
+
+#include "../Light/LightSystem.h"
+#include "../Misc/CpuProfiler.h"
+#include "../Misc/Timer.h"
+#include "../Scene/DemoScene.h"
+#include "../Scene/MeshData.h"
+#include "../VR/HeadlessView.h"
+#include "../VulkanBase/VulkanDevice.h"
+#include "../VulkanBase/VulkanRenderer.h"
+#include "StressScene.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+namespace
+{
+	// Values start after "--name=", an argument of another name leaves the value untouched
+	bool ReadArgument(const std::string& argument, const std::string& name, std::string& outValue)
+	{
+		const std::string prefix{ "--" + name + "=" };
+		if (argument.compare(0u, prefix.size(), prefix) != 0)
+		{
+			return false;
+		}
+
+		outValue = argument.substr(prefix.size());
+		return true;
+	}
+
+	// Finds "key": followed by a number anywhere in the line, the results file keeps one scene per line
+	bool ReadNumber(const std::string& line, const std::string& key, double& outValue)
+	{
+		const std::string quotedKey{ "\"" + key + "\":" };
+		const size_t	  position{ line.find(quotedKey) };
+		if (position == std::string::npos)
+		{
+			return false;
+		}
+
+		std::istringstream stream(line.substr(position + quotedKey.size()));
+		return static_cast<bool>(stream >> outValue);
+	}
+} // namespace
+
+SceneBenchmark::SceneBenchmark(const std::vector<std::string>& arguments)
+{
+	for (const std::string& argument : arguments)
+	{
+		std::string value;
+		if (ReadArgument(argument, "objects", value))
+		{
+			m_ObjectCounts.clear();
+			std::istringstream stream(value);
+			std::string		   objectCount;
+			while (std::getline(stream, objectCount, ','))
+			{
+				m_ObjectCounts.push_back(static_cast<size_t>(std::stoull(objectCount)));
+			}
+		}
+		else if (ReadArgument(argument, "frames", value))
+		{
+			m_MeasuredFrameCount = static_cast<size_t>(std::stoull(value));
+		}
+		else if (ReadArgument(argument, "output", value))
+		{
+			m_OutputFilename = value;
+		}
+		else if (ReadArgument(argument, "baseline", value))
+		{
+			m_BaselineFilename = value;
+		}
+		else if (ReadArgument(argument, "tolerance", value))
+		{
+			m_Tolerance = std::stod(value);
+		}
+		else
+		{
+			std::cerr << "Unknown argument \"" << argument << "\"" << std::endl;
+			m_HasInvalidArguments = true;
+		}
+	}
+}
+
+int SceneBenchmark::Run()
+{
+	SPECTRE_PROFILE_THREAD("Main");
+
+	if (m_HasInvalidArguments || m_ObjectCounts.empty() || m_MeasuredFrameCount == 0u)
+	{
+		std::cerr << "Usage: SceneBenchmark [--objects=1000,10000,100000] [--frames=300] [--output=SceneBenchmark.json] [--baseline=Baseline.json] [--tolerance=10]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	VulkanDevice device(true);
+	device.CreateHeadlessDevice();
+	HeadlessView view(&device);
+
+	// Supplies the models, materials and lights, its own objects are only copied from
+	DemoScene demoScene;
+	MeshData* meshData{ demoScene.LoadMeshData() };
+
+	std::vector<Result> results;
+	for (const size_t objectCount : m_ObjectCounts)
+	{
+		results.push_back(RunScene(&device, view, demoScene, objectCount, meshData));
+	}
+	delete meshData;
+
+	if (!WriteResults(results))
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (!m_BaselineFilename.empty() && !CompareWithBaseline(results))
+	{
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+SceneBenchmark::Result SceneBenchmark::RunScene(const VulkanDevice* device, HeadlessView& view, DemoScene& demoScene, size_t objectCount, const MeshData* meshData) const
+{
+	StressScene stressScene(demoScene.GetGameObjects(), objectCount, Spectre::sceneBenchmarkSeed);
+	std::cout << "Scene benchmark: " << objectCount << " game objects, " << stressScene.GetAnimatedObjectCount() << " of them animated" << std::endl;
+
+	Result result;
+	result.objectCount = objectCount;
+	{
+		VulkanRenderer renderer(device, &view, meshData, demoScene.GetMaterials(), stressScene.GetGameObjects());
+		renderer.WaitForPipelines();
+
+		std::vector<double> frameTimes;
+		frameTimes.reserve(m_MeasuredFrameCount);
+
+		Timer::GetInstance().Start();
+		for (size_t frameIndex = 0u; frameIndex < Spectre::sceneBenchmarkWarmupFrameCount + m_MeasuredFrameCount; ++frameIndex)
+		{
+			SPECTRE_PROFILE_ZONE("Frame");
+			const std::chrono::steady_clock::time_point frameBegin{ std::chrono::steady_clock::now() };
+			Timer::GetInstance().Update();
+
+			// Standing in the middle of the scene and slowly turning around, so every part of it comes into view
+			const float		time{ static_cast<float>(frameIndex) * Spectre::sceneBenchmarkTimeStep };
+			const glm::mat4 headWorldMatrix{ glm::rotate(glm::translate(glm::mat4(1.0f), { 0.0f, 1.7f, 0.0f }), 0.3f * time, { 0.0f, 1.0f, 0.0f }) };
+			view.SetHeadPose(headWorldMatrix);
+			demoScene.Update(time, headWorldMatrix);
+			stressScene.Update(time);
+
+			renderer.Render(glm::mat4(1.0f), view.AcquireImage(), time, LightSystem::GetInstance().GetLightDirection(), LightSystem::GetInstance().GetLights());
+			renderer.Submit(false);
+
+			if (frameIndex >= Spectre::sceneBenchmarkWarmupFrameCount)
+			{
+				const VulkanRenderer::FrameStatistics& frameStatistics{ renderer.GetFrameStatistics() };
+				frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameBegin).count());
+				result.recordingTime += frameStatistics.recordingTime;
+				result.drawCallCount += frameStatistics.drawCallCount;
+				result.pipelineBindCount += frameStatistics.pipelineBindCount;
+			}
+		}
+
+		device->Sync();
+		Timer::GetInstance().Stop();
+
+		const double frameCount{ static_cast<double>(frameTimes.size()) };
+		result.cpuFrameTime = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0) / frameCount;
+		result.recordingTime /= frameCount;
+		result.drawCallCount /= frameCount;
+		result.pipelineBindCount /= frameCount;
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		result.cpuFrameTime95th = frameTimes.at(static_cast<size_t>(0.95 * (frameCount - 1.0) + 0.5));
+	}
+
+	std::cout << "Scene benchmark: " << objectCount << " game objects take " << result.cpuFrameTime << " ms per frame (" << result.cpuFrameTime95th << " ms 95th percentile), " << result.recordingTime << " ms of it recording "
+			  << result.drawCallCount << " draw calls with " << result.pipelineBindCount << " pipeline binds" << std::endl;
+	return result;
+}
+
+bool SceneBenchmark::WriteResults(const std::vector<Result>& results) const
+{
+	std::ofstream file(m_OutputFilename, std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "Failed to write the scene benchmark results to \"" << m_OutputFilename << "\"" << std::endl;
+		return false;
+	}
+
+	// One scene per line, ReadResults() relies on it
+	file << "{\n\t\"frameCount\": " << m_MeasuredFrameCount << ",\n\t\"scenes\": [";
+	for (size_t resultIndex = 0u; resultIndex < results.size(); ++resultIndex)
+	{
+		const Result& result{ results.at(resultIndex) };
+		file << (resultIndex > 0u ? "," : "") << "\n\t\t{ \"objectCount\": " << result.objectCount << ", \"cpuFrameTimeMs\": " << result.cpuFrameTime << ", \"cpuFrameTime95thMs\": " << result.cpuFrameTime95th
+			 << ", \"recordingTimeMs\": " << result.recordingTime << ", \"drawCalls\": " << result.drawCallCount << ", \"pipelineBinds\": " << result.pipelineBindCount << " }";
+	}
+	file << "\n\t]\n}" << std::endl;
+
+	std::cout << "Wrote the scene benchmark results to \"" << m_OutputFilename << "\"" << std::endl;
+	return true;
+}
+
+bool SceneBenchmark::ReadResults(const std::string& filename, std::vector<Result>& outResults)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		double objectCount{ 0.0 };
+		if (!ReadNumber(line, "objectCount", objectCount))
+		{
+			continue;
+		}
+
+		Result result;
+		result.objectCount = static_cast<size_t>(objectCount);
+		if (!ReadNumber(line, "cpuFrameTimeMs", result.cpuFrameTime) || !ReadNumber(line, "cpuFrameTime95thMs", result.cpuFrameTime95th) || !ReadNumber(line, "recordingTimeMs", result.recordingTime) ||
+			!ReadNumber(line, "drawCalls", result.drawCallCount) || !ReadNumber(line, "pipelineBinds", result.pipelineBindCount))
+		{
+			return false;
+		}
+		outResults.push_back(result);
+	}
+	return true;
+}
+
+bool SceneBenchmark::CompareWithBaseline(const std::vector<Result>& results) const
+{
+	std::vector<Result> baselineResults;
+	if (!ReadResults(m_BaselineFilename, baselineResults))
+	{
+		std::cerr << "Failed to read the scene benchmark baseline \"" << m_BaselineFilename << "\"" << std::endl;
+		return false;
+	}
+
+	size_t regressionCount{ 0u };
+	for (const Result& result : results)
+	{
+		const auto baselineResult{ std::find_if(baselineResults.begin(), baselineResults.end(), [&result](const Result& baseline) { return baseline.objectCount == result.objectCount; }) };
+		if (baselineResult == baselineResults.end())
+		{
+			std::cout << "Scene benchmark: no baseline for " << result.objectCount << " game objects" << std::endl;
+			continue;
+		}
+
+		// Times are noisy and get the tolerance, the counts are deterministic and may not grow at all
+		const auto compare = [this, &result, &regressionCount](const char* name, double value, double baselineValue, bool isTime)
+		{
+			const double allowedValue{ isTime ? baselineValue * (1.0 + m_Tolerance / 100.0) : baselineValue };
+			const bool	 isRegression{ value > allowedValue + 1e-6 };
+			const double change{ baselineValue > 0.0 ? 100.0 * (value / baselineValue - 1.0) : 0.0 };
+			std::cout << (isRegression ? "REGRESSION " : "") << result.objectCount << " game objects, " << name << ": " << value << " against " << baselineValue << " (" << (change >= 0.0 ? "+" : "") << change << "%)" << std::endl;
+			regressionCount += isRegression ? 1u : 0u;
+		};
+
+		compare("CPU frame time", result.cpuFrameTime, baselineResult->cpuFrameTime, true);
+		compare("CPU frame time 95th percentile", result.cpuFrameTime95th, baselineResult->cpuFrameTime95th, true);
+		compare("recording time", result.recordingTime, baselineResult->recordingTime, true);
+		compare("draw calls", result.drawCallCount, baselineResult->drawCallCount, false);
+		compare("pipeline binds", result.pipelineBindCount, baselineResult->pipelineBindCount, false);
+	}
+
+	if (regressionCount > 0u)
+	{
+		std::cout << "Scene benchmark: " << regressionCount << " regression(s) against \"" << m_BaselineFilename << "\" with a tolerance of " << m_Tolerance << "%" << std::endl;
+		return false;
+	}
+
+	std::cout << "Scene benchmark: no regressions against \"" << m_BaselineFilename << "\"" << std::endl;
+	return true;
+}
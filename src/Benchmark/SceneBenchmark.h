@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class VulkanDevice;
+class HeadlessView;
+class DemoScene;
+class MeshData;
+
+namespace Spectre
+{
+	const std::string	sceneBenchmarkResultFilename = "SceneBenchmark.json";
+	constexpr size_t	sceneBenchmarkWarmupFrameCount = 30u;
+	constexpr size_t	sceneBenchmarkMeasuredFrameCount = 300u;
+	constexpr double	sceneBenchmarkTolerance = 10.0; // Percent a time may grow over the baseline before it counts as a regression
+	constexpr float		sceneBenchmarkTimeStep = 1.0f / 90.0f;
+	constexpr uint32_t	sceneBenchmarkSeed = 1337u;
+} // namespace Spectre
+
+/*
+ * The scene benchmark renders stress scenes of increasing size headless, by default 1k, 10k and 100k game objects, and
+ * writes the CPU frame time, the command recording time, the draw calls and the pipeline binds per frame to a JSON file.
+ * Given a baseline file written by an earlier run, every scene is compared against the scene of the same size in it and
+ * the run fails when a time grew by more than the tolerance or a count grew at all.
+ *
+ * Usage: SceneBenchmark [--objects=1000,10000,100000] [--frames=300] [--output=SceneBenchmark.json]
+ *                       [--baseline=Baseline.json] [--tolerance=10]
+ */
+class SceneBenchmark final
+{
+public:
+	explicit SceneBenchmark(const std::vector<std::string>& arguments);
+	SceneBenchmark(const SceneBenchmark&) = delete;
+	SceneBenchmark& operator=(const SceneBenchmark&) = delete;
+
+	int Run();
+
+private:
+	struct Result
+	{
+		size_t objectCount{ 0u };
+		double cpuFrameTime{ 0.0 };		 // Average milliseconds per frame
+		double cpuFrameTime95th{ 0.0 };	 // 95th percentile milliseconds per frame
+		double recordingTime{ 0.0 };	 // Average milliseconds spent recording the passes
+		double drawCallCount{ 0.0 };	 // Average per frame
+		double pipelineBindCount{ 0.0 }; // Average per frame
+	};
+
+	std::vector<size_t> m_ObjectCounts{ 1000u, 10000u, 100000u };
+	size_t				m_MeasuredFrameCount{ Spectre::sceneBenchmarkMeasuredFrameCount };
+	std::string			m_OutputFilename{ Spectre::sceneBenchmarkResultFilename };
+	std::string			m_BaselineFilename; // No comparison when empty
+	double				m_Tolerance{ Spectre::sceneBenchmarkTolerance };
+	bool				m_HasInvalidArguments{ false };
+
+	Result RunScene(const VulkanDevice* device, HeadlessView& view, DemoScene& demoScene, size_t objectCount, const MeshData* meshData) const;
+	bool   WriteResults(const std::vector<Result>& results) const;
+	// Returns false when any scene regressed against the baseline
+	bool   CompareWithBaseline(const std::vector<Result>& results) const;
+
+	static bool ReadResults(const std::string& filename, std::vector<Result>& outResults);
+};
@@ -0,0 +1,76 @@
+#include "StressScene.h"
+
+#include "../Scene/GameData.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <random>
+#include <string>
+
+StressScene::StressScene(const std::vector<GameObject*>& prototypes, size_t objectCount, uint32_t seed)
+{
+	// 2D shapes follow the head, copies of them would all end up in the same place
+	std::vector<const GameObject*> sceneryPrototypes;
+	for (const GameObject* prototype : prototypes)
+	{
+		if (!prototype->Is2DShape)
+		{
+			sceneryPrototypes.push_back(prototype);
+		}
+	}
+
+	if (sceneryPrototypes.empty())
+	{
+		return;
+	}
+
+	// The density stays the same for every object count, larger scenes cover a larger area
+	const float halfExtent{ 0.5f * Spectre::stressSceneObjectSpacing * std::sqrt(static_cast<float>(objectCount)) };
+
+	std::mt19937						  generator(seed);
+	std::uniform_real_distribution<float> positionDistribution(-halfExtent, halfExtent);
+	std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+	std::uniform_int_distribution<size_t> prototypeDistribution(0u, sceneryPrototypes.size() - 1u);
+
+	m_GameObjects.reserve(objectCount);
+	for (size_t objectIndex = 0u; objectIndex < objectCount; ++objectIndex)
+	{
+		const GameObject* prototype{ sceneryPrototypes.at(prototypeDistribution(generator)) };
+		GameObject*		  gameObject{ new GameObject{ prototype->Model, prototype->Material, prototype->Name + std::to_string(objectIndex) } };
+
+		const glm::vec3 position{ positionDistribution(generator), 0.0f, positionDistribution(generator) };
+		const float		yaw{ glm::two_pi<float>() * unitDistribution(generator) };
+		gameObject->WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), position), yaw, { 0.0f, 1.0f, 0.0f });
+
+		if (unitDistribution(generator) < Spectre::stressSceneAnimatedFraction)
+		{
+			m_AnimatedObjects.push_back({ gameObject, gameObject->WorldMatrix, glm::two_pi<float>() * unitDistribution(generator), 0.5f + unitDistribution(generator) });
+		}
+		else
+		{
+			gameObject->IsStatic = true;
+		}
+
+		m_GameObjects.push_back(gameObject);
+	}
+}
+
+StressScene::~StressScene()
+{
+	for (GameObject* gameObject : m_GameObjects)
+	{
+		delete gameObject;
+	}
+}
+
+void StressScene::Update(float time)
+{
+	for (const AnimatedObject& animatedObject : m_AnimatedObjects)
+	{
+		const float		angle{ animatedObject.phase + time * animatedObject.speed };
+		const glm::mat4 bobMatrix{ glm::translate(animatedObject.baseMatrix, { 0.0f, 0.5f + 0.5f * std::sin(angle), 0.0f }) };
+		animatedObject.gameObject->WorldMatrix = glm::rotate(bobMatrix, angle, { 0.0f, 1.0f, 0.0f });
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct GameObject;
+
+namespace Spectre
+{
+	constexpr float stressSceneObjectSpacing = 3.0f;	// Meters between neighbours on average, the area grows with the object count
+	constexpr float stressSceneAnimatedFraction = 0.1f; // The others are static and stay in the shadow cache
+} // namespace Spectre
+
+/*
+ * The stress scene scatters copies of existing game objects over a square around the origin, each keeping the model and
+ * material of the object it was copied from. Positions, orientations and the animated subset are drawn from a seeded
+ * generator, so the same seed and object count always produce the same scene. Animated objects spin and bob in Update().
+ */
+class StressScene final
+{
+public:
+	StressScene(const std::vector<GameObject*>& prototypes, size_t objectCount, uint32_t seed);
+	~StressScene();
+	StressScene(const StressScene&) = delete;
+	StressScene& operator=(const StressScene&) = delete;
+
+	void Update(float time);
+
+	const std::vector<GameObject*>& GetGameObjects() const { return m_GameObjects; }
+	size_t							GetAnimatedObjectCount() const { return m_AnimatedObjects.size(); }
+
+private:
+	struct AnimatedObject
+	{
+		GameObject* gameObject{ nullptr };
+		glm::mat4	baseMatrix{ glm::mat4(1.0f) };
+		float		phase{ 0.0f };
+		float		speed{ 1.0f };
+	};
+
+	std::vector<GameObject*>	m_GameObjects;
+	std::vector<AnimatedObject> m_AnimatedObjects;
+};
@@ -0,0 +1,18 @@
+#include "SceneBenchmark.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		SceneBenchmark sceneBenchmark{ std::vector<std::string>(argv + 1, argv + argc) };
+		return sceneBenchmark.Run();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -2,9 +2,9 @@
 
 #include "../Misc/Utils.h"
 
-#include <sstream>
+#include <array>
 
-DataBuffer::DataBuffer(const VulkanDevice* device, const VkBufferUsageFlags bufferUsageFlags, const VkMemoryPropertyFlags memoryProperties, const VkDeviceSize size) : m_Device(device), size(size)
+DataBuffer::DataBuffer(const VulkanDevice* device, const VkBufferUsageFlags bufferUsageFlags, const VkMemoryPropertyFlags memoryProperties, const VkDeviceSize size, bool isSharedWithComputeQueue) : m_Device(device), size(size)
 {
 	const VkDevice vkDevice{ device->GetVkDevice() };
 
@@ -12,34 +12,30 @@ DataBuffer::DataBuffer(const VulkanDevice* device, const VkBufferUsageFlags buff
 	bufferCreateInfo.size = size;
 	bufferCreateInfo.usage = bufferUsageFlags;
 	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	if (vkCreateBuffer(vkDevice, &bufferCreateInfo, nullptr, &buffer) != VK_SUCCESS)
+
+	const std::array<uint32_t, 2u> queueFamilyIndices{ device->GetVkDrawQueueFamilyIndex(), device->GetVkComputeQueueFamilyIndex() };
+	if (isSharedWithComputeQueue && device->HasAsyncComputeQueue())
 	{
-		utils::ThrowError(EError::GenericVulkan);
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilyIndices.size());
+		bufferCreateInfo.pQueueFamilyIndices = queueFamilyIndices.data();
 	}
-
-	VkMemoryRequirements memoryRequirements;
-	vkGetBufferMemoryRequirements(vkDevice, buffer, &memoryRequirements);
-
-	uint32_t suitableMemoryTypeIndex = 0u;
-	if (!utils::FindSuitableMemoryTypeIndex(device->GetVkPhysicalDevice(), memoryRequirements, memoryProperties, suitableMemoryTypeIndex))
+	if (vkCreateBuffer(vkDevice, &bufferCreateInfo, nullptr, &buffer) != VK_SUCCESS)
 	{
-		utils::ThrowError(EError::FeatureNotSupported, "Suitable data buffer memory type");
+		utils::ThrowError(EError::GenericVulkan);
 	}
 
-	VkMemoryAllocateInfo memoryAllocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = suitableMemoryTypeIndex;
-	if (vkAllocateMemory(vkDevice, &memoryAllocateInfo, nullptr, &deviceMemory) != VK_SUCCESS)
+	// Storage buffers count as uniforms, staging buffers are only ever copied from
+	EMemoryCategory category{ EMemoryCategory::Uniform };
+	if (bufferUsageFlags & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
 	{
-		std::stringstream s;
-		s << memoryRequirements.size << " bytes for buffer";
-		utils::ThrowError(EError::OutOfMemory, s.str());
+		category = EMemoryCategory::Geometry;
 	}
-
-	if (vkBindBufferMemory(vkDevice, buffer, deviceMemory, 0u) != VK_SUCCESS)
+	else if (bufferUsageFlags == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
 	{
-		utils::ThrowError(EError::GenericVulkan);
+		category = EMemoryCategory::Staging;
 	}
+	m_Allocation = device->GetMemoryAllocator()->AllocateForBuffer(buffer, memoryProperties, category);
 }
 
 DataBuffer::~DataBuffer()
@@ -47,60 +43,22 @@ DataBuffer::~DataBuffer()
 	const VkDevice vkDevice{ m_Device->GetVkDevice() };
 	if (vkDevice)
 	{
-		if (deviceMemory)
-		{
-			vkFreeMemory(vkDevice, deviceMemory, nullptr);
-		}
-
 		if (buffer)
 		{
 			vkDestroyBuffer(vkDevice, buffer, nullptr);
 		}
-	}
-}
 
-bool DataBuffer::CopyTo(const DataBuffer& target, VkCommandBuffer commandBuffer, VkQueue queue) const
-{
-	VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
-	}
-
-	VkBufferCopy copyRegion{};
-	copyRegion.size = size;
-	vkCmdCopyBuffer(commandBuffer, buffer, target.getBuffer(), 1u, &copyRegion);
-
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
+		m_Device->GetMemoryAllocator()->Free(m_Allocation);
 	}
-
-	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-	submitInfo.commandBufferCount = 1u;
-	submitInfo.pCommandBuffers = &commandBuffer;
-	if (vkQueueSubmit(queue, 1u, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
-	}
-
-	if (vkQueueWaitIdle(queue) != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
-	}
-
-	return true;
 }
 
 void* DataBuffer::MapData() const
 {
-	void* data;
-	const VkResult result{ vkMapMemory(m_Device->GetVkDevice(), deviceMemory, 0u, size, 0, &data) };
-	if (result != VK_SUCCESS)
+	// Only host visible memory is mapped
+	if (!m_Allocation.mappedData)
 	{
 		utils::ThrowError(EError::GenericVulkan);
 	}
 
-	return data;
+	return m_Allocation.mappedData;
 }
\ No newline at end of file
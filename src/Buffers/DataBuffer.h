@@ -2,28 +2,29 @@
 
 #include <vulkan/vulkan.h>
 
+#include "../VulkanBase/MemoryAllocator.h"
 #include "../VulkanBase/VulkanDevice.h"
 
 /*
  * The data buffer class is used to store Vulkan data buffers, namely the uniform buffer and the vertex/index buffer. It
- * is unrelated to Vulkan image buffers used for the depth buffer for example. Note that is good for performance to keep
- * Vulkan buffers mapped until destruction. This class offers functionality to do so, but doesn't enforce the principle.
+ * is unrelated to Vulkan image buffers used for the depth buffer for example. Its memory comes from the memory allocator,
+ * which keeps host visible memory mapped until it is released, so mapping the data is free and needs no unmapping.
  */
 class DataBuffer final
 {
 public:
-	DataBuffer(const VulkanDevice* m_Device, VkBufferUsageFlags bufferUsageFlags, VkMemoryPropertyFlags memoryProperties, VkDeviceSize size);
+	// Buffers shared with the async compute queue are accessed concurrently, so neither queue has to transfer ownership
+	DataBuffer(const VulkanDevice* m_Device, VkBufferUsageFlags bufferUsageFlags, VkMemoryPropertyFlags memoryProperties, VkDeviceSize size, bool isSharedWithComputeQueue = false);
 	~DataBuffer();
 
-	bool  CopyTo(const DataBuffer& target, VkCommandBuffer m_CommandBuffer, VkQueue queue) const;
+	// Device local buffers are filled through the upload manager instead
 	void* MapData() const;
-	void  UnmapData() const { vkUnmapMemory(m_Device->GetVkDevice(), deviceMemory); }
 
 	VkBuffer getBuffer() const { return buffer; }
 
 private:
-	const VulkanDevice* m_Device{ nullptr };
-	VkBuffer			buffer{ nullptr };
-	VkDeviceMemory		deviceMemory{ nullptr };
-	VkDeviceSize		size{ 0u };
+	const VulkanDevice*			m_Device{ nullptr };
+	VkBuffer					buffer{ nullptr };
+	MemoryAllocator::Allocation m_Allocation;
+	VkDeviceSize				size{ 0u };
 };
\ No newline at end of file
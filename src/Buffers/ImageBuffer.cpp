@@ -2,8 +2,6 @@
 
 #include "../Misc/Utils.h"
 
-#include <sstream>
-
 ImageBuffer::ImageBuffer(const VulkanDevice* device, VkExtent2D size, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkImageAspectFlags aspect, size_t layerCount) : m_Device(device)
 {
 	const VkDevice vkDevice{ device->GetVkDevice() };
@@ -24,36 +22,13 @@ ImageBuffer::ImageBuffer(const VulkanDevice* device, VkExtent2D size, VkFormat f
 	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	if (vkCreateImage(vkDevice, &imageCreateInfo, nullptr, &m_Image) != VK_SUCCESS)
 	{
-		(EError::GenericVulkan);
+		utils::ThrowError(EError::GenericVulkan);
 		return;
 	}
 
-	// Find a suitable memory type index
-	VkMemoryRequirements memoryRequirements;
-	vkGetImageMemoryRequirements(vkDevice, m_Image, &memoryRequirements);
-
-	uint32_t suitableMemoryTypeIndex{ 0u };
-	if (!utils::FindSuitableMemoryTypeIndex(device->GetVkPhysicalDevice(), memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, suitableMemoryTypeIndex))
-	{
-		utils::ThrowError(EError::FeatureNotSupported, "Suitable image buffer memory type");
-	}
-
-	// Allocate the device memory for the buffer
-	VkMemoryAllocateInfo memoryAllocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = suitableMemoryTypeIndex;
-	if (vkAllocateMemory(vkDevice, &memoryAllocateInfo, nullptr, &deviceMemory) != VK_SUCCESS)
-	{
-		std::stringstream s;
-		s << memoryRequirements.size << " bytes for image buffer";
-		utils::ThrowError(EError::OutOfMemory, s.str());
-	}
-
-	// Bind the image to the allocated device memory
-	if (vkBindImageMemory(vkDevice, m_Image, deviceMemory, 0u) != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
-	}
+	// Attachments get memory of their own, other images are sub-allocated
+	const bool isAttachment{ (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) != 0u };
+	m_Allocation = device->GetMemoryAllocator()->AllocateForImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, isAttachment ? EMemoryCategory::Attachment : EMemoryCategory::Texture, isAttachment);
 
 	// Create an image view
 	utils::CreateImageView(m_Image, format, layerCount, aspect, vkDevice, m_ImageView);
@@ -69,14 +44,11 @@ ImageBuffer::~ImageBuffer()
 			vkDestroyImageView(vkDevice, m_ImageView, nullptr);
 		}
 
-		if (deviceMemory)
-		{
-			vkFreeMemory(vkDevice, deviceMemory, nullptr);
-		}
-
 		if (m_Image)
 		{
 			vkDestroyImage(vkDevice, m_Image, nullptr);
 		}
+
+		m_Device->GetMemoryAllocator()->Free(m_Allocation);
 	}
 }
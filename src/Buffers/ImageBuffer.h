@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../VulkanBase/MemoryAllocator.h"
 #include "../VulkanBase/VulkanDevice.h"
 
 /*
@@ -12,11 +13,12 @@ public:
 	ImageBuffer(const VulkanDevice* m_Device, VkExtent2D size, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkImageAspectFlags aspect, size_t layerCount);
 	~ImageBuffer();
 
+	VkImage		GetImage() const { return m_Image; }
 	VkImageView GetImageView() const { return m_ImageView; }
 
 private:
-	const VulkanDevice* m_Device{ nullptr };
-	VkImage				m_Image{ nullptr };
-	VkDeviceMemory		deviceMemory{ nullptr };
-	VkImageView			m_ImageView{ nullptr };
+	const VulkanDevice*			m_Device{ nullptr };
+	VkImage						m_Image{ nullptr };
+	MemoryAllocator::Allocation m_Allocation;
+	VkImageView					m_ImageView{ nullptr };
 };
\ No newline at end of file
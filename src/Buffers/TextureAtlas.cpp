@@ -0,0 +1,197 @@
+#include "TextureAtlas.h"
+
+#include "../Misc/BlockCompression.h"
+#include "../Misc/TextureCooker.h"
+#include "../Misc/Utils.h"
+#include "../VulkanBase/VulkanDevice.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t gutterSize = 1u << (Spectre::textureAtlasMipCount - 1u);								// Still a texel wide in the last level
+	constexpr uint32_t cellAlignment = BlockCompression::blockSize << (Spectre::textureAtlasMipCount - 1u);	// Still a block in the last level
+	constexpr size_t   texelSize = 4u;																		// RGBA8
+
+	// Creating an array view takes more than one layer
+	static_assert(Spectre::textureAtlasLayerCount > 1u);
+
+	uint32_t AlignToCell(uint32_t size) { return (size + cellAlignment - 1u) / cellAlignment * cellAlignment; }
+} // namespace
+
+TextureAtlas::TextureAtlas(const VulkanDevice* device, VkFormat format, UploadManager* uploadManager) : m_Device(device), m_Format(format)
+{
+	const VkDevice vkDevice{ device->GetVkDevice() };
+
+	// Create an image with every layer the atlas will ever have
+	VkImageCreateInfo imageCreateInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.extent.width = Spectre::textureAtlasSize;
+	imageCreateInfo.extent.height = Spectre::textureAtlasSize;
+	imageCreateInfo.extent.depth = 1u;
+	imageCreateInfo.mipLevels = Spectre::textureAtlasMipCount;
+	imageCreateInfo.arrayLayers = Spectre::textureAtlasLayerCount;
+	imageCreateInfo.format = format;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateImage(vkDevice, &imageCreateInfo, nullptr, &m_Image) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	m_Allocation = device->GetMemoryAllocator()->AllocateForImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Texture);
+	utils::CreateImageView(m_Image, format, Spectre::textureAtlasLayerCount, VK_IMAGE_ASPECT_COLOR_BIT, vkDevice, m_ImageView, Spectre::textureAtlasMipCount);
+
+	m_UsedLayerHeights.resize(Spectre::textureAtlasLayerCount, 0u);
+
+	// Goes out with the first upload batch, before any frame samples the atlas
+	Allocate({ 1u, 1u }, m_PlaceholderCell);
+	Upload(m_PlaceholderCell, BuildLevels(m_PlaceholderCell, std::vector<uint8_t>(texelSize, 0xFFu)), uploadManager);
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice)
+	{
+		if (m_ImageView)
+		{
+			vkDestroyImageView(vkDevice, m_ImageView, nullptr);
+		}
+
+		if (m_Image)
+		{
+			vkDestroyImage(vkDevice, m_Image, nullptr);
+		}
+
+		m_Device->GetMemoryAllocator()->Free(m_Allocation);
+	}
+}
+
+bool TextureAtlas::Allocate(VkExtent2D textureExtent, Cell& outCell)
+{
+	const VkExtent2D extent{ AlignToCell(textureExtent.width + 2u * gutterSize), AlignToCell(textureExtent.height + 2u * gutterSize) };
+	if (extent.width > Spectre::textureAtlasSize || extent.height > Spectre::textureAtlasSize)
+	{
+		return false;
+	}
+
+	// Shelves much taller than the cell would waste most of their height on it
+	for (Shelf& shelf : m_Shelves)
+	{
+		if (shelf.height >= extent.height && shelf.height <= extent.height * 2u && shelf.usedWidth + extent.width <= Spectre::textureAtlasSize)
+		{
+			outCell = { shelf.layer, { static_cast<int32_t>(shelf.usedWidth), static_cast<int32_t>(shelf.y) }, extent, textureExtent };
+			shelf.usedWidth += extent.width;
+			++m_CellCount;
+			return true;
+		}
+	}
+
+	// Otherwise a new shelf goes on top of the first layer with room left
+	for (uint32_t layer = 0u; layer < Spectre::textureAtlasLayerCount; ++layer)
+	{
+		uint32_t& usedHeight{ m_UsedLayerHeights.at(layer) };
+		if (usedHeight + extent.height <= Spectre::textureAtlasSize)
+		{
+			m_Shelves.push_back({ layer, usedHeight, extent.height, extent.width });
+			outCell = { layer, { 0, static_cast<int32_t>(usedHeight) }, extent, textureExtent };
+			usedHeight += extent.height;
+			++m_CellCount;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::vector<std::vector<uint8_t>> TextureAtlas::BuildLevels(const Cell& cell, const std::vector<uint8_t>& texels) const
+{
+	// The gutter repeats the nearest edge texel, so filtering across the edge never reaches a neighbor
+	std::vector<uint8_t> cellTexels(static_cast<size_t>(cell.extent.width) * cell.extent.height * texelSize);
+	for (uint32_t y = 0u; y < cell.extent.height; ++y)
+	{
+		const uint32_t row{ std::min(y >= gutterSize ? y - gutterSize : 0u, cell.textureExtent.height - 1u) };
+		for (uint32_t x = 0u; x < cell.extent.width; ++x)
+		{
+			const uint32_t column{ std::min(x >= gutterSize ? x - gutterSize : 0u, cell.textureExtent.width - 1u) };
+			std::copy_n(&texels.at((static_cast<size_t>(row) * cell.textureExtent.width + column) * texelSize), texelSize, &cellTexels.at((static_cast<size_t>(y) * cell.extent.width + x) * texelSize));
+		}
+	}
+
+	std::vector<std::vector<uint8_t>> levels;
+	VkExtent2D						  extent{ cell.extent };
+	for (uint32_t mip = 0u; mip < Spectre::textureAtlasMipCount; ++mip)
+	{
+		levels.push_back(BlockCompression::IsCompressed(m_Format) ? BlockCompression::Encode(m_Format, cellTexels, extent) : cellTexels);
+		if (mip + 1u < Spectre::textureAtlasMipCount)
+		{
+			cellTexels = TextureCooker::Downsample(cellTexels, extent);
+			extent = TextureCooker::GetMipExtent(extent, 1u);
+		}
+	}
+
+	return levels;
+}
+
+void TextureAtlas::Upload(const Cell& cell, const std::vector<std::vector<uint8_t>>& levels, UploadManager* uploadManager)
+{
+	std::vector<VkBufferImageCopy> uploadRegions;
+	VkDeviceSize				   stagingSize{ 0u };
+	for (uint32_t mip = 0u; mip < Spectre::textureAtlasMipCount; ++mip)
+	{
+		VkBufferImageCopy uploadRegion{};
+		uploadRegion.bufferOffset = stagingSize;
+		uploadRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, cell.layer, 1u };
+		uploadRegion.imageOffset = { cell.offset.x >> mip, cell.offset.y >> mip, 0 };
+		uploadRegion.imageExtent = { cell.extent.width >> mip, cell.extent.height >> mip, 1u };
+		uploadRegions.push_back(uploadRegion);
+
+		stagingSize += utils::Align(static_cast<VkDeviceSize>(levels.at(mip).size()), Spectre::uploadStagingAlignment);
+	}
+
+	// The first upload defines the rest of the image along with it, later ones keep the other cells of their layer
+	const VkImageSubresourceRange subresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0u, Spectre::textureAtlasMipCount, m_IsInitialized ? cell.layer : 0u, m_IsInitialized ? 1u : Spectre::textureAtlasLayerCount };
+	const VkImageLayout			  initialLayout{ m_IsInitialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED };
+	UploadManager::Token		  uploadToken;
+	char*						  stagingData{ static_cast<char*>(uploadManager->StageImage(m_Image, stagingSize, uploadRegions, subresourceRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uploadToken, initialLayout)) };
+	for (uint32_t mip = 0u; mip < Spectre::textureAtlasMipCount; ++mip)
+	{
+		memcpy(stagingData + uploadRegions.at(mip).bufferOffset, levels.at(mip).data(), levels.at(mip).size());
+	}
+
+	m_IsInitialized = true;
+}
+
+TextureAtlas::Region TextureAtlas::GetRegion(const Cell& cell)
+{
+	constexpr float atlasSize{ static_cast<float>(Spectre::textureAtlasSize) };
+
+	Region region;
+	region.atlas = this;
+	region.layer = cell.layer;
+	region.uvTransform = { static_cast<float>(cell.textureExtent.width) / atlasSize, static_cast<float>(cell.textureExtent.height) / atlasSize, static_cast<float>(cell.offset.x + gutterSize) / atlasSize, static_cast<float>(cell.offset.y + gutterSize) / atlasSize };
+	return region;
+}
+
+TextureAtlas::Region TextureAtlas::GetPlaceholderRegion()
+{
+	// Every UV lands on the center of the single white texel
+	Region region{ GetRegion(m_PlaceholderCell) };
+	region.uvTransform = { 0.0f, 0.0f, region.uvTransform.z + 0.5f / Spectre::textureAtlasSize, region.uvTransform.w + 0.5f / Spectre::textureAtlasSize };
+	return region;
+}
+
+VkDeviceSize TextureAtlas::GetSize() const
+{
+	VkDeviceSize size{ 0u };
+	for (uint32_t mip = 0u; mip < Spectre::textureAtlasMipCount; ++mip)
+	{
+		size += BlockCompression::GetLevelSize(m_Format, TextureCooker::GetMipExtent({ Spectre::textureAtlasSize, Spectre::textureAtlasSize }, mip));
+	}
+	return size * Spectre::textureAtlasLayerCount;
+}
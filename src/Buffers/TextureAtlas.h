@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../VulkanBase/MemoryAllocator.h"
+#include "../VulkanBase/UploadManager.h"
+
+#include <glm/vec4.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+class VulkanDevice;
+
+namespace Spectre
+{
+	constexpr uint32_t textureAtlasSize = 1024u;		  // Extent of every layer
+	constexpr uint32_t textureAtlasLayerCount = 2u;		  // Allocated up front, the atlas never grows
+	constexpr uint32_t textureAtlasMipCount = 4u;		  // The gutters around every texture keep this many levels from bleeding into each other
+	constexpr uint32_t textureAtlasMaxTextureSize = 128u; // Larger textures are streamed on their own
+} // namespace Spectre
+
+/*
+ * The texture atlas packs small textures of one format into the layers of a single 2D texture array, so they share an
+ * image, an allocation and a descriptor set. Every texture gets a cell of its own on a shelf of a layer, its edge texels
+ * are repeated into a gutter around it that is wide enough for the atlas' short mip chain, and cells are aligned so that
+ * even the last level of a block compressed atlas starts on a block boundary. The levels of a cell are built on the CPU
+ * and uploaded into the cell alone. Textures are sampled through a UV scale and offset into their layer, a placeholder
+ * cell of white texels stands in for textures that are still loading.
+ */
+class TextureAtlas final
+{
+public:
+	// Where in the atlas a texture ends up, in texels of level zero
+	struct Cell
+	{
+		uint32_t   layer{ 0u };
+		VkOffset2D offset{ 0, 0 };
+		VkExtent2D extent{ 0u, 0u }; // Of the whole cell, gutters included
+		VkExtent2D textureExtent{ 0u, 0u };
+	};
+
+	// Read by the textured atlas shaders through the material
+	struct Region
+	{
+		TextureAtlas* atlas{ nullptr };
+		uint32_t	  layer{ 0u };
+		glm::vec4	  uvTransform{ 1.0f, 1.0f, 0.0f, 0.0f }; // Scale in xy, offset in zw
+	};
+
+	// Creates the image and uploads the placeholder cell
+	TextureAtlas(const VulkanDevice* device, VkFormat format, UploadManager* uploadManager);
+	~TextureAtlas();
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// Returns false once no layer has room for the texture anymore
+	bool							  Allocate(VkExtent2D textureExtent, Cell& outCell);
+	// Pads the RGBA8 texels of a texture to its cell and builds every level of it in the format of the atlas, safe to call from any thread
+	std::vector<std::vector<uint8_t>> BuildLevels(const Cell& cell, const std::vector<uint8_t>& texels) const;
+	void							  Upload(const Cell& cell, const std::vector<std::vector<uint8_t>>& levels, UploadManager* uploadManager);
+	// UV transform and layer of the texture in the cell
+	Region							  GetRegion(const Cell& cell);
+	Region							  GetPlaceholderRegion();
+
+	VkFormat	 GetFormat() const { return m_Format; }
+	VkImageView	 GetImageView() const { return m_ImageView; }
+	VkDeviceSize GetSize() const;
+	size_t		 GetCellCount() const { return m_CellCount; }
+
+private:
+	// Cells of similar height are packed side by side
+	struct Shelf
+	{
+		uint32_t layer{ 0u };
+		uint32_t y{ 0u };
+		uint32_t height{ 0u };
+		uint32_t usedWidth{ 0u };
+	};
+
+	const VulkanDevice*			m_Device{ nullptr };
+	VkFormat					m_Format{ VK_FORMAT_UNDEFINED };
+	VkImage						m_Image{ nullptr };
+	MemoryAllocator::Allocation m_Allocation;
+	VkImageView					m_ImageView{ nullptr };
+	bool						m_IsInitialized{ false }; // The first upload defines the layout of the whole image
+
+	std::vector<Shelf>	  m_Shelves;
+	std::vector<uint32_t> m_UsedLayerHeights;
+	size_t				  m_CellCount{ 0u };
+	Cell				  m_PlaceholderCell;
+};
@@ -1,123 +1,283 @@
 #include "TextureBuffer.h"
 
+#include "../Misc/BlockCompression.h"
+#include "../Misc/CpuProfiler.h"
+#include "../Misc/TextureCooker.h"
 #include "../Misc/Utils.h"
-#include <sstream>
-//#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include "../VulkanBase/VulkanDevice.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 
-TextureBuffer::TextureBuffer(const VulkanDevice* device, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkImageAspectFlags aspect, size_t layerCount, std::string textureName) : m_Device(device)
+TextureBuffer::TextureBuffer(const VulkanDevice* device, const std::string& filename) : m_Device(device), m_Filename(filename)
 {
-	const VkDevice vkDevice = device->GetVkDevice();
+	// A cooked texture next to the source image holds every level ready to upload
+	const std::string		  cookedFilename{ TextureCooker::GetCookedFilename(filename) };
+	std::ifstream			  cookedFile(cookedFilename, std::ios::binary);
+	TextureCooker::FileHeader header{};
+	const bool				  isCooked{ cookedFile.is_open() && TextureCooker::ReadHeader(cookedFile, header, m_CookedLevels) };
+	if (isCooked && (header.format == static_cast<uint32_t>(Spectre::textureFormat) || BlockCompression::IsCompressed(static_cast<VkFormat>(header.format))))
+	{
+		m_CookedFilename = cookedFilename;
+		m_CookedFormat = static_cast<VkFormat>(header.format);
+		m_Extent = { header.width, header.height };
+
+		// Blocks the device can't sample are transcoded on the worker thread that reads them
+		if (device->SupportsTextureFormat(m_CookedFormat))
+		{
+			m_Format = m_CookedFormat;
+		}
+	}
+	else
+	{
+		m_CookedLevels.clear();
+		if (!TextureCooker::ReadImageExtent(filename, m_Extent))
+		{
+			utils::ThrowError(EError::ImageLoadingFailure, filename);
+		}
+
+		// Only the most detailed level that is streamed in gets decoded, blits generate the levels below it
+		m_GeneratesMips = device->SupportsLinearBlit(Spectre::textureFormat);
+	}
+
+	m_MipCount = TextureCooker::GetMipCount(m_Extent);
+	m_ResidentMip = m_MipCount;
+
+	// The mip tail starts at the first level that is small enough along both axes
+	while (m_MipTail + 1u < m_MipCount && std::max(GetMipExtent(m_MipTail).width, GetMipExtent(m_MipTail).height) > Spectre::textureMipTailSize)
+	{
+		++m_MipTail;
+	}
+}
+
+TextureBuffer::~TextureBuffer()
+{
+	for (const RetiredImage& retiredImage : m_RetiredImages)
+	{
+		DestroyImage(retiredImage.image, retiredImage.imageView, retiredImage.allocation);
+	}
+
+	DestroyImage(m_Image, m_ImageView, m_Allocation);
+}
+
+TextureBuffer::MipData TextureBuffer::LoadMips(uint32_t firstMip, uint32_t endMip) const
+{
+	SPECTRE_PROFILE_ZONE("TextureBuffer::LoadMips");
+
+	MipData mipData;
+	mipData.firstMip = firstMip;
+
+	// Cooked levels are read as they are, nothing else of the file is touched
+	if (!m_CookedFilename.empty())
+	{
+		std::ifstream file(m_CookedFilename, std::ios::binary);
+		if (!file.is_open())
+		{
+			utils::ThrowError(EError::FileMissing, m_CookedFilename);
+		}
+
+		for (uint32_t mip = firstMip; mip < endMip; ++mip)
+		{
+			// A level table that disagrees with the format would make the upload read past the level
+			const TextureCooker::Level& level{ m_CookedLevels.at(mip) };
+			if (level.size != BlockCompression::GetLevelSize(m_CookedFormat, GetMipExtent(mip)))
+			{
+				utils::ThrowError(EError::ImageLoadingFailure, m_CookedFilename);
+			}
+
+			std::vector<uint8_t>& levelData{ mipData.levels.emplace_back(static_cast<size_t>(level.size)) };
+			file.seekg(static_cast<std::streamoff>(level.offset));
+			file.read(reinterpret_cast<char*>(levelData.data()), static_cast<std::streamsize>(levelData.size()));
+		}
+
+		if (!file.good())
+		{
+			utils::ThrowError(EError::ImageLoadingFailure, m_CookedFilename);
+		}
+
+		if (m_Format != m_CookedFormat)
+		{
+			for (uint32_t mip = firstMip; mip < endMip; ++mip)
+			{
+				std::vector<uint8_t>& levelData{ mipData.levels.at(mip - firstMip) };
+				levelData = BlockCompression::Decode(m_CookedFormat, levelData, GetMipExtent(mip));
+			}
+		}
+		return mipData;
+	}
 
-	stbi_uc* textureData = stbi_load(textureName.c_str(), &m_TextureWidth, &m_TextureHeight, &m_TextureChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = m_TextureWidth * m_TextureHeight * 4;
+	VkExtent2D			 extent;
+	std::vector<uint8_t> texels{ TextureCooker::DecodeImage(m_Filename, extent) };
 
-	if (!textureData)
+	// The file may have been replaced since its header was read
+	if (extent.width != m_Extent.width || extent.height != m_Extent.height)
 	{
-		utils::ThrowError(EError::ImageFailure);
+		utils::ThrowError(EError::ImageLoadingFailure, m_Filename);
 	}
 
-	CreateTextureSampler(vkDevice);
+	// Every level is downsampled from the one before, only the requested levels are kept
+	mipData.isPartial = m_GeneratesMips && firstMip + 1u < endMip;
+	const uint32_t lastMip{ mipData.isPartial ? firstMip : endMip - 1u };
+	for (uint32_t mip = 0u; mip <= lastMip; ++mip)
+	{
+		if (mip >= firstMip)
+		{
+			mipData.levels.push_back(mip == lastMip ? std::move(texels) : texels);
+		}
+
+		if (mip < lastMip)
+		{
+			texels = TextureCooker::Downsample(texels, GetMipExtent(mip));
+		}
+	}
 
-	CreateImage(layerCount, format, usage, samples, vkDevice, device, aspect);
+	return mipData;
 }
 
-void TextureBuffer::CreateImage(const size_t& layerCount, VkFormat format, const VkImageUsageFlags& usage, VkSampleCountFlagBits samples, const VkDevice& vkDevice, const VulkanDevice* device, const VkImageAspectFlags& aspect)
+void TextureBuffer::SetResidentMip(uint32_t residentMip, const MipData& mipData, UploadManager* uploadManager)
 {
-	// Create an image
+	if (residentMip == m_ResidentMip)
+	{
+		return;
+	}
+
+	const VkDevice	 vkDevice{ m_Device->GetVkDevice() };
+	const uint32_t	 levelCount{ m_MipCount - residentMip };
+	const VkExtent2D extent{ GetMipExtent(residentMip) };
+
+	// Create an image, it is the source of the copy into its own successor later on
 	VkImageCreateInfo imageCreateInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
 	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageCreateInfo.extent.width = m_TextureWidth;
-	imageCreateInfo.extent.height = m_TextureHeight;
+	imageCreateInfo.extent.width = extent.width;
+	imageCreateInfo.extent.height = extent.height;
 	imageCreateInfo.extent.depth = 1u;
-	imageCreateInfo.mipLevels = 1u;
-	imageCreateInfo.arrayLayers = static_cast<uint32_t>(layerCount);
-	imageCreateInfo.format = format;
+	imageCreateInfo.mipLevels = levelCount;
+	imageCreateInfo.arrayLayers = 1u;
+	imageCreateInfo.format = m_Format;
 	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageCreateInfo.usage = usage;
-	imageCreateInfo.samples = samples;
+	imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-	if (vkCreateImage(vkDevice, &imageCreateInfo, nullptr, &m_Image) != VK_SUCCESS)
+	VkImage image{ nullptr };
+	if (vkCreateImage(vkDevice, &imageCreateInfo, nullptr, &image) != VK_SUCCESS)
 	{
-		(EError::GenericVulkan);
-		return;
+		utils::ThrowError(EError::GenericVulkan);
 	}
 
-	// Find a suitable memory type index
-	VkMemoryRequirements memoryRequirements;
-	vkGetImageMemoryRequirements(vkDevice, m_Image, &memoryRequirements);
+	const MemoryAllocator::Allocation allocation{ m_Device->GetMemoryAllocator()->AllocateForImage(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Texture) };
+
+	VkImageView imageView{ nullptr };
+	utils::CreateImageView(image, m_Format, 1u, VK_IMAGE_ASPECT_COLOR_BIT, vkDevice, imageView, levelCount);
 
-	uint32_t suitableMemoryTypeIndex = 0u;
-	if (!utils::FindSuitableMemoryTypeIndex(device->GetVkPhysicalDevice(), memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, suitableMemoryTypeIndex))
+	// The levels both images have are copied on the GPU, the new image starts at a different level of the chain
+	const uint32_t		 firstCopiedMip{ std::max(residentMip, m_ResidentMip) };
+	UploadManager::Token copyToken{ 0u };
+	if (firstCopiedMip < m_MipCount)
 	{
-		utils::ThrowError(EError::FeatureNotSupported, "Suitable image buffer memory type");
+		std::vector<VkImageCopy> copyRegions;
+		for (uint32_t mip = firstCopiedMip; mip < m_MipCount; ++mip)
+		{
+			const VkExtent2D mipExtent{ GetMipExtent(mip) };
+
+			VkImageCopy copyRegion{};
+			copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - m_ResidentMip, 0u, 1u };
+			copyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - residentMip, 0u, 1u };
+			copyRegion.extent = { mipExtent.width, mipExtent.height, 1u };
+			copyRegions.push_back(copyRegion);
+		}
+
+		const uint32_t copiedLevelCount{ m_MipCount - firstCopiedMip };
+		uploadManager->CopyImage(m_Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, { VK_IMAGE_ASPECT_COLOR_BIT, firstCopiedMip - m_ResidentMip, copiedLevelCount, 0u, 1u }, image,
+								 { VK_IMAGE_ASPECT_COLOR_BIT, firstCopiedMip - residentMip, copiedLevelCount, 0u, 1u }, copyRegions, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, copyToken);
 	}
 
-	// Allocate the device memory for the buffer
-	VkMemoryAllocateInfo memoryAllocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = suitableMemoryTypeIndex;
-	if (vkAllocateMemory(vkDevice, &memoryAllocateInfo, nullptr, &deviceMemory) != VK_SUCCESS)
+	// The more detailed levels the old image lacks come from the mip data, partial data only holds the first of them
+	if (residentMip < firstCopiedMip)
 	{
-		std::stringstream s;
-		s << memoryRequirements.size << " bytes for image buffer";
-		utils::ThrowError(EError::OutOfMemory, s.str());
+		const uint32_t				   stagedEndMip{ mipData.isPartial ? residentMip + 1u : firstCopiedMip };
+		std::vector<VkBufferImageCopy> uploadRegions;
+		VkDeviceSize				   stagingSize{ 0u };
+		for (uint32_t mip = residentMip; mip < stagedEndMip; ++mip)
+		{
+			const VkExtent2D mipExtent{ GetMipExtent(mip) };
+
+			VkBufferImageCopy uploadRegion{};
+			uploadRegion.bufferOffset = stagingSize;
+			uploadRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - residentMip, 0u, 1u };
+			uploadRegion.imageExtent = { mipExtent.width, mipExtent.height, 1u };
+			uploadRegions.push_back(uploadRegion);
+
+			stagingSize += utils::Align(static_cast<VkDeviceSize>(mipData.levels.at(mip - mipData.firstMip).size()), Spectre::uploadStagingAlignment);
+		}
+
+		UploadManager::Token uploadToken;
+		const VkImageLayout	 stagedLayout{ mipData.isPartial ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		char*				 stagingData{ static_cast<char*>(uploadManager->StageImage(image, stagingSize, uploadRegions, { VK_IMAGE_ASPECT_COLOR_BIT, 0u, stagedEndMip - residentMip, 0u, 1u }, stagedLayout, uploadToken)) };
+		for (uint32_t mip = residentMip; mip < stagedEndMip; ++mip)
+		{
+			const std::vector<uint8_t>& texels{ mipData.levels.at(mip - mipData.firstMip) };
+			memcpy(stagingData + uploadRegions.at(mip - residentMip).bufferOffset, texels.data(), texels.size());
+		}
+
+		if (mipData.isPartial)
+		{
+			uploadManager->GenerateMips(image, extent, { VK_IMAGE_ASPECT_COLOR_BIT, 0u, firstCopiedMip - residentMip, 0u, 1u }, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uploadToken);
+		}
 	}
 
-	// Bind the image to the allocated device memory
-	if (vkBindImageMemory(vkDevice, m_Image, deviceMemory, 0u) != VK_SUCCESS)
+	// Frames still in flight may be sampling the old image
+	if (m_Image)
 	{
-		utils::ThrowError(EError::GenericVulkan);
+		m_RetiredImages.push_back({ m_Image, m_ImageView, m_Allocation, copyToken });
 	}
 
-	// Create an image view
-	utils::CreateImageView(m_Image, format, layerCount, aspect, vkDevice, m_ImageView);
+	m_Image = image;
+	m_Allocation = allocation;
+	m_ImageView = imageView;
+	m_ResidentMip = residentMip;
+	++m_Generation;
 }
 
-void TextureBuffer::CreateTextureSampler(const VkDevice& vkDevice)
+void TextureBuffer::ReleaseRetiredImages(UploadManager* uploadManager)
 {
-	VkSamplerCreateInfo samplerInfo{};
-	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-	samplerInfo.magFilter = VK_FILTER_LINEAR;
-	samplerInfo.minFilter = VK_FILTER_LINEAR;
-	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.anisotropyEnable = VK_TRUE;
-	samplerInfo.maxAnisotropy = 16;
-	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-	samplerInfo.unnormalizedCoordinates = VK_FALSE;
-	samplerInfo.compareEnable = VK_FALSE;
-	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-
-	if (vkCreateSampler(vkDevice, &samplerInfo, nullptr, &m_TextureSampler) != VK_SUCCESS)
+	const auto firstReleased{ std::partition(m_RetiredImages.begin(), m_RetiredImages.end(), [uploadManager](const RetiredImage& retiredImage) { return !uploadManager->IsComplete(retiredImage.copyToken); }) };
+	for (auto it = firstReleased; it != m_RetiredImages.end(); ++it)
 	{
-		utils::ThrowError(EError::GenericVulkan);
+		DestroyImage(it->image, it->imageView, it->allocation);
 	}
+	m_RetiredImages.erase(firstReleased, m_RetiredImages.end());
 }
 
-TextureBuffer::~TextureBuffer()
+VkExtent2D TextureBuffer::GetMipExtent(uint32_t mip) const { return TextureCooker::GetMipExtent(m_Extent, mip); }
+
+VkDeviceSize TextureBuffer::GetSize(uint32_t firstMip) const
+{
+	VkDeviceSize size{ 0u };
+	for (uint32_t mip = firstMip; mip < m_MipCount; ++mip)
+	{
+		size += BlockCompression::GetLevelSize(m_Format, GetMipExtent(mip));
+	}
+	return size;
+}
+
+void TextureBuffer::DestroyImage(VkImage image, VkImageView imageView, const MemoryAllocator::Allocation& allocation) const
 {
 	const VkDevice vkDevice{ m_Device->GetVkDevice() };
 	if (vkDevice)
 	{
-		if (m_ImageView)
+		if (imageView)
 		{
-			vkDestroyImageView(vkDevice, m_ImageView, nullptr);
+			vkDestroyImageView(vkDevice, imageView, nullptr);
 		}
 
-		if (deviceMemory)
+		if (image)
 		{
-			vkFreeMemory(vkDevice, deviceMemory, nullptr);
+			vkDestroyImage(vkDevice, image, nullptr);
 		}
 
-		if (m_Image)
-		{
-			vkDestroyImage(vkDevice, m_Image, nullptr);
-		}
+		m_Device->GetMemoryAllocator()->Free(allocation);
 	}
 }
@@ -1,26 +1,97 @@
 #pragma once
 
-#include "../VulkanBase/VulkanDevice.h"
+#include "../Misc/TextureCooker.h"
+#include "../VulkanBase/MemoryAllocator.h"
+#include "../VulkanBase/UploadManager.h"
 
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class VulkanDevice;
+
+namespace Spectre
+{
+	constexpr VkFormat textureFormat = VK_FORMAT_R8G8B8A8_SRGB; // Of decoded source images and transcoded blocks
+	constexpr uint32_t textureMipTailSize = 64u; // Levels no larger than this along either axis load first and are never evicted
+} // namespace Spectre
+
+/*
+ * The texture buffer holds a streamed 2D texture. Its image only contains the tail end of the mip chain, every level
+ * from the resident mip down to 1x1, and detail is added or taken away by replacing the image with one that has more or
+ * fewer levels. The levels both images have in common are copied on the GPU, so only the new levels are uploaded. The
+ * replaced images stay alive until nothing references them anymore. New levels are read from a cooked texture when
+ * there is one, otherwise the source image is decoded on a worker thread and only the most detailed new level is
+ * uploaded, the levels below it are blitted from it on the GPU. Cooked textures are block compressed, devices that can't
+ * sample their format get the blocks transcoded to RGBA8 as the levels are read. Which levels are resident is up to the
+ * texture streamer.
+ */
 class TextureBuffer final
 {
 public:
-	TextureBuffer(const VulkanDevice* m_Device, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkImageAspectFlags aspect, size_t layerCount, std::string textureName);
-	void CreateImage(const size_t& layerCount, VkFormat format, const VkImageUsageFlags& usage, VkSampleCountFlagBits samples, const VkDevice& vkDevice, const VulkanDevice* device, const VkImageAspectFlags& aspect);
-	void CreateTextureSampler(const VkDevice& vkDevice);
+	// Texels or blocks of consecutive mip levels in the format of the image, the most detailed one first
+	struct MipData
+	{
+		uint32_t						  firstMip{ 0u };
+		std::vector<std::vector<uint8_t>> levels;
+		bool							  isPartial{ false }; // Only holds the first level, the following ones are generated from it
+	};
+
+	// Only reads the header of the image file, nothing is resident until the streamer makes some levels resident
+	TextureBuffer(const VulkanDevice* device, const std::string& filename);
 	~TextureBuffer();
+	TextureBuffer(const TextureBuffer&) = delete;
+	TextureBuffer& operator=(const TextureBuffer&) = delete;
+
+	// Reads or decodes the levels from the first mip up to the end mip, safe to call from any thread
+	MipData LoadMips(uint32_t firstMip, uint32_t endMip) const;
+	// Replaces the image with one holding the levels from the resident mip down, the mip data holds the levels the current image lacks
+	void	SetResidentMip(uint32_t residentMip, const MipData& mipData, UploadManager* uploadManager);
+	// Destroys the replaced images whose levels have been copied, nothing may reference their views anymore
+	void	ReleaseRetiredImages(UploadManager* uploadManager);
 
-	VkImageView GetImageView() const { return m_ImageView; }
-	VkSampler	GetImageSampler() const { return m_TextureSampler; };
+	const std::string& GetFilename() const { return m_Filename; }
+	uint32_t		   GetMipCount() const { return m_MipCount; }
+	// First level of the mip tail
+	uint32_t		   GetMipTail() const { return m_MipTail; }
+	// Most detailed resident level, equal to the mip count while nothing is resident
+	uint32_t		   GetResidentMip() const { return m_ResidentMip; }
+	VkExtent2D		   GetMipExtent(uint32_t mip) const;
+	// Of all levels from the first mip down to 1x1
+	VkDeviceSize	   GetSize(uint32_t firstMip) const;
+	VkImageView		   GetImageView() const { return m_ImageView; }
+	// Changes whenever the image view does
+	uint64_t		   GetGeneration() const { return m_Generation; }
+	uint32_t		   GetMemoryTypeIndex() const { return m_Allocation.memoryTypeIndex; }
+	// Of the image and the levels the mip data holds
+	VkFormat		   GetFormat() const { return m_Format; }
 
 private:
-	const VulkanDevice* m_Device{ nullptr };
-	VkImage				m_Image{ nullptr };
-	VkDeviceMemory		deviceMemory{ nullptr };
-	VkImageView			m_ImageView{ nullptr };
-	VkSampler			m_TextureSampler;
-
-	int		 m_TextureWidth;
-	int		 m_TextureHeight;
-	int		 m_TextureChannels;
-};
\ No newline at end of file
+	struct RetiredImage
+	{
+		VkImage						image{ nullptr };
+		VkImageView					imageView{ nullptr };
+		MemoryAllocator::Allocation allocation;
+		UploadManager::Token		copyToken{ 0u }; // Copies the levels of the image into its successor
+	};
+
+	const VulkanDevice*			m_Device{ nullptr };
+	std::string					m_Filename;
+	VkExtent2D					m_Extent{ 0u, 0u };
+	uint32_t					m_MipCount{ 0u }, m_MipTail{ 0u }, m_ResidentMip{ 0u };
+	VkImage						m_Image{ nullptr };
+	MemoryAllocator::Allocation m_Allocation;
+	VkImageView					m_ImageView{ nullptr };
+	uint64_t					m_Generation{ 0u };
+	std::vector<RetiredImage>	m_RetiredImages;
+
+	VkFormat							m_Format{ Spectre::textureFormat };
+	std::string							m_CookedFilename; // Empty when the source image is decoded instead
+	std::vector<TextureCooker::Level>	m_CookedLevels;
+	VkFormat							m_CookedFormat{ Spectre::textureFormat }; // Transcoded when it differs from the image format
+	bool								m_GeneratesMips{ false };
+
+	void DestroyImage(VkImage image, VkImageView imageView, const MemoryAllocator::Allocation& allocation) const;
+};
@@ -0,0 +1,43 @@
+#include "../Misc/TextureCooker.h"
+#include <iostream>
+#include <string>
+
+// Cooks every source image given on the command line into a cooked texture next to it
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: TextureCooker [--bc1 | --rgba8] <image>..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		// BC7 keeps alpha and is the most accurate, BC1 halves the size again for opaque textures
+		VkFormat format{ VK_FORMAT_BC7_SRGB_BLOCK };
+		for (int argumentIndex = 1; argumentIndex < argc; ++argumentIndex)
+		{
+			const std::string argument{ argv[argumentIndex] };
+			if (argument == "--bc1")
+			{
+				format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+				continue;
+			}
+			if (argument == "--rgba8")
+			{
+				format = VK_FORMAT_R8G8B8A8_SRGB;
+				continue;
+			}
+
+			const std::string cookedFilename{ TextureCooker::GetCookedFilename(argument) };
+			TextureCooker::Cook(argument, cookedFilename, format);
+			std::cout << "Cooked \"" << argument << "\" into \"" << cookedFilename << "\"" << std::endl;
+		}
+		return EXIT_SUCCESS;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -1,15 +1,91 @@
 #include "App.h"
 #include "../Input/InputHandler.h"
 #include "../Light/LightSystem.h"
+#include "../Misc/CpuProfiler.h"
 #include "../Misc/Utils.h"
+#include "../Scene/DemoScene.h"
 #include "../Scene/GameData.h"
 #include "../Scene/MeshData.h"
 #include "../VR/Controllers.h"
+#include "../VR/HeadlessView.h"
 #include "../VulkanBase/VulkanDevice.h"
 #include "../VulkanBase/VulkanRenderer.h"
 // #include "../VulkanBase/VulkanWindow.h"
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <numeric>
+
+namespace Spectre
+{
+	constexpr int	 depthPrepassToggleKey = GLFW_KEY_P;
+	constexpr int	 sunPauseToggleKey = GLFW_KEY_L;
+	constexpr int	 asyncComputeToggleKey = GLFW_KEY_C;
+	constexpr int	 cpuTraceDumpKey = GLFW_KEY_T;
+	constexpr int	 foveationToggleKey = GLFW_KEY_F;
+	constexpr size_t benchmarkSettleFrameCount = 30u; // Statistics lag behind by the frames in flight
+	constexpr size_t benchmarkMeasuredFrameCount = 300u;
+	constexpr size_t headlessWarmupFrameCount = 60u;
+	constexpr size_t headlessMeasuredFrameCount = 600u;
+	constexpr float	 headlessTimeStep = 1.0f / 90.0f; // Scene time advances at the display rate of a headset
+	constexpr float	 headlessOrbitDuration = 20.0f;	   // Seconds for the camera to circle the ruins once
+
+	const std::string foveationArgument = "--foveation=";
+
+	// Indexed by EFoveationLevel, also the values of the foveation argument
+	constexpr std::array<const char*, static_cast<size_t>(EFoveationLevel::Count)> foveationLevelNames{ "off", "low", "medium", "high" };
+} // namespace Spectre
+
+namespace
+{
+	// Circles the ruins at standing eye height, looking at their center and bobbing a little so the view keeps changing
+	glm::mat4 GetScriptedHeadPose(float time)
+	{
+		const glm::vec3 center{ 0.0f, 1.0f, -4.0f };
+		const float		angle{ glm::two_pi<float>() * time / Spectre::headlessOrbitDuration };
+		const glm::vec3 position{ center.x + 7.0f * glm::sin(angle), 1.7f + 0.2f * glm::sin(3.0f * angle), center.z + 7.0f * glm::cos(angle) };
+		return glm::inverse(glm::lookAt(position, center, { 0.0f, 1.0f, 0.0f }));
+	}
+
+	double GetPercentile(const std::vector<double>& sortedValues, double percentile)
+	{
+		const size_t index{ static_cast<size_t>(percentile / 100.0 * static_cast<double>(sortedValues.size() - 1u) + 0.5) };
+		return sortedValues.at(index);
+	}
+} // namespace
+
+App::App(const std::vector<std::string>& arguments)
+{
+	for (const std::string& argument : arguments)
+	{
+		if (argument == "--prepass-benchmark")
+		{
+			m_IsDepthPrepassBenchmark = true;
+		}
+		else if (argument == "--headless")
+		{
+			m_IsHeadless = true;
+		}
+		else if (argument.rfind(Spectre::foveationArgument, 0u) == 0u)
+		{
+			const std::string levelName{ argument.substr(Spectre::foveationArgument.size()) };
+			const auto		  level{ std::find(Spectre::foveationLevelNames.begin(), Spectre::foveationLevelNames.end(), levelName) };
+			if (level == Spectre::foveationLevelNames.end())
+			{
+				std::cerr << "Ignoring unknown foveation level \"" << levelName << "\"" << std::endl;
+				continue;
+			}
+			m_FoveationLevel = static_cast<EFoveationLevel>(level - Spectre::foveationLevelNames.begin());
+		}
+		else
+		{
+			std::cerr << "Ignoring unknown argument \"" << argument << "\"" << std::endl;
+		}
+	}
+}
 
 App::~App()
 {
@@ -22,6 +98,13 @@ App::~App()
 
 int App::Run()
 {
+	SPECTRE_PROFILE_THREAD("Main");
+
+	if (m_IsHeadless)
+	{
+		return RunHeadless();
+	}
+
 	VulkanDevice device;
 	VulkanWindow window(&device);
 
@@ -30,75 +113,40 @@ int App::Run()
 	Headset		headset(&device);
 	Controllers controllers(device.GetXrInstance(), headset.GetXrSession());
 
-	Model				gridModel, ruinsModel, carModelLeft, carModelRight, beetleModel, bikeModel, handModelLeft, handModelRight, planeModelLeft, planeModelRight, squareModel, sunModel;
-	std::vector<Model*> models{ &gridModel, &ruinsModel, &carModelLeft, &carModelRight, &sunModel, &beetleModel, &bikeModel, &handModelLeft, &handModelRight, &planeModelLeft, &planeModelRight, &squareModel };
-
-	Material gridMaterial, diffuseMaterial, transparentMaterial, material2D, sunMaterial = {};
-	gridMaterial.vertShaderName = "shaders/Grid.vert.spv";
-	gridMaterial.fragShaderName = "shaders/Grid.frag.spv";
-	gridMaterial.dynamicUniformData.colorMultiplier = glm::vec4(1.0f);
-
-	diffuseMaterial.vertShaderName = "shaders/Diffuse.vert.spv";
-	diffuseMaterial.fragShaderName = "shaders/Diffuse.frag.spv";
-	diffuseMaterial.dynamicUniformData.colorMultiplier = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-
-	sunMaterial.vertShaderName = "shaders/Illumination.vert.spv";
-	sunMaterial.fragShaderName = "shaders/Illumination.frag.spv";
-	sunMaterial.dynamicUniformData.colorMultiplier = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
-
-	transparentMaterial.vertShaderName = "shaders/DiffuseTransparent.vert.spv";
-	transparentMaterial.fragShaderName = "shaders/DiffuseTransparent.frag.spv";
-	transparentMaterial.dynamicUniformData.colorMultiplier = glm::vec4(0.0f, 0.8f, 0.f, 0.66f);
-	transparentMaterial.pipelineData.cullMode = VkCullModeFlagBits::VK_CULL_MODE_NONE;
-
-	material2D.vertShaderName = "shaders/Diffuse2D.vert.spv";
-	material2D.fragShaderName = "shaders/Diffuse2D.frag.spv";
-	material2D.dynamicUniformData.colorMultiplier = glm::vec4(1.0f, 0.0f, 0.1f, 0.66f);
-	material2D.pipelineData.depthTestEnable = VK_FALSE;
-	material2D.pipelineData.depthWriteEnable = VK_FALSE;
-	std::vector<Material*> materials{ &gridMaterial, &diffuseMaterial, &transparentMaterial, &material2D, &sunMaterial };
-
-	GameObject				 grid{ &gridModel, &gridMaterial, "grid" };
-	GameObject				 ruins{ &ruinsModel, &diffuseMaterial, "ruins" };
-	GameObject				 carLeft{ &carModelLeft, &diffuseMaterial, "carLeft" };
-	GameObject				 carRight{ &carModelRight, &diffuseMaterial, "carRight" };
-	GameObject				 sun{ &sunModel, &sunMaterial, "sun" };
-	GameObject				 beetle{ &beetleModel, &diffuseMaterial, "beetle" };
-	GameObject				 bike{ &bikeModel, &transparentMaterial, "bike" };
-	GameObject				 handLeft{ &handModelLeft, &diffuseMaterial, "handLeft" };
-	GameObject				 handRight{ &handModelRight, &diffuseMaterial, "handRight" };
-	GameObject				 planeLeft{ &planeModelLeft, &material2D, "planeLeft", glm::vec2{ -4.0f, -4.0f } };
-	GameObject				 planeRight{ &planeModelRight, &material2D, "planeRight", glm::vec2{ 4.0f, 4.0f } };
-	GameObject				 square{ &squareModel, &material2D, "square", glm::vec2{ 4.0f, 4.0f } };
-	std::vector<GameObject*> gameObjects = { &grid, &ruins, &carLeft, &carRight, &sun, &beetle, &bike, &handLeft, &handRight, &planeLeft, &planeRight, &square };
-
-	carLeft.WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { -3.5f, 0.0f, -7.0f }), glm::radians(75.0f), { 0.0f, 1.0f, 0.0f });
-	carRight.WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { 8.0f, 0.0f, -15.0f }), glm::radians(-15.0f), { 0.0f, 1.0f, 0.0f });
-	beetle.WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { -3.5f, 0.0f, -0.5f }), glm::radians(-125.0f), { 0.0f, 1.0f, 0.0f });
-
-	MeshData* meshData{ new MeshData };
-	meshData->LoadModel("models/Grid.obj", MeshData::Color::FromNormals, models, 1u);
-	meshData->LoadModel("models/Ruins.obj", MeshData::Color::White, models, 1u);
-	meshData->LoadModel("models/Car.obj", MeshData::Color::White, models, 3u);
-	meshData->LoadModel("models/Beetle.obj", MeshData::Color::White, models, 1u);
-	meshData->LoadModel("models/Bike.obj", MeshData::Color::White, models, 1u);
-	meshData->LoadModel("models/Hand.obj", MeshData::Color::White, models, 2u);
-	meshData->LoadModel("models/Plane.obj", MeshData::Color::White, models, 2u);
-	meshData->CreateSquare(models, 1u);
-
-	VulkanRenderer renderer(&device, &headset, meshData, materials, gameObjects);
+	DemoScene scene;
+	MeshData* meshData{ scene.LoadMeshData() };
+	VulkanRenderer renderer(&device, &headset, meshData, scene.GetMaterials(), scene.GetGameObjects());
+	renderer.SetFoveationLevel(m_FoveationLevel);
 	delete meshData;
 
 	window.Connect(&headset, &renderer);
 	InputHandler::GetInstance().Init(&controllers, &headset);
 
+	// Both halves of the benchmark have to draw with the same pipelines
+	if (m_IsDepthPrepassBenchmark)
+	{
+		if (!device.SupportsPipelineStatisticsQuery())
+		{
+			utils::ThrowError(EError::FeatureNotSupported, "Vulkan physical device feature \"pipelineStatisticsQuery\"");
+		}
+		renderer.WaitForPipelines();
+		renderer.SetDepthPrepassEnabled(false);
+		std::cout << "Depth prepass benchmark: measuring " << Spectre::benchmarkMeasuredFrameCount << " frames without and with the depth prepass" << std::endl;
+	}
+
 	// Main loop
+	bool isBenchmarkFinished{ false };
 	Timer::GetInstance().Start();
-	while (!headset.IsExitRequested() && !window.IsExitRequested())
+	while (!headset.IsExitRequested() && !window.IsExitRequested() && !isBenchmarkFinished)
 	{
+		SPECTRE_PROFILE_ZONE("Frame");
 		Timer::GetInstance().Update();
 
 		window.ProcessWindowEvents();
+		if (!m_IsDepthPrepassBenchmark)
+		{
+			HandleRendererToggles(window, renderer);
+		}
 
 		uint32_t						swapchainImageIndex;
 		const Headset::BeginFrameResult frameResult{ headset.BeginFrame(swapchainImageIndex) };
@@ -118,20 +166,23 @@ int App::Run()
 			time += Timer::GetInstance().GetDeltaTime();
 
 			// Update
-			LightSystem::GetInstance().Update(&sun);
 			InputHandler::GetInstance().Update();
-			UpdateControllers(headset, controllers, handRight, handLeft);
-			UpdateGameObjects(gameObjects, headset);
-			UpdateObjects(time, bike);
+			UpdateControllers(headset, controllers, scene.GetHandRight(), scene.GetHandLeft());
+			scene.Update(time, headset.worldMatrix);
 
 			// Render
-			renderer.Render(headset.cameraMatrix, swapchainImageIndex, time, LightSystem::GetInstance().GetLightDirection());
+			renderer.Render(headset.cameraMatrix, swapchainImageIndex, time, LightSystem::GetInstance().GetLightDirection(), LightSystem::GetInstance().GetLights());
 
 			// Present
-			if (!PresentImage(window, swapchainImageIndex, renderer))
+			if (!PresentImage(window, renderer))
 			{
 				return EXIT_FAILURE;
 			}
+
+			if (m_IsDepthPrepassBenchmark)
+			{
+				isBenchmarkFinished = !UpdateDepthPrepassBenchmark(renderer);
+			}
 		}
 
 		if (frameResult == Headset::BeginFrameResult::RenderFully || frameResult == Headset::BeginFrameResult::SkipRender)
@@ -146,9 +197,63 @@ int App::Run()
 	return EXIT_SUCCESS;
 }
 
-int App::PresentImage(VulkanWindow& window, const uint32_t& swapchainImageIndex, VulkanRenderer& renderer)
+int App::RunHeadless()
 {
-	VulkanWindow::RenderResult windowResult{ window.Render(swapchainImageIndex) };
+	VulkanDevice device(true);
+	device.CreateHeadlessDevice();
+
+	HeadlessView view(&device);
+	DemoScene	 scene;
+	MeshData*	 meshData{ scene.LoadMeshData() };
+
+	VulkanRenderer renderer(&device, &view, meshData, scene.GetMaterials(), scene.GetGameObjects());
+	renderer.SetFoveationLevel(m_FoveationLevel);
+	delete meshData;
+
+	// Pipelines that are still compiling would be drawn with the fallback and make the first frames cheaper
+	renderer.WaitForPipelines();
+	std::cout << "Headless: rendering " << Spectre::headlessWarmupFrameCount << " warmup and " << Spectre::headlessMeasuredFrameCount << " measured frames at " << Spectre::headlessEyeResolution.width << "x" << Spectre::headlessEyeResolution.height << " per eye, foveation " << (renderer.IsFoveationEnabled() ? Spectre::foveationLevelNames.at(static_cast<size_t>(m_FoveationLevel)) : "off") << std::endl;
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(Spectre::headlessMeasuredFrameCount);
+
+	Timer::GetInstance().Start();
+	for (size_t frameIndex = 0u; frameIndex < Spectre::headlessWarmupFrameCount + Spectre::headlessMeasuredFrameCount; ++frameIndex)
+	{
+		SPECTRE_PROFILE_ZONE("Frame");
+		const std::chrono::steady_clock::time_point frameBegin{ std::chrono::steady_clock::now() };
+		Timer::GetInstance().Update();
+
+		// A fixed time step makes every run follow the same path, no matter how fast the device renders
+		const float		time{ static_cast<float>(frameIndex) * Spectre::headlessTimeStep };
+		const glm::mat4 headWorldMatrix{ GetScriptedHeadPose(time) };
+		view.SetHeadPose(headWorldMatrix);
+		scene.Update(time, headWorldMatrix);
+
+		// The frame time includes waiting for the frame in flight, so it is bound by the GPU once that is the slower side
+		renderer.Render(glm::mat4(1.0f), view.AcquireImage(), time, LightSystem::GetInstance().GetLightDirection(), LightSystem::GetInstance().GetLights());
+		renderer.Submit(false);
+
+		if (frameIndex >= Spectre::headlessWarmupFrameCount)
+		{
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameBegin).count());
+		}
+	}
+
+	device.Sync();
+	Timer::GetInstance().Stop();
+
+	std::vector<double> sortedFrameTimes{ frameTimes };
+	std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+	const double averageFrameTime{ std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0) / static_cast<double>(frameTimes.size()) };
+	std::cout << "Headless frame times over " << frameTimes.size() << " frames: average " << averageFrameTime << " ms (" << 1000.0 / averageFrameTime << " fps), min " << sortedFrameTimes.front() << " ms, median " << GetPercentile(sortedFrameTimes, 50.0)
+			  << " ms, 95th percentile " << GetPercentile(sortedFrameTimes, 95.0) << " ms, 99th percentile " << GetPercentile(sortedFrameTimes, 99.0) << " ms, max " << sortedFrameTimes.back() << " ms" << std::endl;
+	return EXIT_SUCCESS;
+}
+
+int App::PresentImage(VulkanWindow& window, VulkanRenderer& renderer)
+{
+	VulkanWindow::RenderResult windowResult{ window.Render() };
 	if (windowResult == VulkanWindow::RenderResult::ThrowError)
 	{
 		return false;
@@ -165,15 +270,99 @@ int App::PresentImage(VulkanWindow& window, const uint32_t& swapchainImageIndex,
 	return true;
 }
 
-void App::UpdateGameObjects(std::vector<GameObject*>& gameObjects, Headset& headset)
+void App::HandleRendererToggles(const VulkanWindow& window, VulkanRenderer& renderer)
 {
-	for (auto& object : gameObjects)
+	// Toggle when the key is released so holding it down doesn't flip the state every frame
+	const bool isDepthPrepassKeyPressed{ glfwGetKey(window.GetWindow(), Spectre::depthPrepassToggleKey) == GLFW_PRESS };
+	if (m_WasDepthPrepassKeyPressed && !isDepthPrepassKeyPressed)
+	{
+		renderer.SetDepthPrepassEnabled(!renderer.IsDepthPrepassEnabled());
+		std::cout << "Depth prepass " << (renderer.IsDepthPrepassEnabled() ? "enabled" : "disabled") << std::endl;
+	}
+	m_WasDepthPrepassKeyPressed = isDepthPrepassKeyPressed;
+
+	// A resting sun lets the static shadow casters stay cached
+	const bool isSunPauseKeyPressed{ glfwGetKey(window.GetWindow(), Spectre::sunPauseToggleKey) == GLFW_PRESS };
+	if (m_WasSunPauseKeyPressed && !isSunPauseKeyPressed)
+	{
+		LightSystem& lightSystem{ LightSystem::GetInstance() };
+		lightSystem.SetSunPaused(!lightSystem.IsSunPaused());
+		std::cout << "Sun " << (lightSystem.IsSunPaused() ? "paused" : "resumed") << std::endl;
+	}
+	m_WasSunPauseKeyPressed = isSunPauseKeyPressed;
+
+	// Compare the draw queue times with and without async compute, they are reported on exit
+	const bool isAsyncComputeKeyPressed{ glfwGetKey(window.GetWindow(), Spectre::asyncComputeToggleKey) == GLFW_PRESS };
+	if (m_WasAsyncComputeKeyPressed && !isAsyncComputeKeyPressed)
+	{
+		renderer.SetAsyncComputeEnabled(!renderer.IsAsyncComputeEnabled());
+		std::cout << "Async compute " << (renderer.IsAsyncComputeEnabled() ? "enabled" : "disabled or not supported") << std::endl;
+	}
+	m_WasAsyncComputeKeyPressed = isAsyncComputeKeyPressed;
+
+	// Dumps the most recent CPU zones of every thread, the file is overwritten on every dump
+	const bool isCpuTraceKeyPressed{ glfwGetKey(window.GetWindow(), Spectre::cpuTraceDumpKey) == GLFW_PRESS };
+	if (m_WasCpuTraceKeyPressed && !isCpuTraceKeyPressed)
+	{
+		CpuProfiler::GetInstance().WriteChromeTrace(Spectre::cpuTraceFilename);
+	}
+	m_WasCpuTraceKeyPressed = isCpuTraceKeyPressed;
+
+	// Cycles through the foveation levels, the shaded pixels are compared with the fragment shader invocations of the eye passes
+	const bool isFoveationKeyPressed{ glfwGetKey(window.GetWindow(), Spectre::foveationToggleKey) == GLFW_PRESS };
+	if (m_WasFoveationKeyPressed && !isFoveationKeyPressed)
 	{
-		object->Update(headset);
+		uint64_t fragmentShaderInvocationCount{ 0u };
+		if (renderer.GetFragmentShaderInvocationCount(fragmentShaderInvocationCount))
+		{
+			std::cout << "Foveation " << Spectre::foveationLevelNames.at(static_cast<size_t>(renderer.GetFoveationLevel())) << ": " << fragmentShaderInvocationCount << " fragment shader invocations in the eye passes of the last frame" << std::endl;
+		}
+
+		const size_t levelIndex{ (static_cast<size_t>(renderer.GetFoveationLevel()) + 1u) % Spectre::foveationLevelNames.size() };
+		renderer.SetFoveationLevel(static_cast<EFoveationLevel>(levelIndex));
+		std::cout << "Foveation " << Spectre::foveationLevelNames.at(levelIndex) << (levelIndex > 0u && !renderer.IsFoveationEnabled() ? " (not supported without dynamic rendering)" : "") << std::endl;
 	}
+	m_WasFoveationKeyPressed = isFoveationKeyPressed;
 }
 
-void App::UpdateObjects(float time, GameObject& bikeModel) { bikeModel.WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { 0.5f, 0.0f, -4.5f }), time * 0.2f, { 0.0f, 1.0f, 0.0f }); }
+bool App::UpdateDepthPrepassBenchmark(VulkanRenderer& renderer)
+{
+	constexpr size_t phaseFrameCount{ Spectre::benchmarkSettleFrameCount + Spectre::benchmarkMeasuredFrameCount };
+	const bool		 isDepthPrepassPhase{ m_BenchmarkFrameIndex >= phaseFrameCount };
+
+	// Skip the first frames of each phase, their statistics may still belong to the previous phase
+	uint64_t fragmentShaderInvocationCount{ 0u };
+	if (m_BenchmarkFrameIndex % phaseFrameCount >= Spectre::benchmarkSettleFrameCount && renderer.GetFragmentShaderInvocationCount(fragmentShaderInvocationCount))
+	{
+		m_BenchmarkInvocationSum += fragmentShaderInvocationCount;
+		++m_BenchmarkSampleCount;
+	}
+
+	++m_BenchmarkFrameIndex;
+	if (m_BenchmarkFrameIndex % phaseFrameCount != 0u)
+	{
+		return true;
+	}
+
+	const double averageInvocationCount{ m_BenchmarkSampleCount > 0u ? static_cast<double>(m_BenchmarkInvocationSum) / static_cast<double>(m_BenchmarkSampleCount) : 0.0 };
+	m_BenchmarkInvocationSum = 0u;
+	m_BenchmarkSampleCount = 0u;
+
+	if (!isDepthPrepassPhase)
+	{
+		m_BenchmarkAverageWithoutPrepass = averageInvocationCount;
+		renderer.SetDepthPrepassEnabled(true);
+		return true;
+	}
+
+	std::cout << "Depth prepass benchmark: " << static_cast<uint64_t>(m_BenchmarkAverageWithoutPrepass) << " fragment shader invocations per frame without, " << static_cast<uint64_t>(averageInvocationCount) << " with the depth prepass";
+	if (m_BenchmarkAverageWithoutPrepass > 0.0)
+	{
+		std::cout << " (" << 100.0 * (1.0 - averageInvocationCount / m_BenchmarkAverageWithoutPrepass) << "% fewer)";
+	}
+	std::cout << std::endl;
+	return false;
+}
 
 void App::UpdateControllers(Headset& headset, Controllers& controllers, GameObject& handModelRight, GameObject& handModelLeft)
 {
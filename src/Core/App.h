@@ -1,7 +1,11 @@
 #include "../Misc/Timer.h"
 #include "../VR/Headset.h"
+#include "../VulkanBase/Foveation.h"
 #include "../VulkanBase/VulkanWindow.h"
 
+#include <string>
+#include <vector>
+
 class Controllers;
 struct GameObject;
 
@@ -13,6 +17,7 @@ public:
 	static constexpr int m_HEIGHT{ 600 };
 
 	App(){};
+	explicit App(const std::vector<std::string>& arguments);
 	~App();
 	App(const App&) = delete;
 	App(App&&) = delete;
@@ -22,8 +27,25 @@ public:
 	int Run();
 
 private:
+	// Renders a fixed number of frames along a scripted camera path into offscreen images and reports the frame times
+	int	 RunHeadless();
 	void UpdateControllers(Headset& headset, Controllers& controllers, GameObject& handModelRight, GameObject& handModelLeft);
-	void UpdateObjects(float time, GameObject& bikeModel);
-	int	 PresentImage(VulkanWindow& window, const uint32_t& swapchainImageIndex, VulkanRenderer& renderer);
-	void UpdateGameObjects(std::vector<GameObject*>& gameObjects, Headset& headset);
+	int	 PresentImage(VulkanWindow& window, VulkanRenderer& renderer);
+	void HandleRendererToggles(const VulkanWindow& window, VulkanRenderer& renderer);
+	bool UpdateDepthPrepassBenchmark(VulkanRenderer& renderer);
+
+	bool	 m_IsHeadless{ false }; // Needs neither a headset nor a window
+	// Renders a fixed number of frames without and with the depth prepass and reports the fragment shader invocations
+	bool	 m_IsDepthPrepassBenchmark{ false };
+	bool	 m_WasDepthPrepassKeyPressed{ false };
+	bool	 m_WasSunPauseKeyPressed{ false };
+	bool	 m_WasAsyncComputeKeyPressed{ false };
+	bool	 m_WasCpuTraceKeyPressed{ false };
+	bool	 m_WasFoveationKeyPressed{ false };
+	size_t	 m_BenchmarkFrameIndex{ 0u };
+	size_t	 m_BenchmarkSampleCount{ 0u };
+	uint64_t m_BenchmarkInvocationSum{ 0u };
+	double	 m_BenchmarkAverageWithoutPrepass{ 0.0 };
+
+	EFoveationLevel m_FoveationLevel{ EFoveationLevel::Off };
 };
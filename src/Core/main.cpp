@@ -1,10 +1,12 @@
 #include "App.h"
 #include <iostream>
+#include <string>
+#include <vector>
 
-int main()
+int main(int argc, char* argv[])
 {
 
-	App app{};
+	App app{ std::vector<std::string>(argv + 1, argv + argc) };
 	try
 	{
 		app.Run();
@@ -1,6 +1,7 @@
 #include "InputHandler.h"
 #include <limits>
 
+#include "../Misc/CpuProfiler.h"
 #include "../Misc/Timer.h"
 #include "../Misc/Utils.h"
 
@@ -108,6 +109,8 @@ void InputHandler::HandleMouse(GLFWwindow* window, Headset& headset)
 
 void InputHandler::Update()
 {
+	SPECTRE_PROFILE_ZONE("InputHandler::Update");
+
 	// Update the actions
 	const auto& paths{ m_Controllers->GetPaths() };
 	for (size_t controllerIndex = 0u; controllerIndex < m_Controllers->GetNumberOfController(); ++controllerIndex)
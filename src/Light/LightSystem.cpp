@@ -13,6 +13,11 @@ void LightSystem::Update(GameObject* sun) {
 
 void LightSystem::UpdateAngle()
 {
+	if (m_IsSunPaused)
+	{
+		return;
+	}
+
 	m_Angle += Timer::GetInstance().GetDeltaTime() * m_Speed;
 	if (m_Angle >= 360)
 	{
@@ -29,4 +34,24 @@ void LightSystem::RotateSun(GameObject* sun)
 	sunPosition = rotationMatrix * sunPosition;
 
 	sun->WorldMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(sunPosition));
+}
+
+size_t LightSystem::AddPointLight(const glm::vec3& position, float range, const glm::vec3& color, float intensity)
+{
+	Light light{};
+	light.positionRange = glm::vec4(position, range);
+	light.colorIntensity = glm::vec4(color, intensity);
+	m_Lights.push_back(light);
+	return m_Lights.size() - 1u;
+}
+
+size_t LightSystem::AddSpotLight(const glm::vec3& position, const glm::vec3& direction, float range, float innerConeAngle, float outerConeAngle, const glm::vec3& color, float intensity)
+{
+	Light light{};
+	light.positionRange = glm::vec4(position, range);
+	light.colorIntensity = glm::vec4(color, intensity);
+	light.direction = glm::vec4(glm::normalize(direction), 1.0f);
+	light.spotCosines = glm::vec4(glm::cos(glm::radians(innerConeAngle)), glm::cos(glm::radians(outerConeAngle)), 0.0f, 0.0f);
+	m_Lights.push_back(light);
+	return m_Lights.size() - 1u;
 }
\ No newline at end of file
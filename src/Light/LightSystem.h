@@ -7,22 +7,47 @@
 #include <glm/ext/vector_float3.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/trigonometric.hpp>
+#include <vector>
 
 struct GameObject;
 
+/*
+ * The light system drives the directional sun and owns the local point and spot lights. Local lights are uploaded as
+ * they are to a storage buffer every frame, where a compute pass sorts them into the clusters of the view frustum.
+ */
 class LightSystem : public Singleton<LightSystem>
 {
 public:
+	// Matches the Light struct in shaders/Lighting.glsl
+	struct Light
+	{
+		glm::vec4 positionRange;  // xyz = world position, w = distance at which the light fades out
+		glm::vec4 colorIntensity; // rgb = color, a = intensity
+		glm::vec4 direction;	  // xyz = spot direction, w = 1 for spot lights and 0 for point lights
+		glm::vec4 spotCosines;	  // x = cosine of the inner cone, y = cosine of the outer cone
+	};
+
 	void	  Update(GameObject* sun);
 	glm::vec3 GetLightDirection() { return m_LightDirection; }
+	void	  SetSunPaused(bool isPaused) { m_IsSunPaused = isPaused; }
+	bool	  IsSunPaused() const { return m_IsSunPaused; }
+
+	size_t					  AddPointLight(const glm::vec3& position, float range, const glm::vec3& color, float intensity);
+	size_t					  AddSpotLight(const glm::vec3& position, const glm::vec3& direction, float range, float innerConeAngle, float outerConeAngle, const glm::vec3& color, float intensity);
+	void					  SetLightPosition(size_t lightIndex, const glm::vec3& position) { m_Lights.at(lightIndex).positionRange = glm::vec4(position, m_Lights.at(lightIndex).positionRange.w); }
+	void					  ClearLights() { m_Lights.clear(); }
+	const std::vector<Light>& GetLights() const { return m_Lights; }
 
 private:
 	glm::vec3 m_LightOrigin{ 0, 5, 20 };
 	glm::vec3 m_MapCenter{ 0, 0, 0 };
 	glm::vec3 m_LightDirection{ 1.0f, -1.0f, -1.0f };
 
+	std::vector<Light> m_Lights;
+
 	float m_Angle{ 0 };
 	float m_Speed{ 10 };
+	bool  m_IsSunPaused{ false };
 
 	void UpdateAngle();
 	void RotateSun(GameObject* sun);
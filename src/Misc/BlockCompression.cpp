@@ -0,0 +1,440 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+	constexpr size_t texelSize = 4u;									 // RGBA8
+	constexpr size_t blockTexelCount = 16u;								 // 4x4
+	constexpr size_t bc1BlockSize = 8u, bc7BlockSize = 16u;				 // Bytes
+	constexpr size_t powerIterationCount = 8u;							 // Converges well before this for 16 texels
+	constexpr float	 endpointInset = 1.0f / 16.0f;						 // Of the range, pulls the endpoints in from the outermost texels
+	constexpr std::array<uint32_t, 16u> bc7Weights{ 0u, 4u, 9u, 13u, 17u, 21u, 26u, 30u, 34u, 38u, 43u, 47u, 51u, 55u, 60u, 64u }; // 4-bit indices
+
+	// Endpoints of the line through the texels along their principal axis
+	template <size_t ChannelCount> void FitLine(const uint8_t* texels, std::array<float, ChannelCount>& outLow, std::array<float, ChannelCount>& outHigh)
+	{
+		std::array<float, ChannelCount> mean{}, minimum{}, maximum{};
+		minimum.fill(255.0f);
+		for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+		{
+			for (size_t channel = 0u; channel < ChannelCount; ++channel)
+			{
+				const float value{ static_cast<float>(texels[texel * texelSize + channel]) };
+				mean.at(channel) += value / static_cast<float>(blockTexelCount);
+				minimum.at(channel) = std::min(minimum.at(channel), value);
+				maximum.at(channel) = std::max(maximum.at(channel), value);
+			}
+		}
+
+		std::array<std::array<float, ChannelCount>, ChannelCount> covariance{};
+		for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+		{
+			for (size_t row = 0u; row < ChannelCount; ++row)
+			{
+				for (size_t column = 0u; column < ChannelCount; ++column)
+				{
+					covariance.at(row).at(column) += (texels[texel * texelSize + row] - mean.at(row)) * (texels[texel * texelSize + column] - mean.at(column));
+				}
+			}
+		}
+
+		// Power iteration, starting from the diagonal of the bounding box
+		std::array<float, ChannelCount> axis{};
+		for (size_t channel = 0u; channel < ChannelCount; ++channel)
+		{
+			axis.at(channel) = maximum.at(channel) - minimum.at(channel);
+		}
+		for (size_t iteration = 0u; iteration < powerIterationCount; ++iteration)
+		{
+			std::array<float, ChannelCount> product{};
+			float							length{ 0.0f };
+			for (size_t row = 0u; row < ChannelCount; ++row)
+			{
+				for (size_t column = 0u; column < ChannelCount; ++column)
+				{
+					product.at(row) += covariance.at(row).at(column) * axis.at(column);
+				}
+				length += product.at(row) * product.at(row);
+			}
+
+			// A block of a single color has no axis, the endpoints collapse onto the mean
+			if (length <= 0.0f)
+			{
+				break;
+			}
+
+			for (size_t channel = 0u; channel < ChannelCount; ++channel)
+			{
+				axis.at(channel) = product.at(channel) / std::sqrt(length);
+			}
+		}
+
+		float lowProjection{ 0.0f }, highProjection{ 0.0f };
+		for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+		{
+			float projection{ 0.0f };
+			for (size_t channel = 0u; channel < ChannelCount; ++channel)
+			{
+				projection += (texels[texel * texelSize + channel] - mean.at(channel)) * axis.at(channel);
+			}
+			lowProjection = std::min(lowProjection, projection);
+			highProjection = std::max(highProjection, projection);
+		}
+
+		const float inset{ (highProjection - lowProjection) * endpointInset };
+		for (size_t channel = 0u; channel < ChannelCount; ++channel)
+		{
+			outLow.at(channel) = std::clamp(mean.at(channel) + axis.at(channel) * (lowProjection + inset), 0.0f, 255.0f);
+			outHigh.at(channel) = std::clamp(mean.at(channel) + axis.at(channel) * (highProjection - inset), 0.0f, 255.0f);
+		}
+	}
+
+	uint16_t PackRgb565(const std::array<float, 3u>& color)
+	{
+		const uint32_t red{ static_cast<uint32_t>(std::lround(color.at(0u) * 31.0f / 255.0f)) };
+		const uint32_t green{ static_cast<uint32_t>(std::lround(color.at(1u) * 63.0f / 255.0f)) };
+		const uint32_t blue{ static_cast<uint32_t>(std::lround(color.at(2u) * 31.0f / 255.0f)) };
+		return static_cast<uint16_t>((red << 11u) | (green << 5u) | blue);
+	}
+
+	std::array<uint32_t, 3u> UnpackRgb565(uint16_t color)
+	{
+		const uint32_t red{ (color >> 11u) & 31u }, green{ (color >> 5u) & 63u }, blue{ color & 31u };
+		return { (red << 3u) | (red >> 2u), (green << 2u) | (green >> 4u), (blue << 3u) | (blue >> 2u) };
+	}
+
+	// BC7 fields are packed from the least significant bit of the block on
+	class BitWriter final
+	{
+	public:
+		explicit BitWriter(uint8_t* data) : m_Data(data) { std::fill(m_Data, m_Data + bc7BlockSize, uint8_t{ 0u }); }
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0u; bit < bitCount; ++bit, ++m_Position)
+			{
+				m_Data[m_Position / 8u] |= static_cast<uint8_t>(((value >> bit) & 1u) << (m_Position % 8u));
+			}
+		}
+
+	private:
+		uint8_t* m_Data{ nullptr };
+		uint32_t m_Position{ 0u };
+	};
+
+	class BitReader final
+	{
+	public:
+		explicit BitReader(const uint8_t* data) : m_Data(data) {}
+
+		uint32_t Read(uint32_t bitCount)
+		{
+			uint32_t value{ 0u };
+			for (uint32_t bit = 0u; bit < bitCount; ++bit, ++m_Position)
+			{
+				value |= ((m_Data[m_Position / 8u] >> (m_Position % 8u)) & 1u) << bit;
+			}
+			return value;
+		}
+
+	private:
+		const uint8_t* m_Data{ nullptr };
+		uint32_t	   m_Position{ 0u };
+	};
+} // namespace
+
+bool BlockCompression::IsCompressed(VkFormat format) { return format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK; }
+
+VkDeviceSize BlockCompression::GetLevelSize(VkFormat format, VkExtent2D extent)
+{
+	const VkDeviceSize blockCount{ static_cast<VkDeviceSize>((extent.width + blockSize - 1u) / blockSize) * ((extent.height + blockSize - 1u) / blockSize) };
+	switch (format)
+	{
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		return blockCount * bc1BlockSize;
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return blockCount * bc7BlockSize;
+	default:
+		return static_cast<VkDeviceSize>(extent.width) * extent.height * texelSize;
+	}
+}
+
+std::vector<uint8_t> BlockCompression::Encode(VkFormat format, const std::vector<uint8_t>& texels, VkExtent2D extent)
+{
+	const uint32_t		 blockColumnCount{ (extent.width + blockSize - 1u) / blockSize }, blockRowCount{ (extent.height + blockSize - 1u) / blockSize };
+	const size_t		 encodedBlockSize{ format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ? bc1BlockSize : bc7BlockSize };
+	std::vector<uint8_t> blocks(static_cast<size_t>(GetLevelSize(format, extent)));
+	for (uint32_t blockRow = 0u; blockRow < blockRowCount; ++blockRow)
+	{
+		for (uint32_t blockColumn = 0u; blockColumn < blockColumnCount; ++blockColumn)
+		{
+			std::array<uint8_t, blockTexelCount * texelSize> blockTexels;
+			for (uint32_t y = 0u; y < blockSize; ++y)
+			{
+				for (uint32_t x = 0u; x < blockSize; ++x)
+				{
+					const uint32_t column{ std::min(blockColumn * blockSize + x, extent.width - 1u) }, row{ std::min(blockRow * blockSize + y, extent.height - 1u) };
+					std::copy_n(&texels.at((static_cast<size_t>(row) * extent.width + column) * texelSize), texelSize, &blockTexels.at((y * blockSize + x) * texelSize));
+				}
+			}
+
+			uint8_t* block{ &blocks.at((static_cast<size_t>(blockRow) * blockColumnCount + blockColumn) * encodedBlockSize) };
+			if (format == VK_FORMAT_BC1_RGB_SRGB_BLOCK)
+			{
+				EncodeBc1Block(blockTexels.data(), block);
+			}
+			else
+			{
+				EncodeBc7Block(blockTexels.data(), block);
+			}
+		}
+	}
+
+	return blocks;
+}
+
+std::vector<uint8_t> BlockCompression::Decode(VkFormat format, const std::vector<uint8_t>& blocks, VkExtent2D extent)
+{
+	const uint32_t		 blockColumnCount{ (extent.width + blockSize - 1u) / blockSize }, blockRowCount{ (extent.height + blockSize - 1u) / blockSize };
+	const size_t		 encodedBlockSize{ format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ? bc1BlockSize : bc7BlockSize };
+	std::vector<uint8_t> texels(static_cast<size_t>(extent.width) * extent.height * texelSize);
+	for (uint32_t blockRow = 0u; blockRow < blockRowCount; ++blockRow)
+	{
+		for (uint32_t blockColumn = 0u; blockColumn < blockColumnCount; ++blockColumn)
+		{
+			const uint8_t*									  block{ &blocks.at((static_cast<size_t>(blockRow) * blockColumnCount + blockColumn) * encodedBlockSize) };
+			std::array<uint8_t, blockTexelCount * texelSize> blockTexels;
+			if (format == VK_FORMAT_BC1_RGB_SRGB_BLOCK)
+			{
+				DecodeBc1Block(block, blockTexels.data());
+			}
+			else
+			{
+				DecodeBc7Block(block, blockTexels.data());
+			}
+
+			// Blocks at the right and bottom edge may reach past the level
+			for (uint32_t y = 0u; y < blockSize && blockRow * blockSize + y < extent.height; ++y)
+			{
+				for (uint32_t x = 0u; x < blockSize && blockColumn * blockSize + x < extent.width; ++x)
+				{
+					const size_t texel{ static_cast<size_t>(blockRow * blockSize + y) * extent.width + blockColumn * blockSize + x };
+					std::copy_n(&blockTexels.at((y * blockSize + x) * texelSize), texelSize, &texels.at(texel * texelSize));
+				}
+			}
+		}
+	}
+
+	return texels;
+}
+
+void BlockCompression::EncodeBc1Block(const uint8_t* texels, uint8_t* block)
+{
+	std::array<float, 3u> low, high;
+	FitLine<3u>(texels, low, high);
+
+	// The four color mode needs the first endpoint to be the larger one, equal endpoints make every index pick the first
+	uint16_t color0{ PackRgb565(high) }, color1{ PackRgb565(low) };
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+	}
+
+	const std::array<uint32_t, 3u>				  endpoint0{ UnpackRgb565(color0) }, endpoint1{ UnpackRgb565(color1) };
+	std::array<std::array<uint32_t, 3u>, 4u> palette{ endpoint0, endpoint1 };
+	for (size_t channel = 0u; channel < 3u; ++channel)
+	{
+		palette.at(2u).at(channel) = (2u * endpoint0.at(channel) + endpoint1.at(channel)) / 3u;
+		palette.at(3u).at(channel) = (endpoint0.at(channel) + 2u * endpoint1.at(channel)) / 3u;
+	}
+
+	uint32_t indices{ 0u };
+	if (color0 != color1)
+	{
+		for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+		{
+			uint32_t bestIndex{ 0u }, bestError{ UINT32_MAX };
+			for (uint32_t index = 0u; index < palette.size(); ++index)
+			{
+				uint32_t error{ 0u };
+				for (size_t channel = 0u; channel < 3u; ++channel)
+				{
+					const int32_t difference{ static_cast<int32_t>(texels[texel * texelSize + channel]) - static_cast<int32_t>(palette.at(index).at(channel)) };
+					error += static_cast<uint32_t>(difference * difference);
+				}
+
+				if (error < bestError)
+				{
+					bestIndex = index;
+					bestError = error;
+				}
+			}
+			indices |= bestIndex << (texel * 2u);
+		}
+	}
+
+	block[0] = static_cast<uint8_t>(color0 & 0xFFu);
+	block[1] = static_cast<uint8_t>(color0 >> 8u);
+	block[2] = static_cast<uint8_t>(color1 & 0xFFu);
+	block[3] = static_cast<uint8_t>(color1 >> 8u);
+	for (size_t byte = 0u; byte < 4u; ++byte)
+	{
+		block[4u + byte] = static_cast<uint8_t>(indices >> (byte * 8u));
+	}
+}
+
+void BlockCompression::DecodeBc1Block(const uint8_t* block, uint8_t* texels)
+{
+	const uint16_t							 color0{ static_cast<uint16_t>(block[0] | (block[1] << 8u)) }, color1{ static_cast<uint16_t>(block[2] | (block[3] << 8u)) };
+	const std::array<uint32_t, 3u>			 endpoint0{ UnpackRgb565(color0) }, endpoint1{ UnpackRgb565(color1) };
+	std::array<std::array<uint32_t, 3u>, 4u> palette{ endpoint0, endpoint1 };
+	for (size_t channel = 0u; channel < 3u; ++channel)
+	{
+		if (color0 > color1)
+		{
+			palette.at(2u).at(channel) = (2u * endpoint0.at(channel) + endpoint1.at(channel)) / 3u;
+			palette.at(3u).at(channel) = (endpoint0.at(channel) + 2u * endpoint1.at(channel)) / 3u;
+		}
+		else
+		{
+			// The three color mode, the fourth color is black without alpha in the RGB format
+			palette.at(2u).at(channel) = (endpoint0.at(channel) + endpoint1.at(channel)) / 2u;
+			palette.at(3u).at(channel) = 0u;
+		}
+	}
+
+	const uint32_t indices{ static_cast<uint32_t>(block[4] | (block[5] << 8u) | (block[6] << 16u) | (static_cast<uint32_t>(block[7]) << 24u)) };
+	for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+	{
+		const std::array<uint32_t, 3u>& color{ palette.at((indices >> (texel * 2u)) & 3u) };
+		for (size_t channel = 0u; channel < 3u; ++channel)
+		{
+			texels[texel * texelSize + channel] = static_cast<uint8_t>(color.at(channel));
+		}
+		texels[texel * texelSize + 3u] = 255u;
+	}
+}
+
+void BlockCompression::EncodeBc7Block(const uint8_t* texels, uint8_t* block)
+{
+	std::array<float, 4u> low, high;
+	FitLine<4u>(texels, low, high);
+
+	// Mode 6 stores 7 bits per channel and endpoint plus a shared lowest bit per endpoint, whichever bit lands closer wins
+	std::array<std::array<uint32_t, 4u>, 2u> quantized;
+	std::array<uint32_t, 2u>				 pBits;
+	std::array<std::array<uint32_t, 4u>, 2u> endpoints;
+	for (size_t endpoint = 0u; endpoint < 2u; ++endpoint)
+	{
+		const std::array<float, 4u>& color{ endpoint == 0u ? low : high };
+		float						 bestError{ INFINITY };
+		for (uint32_t pBit = 0u; pBit < 2u; ++pBit)
+		{
+			std::array<uint32_t, 4u> candidate;
+			float					 error{ 0.0f };
+			for (size_t channel = 0u; channel < 4u; ++channel)
+			{
+				candidate.at(channel) = static_cast<uint32_t>(std::clamp(std::lround((color.at(channel) - static_cast<float>(pBit)) / 2.0f), 0l, 127l));
+				const float difference{ static_cast<float>(candidate.at(channel) * 2u + pBit) - color.at(channel) };
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				quantized.at(endpoint) = candidate;
+				pBits.at(endpoint) = pBit;
+			}
+		}
+
+		for (size_t channel = 0u; channel < 4u; ++channel)
+		{
+			endpoints.at(endpoint).at(channel) = quantized.at(endpoint).at(channel) * 2u + pBits.at(endpoint);
+		}
+	}
+
+	std::array<uint32_t, blockTexelCount> indices;
+	for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+	{
+		uint32_t bestError{ UINT32_MAX };
+		for (uint32_t index = 0u; index < bc7Weights.size(); ++index)
+		{
+			uint32_t error{ 0u };
+			for (size_t channel = 0u; channel < 4u; ++channel)
+			{
+				const uint32_t value{ ((64u - bc7Weights.at(index)) * endpoints.at(0u).at(channel) + bc7Weights.at(index) * endpoints.at(1u).at(channel) + 32u) >> 6u };
+				const int32_t  difference{ static_cast<int32_t>(texels[texel * texelSize + channel]) - static_cast<int32_t>(value) };
+				error += static_cast<uint32_t>(difference * difference);
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				indices.at(texel) = index;
+			}
+		}
+	}
+
+	// The index of the first texel drops its top bit, so it has to be in the lower half
+	if (indices.at(0u) >= 8u)
+	{
+		std::swap(quantized.at(0u), quantized.at(1u));
+		std::swap(pBits.at(0u), pBits.at(1u));
+		for (uint32_t& index : indices)
+		{
+			index = 15u - index;
+		}
+	}
+
+	BitWriter bitWriter{ block };
+	bitWriter.Write(1u << 6u, 7u);
+	for (size_t channel = 0u; channel < 4u; ++channel)
+	{
+		bitWriter.Write(quantized.at(0u).at(channel), 7u);
+		bitWriter.Write(quantized.at(1u).at(channel), 7u);
+	}
+	bitWriter.Write(pBits.at(0u), 1u);
+	bitWriter.Write(pBits.at(1u), 1u);
+	for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+	{
+		bitWriter.Write(indices.at(texel), texel == 0u ? 3u : 4u);
+	}
+}
+
+void BlockCompression::DecodeBc7Block(const uint8_t* block, uint8_t* texels)
+{
+	// Other modes are never cooked, they decode to transparent black
+	BitReader bitReader{ block };
+	if (bitReader.Read(7u) != (1u << 6u))
+	{
+		std::fill(texels, texels + blockTexelCount * texelSize, uint8_t{ 0u });
+		return;
+	}
+
+	std::array<std::array<uint32_t, 4u>, 2u> endpoints;
+	for (size_t channel = 0u; channel < 4u; ++channel)
+	{
+		endpoints.at(0u).at(channel) = bitReader.Read(7u) << 1u;
+		endpoints.at(1u).at(channel) = bitReader.Read(7u) << 1u;
+	}
+	const std::array<uint32_t, 2u> pBits{ bitReader.Read(1u), bitReader.Read(1u) };
+	for (size_t endpoint = 0u; endpoint < 2u; ++endpoint)
+	{
+		for (uint32_t& value : endpoints.at(endpoint))
+		{
+			value |= pBits.at(endpoint);
+		}
+	}
+
+	for (size_t texel = 0u; texel < blockTexelCount; ++texel)
+	{
+		const uint32_t weight{ bc7Weights.at(bitReader.Read(texel == 0u ? 3u : 4u)) };
+		for (size_t channel = 0u; channel < 4u; ++channel)
+		{
+			texels[texel * texelSize + channel] = static_cast<uint8_t>(((64u - weight) * endpoints.at(0u).at(channel) + weight * endpoints.at(1u).at(channel) + 32u) >> 6u);
+		}
+	}
+}
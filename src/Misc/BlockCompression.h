@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Block compression encodes RGBA8 texels into BC1 or BC7 blocks of 4x4 texels and decodes them again. The encoders fit
+ * a line through the colors of each block and quantize the texels onto it, which is fast enough to cook textures on the
+ * fly and close to what offline compressors reach for smooth content. BC7 only uses mode 6, a single RGBA line with
+ * sixteen steps, so the decoder only has to understand what the encoder writes. It transcodes cooked textures for
+ * devices that can't sample the compressed formats.
+ */
+class BlockCompression final
+{
+public:
+	static constexpr uint32_t blockSize = 4u; // Texels along either axis of a block
+
+	// Compressed formats need their level extent rounded up to whole blocks
+	static bool			IsCompressed(VkFormat format);
+	static VkDeviceSize GetLevelSize(VkFormat format, VkExtent2D extent);
+
+	// Texels outside the extent are filled by repeating the last row and column of the level
+	static std::vector<uint8_t> Encode(VkFormat format, const std::vector<uint8_t>& texels, VkExtent2D extent);
+	static std::vector<uint8_t> Decode(VkFormat format, const std::vector<uint8_t>& blocks, VkExtent2D extent);
+
+private:
+	static void EncodeBc1Block(const uint8_t* texels, uint8_t* block);
+	static void DecodeBc1Block(const uint8_t* block, uint8_t* texels);
+	static void EncodeBc7Block(const uint8_t* texels, uint8_t* block);
+	static void DecodeBc7Block(const uint8_t* block, uint8_t* texels);
+};
@@ -0,0 +1,111 @@
+#include "CpuProfiler.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	struct CopiedEvent
+	{
+		const char* name{ nullptr };
+		int64_t		beginNanoseconds{ 0 };
+		int64_t		endNanoseconds{ 0 };
+	};
+} // namespace
+
+void CpuProfiler::Record(const char* name, Clock::time_point begin, Clock::time_point end)
+{
+	ThreadBuffer*  buffer{ GetThreadBuffer() };
+	const uint64_t index{ buffer->writtenCount.load(std::memory_order_relaxed) };
+
+	// Announces the overwrite before touching the slot, a concurrent dump drops it
+	buffer->startedCount.store(index + 1u, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Event& event{ buffer->events[index & (Spectre::cpuProfilerEventsPerThread - 1u)] };
+	event.name.store(name, std::memory_order_relaxed);
+	event.beginNanoseconds.store(std::chrono::duration_cast<std::chrono::nanoseconds>(begin - m_StartTime).count(), std::memory_order_relaxed);
+	event.endNanoseconds.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_StartTime).count(), std::memory_order_relaxed);
+	buffer->writtenCount.store(index + 1u, std::memory_order_release);
+}
+
+CpuProfiler::ThreadBuffer* CpuProfiler::GetThreadBuffer()
+{
+	static thread_local ThreadBuffer* threadBuffer{ nullptr };
+	if (threadBuffer)
+	{
+		return threadBuffer;
+	}
+
+	// Buffers outlive their threads so a dump after a thread has finished still contains its zones
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	ThreadBuffer&					  buffer{ m_ThreadBuffers.emplace_back() };
+	buffer.threadIndex = static_cast<uint32_t>(m_ThreadBuffers.size() - 1u);
+	buffer.threadName = "Thread " + std::to_string(buffer.threadIndex);
+	threadBuffer = &buffer;
+	return &buffer;
+}
+
+void CpuProfiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer* buffer{ GetThreadBuffer() };
+
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	buffer->threadName = name;
+}
+
+bool CpuProfiler::WriteChromeTrace(const std::string& filename)
+{
+	std::ofstream file(filename, std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "Failed to write the CPU trace to \"" << filename << "\"" << std::endl;
+		return false;
+	}
+
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	size_t							  eventCount{ 0u }, droppedEventCount{ 0u };
+	file << "{\"traceEvents\":[";
+	for (const ThreadBuffer& buffer : m_ThreadBuffers)
+	{
+		file << (buffer.threadIndex > 0u ? "," : "") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer.threadIndex << ",\"args\":{\"name\":\"" << buffer.threadName << "\"}}";
+
+		const uint64_t writtenCount{ buffer.writtenCount.load(std::memory_order_acquire) };
+		const uint64_t firstIndex{ writtenCount > Spectre::cpuProfilerEventsPerThread ? writtenCount - Spectre::cpuProfilerEventsPerThread : 0u };
+
+		std::vector<CopiedEvent> copiedEvents;
+		copiedEvents.reserve(static_cast<size_t>(writtenCount - firstIndex));
+		for (uint64_t index = firstIndex; index < writtenCount; ++index)
+		{
+			const Event& event{ buffer.events[index & (Spectre::cpuProfilerEventsPerThread - 1u)] };
+			copiedEvents.push_back({ event.name.load(std::memory_order_relaxed), event.beginNanoseconds.load(std::memory_order_relaxed), event.endNanoseconds.load(std::memory_order_relaxed) });
+		}
+
+		// Slots the thread started to overwrite while they were copied may be torn
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t startedCount{ buffer.startedCount.load(std::memory_order_relaxed) };
+		for (uint64_t index = firstIndex; index < writtenCount; ++index)
+		{
+			if (index + Spectre::cpuProfilerEventsPerThread < startedCount)
+			{
+				++droppedEventCount;
+				continue;
+			}
+
+			const CopiedEvent& event{ copiedEvents.at(static_cast<size_t>(index - firstIndex)) };
+			file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer.threadIndex << ",\"ts\":" << static_cast<double>(event.beginNanoseconds) * 1e-3
+				 << ",\"dur\":" << static_cast<double>(event.endNanoseconds - event.beginNanoseconds) * 1e-3 << "}";
+			++eventCount;
+		}
+	}
+	file << "\n]}" << std::endl;
+
+	std::cout << "Wrote " << eventCount << " CPU zone(s) of " << m_ThreadBuffers.size() << " thread(s) to \"" << filename << "\"";
+	if (droppedEventCount > 0u)
+	{
+		std::cout << ", " << droppedEventCount << " overwritten while writing were dropped";
+	}
+	std::cout << std::endl;
+	return true;
+}
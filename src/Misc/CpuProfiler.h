@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef singleton
+#include "Singleton.h"
+#define singleton
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+namespace Spectre
+{
+	constexpr size_t cpuProfilerEventsPerThread = 65536u; // Power of two, older zones are overwritten
+	const std::string cpuTraceFilename = "CpuTrace.json";
+} // namespace Spectre
+
+// Zones compile away entirely unless the build enables the CPU profiler
+#ifdef SPECTRE_CPU_PROFILER
+#define SPECTRE_PROFILER_CONCATENATE_INNER(a, b) a##b
+#define SPECTRE_PROFILER_CONCATENATE(a, b)		 SPECTRE_PROFILER_CONCATENATE_INNER(a, b)
+#define SPECTRE_PROFILE_ZONE(name)				 const CpuProfiler::Zone SPECTRE_PROFILER_CONCATENATE(profilerZone, __LINE__)(name)
+#define SPECTRE_PROFILE_THREAD(name)			 CpuProfiler::GetInstance().SetThreadName(name)
+#else
+#define SPECTRE_PROFILE_ZONE(name)	 ((void)0)
+#define SPECTRE_PROFILE_THREAD(name) ((void)0)
+#endif
+
+/*
+ * The CPU profiler records named zones of code as begin and end timestamps. Every thread writes into a ring buffer of its
+ * own without taking a lock, only the first zone of a thread registers its buffer. Dumping copies the buffers while the
+ * threads keep writing, zones that were overwritten during the copy are dropped. The dump is a Chrome trace file for
+ * chrome://tracing or Perfetto with one track per thread. Zone names must be string literals, only the pointer is stored.
+ */
+class CpuProfiler final : public Singleton<CpuProfiler>
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Records the time from its construction to its destruction, use SPECTRE_PROFILE_ZONE instead of creating one directly
+	class Zone final
+	{
+	public:
+		explicit Zone(const char* name) : m_Name(name), m_Begin(Clock::now()) {}
+		~Zone() { CpuProfiler::GetInstance().Record(m_Name, m_Begin, Clock::now()); }
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		const char*				m_Name;
+		const Clock::time_point m_Begin;
+	};
+
+	// Names the track of the calling thread in the trace
+	void SetThreadName(const std::string& name);
+	// Writes the zones that are still in the ring buffers, safe to call while other threads record
+	bool WriteChromeTrace(const std::string& filename);
+
+private:
+	friend class Singleton<CpuProfiler>;
+	CpuProfiler() = default;
+
+	// Fields are atomic so the dump may read a slot while its thread overwrites it, relaxed stores are plain writes
+	struct Event
+	{
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<int64_t>	 beginNanoseconds{ 0 };
+		std::atomic<int64_t>	 endNanoseconds{ 0 };
+	};
+
+	struct ThreadBuffer
+	{
+		Event				  events[Spectre::cpuProfilerEventsPerThread];
+		std::atomic<uint64_t> startedCount{ 0u }; // Increased before a slot is overwritten, only by the owning thread
+		std::atomic<uint64_t> writtenCount{ 0u }; // Increased once the slot is complete
+		uint32_t			  threadIndex{ 0u };
+		std::string			  threadName; // Guarded by the mutex
+	};
+
+	const Clock::time_point	 m_StartTime{ Clock::now() };
+	std::mutex				 m_Mutex; // Guards the registration of thread buffers, never taken while recording
+	std::deque<ThreadBuffer> m_ThreadBuffers;
+
+	void		  Record(const char* name, Clock::time_point begin, Clock::time_point end);
+	ThreadBuffer* GetThreadBuffer();
+};
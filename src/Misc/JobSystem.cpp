@@ -0,0 +1,77 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem()
+{
+	// Leave one hardware thread for the main loop
+	const unsigned int hardwareThreadCount{ std::thread::hardware_concurrency() };
+	const unsigned int workerCount{ hardwareThreadCount > 1u ? hardwareThreadCount - 1u : 1u };
+
+	m_Workers.reserve(workerCount);
+	for (unsigned int workerIndex = 0u; workerIndex < workerCount; ++workerIndex)
+	{
+		m_Workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_JobAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		if (worker.joinable())
+		{
+			worker.join();
+		}
+	}
+}
+
+std::shared_future<void> JobSystem::Schedule(std::function<void()> job, EJobPriority priority)
+{
+	std::packaged_task<void()> task{ std::move(job) };
+	std::shared_future<void>   future{ task.get_future().share() };
+
+	{
+		std::lock_guard lock{ m_Mutex };
+		if (priority == EJobPriority::High)
+		{
+			m_HighPriorityJobs.push_back(std::move(task));
+		}
+		else
+		{
+			m_LowPriorityJobs.push_back(std::move(task));
+		}
+	}
+	m_JobAvailable.notify_one();
+
+	return future;
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		std::packaged_task<void()> task;
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_JobAvailable.wait(lock, [this] { return m_IsStopping || !m_HighPriorityJobs.empty() || !m_LowPriorityJobs.empty(); });
+
+			// Drain the queues before stopping so nobody waits on a future that never resolves
+			if (m_HighPriorityJobs.empty() && m_LowPriorityJobs.empty())
+			{
+				return;
+			}
+
+			std::deque<std::packaged_task<void()>>& queue{ m_HighPriorityJobs.empty() ? m_LowPriorityJobs : m_HighPriorityJobs };
+			task = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		// Exceptions are stored in the future by the packaged task
+		task();
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef singleton
+#include "Singleton.h"
+#define singleton
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class EJobPriority
+{
+	High, // Work something is about to wait on, like pipelines needed for the first frame
+	Low	  // Background work nobody is blocked on yet
+};
+
+/*
+ * The job system owns a small pool of worker threads that execute scheduled jobs in priority order. Every scheduled job
+ * returns a shared future, waiting on it rethrows any exception the job threw on its worker thread.
+ */
+class JobSystem final : public Singleton<JobSystem>
+{
+public:
+	~JobSystem();
+
+	std::shared_future<void> Schedule(std::function<void()> job, EJobPriority priority = EJobPriority::Low);
+	size_t					 GetWorkerCount() const { return m_Workers.size(); }
+
+private:
+	friend class Singleton<JobSystem>;
+	JobSystem();
+
+	std::vector<std::thread>			   m_Workers;
+	std::deque<std::packaged_task<void()>> m_HighPriorityJobs, m_LowPriorityJobs;
+	std::mutex							   m_Mutex;
+	std::condition_variable				   m_JobAvailable;
+	bool								   m_IsStopping{ false };
+
+	void WorkerLoop();
+};
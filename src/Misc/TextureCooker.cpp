@@ -0,0 +1,199 @@
+#include "TextureCooker.h"
+
+#include "BlockCompression.h"
+#include "CpuProfiler.h"
+#include "Utils.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+	constexpr uint32_t cookedTextureMagic{ 0x58455453u }; // "STEX"
+	constexpr uint32_t cookedTextureVersion{ 1u };
+	constexpr size_t   texelSize = 4u; // RGBA8
+
+	std::array<float, 256u> MakeSrgbToLinearTable()
+	{
+		std::array<float, 256u> table;
+		for (size_t index = 0u; index < table.size(); ++index)
+		{
+			const float encoded{ static_cast<float>(index) / 255.0f };
+			table.at(index) = encoded <= 0.04045f ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+		}
+		return table;
+	}
+
+	float SrgbToLinear(uint8_t value)
+	{
+		// Only 256 possible inputs, the table is built on first use
+		static const std::array<float, 256u> table{ MakeSrgbToLinearTable() };
+		return table[value];
+	}
+
+	uint8_t LinearToSrgb(float value)
+	{
+		const float encoded{ value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f };
+		return static_cast<uint8_t>(std::clamp(encoded * 255.0f + 0.5f, 0.0f, 255.0f));
+	}
+} // namespace
+
+void TextureCooker::Cook(const std::string& sourceFilename, const std::string& cookedFilename, VkFormat format)
+{
+	SPECTRE_PROFILE_ZONE("TextureCooker::Cook");
+
+	VkExtent2D			 extent;
+	std::vector<uint8_t> texels{ DecodeImage(sourceFilename, extent) };
+
+	FileHeader header{};
+	header.magic = cookedTextureMagic;
+	header.version = cookedTextureVersion;
+	header.width = extent.width;
+	header.height = extent.height;
+	header.mipCount = GetMipCount(extent);
+	header.format = format;
+
+	// The levels follow the level table back to back
+	std::vector<Level> levels(header.mipCount);
+	uint64_t		   offset{ sizeof(FileHeader) + sizeof(Level) * levels.size() };
+	for (uint32_t mip = 0u; mip < header.mipCount; ++mip)
+	{
+		levels.at(mip) = { offset, BlockCompression::GetLevelSize(format, GetMipExtent(extent, mip)) };
+		offset += levels.at(mip).size;
+	}
+
+	std::ofstream file(cookedFilename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		utils::ThrowError(EError::FileWriteFailure, cookedFilename);
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(sizeof(Level) * levels.size()));
+	for (uint32_t mip = 0u; mip < header.mipCount; ++mip)
+	{
+		// Each level is downsampled from the uncompressed one before it, never from blocks
+		if (BlockCompression::IsCompressed(format))
+		{
+			const std::vector<uint8_t> blocks{ BlockCompression::Encode(format, texels, GetMipExtent(extent, mip)) };
+			file.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(blocks.size()));
+		}
+		else
+		{
+			file.write(reinterpret_cast<const char*>(texels.data()), static_cast<std::streamsize>(texels.size()));
+		}
+		if (mip + 1u < header.mipCount)
+		{
+			texels = Downsample(texels, GetMipExtent(extent, mip));
+		}
+	}
+
+	if (!file.good())
+	{
+		utils::ThrowError(EError::FileWriteFailure, cookedFilename);
+	}
+}
+
+std::string TextureCooker::GetCookedFilename(const std::string& sourceFilename)
+{
+	const size_t extensionStart{ sourceFilename.find_last_of('.') };
+	const size_t filenameStart{ sourceFilename.find_last_of("/\\") };
+	if (extensionStart == std::string::npos || (filenameStart != std::string::npos && extensionStart < filenameStart))
+	{
+		return sourceFilename + Spectre::cookedTextureExtension;
+	}
+
+	return sourceFilename.substr(0u, extensionStart) + Spectre::cookedTextureExtension;
+}
+
+bool TextureCooker::ReadHeader(std::istream& file, FileHeader& outHeader, std::vector<Level>& outLevels)
+{
+	file.read(reinterpret_cast<char*>(&outHeader), sizeof(outHeader));
+	if (!file.good() || outHeader.magic != cookedTextureMagic || outHeader.version != cookedTextureVersion)
+	{
+		return false;
+	}
+
+	// A level table that doesn't match the extent means the file is damaged
+	if (outHeader.width == 0u || outHeader.height == 0u || outHeader.mipCount != GetMipCount({ outHeader.width, outHeader.height }))
+	{
+		return false;
+	}
+
+	outLevels.resize(outHeader.mipCount);
+	file.read(reinterpret_cast<char*>(outLevels.data()), static_cast<std::streamsize>(sizeof(Level) * outLevels.size()));
+	return file.good();
+}
+
+bool TextureCooker::ReadImageExtent(const std::string& filename, VkExtent2D& outExtent)
+{
+	int width, height, channelCount;
+	if (!stbi_info(filename.c_str(), &width, &height, &channelCount))
+	{
+		return false;
+	}
+
+	outExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+	return true;
+}
+
+std::vector<uint8_t> TextureCooker::DecodeImage(const std::string& filename, VkExtent2D& outExtent)
+{
+	int		 width, height, channelCount;
+	stbi_uc* pixels{ stbi_load(filename.c_str(), &width, &height, &channelCount, STBI_rgb_alpha) };
+	if (!pixels)
+	{
+		utils::ThrowError(EError::ImageLoadingFailure, filename);
+	}
+
+	outExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+	std::vector<uint8_t> texels(pixels, pixels + static_cast<size_t>(width) * height * texelSize);
+	stbi_image_free(pixels);
+	return texels;
+}
+
+std::vector<uint8_t> TextureCooker::Downsample(const std::vector<uint8_t>& texels, VkExtent2D extent)
+{
+	const VkExtent2D	 halfExtent{ GetMipExtent(extent, 1u) };
+	std::vector<uint8_t> halfTexels(static_cast<size_t>(halfExtent.width) * halfExtent.height * texelSize);
+	for (uint32_t y = 0u; y < halfExtent.height; ++y)
+	{
+		const std::array<uint32_t, 2u> rows{ std::min(y * 2u, extent.height - 1u), std::min(y * 2u + 1u, extent.height - 1u) };
+		for (uint32_t x = 0u; x < halfExtent.width; ++x)
+		{
+			const std::array<uint32_t, 2u> columns{ std::min(x * 2u, extent.width - 1u), std::min(x * 2u + 1u, extent.width - 1u) };
+			std::array<float, 3u>		   color{ 0.0f, 0.0f, 0.0f };
+			uint32_t					   alpha{ 0u };
+			for (const uint32_t row : rows)
+			{
+				for (const uint32_t column : columns)
+				{
+					const uint8_t* texel{ &texels.at((static_cast<size_t>(row) * extent.width + column) * texelSize) };
+					for (size_t channel = 0u; channel < color.size(); ++channel)
+					{
+						color.at(channel) += SrgbToLinear(texel[channel]);
+					}
+					alpha += texel[3];
+				}
+			}
+
+			uint8_t* halfTexel{ &halfTexels.at((static_cast<size_t>(y) * halfExtent.width + x) * texelSize) };
+			for (size_t channel = 0u; channel < color.size(); ++channel)
+			{
+				halfTexel[channel] = LinearToSrgb(color.at(channel) * 0.25f);
+			}
+			halfTexel[3] = static_cast<uint8_t>((alpha + 2u) / 4u); // Alpha is stored linearly
+		}
+	}
+
+	return halfTexels;
+}
+
+uint32_t TextureCooker::GetMipCount(VkExtent2D extent) { return static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1u; }
+
+VkExtent2D TextureCooker::GetMipExtent(VkExtent2D extent, uint32_t mip) { return { std::max(extent.width >> mip, 1u), std::max(extent.height >> mip, 1u) }; }
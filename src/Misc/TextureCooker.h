@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Spectre
+{
+	constexpr const char* cookedTextureExtension = ".stex";
+} // namespace Spectre
+
+/*
+ * The texture cooker turns source images into cooked textures, files holding the complete mip chain block compressed,
+ * BC7 unless asked for BC1 or plain RGBA8. Cooking is meant to happen offline through the TextureCooker tool, the
+ * texture buffer prefers a cooked texture next to its source image and reads just the levels it streams in from it.
+ * Source images that haven't been cooked are decoded at runtime, the cooker provides the decoding and downsampling for
+ * both.
+ */
+class TextureCooker final
+{
+public:
+	// Start of a cooked texture, followed by the level table and the texels of every level, the most detailed one first
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipCount;
+		uint32_t format; // VkFormat of the texels
+	};
+
+	struct Level
+	{
+		uint64_t offset; // From the start of the file
+		uint64_t size;
+	};
+
+	// Writes the full mip chain of the source image, every level downsampled from the one before and then block compressed
+	static void Cook(const std::string& sourceFilename, const std::string& cookedFilename, VkFormat format = VK_FORMAT_BC7_SRGB_BLOCK);
+	// Swaps the extension of the source image for the cooked one
+	static std::string GetCookedFilename(const std::string& sourceFilename);
+	// Returns false if the file isn't a cooked texture of this version
+	static bool		   ReadHeader(std::istream& file, FileHeader& outHeader, std::vector<Level>& outLevels);
+
+	// Only reads the header of the source image
+	static bool					ReadImageExtent(const std::string& filename, VkExtent2D& outExtent);
+	// Decodes the source image to RGBA8 texels
+	static std::vector<uint8_t> DecodeImage(const std::string& filename, VkExtent2D& outExtent);
+	// Averages each 2x2 block in linear space, the last row or column is repeated for odd sizes
+	static std::vector<uint8_t> Downsample(const std::vector<uint8_t>& texels, VkExtent2D extent);
+
+	// Halves the extent per level down to 1x1
+	static uint32_t	  GetMipCount(VkExtent2D extent);
+	static VkExtent2D GetMipExtent(VkExtent2D extent, uint32_t mip);
+};
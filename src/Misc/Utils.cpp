@@ -16,6 +16,9 @@ void utils::ThrowError(EError error, const std::string& details)
 	case EError::FileMissing:
 		throw std::runtime_error("Failed to find file");
 		break;
+	case EError::FileWriteFailure:
+		throw std::runtime_error("Failed to write file");
+		break;
 	case EError::GenericGLFW:
 		throw std::runtime_error("Program encountered a generic GLFW error");
 		break;
@@ -28,6 +31,9 @@ void utils::ThrowError(EError error, const std::string& details)
 	case EError::HeadsetNotConnected:
 		throw std::runtime_error("No headset detected.\nPlease make sure that your headset is connected and running");
 		break;
+	case EError::ImageLoadingFailure:
+		throw std::runtime_error("Failed to load image");
+		break;
 	case EError::ModelLoadingFailure:
 		throw std::runtime_error("Failed to load model");
 		break;
@@ -43,7 +49,7 @@ void utils::ThrowError(EError error, const std::string& details)
 	}
 }
 
-void utils::CreateImageView(const VkImage& image, VkFormat format, const uint32_t& layerCount, const VkImageAspectFlags aspectFlags, const VkDevice& device, VkImageView& outImageView)
+void utils::CreateImageView(const VkImage& image, VkFormat format, const uint32_t& layerCount, const VkImageAspectFlags aspectFlags, const VkDevice& device, VkImageView& outImageView, uint32_t mipLevelCount)
 {
 	// Create an image view
 	VkImageViewCreateInfo imageViewCreateInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
@@ -55,7 +61,7 @@ void utils::CreateImageView(const VkImage& image, VkFormat format, const uint32_
 	imageViewCreateInfo.subresourceRange.aspectMask = aspectFlags;
 	imageViewCreateInfo.subresourceRange.baseArrayLayer = 0u;
 	imageViewCreateInfo.subresourceRange.baseMipLevel = 0u;
-	imageViewCreateInfo.subresourceRange.levelCount = 1u;
+	imageViewCreateInfo.subresourceRange.levelCount = mipLevelCount;
 
 	if (vkCreateImageView(device, &imageViewCreateInfo, nullptr, &outImageView) != VK_SUCCESS)
 	{
@@ -20,10 +20,12 @@ enum class EError
 {
 	FeatureNotSupported,
 	FileMissing,
+	FileWriteFailure,
 	GenericGLFW,
 	GenericOpenXR,
 	GenericVulkan,
 	HeadsetNotConnected,
+	ImageLoadingFailure,
 	ModelLoadingFailure,
 	OutOfMemory,
 	VulkanNotSupported,
@@ -34,7 +36,7 @@ namespace utils
 {
 	// Reports an error with optional details through a system-native message box
 	void					 ThrowError(EError error, const std::string& details = "");
-	void					 CreateImageView(const VkImage& image, VkFormat format, const uint32_t& layerCount, const VkImageAspectFlags aspectFlags, const VkDevice& device, VkImageView& outImageView);
+	void					 CreateImageView(const VkImage& image, VkFormat format, const uint32_t& layerCount, const VkImageAspectFlags aspectFlags, const VkDevice& device, VkImageView& outImageView, uint32_t mipLevelCount = 1u);
 	bool					 LoadXrExtensionFunction(XrInstance instance, const std::string& name, PFN_xrVoidFunction* function);
 	PFN_vkVoidFunction		 LoadVkExtensionFunction(VkInstance instance, const std::string& name);
 	std::vector<const char*> UnpackExtensionString(const std::string& string);
@@ -58,4 +60,11 @@ namespace utils
 	bool UpdateActionStateVector2(XrSession session, XrAction action, XrPath path, XrActionStateVector2f& outState);
 	bool UpdateActionStateBoolean(XrSession session, XrAction action, XrPath path, XrActionStateBoolean& outState);
 
+	// Mixes the hash of a value into a running hash
+	template<typename T>
+	void HashCombine(size_t& seed, const T& value)
+	{
+		seed ^= std::hash<T>{}(value) + 0x9e3779b9u + (seed << 6) + (seed >> 2);
+	}
+
 } // namespace utils
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "DemoScene.h"
+
+#include "../Light/LightSystem.h"
+#include "GameData.h"
+#include "MeshData.h"
+
+#include <glm/gtc/constants.hpp>
+
+namespace Spectre
+{
+	constexpr size_t ringLightCount = 32u;
+} // namespace Spectre
+
+DemoScene::DemoScene()
+{
+	Model *gridModel{ new Model }, *ruinsModel{ new Model }, *carModelLeft{ new Model }, *carModelRight{ new Model }, *sunModel{ new Model }, *beetleModel{ new Model }, *bikeModel{ new Model };
+	Model *handModelLeft{ new Model }, *handModelRight{ new Model }, *planeModelLeft{ new Model }, *planeModelRight{ new Model }, *squareModel{ new Model };
+	m_Models = { gridModel, ruinsModel, carModelLeft, carModelRight, sunModel, beetleModel, bikeModel, handModelLeft, handModelRight, planeModelLeft, planeModelRight, squareModel };
+
+	Material *gridMaterial{ new Material }, *diffuseMaterial{ new Material }, *transparentMaterial{ new Material }, *material2D{ new Material }, *sunMaterial{ new Material }, *texturedMaterial{ new Material };
+	gridMaterial->vertShaderName = "shaders/Grid.vert.spv";
+	gridMaterial->fragShaderName = "shaders/Grid.frag.spv";
+	gridMaterial->dynamicUniformData.colorMultiplier = glm::vec4(1.0f);
+	gridMaterial->castsShadows = false; // The floor has nothing below it to shadow
+
+	diffuseMaterial->vertShaderName = "shaders/Diffuse.vert.spv";
+	diffuseMaterial->fragShaderName = "shaders/Diffuse.frag.spv";
+	diffuseMaterial->dynamicUniformData.colorMultiplier = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+	texturedMaterial->vertShaderName = "shaders/Textured.vert.spv";
+	texturedMaterial->fragShaderName = "shaders/Textured.frag.spv";
+	texturedMaterial->dynamicUniformData.colorMultiplier = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	texturedMaterial->albedoTextureName = "textures/test.png";
+
+	sunMaterial->vertShaderName = "shaders/Illumination.vert.spv";
+	sunMaterial->fragShaderName = "shaders/Illumination.frag.spv";
+	sunMaterial->dynamicUniformData.colorMultiplier = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
+	sunMaterial->castsShadows = false; // Sits right in the path of its own light
+
+	transparentMaterial->vertShaderName = "shaders/DiffuseTransparent.vert.spv";
+	transparentMaterial->fragShaderName = "shaders/DiffuseTransparent.frag.spv";
+	transparentMaterial->dynamicUniformData.colorMultiplier = glm::vec4(0.0f, 0.8f, 0.f, 0.66f);
+	transparentMaterial->pipelineData.cullMode = VkCullModeFlagBits::VK_CULL_MODE_NONE;
+	transparentMaterial->renderBucket = ERenderBucket::Transparent;
+
+	material2D->vertShaderName = "shaders/Diffuse2D.vert.spv";
+	material2D->fragShaderName = "shaders/Diffuse2D.frag.spv";
+	material2D->dynamicUniformData.colorMultiplier = glm::vec4(1.0f, 0.0f, 0.1f, 0.66f);
+	material2D->pipelineData.depthTestEnable = VK_FALSE;
+	material2D->pipelineData.depthWriteEnable = VK_FALSE;
+	material2D->renderBucket = ERenderBucket::Overlay;
+	m_Materials = { gridMaterial, diffuseMaterial, transparentMaterial, material2D, sunMaterial, texturedMaterial };
+
+	GameObject* grid{ new GameObject{ gridModel, gridMaterial, "grid" } };
+	GameObject* ruins{ new GameObject{ ruinsModel, diffuseMaterial, "ruins" } };
+	GameObject* carLeft{ new GameObject{ carModelLeft, diffuseMaterial, "carLeft" } };
+	GameObject* carRight{ new GameObject{ carModelRight, diffuseMaterial, "carRight" } };
+	GameObject* beetle{ new GameObject{ beetleModel, texturedMaterial, "beetle" } };
+	m_Sun = new GameObject{ sunModel, sunMaterial, "sun" };
+	m_Bike = new GameObject{ bikeModel, transparentMaterial, "bike" };
+	m_HandLeft = new GameObject{ handModelLeft, diffuseMaterial, "handLeft" };
+	m_HandRight = new GameObject{ handModelRight, diffuseMaterial, "handRight" };
+	GameObject* planeLeft{ new GameObject{ planeModelLeft, material2D, "planeLeft", glm::vec2{ -4.0f, -4.0f } } };
+	GameObject* planeRight{ new GameObject{ planeModelRight, material2D, "planeRight", glm::vec2{ 4.0f, 4.0f } } };
+	GameObject* square{ new GameObject{ squareModel, material2D, "square", glm::vec2{ 4.0f, 4.0f } } };
+	m_GameObjects = { grid, ruins, carLeft, carRight, m_Sun, beetle, m_Bike, m_HandLeft, m_HandRight, planeLeft, planeRight, square };
+
+	carLeft->WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { -3.5f, 0.0f, -7.0f }), glm::radians(75.0f), { 0.0f, 1.0f, 0.0f });
+	carRight->WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { 8.0f, 0.0f, -15.0f }), glm::radians(-15.0f), { 0.0f, 1.0f, 0.0f });
+	beetle->WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { -3.5f, 0.0f, -0.5f }), glm::radians(-125.0f), { 0.0f, 1.0f, 0.0f });
+
+	// The scenery never moves, its shadows are only drawn again when the sun or the cascades move
+	for (GameObject* staticObject : { grid, ruins, carLeft, carRight, beetle })
+	{
+		staticObject->IsStatic = true;
+	}
+
+	// A ring of colored point lights around the ruins and a spot light above each car, culled per cluster on the GPU
+	LightSystem& lightSystem{ LightSystem::GetInstance() };
+	for (size_t lightIndex = 0u; lightIndex < Spectre::ringLightCount; ++lightIndex)
+	{
+		const float		angle{ glm::two_pi<float>() * static_cast<float>(lightIndex) / static_cast<float>(Spectre::ringLightCount) };
+		const glm::vec3 color{ 0.5f + 0.5f * glm::cos(angle), 0.5f + 0.5f * glm::cos(angle + 2.1f), 0.5f + 0.5f * glm::cos(angle + 4.2f) };
+		lightSystem.AddPointLight({ 6.0f * glm::cos(angle), 0.5f, 6.0f * glm::sin(angle) - 4.0f }, 3.0f, color, 4.0f);
+	}
+	lightSystem.AddSpotLight({ -3.5f, 4.0f, -7.0f }, { 0.0f, -1.0f, 0.0f }, 8.0f, 20.0f, 30.0f, { 1.0f, 0.9f, 0.7f }, 20.0f);
+	lightSystem.AddSpotLight({ 8.0f, 4.0f, -15.0f }, { 0.0f, -1.0f, 0.0f }, 8.0f, 20.0f, 30.0f, { 1.0f, 0.9f, 0.7f }, 20.0f);
+}
+
+DemoScene::~DemoScene()
+{
+	for (GameObject* gameObject : m_GameObjects)
+	{
+		delete gameObject;
+	}
+
+	for (Material* material : m_Materials)
+	{
+		delete material;
+	}
+
+	for (Model* model : m_Models)
+	{
+		delete model;
+	}
+}
+
+MeshData* DemoScene::LoadMeshData()
+{
+	MeshData* meshData{ new MeshData };
+	meshData->LoadModel("models/Grid.obj", MeshData::Color::FromNormals, m_Models, 1u);
+	meshData->LoadModel("models/Ruins.obj", MeshData::Color::White, m_Models, 1u);
+	meshData->LoadModel("models/Car.obj", MeshData::Color::White, m_Models, 3u);
+	meshData->LoadModel("models/Beetle.obj", MeshData::Color::White, m_Models, 1u);
+	meshData->LoadModel("models/Bike.obj", MeshData::Color::White, m_Models, 1u);
+	meshData->LoadModel("models/Hand.obj", MeshData::Color::White, m_Models, 2u);
+	meshData->LoadModel("models/Plane.obj", MeshData::Color::White, m_Models, 2u);
+	meshData->CreateSquare(m_Models, 1u);
+	return meshData;
+}
+
+void DemoScene::Update(float time, const glm::mat4& headWorldMatrix)
+{
+	LightSystem::GetInstance().Update(m_Sun);
+
+	for (GameObject* gameObject : m_GameObjects)
+	{
+		gameObject->Update(headWorldMatrix);
+	}
+
+	m_Bike->WorldMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), { 0.5f, 0.0f, -4.5f }), time * 0.2f, { 0.0f, 1.0f, 0.0f });
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+
+#include <vector>
+
+class MeshData;
+struct Model;
+struct Material;
+struct GameObject;
+
+/*
+ * The demo scene holds the models, materials and game objects of the ruins with the cars, the bike and the 2D overlay,
+ * together with the ring of local lights around them. Rendering on the headset and the headless benchmark share it so
+ * that both draw exactly the same frame. The hands are posed by the caller, everything else moves in Update().
+ */
+class DemoScene final
+{
+public:
+	DemoScene();
+	~DemoScene();
+	DemoScene(const DemoScene&) = delete;
+	DemoScene& operator=(const DemoScene&) = delete;
+
+	// Assigns the index ranges of every model, the mesh data is only needed until the renderer has uploaded it
+	MeshData* LoadMeshData();
+	// Moves the sun, the bike and the 2D shapes, which stay in front of the head
+	void	  Update(float time, const glm::mat4& headWorldMatrix);
+
+	const std::vector<Material*>&	GetMaterials() const { return m_Materials; }
+	const std::vector<GameObject*>& GetGameObjects() const { return m_GameObjects; }
+	GameObject&						GetHandLeft() const { return *m_HandLeft; }
+	GameObject&						GetHandRight() const { return *m_HandRight; }
+
+private:
+	std::vector<Model*>		 m_Models; // In the order the meshes are loaded
+	std::vector<Material*>	 m_Materials;
+	std::vector<GameObject*> m_GameObjects;
+
+	GameObject* m_Sun{ nullptr };
+	GameObject* m_Bike{ nullptr };
+	GameObject* m_HandLeft{ nullptr };
+	GameObject* m_HandRight{ nullptr };
+};
@@ -1,34 +1,42 @@
 ﻿#pragma once
 
-#include "../VR/Headset.h"
+#include "../Buffers/TextureAtlas.h"
 #include "../VulkanBase/VulkanPipeline.h"
 #include "../VulkanBase/VulkanRenderSystem.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/mat4x4.hpp>
 #include <string>
 
+class TextureBuffer;
+
 struct Model final
 {
 	size_t FirstIndex{ 0u };
 	size_t IndexCount{ 0u };
 };
 
+// Decides in which part of the frame a material is drawn, only opaque materials take part in the depth prepass
+enum class ERenderBucket
+{
+	Opaque,
+	Transparent,
+	Overlay
+};
+
 struct Material
 {
 	VulkanRenderSystem::DynamicVertexUniformData dynamicUniformData{};
 	std::string									 vertShaderName{ "shaders/Diffuse.vert.spv" };
 	std::string									 fragShaderName{ "shaders/Diffuse.frag.spv" };
 	Spectre::PipelineMaterialPayload			 pipelineData{};
+	ERenderBucket								 renderBucket{ ERenderBucket::Opaque };
 	VulkanPipeline*								 pipeline{ nullptr };
-};
-
-struct ShadowMap
-{
-	VkImage		  image;
-	VkImageView	  imageView;
-	VkSampler	  sampler;
-	VkFramebuffer framebuffer;
-	VkExtent2D	  extent;
+	VulkanPipeline*								 depthPrepassPipeline{ nullptr }; // Position-only, writes depth
+	VulkanPipeline*								 depthEqualPipeline{ nullptr };	  // Color pass after the prepass, tests depth for equality
+	bool										 castsShadows{ true };			  // Only opaque materials cast shadows
+	std::string									 albedoTextureName;				  // Streamed in by the texture streamer when set, or packed into an atlas if it is small
+	TextureBuffer*								 albedoTexture{ nullptr };
+	const TextureAtlas::Region*					 albedoRegion{ nullptr }; // Set instead of the texture when it has been packed
 };
 
 struct GameObject
@@ -52,13 +60,13 @@ struct GameObject
 		Material = material;
 	}
 
-	void Update(Headset& headset)
+	void Update(const glm::mat4& headWorldMatrix)
 	{
 		// Code is located here as the 2D shapes must act as VR UI, this uses the 2D pipeline with depthtesting disabled
 		if (Is2DShape)
 		{
 			// Offsets the object from the headset center
-			auto offsetMatrix{ glm::translate(headset.worldMatrix, Offset) };
+			auto offsetMatrix{ glm::translate(headWorldMatrix, Offset) };
 			WorldMatrix = offsetMatrix;
 
 			// Calculates the vector between origin and current location
@@ -81,5 +89,6 @@ struct GameObject
 	Model*		Model{ nullptr };
 	Material*	Material{ nullptr };
 	bool		Is2DShape{ false };
+	bool		IsStatic{ false }; // Never moves, its shadow is cached
 	glm::vec3	Offset{ 0, 0, -12 };
 };
@@ -33,6 +33,12 @@ bool MeshData::LoadModel(const std::string& filename, Color color, std::vector<M
 				vertex.normal = { 0.0f, 0.0f, 0.0f };
 			}
 
+			// OBJ texture coordinates start at the bottom left, Vulkan samples from the top left
+			if (index.texcoord_index >= 0)
+			{
+				vertex.uv = { attrib.texcoords[2 * index.texcoord_index + 0], 1.0f - attrib.texcoords[2 * index.texcoord_index + 1] };
+			}
+
 			switch (color)
 			{
 			case Color::White:
@@ -13,6 +13,7 @@ struct Vertex final
 	glm::vec3 position;
 	glm::vec3 normal;
 	glm::vec3 color;
+	glm::vec2 uv{ 0.0f }; // Only sampled by textured materials
 };
 
 struct Vertex2D final
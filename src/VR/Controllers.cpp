@@ -1,6 +1,7 @@
 #include "Controllers.h"
 
 #include "../Input/InputHandler.h"
+#include "../Misc/CpuProfiler.h"
 #include "../Misc/Utils.h"
 #include "../VulkanBase/VulkanDevice.h"
 #include <array>
@@ -366,6 +367,8 @@ Controllers::~Controllers()
 
 bool Controllers::Sync()
 {
+	SPECTRE_PROFILE_ZONE("Controllers::Sync");
+
 	// Sync the actions
 	XrActiveActionSet activeActionSet;
 	activeActionSet.actionSet = m_ActionSetData.actionSet;
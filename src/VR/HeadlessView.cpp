@@ -0,0 +1,68 @@
+#include "HeadlessView.h"
+
+#include "../Buffers/ImageBuffer.h"
+#include "../Misc/Utils.h"
+#include "../VulkanBase/RenderTarget.h"
+#include "../VulkanBase/VulkanDevice.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	constexpr size_t eyeCount = 2u;
+} // namespace
+
+HeadlessView::HeadlessView(const VulkanDevice* device) : StereoView(device)
+{
+	const VkDevice vkDevice{ device->GetVkDevice() };
+
+	// The images take the place of the swapchain images, resolved or composited into and then left alone
+	m_Images.resize(Spectre::headlessImageCount);
+	m_RenderTargets.resize(Spectre::headlessImageCount);
+	for (size_t imageIndex = 0u; imageIndex < Spectre::headlessImageCount; ++imageIndex)
+	{
+		ImageBuffer*& image{ m_Images.at(imageIndex) };
+		image = new ImageBuffer(device, Spectre::headlessEyeResolution, Spectre::eyeColorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT, eyeCount);
+		m_RenderTargets.at(imageIndex) = new RenderTarget(vkDevice, image->GetImage(), Spectre::headlessEyeResolution, Spectre::eyeColorFormat, static_cast<uint32_t>(eyeCount));
+	}
+
+	const float tangent{ glm::tan(Spectre::headlessHalfFieldOfView) };
+	m_EyeFov.angleLeft = -Spectre::headlessHalfFieldOfView;
+	m_EyeFov.angleRight = Spectre::headlessHalfFieldOfView;
+	m_EyeFov.angleUp = glm::atan(tangent * static_cast<float>(Spectre::headlessEyeResolution.height) / static_cast<float>(Spectre::headlessEyeResolution.width));
+	m_EyeFov.angleDown = -m_EyeFov.angleUp;
+	m_EyeProjectionMatrix = utils::CreateProjectionMatrix(m_EyeFov, Spectre::nearClip, Spectre::farClip);
+
+	m_EyeViewMatrices.resize(eyeCount);
+	SetHeadPose(glm::mat4(1.0f));
+}
+
+HeadlessView::~HeadlessView()
+{
+	for (RenderTarget* renderTarget : m_RenderTargets)
+	{
+		delete renderTarget;
+	}
+
+	for (ImageBuffer* image : m_Images)
+	{
+		delete image;
+	}
+}
+
+uint32_t HeadlessView::AcquireImage()
+{
+	m_ImageIndex = (m_ImageIndex + 1u) % static_cast<uint32_t>(m_Images.size());
+	return m_ImageIndex;
+}
+
+void HeadlessView::SetHeadPose(const glm::mat4& headWorldMatrix)
+{
+	// The left eye sits half the interpupillary distance to the left of the head, the right eye to the right
+	for (size_t eyeIndex = 0u; eyeIndex < m_EyeViewMatrices.size(); ++eyeIndex)
+	{
+		const float		eyeOffset{ (eyeIndex == 0u ? -0.5f : 0.5f) * Spectre::headlessInterpupillaryDistance };
+		const glm::mat4 eyeWorldMatrix{ glm::translate(headWorldMatrix, { eyeOffset, 0.0f, 0.0f }) };
+		m_EyeViewMatrices.at(eyeIndex) = glm::inverse(eyeWorldMatrix);
+	}
+}
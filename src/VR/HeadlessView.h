@@ -0,0 +1,46 @@
+#pragma once
+
+#include "StereoView.h"
+
+#include <vector>
+
+class ImageBuffer;
+
+namespace Spectre
+{
+	constexpr VkExtent2D headlessEyeResolution = { 1440u, 1584u };
+	constexpr size_t	 headlessImageCount = 3u; // Cycled like a swapchain
+	constexpr float		 headlessInterpupillaryDistance = 0.063f;
+	constexpr float		 headlessHalfFieldOfView = 0.785398f; // 45 degrees in every direction
+} // namespace Spectre
+
+/*
+ * The headless view stands in for the headset when there is neither an OpenXR runtime nor a window. It renders both eyes
+ * into layered offscreen images that nothing ever presents, with a symmetric field of view and the eyes offset from the
+ * head pose by half the interpupillary distance each. The head pose is set by the caller, usually along a scripted path.
+ */
+class HeadlessView final : public StereoView
+{
+public:
+	explicit HeadlessView(const VulkanDevice* device);
+	~HeadlessView() override;
+
+	// Returns the index of the next offscreen image, the render graph waits for the GPU to be done with it
+	uint32_t AcquireImage();
+	void	 SetHeadPose(const glm::mat4& headWorldMatrix);
+
+	size_t		  GetEyeCount() const override { return m_EyeViewMatrices.size(); }
+	VkExtent2D	  GetEyeResolution(size_t eyeIndex) const override { return Spectre::headlessEyeResolution; }
+	glm::mat4	  GetEyeViewMatrix(size_t eyeIndex) const override { return m_EyeViewMatrices.at(eyeIndex); }
+	glm::mat4	  GetEyeProjectionMatrix(size_t eyeIndex) const override { return m_EyeProjectionMatrix; }
+	XrFovf		  GetEyeFov(size_t eyeIndex) const override { return m_EyeFov; }
+	RenderTarget* GetRenderTarget(size_t swapchainImageIndex) const override { return m_RenderTargets.at(swapchainImageIndex); }
+
+private:
+	std::vector<ImageBuffer*>  m_Images;
+	std::vector<RenderTarget*> m_RenderTargets;
+	std::vector<glm::mat4>	   m_EyeViewMatrices;
+	glm::mat4				   m_EyeProjectionMatrix{ glm::mat4(1.0f) };
+	XrFovf					   m_EyeFov{};
+	uint32_t				   m_ImageIndex{ 0u };
+};
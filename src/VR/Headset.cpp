@@ -1,27 +1,20 @@
 #include "Headset.h"
 
-#include "../Buffers/ImageBuffer.h"
+#include "../Misc/CpuProfiler.h"
 #include "../Misc/Utils.h"
 #include "../VulkanBase/RenderTarget.h"
 #include "../VulkanBase/VulkanDevice.h"
 
 #include <glm/mat4x4.hpp>
 
-#include <array>
-
 namespace
 {
 	constexpr XrReferenceSpaceType spaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-	constexpr VkFormat			   colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
-	constexpr VkFormat			   depthFormat = VK_FORMAT_D32_SFLOAT;
 } // namespace
 
-Headset::Headset(const VulkanDevice* device) : m_Device(device)
+Headset::Headset(const VulkanDevice* device) : StereoView(device)
 {
-	const VkDevice				vkDevice{ device->GetVkDevice() };
-	const VkSampleCountFlagBits multisampleCount{ device->GetMultisampleCount() };
-
-	CreateRenderPass(multisampleCount, vkDevice);
+	const VkDevice vkDevice{ device->GetVkDevice() };
 
 	const XrInstance	   m_XrInstance{ device->GetXrInstance() };
 	const XrSystemId	   xrSystemId{ device->GetXrSystemId() };
@@ -90,9 +83,6 @@ Headset::Headset(const VulkanDevice* device) : m_Device(device)
 
 	const VkExtent2D eyeResolution{ GetEyeResolution(0u) };
 
-	m_ColorBuffer = new ImageBuffer(device, eyeResolution, colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, device->GetMultisampleCount(), VK_IMAGE_ASPECT_COLOR_BIT, 2u);
-	m_DepthBuffer = new ImageBuffer(device, eyeResolution, depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, device->GetMultisampleCount(), VK_IMAGE_ASPECT_DEPTH_BIT, 2u);
-
 	// Create a swapchain and render targets
 	CreateSwapChain(vkDevice, eyeResolution);
 
@@ -125,7 +115,9 @@ void Headset::CreateSwapChain(const VkDevice& vkDevice, const VkExtent2D& eyeRes
 
 	// Create a swapchain
 	XrSwapchainCreateInfo swapchainCreateInfo{ XR_TYPE_SWAPCHAIN_CREATE_INFO };
-	swapchainCreateInfo.format = colorFormat;
+	swapchainCreateInfo.format = Spectre::eyeColorFormat;
+	// Foveated rendering composites the eye regions into the images with transfers, the mirror view blits from them
+	swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
 	swapchainCreateInfo.sampleCount = eyeImageInfo.recommendedSwapchainSampleCount;
 	swapchainCreateInfo.width = eyeImageInfo.recommendedImageRectWidth;
 	swapchainCreateInfo.height = eyeImageInfo.recommendedImageRectHeight;
@@ -169,83 +161,7 @@ void Headset::CreateSwapChain(const VkDevice& vkDevice, const VkExtent2D& eyeRes
 		RenderTarget*& renderTarget = m_SwapchainRenderTargets.at(renderTargetIndex);
 
 		const VkImage image = swapchainImages.at(renderTargetIndex).image;
-		renderTarget = new RenderTarget(vkDevice, image, m_ColorBuffer->GetImageView(), m_DepthBuffer->GetImageView(), eyeResolution, colorFormat, m_RenderPass, 2u);
-	}
-}
-
-// Could be moved to utils
-void Headset::CreateRenderPass(const VkSampleCountFlagBits& m_MultisampleCount, const VkDevice& vkDevice)
-{
-
-	constexpr uint32_t viewMask{ 0b00000011 };
-	constexpr uint32_t correlationMask{ 0b00000011 };
-
-	VkRenderPassMultiviewCreateInfo renderPassMultiviewCreateInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO };
-	renderPassMultiviewCreateInfo.subpassCount = 1u;
-	renderPassMultiviewCreateInfo.pViewMasks = &viewMask;
-	renderPassMultiviewCreateInfo.correlationMaskCount = 1u;
-	renderPassMultiviewCreateInfo.pCorrelationMasks = &correlationMask;
-
-	VkAttachmentDescription colorAttachmentDescription{};
-	colorAttachmentDescription.format = colorFormat;
-	colorAttachmentDescription.samples = m_MultisampleCount;
-	colorAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	colorAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	colorAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentReference colorAttachmentReference{};
-	colorAttachmentReference.attachment = 0u;
-	colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentDescription depthAttachmentDescription{};
-	depthAttachmentDescription.format = depthFormat;
-	depthAttachmentDescription.samples = m_MultisampleCount;
-	depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	depthAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	depthAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	depthAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	depthAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentReference depthAttachmentReference{};
-	depthAttachmentReference.attachment = 1u;
-	depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentDescription resolveAttachmentDescription{};
-	resolveAttachmentDescription.format = colorFormat;
-	resolveAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
-	resolveAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	resolveAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	resolveAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	resolveAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	resolveAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	resolveAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentReference resolveAttachmentReference{};
-	resolveAttachmentReference.attachment = 2u;
-	resolveAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkSubpassDescription subpassDescription{};
-	subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpassDescription.colorAttachmentCount = 1u;
-	subpassDescription.pColorAttachments = &colorAttachmentReference;
-	subpassDescription.pDepthStencilAttachment = &depthAttachmentReference;
-	subpassDescription.pResolveAttachments = &resolveAttachmentReference;
-
-	const std::array attachments{ colorAttachmentDescription, depthAttachmentDescription, resolveAttachmentDescription };
-
-	VkRenderPassCreateInfo renderPassCreateInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
-	renderPassCreateInfo.pNext = &renderPassMultiviewCreateInfo;
-	renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-	renderPassCreateInfo.pAttachments = attachments.data();
-	renderPassCreateInfo.subpassCount = 1u;
-	renderPassCreateInfo.pSubpasses = &subpassDescription;
-	if (vkCreateRenderPass(vkDevice, &renderPassCreateInfo, nullptr, &m_RenderPass) != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
+		renderTarget = new RenderTarget(vkDevice, image, eyeResolution, Spectre::eyeColorFormat, 2u);
 	}
 }
 
@@ -269,7 +185,7 @@ void Headset::VerifyColorFormatSupport()
 	bool formatFound = false;
 	for (const int64_t& format : formats)
 	{
-		if (format == static_cast<int64_t>(colorFormat))
+		if (format == static_cast<int64_t>(Spectre::eyeColorFormat))
 		{
 			formatFound = true;
 			break;
@@ -306,22 +222,6 @@ Headset::~Headset()
 		xrDestroySpace(m_Space);
 	}
 
-	if (m_DepthBuffer)
-	{
-		delete m_DepthBuffer;
-	}
-
-	if (m_ColorBuffer)
-	{
-		delete m_ColorBuffer;
-	}
-
-	const VkDevice vkDevice = m_Device->GetVkDevice();
-	if (vkDevice && m_RenderPass)
-	{
-		vkDestroyRenderPass(vkDevice, m_RenderPass, nullptr);
-	}
-
 	for (RenderTarget* renderTarget : m_SwapchainRenderTargets)
 	{
 		delete renderTarget;
@@ -330,6 +230,8 @@ Headset::~Headset()
 
 Headset::BeginFrameResult Headset::BeginFrame(uint32_t& outSwapchainImageIndex)
 {
+	SPECTRE_PROFILE_ZONE("Headset::BeginFrame");
+
 	const XrInstance instance{ m_Device->GetXrInstance() };
 
 	// Poll OpenXR events
@@ -429,7 +331,7 @@ Headset::BeginFrameResult Headset::BeginFrame(uint32_t& outSwapchainImageIndex)
 		eyeRenderInfo.fov = eyePose.fov;
 		const XrPosef& pose = eyeRenderInfo.pose;
 		m_EyeViewMatrices.at(eyeIndex) = glm::inverse(utils::ToMatrix(pose));
-		m_EyeProjectionMatrices.at(eyeIndex) = utils::CreateProjectionMatrix(eyeRenderInfo.fov, 0.01f, 250.0f);
+		m_EyeProjectionMatrices.at(eyeIndex) = utils::CreateProjectionMatrix(eyeRenderInfo.fov, Spectre::nearClip, Spectre::farClip);
 
 		m_ViewerPosition = glm::vec3(pose.position.x, pose.position.y, pose.position.z) - m_ViewerPositionOffset;
 		m_ViewerOrientation = glm::quat(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
@@ -461,6 +363,8 @@ Headset::BeginFrameResult Headset::BeginFrame(uint32_t& outSwapchainImageIndex)
 
 void Headset::EndFrame() const
 {
+	SPECTRE_PROFILE_ZONE("Headset::EndFrame");
+
 	// Release the swapchain image
 	XrSwapchainImageReleaseInfo swapchainImageReleaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
 	XrResult					result{ xrReleaseSwapchainImage(m_Swapchain, &swapchainImageReleaseInfo) };
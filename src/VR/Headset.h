@@ -7,17 +7,14 @@
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <glm/gtx/quaternion.hpp>
-class VulkanDevice;
-class ImageBuffer;
-class RenderTarget;
 
+#include "StereoView.h"
 
-class Headset final
+class Headset final : public StereoView
 {
 public:
-	Headset(){};
-	Headset(const VulkanDevice* m_Device);
-	~Headset();
+	explicit Headset(const VulkanDevice* m_Device);
+	~Headset() override;
 
 	enum class BeginFrameResult
 	{
@@ -33,13 +30,13 @@ public:
 	XrSession	 GetXrSession() const { return m_Session; }
 	XrSpace		 GetXrSpace() const { return m_Space; }
 	XrFrameState GetXrFrameState() const { return m_FrameState; }
-	VkRenderPass GetVkRenderPass() const { return m_RenderPass; }
-	size_t		 GetEyeCount() const { return m_EyeCount; }
 
-	VkExtent2D	  GetEyeResolution(size_t eyeIndex) const;
-	glm::mat4	  GetEyeViewMatrix(size_t eyeIndex) const { return m_EyeViewMatrices.at(eyeIndex); }
-	glm::mat4	  GetEyeProjectionMatrix(size_t eyeIndex) const { return m_EyeProjectionMatrices.at(eyeIndex); }
-	RenderTarget* GetRenderTarget(size_t swapchainImageIndex) const { return m_SwapchainRenderTargets.at(swapchainImageIndex); }
+	size_t		  GetEyeCount() const override { return m_EyeCount; }
+	VkExtent2D	  GetEyeResolution(size_t eyeIndex) const override;
+	glm::mat4	  GetEyeViewMatrix(size_t eyeIndex) const override { return m_EyeViewMatrices.at(eyeIndex); }
+	glm::mat4	  GetEyeProjectionMatrix(size_t eyeIndex) const override { return m_EyeProjectionMatrices.at(eyeIndex); }
+	XrFovf		  GetEyeFov(size_t eyeIndex) const override { return m_EyeRenderInfos.at(eyeIndex).fov; }
+	RenderTarget* GetRenderTarget(size_t swapchainImageIndex) const override { return m_SwapchainRenderTargets.at(swapchainImageIndex); }
 	
 	const XrPosef& GetEyePose(size_t eyeIndex) const { return m_EyePoses.at(eyeIndex).pose; };
 
@@ -54,8 +51,6 @@ public:
 private:
 	bool m_ExitRequested{ false };
 
-	const VulkanDevice* m_Device{ nullptr };
-
 	size_t				   m_EyeCount = 0u;
 	std::vector<glm::mat4> m_EyeViewMatrices;
 	std::vector<glm::mat4> m_EyeProjectionMatrices;
@@ -76,13 +71,8 @@ private:
 	XrSwapchain				   m_Swapchain{ nullptr };
 	std::vector<RenderTarget*> m_SwapchainRenderTargets;
 
-	VkRenderPass m_RenderPass{ nullptr };
-
-	ImageBuffer *m_ColorBuffer{ nullptr }, *m_DepthBuffer{ nullptr };
-
 	bool BeginSession() const;
 	bool EndSession() const;
 	void CreateSwapChain(const VkDevice& vkDevice, const VkExtent2D& eyeResolution);
-	void CreateRenderPass(const VkSampleCountFlagBits& m_MultisampleCount, const VkDevice& vkDevice);
 	void VerifyColorFormatSupport();
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "StereoView.h"
+
+#include "../Misc/Utils.h"
+#include "../VulkanBase/VulkanDevice.h"
+
+#include <array>
+
+StereoView::StereoView(const VulkanDevice* device) : m_Device(device)
+{
+	// The render pass is only needed when dynamic rendering is unavailable
+	if (!device->UsesDynamicRendering())
+	{
+		CreateRenderPass(device->GetMultisampleCount(), device->GetVkDevice());
+	}
+}
+
+StereoView::~StereoView()
+{
+	const VkDevice vkDevice = m_Device->GetVkDevice();
+	if (vkDevice && m_RenderPass)
+	{
+		vkDestroyRenderPass(vkDevice, m_RenderPass, nullptr);
+	}
+}
+
+Spectre::RenderTargetLayout StereoView::GetRenderTargetLayout() const
+{
+	Spectre::RenderTargetLayout renderTargetLayout;
+	renderTargetLayout.renderPass = m_RenderPass;
+	renderTargetLayout.colorFormat = Spectre::eyeColorFormat;
+	renderTargetLayout.depthFormat = Spectre::eyeDepthFormat;
+	renderTargetLayout.sampleCount = m_Device->GetMultisampleCount();
+	renderTargetLayout.viewMask = Spectre::eyeViewMask;
+	return renderTargetLayout;
+}
+
+void StereoView::CreateRenderPass(VkSampleCountFlagBits multisampleCount, VkDevice vkDevice)
+{
+	constexpr uint32_t correlationMask{ 0b00000011 };
+
+	VkRenderPassMultiviewCreateInfo renderPassMultiviewCreateInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO };
+	renderPassMultiviewCreateInfo.subpassCount = 1u;
+	renderPassMultiviewCreateInfo.pViewMasks = &Spectre::eyeViewMask;
+	renderPassMultiviewCreateInfo.correlationMaskCount = 1u;
+	renderPassMultiviewCreateInfo.pCorrelationMasks = &correlationMask;
+
+	// The render graph transitions the attachments before the pass begins, the multisampled color is only resolved, never stored
+	VkAttachmentDescription colorAttachmentDescription{};
+	colorAttachmentDescription.format = Spectre::eyeColorFormat;
+	colorAttachmentDescription.samples = multisampleCount;
+	colorAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentReference{};
+	colorAttachmentReference.attachment = 0u;
+	colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription depthAttachmentDescription{};
+	depthAttachmentDescription.format = Spectre::eyeDepthFormat;
+	depthAttachmentDescription.samples = multisampleCount;
+	depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentReference{};
+	depthAttachmentReference.attachment = 1u;
+	depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription resolveAttachmentDescription{};
+	resolveAttachmentDescription.format = Spectre::eyeColorFormat;
+	resolveAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+	resolveAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolveAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	resolveAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolveAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	resolveAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	resolveAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference resolveAttachmentReference{};
+	resolveAttachmentReference.attachment = 2u;
+	resolveAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpassDescription{};
+	subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpassDescription.colorAttachmentCount = 1u;
+	subpassDescription.pColorAttachments = &colorAttachmentReference;
+	subpassDescription.pDepthStencilAttachment = &depthAttachmentReference;
+	subpassDescription.pResolveAttachments = &resolveAttachmentReference;
+
+	const std::array attachments{ colorAttachmentDescription, depthAttachmentDescription, resolveAttachmentDescription };
+
+	VkRenderPassCreateInfo renderPassCreateInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+	renderPassCreateInfo.pNext = &renderPassMultiviewCreateInfo;
+	renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassCreateInfo.pAttachments = attachments.data();
+	renderPassCreateInfo.subpassCount = 1u;
+	renderPassCreateInfo.pSubpasses = &subpassDescription;
+	if (vkCreateRenderPass(vkDevice, &renderPassCreateInfo, nullptr, &m_RenderPass) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <openxr/openxr.h>
+#include <vulkan/vulkan.h>
+
+#include "../VulkanBase/VulkanPipeline.h"
+
+class VulkanDevice;
+class RenderTarget;
+
+namespace Spectre
+{
+	constexpr float nearClip = 0.01f;
+	constexpr float farClip = 250.0f;
+
+	constexpr VkFormat eyeColorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+	constexpr VkFormat eyeDepthFormat = VK_FORMAT_D32_SFLOAT;
+	constexpr uint32_t eyeViewMask = 0b00000011; // Both eyes are drawn at once with multiview
+} // namespace Spectre
+
+/*
+ * The stereo view is what the renderer draws into, one layer per eye of a layered render target with a view and
+ * projection matrix each. The headset implements it with the OpenXR swapchain, the headless view with offscreen images.
+ * Both share the attachment formats and, when dynamic rendering is unavailable, the multiview render pass.
+ */
+class StereoView
+{
+public:
+	explicit StereoView(const VulkanDevice* device);
+	virtual ~StereoView();
+	StereoView(const StereoView&) = delete;
+	StereoView& operator=(const StereoView&) = delete;
+
+	virtual size_t		  GetEyeCount() const = 0;
+	virtual VkExtent2D	  GetEyeResolution(size_t eyeIndex) const = 0;
+	virtual glm::mat4	  GetEyeViewMatrix(size_t eyeIndex) const = 0;
+	virtual glm::mat4	  GetEyeProjectionMatrix(size_t eyeIndex) const = 0;
+	virtual XrFovf		  GetEyeFov(size_t eyeIndex) const = 0; // The projection matrix is made from it
+	virtual RenderTarget* GetRenderTarget(size_t swapchainImageIndex) const = 0;
+
+	VkRenderPass GetVkRenderPass() const { return m_RenderPass; }
+	// Describes the eye attachments, the render pass is null when rendering with dynamic rendering
+	Spectre::RenderTargetLayout GetRenderTargetLayout() const;
+
+protected:
+	const VulkanDevice* m_Device{ nullptr };
+
+private:
+	VkRenderPass m_RenderPass{ nullptr };
+
+	void CreateRenderPass(VkSampleCountFlagBits multisampleCount, VkDevice vkDevice);
+};
@@ -0,0 +1,90 @@
+#include "AsyncComputeQueue.h"
+
+#include "../Misc/Utils.h"
+#include "GpuProfiler.h"
+#include "QueueTimeline.h"
+#include "VulkanDevice.h"
+
+#include <iostream>
+
+AsyncComputeQueue::AsyncComputeQueue(const VulkanDevice* device, size_t frameCount) : m_Device(device)
+{
+	const VkDevice vkDevice{ device->GetVkDevice() };
+
+	VkCommandPoolCreateInfo commandPoolCreateInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	commandPoolCreateInfo.queueFamilyIndex = device->GetVkComputeQueueFamilyIndex();
+	if (vkCreateCommandPool(vkDevice, &commandPoolCreateInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	m_CommandBuffers.resize(frameCount);
+	VkCommandBufferAllocateInfo commandBufferAllocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	commandBufferAllocateInfo.commandPool = m_CommandPool;
+	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferAllocateInfo.commandBufferCount = static_cast<uint32_t>(m_CommandBuffers.size());
+	if (vkAllocateCommandBuffers(vkDevice, &commandBufferAllocateInfo, m_CommandBuffers.data()) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	// Compute queues can only count compute shader invocations
+	const VkQueryPipelineStatisticFlags statisticFlags{ device->SupportsPipelineStatisticsQuery() ? VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT : 0u };
+	m_GpuProfiler = new GpuProfiler(device, "Async compute queue", device->GetComputeQueueTimestampValidBits(), statisticFlags, frameCount);
+}
+
+AsyncComputeQueue::~AsyncComputeQueue()
+{
+	delete m_GpuProfiler;
+
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice && m_CommandPool)
+	{
+		vkDestroyCommandPool(vkDevice, m_CommandPool, nullptr);
+	}
+}
+
+VkCommandBuffer AsyncComputeQueue::Begin(size_t frameIndex)
+{
+	const VkCommandBuffer commandBuffer{ m_CommandBuffers.at(frameIndex) };
+	if (vkResetCommandBuffer(commandBuffer, 0u) != VK_SUCCESS)
+	{
+		return nullptr;
+	}
+
+	VkCommandBufferBeginInfo commandBufferBeginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+	{
+		return nullptr;
+	}
+
+	// The draw queue of this frame waited on the previous submission and has finished since, so its results are available
+	m_GpuProfiler->BeginFrame(frameIndex, commandBuffer);
+	return commandBuffer;
+}
+
+uint64_t AsyncComputeQueue::Submit(size_t frameIndex)
+{
+	const VkCommandBuffer commandBuffer{ m_CommandBuffers.at(frameIndex) };
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		return 0u;
+	}
+
+	const uint64_t signalValue{ m_Device->GetComputeQueueTimeline()->Submit({ commandBuffer }) };
+	if (signalValue == 0u)
+	{
+		return 0u;
+	}
+
+	++m_SubmissionCount;
+	return signalValue;
+}
+
+void AsyncComputeQueue::LogStatistics() const
+{
+	std::cout << "Async compute queue: " << m_SubmissionCount << " submission(s)" << std::endl;
+	m_GpuProfiler->LogStatistics();
+}
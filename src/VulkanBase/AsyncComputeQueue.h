@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class GpuProfiler;
+class VulkanDevice;
+
+/*
+ * The async compute queue records compute work like light culling into command buffers of the dedicated compute queue
+ * family, so it runs next to the graphics work of the previous frame instead of in front of the current one. Every frame
+ * in flight has its own command buffer. The draw queue waits for the compute queue timeline value of its own frame right
+ * before the stage that consumes the results. The queue has its own GPU profiler, its scopes measure how long the work
+ * takes on the compute queue, which is the time the draw queue no longer spends on it.
+ */
+class AsyncComputeQueue final
+{
+public:
+	AsyncComputeQueue(const VulkanDevice* device, size_t frameCount);
+	~AsyncComputeQueue();
+	AsyncComputeQueue(const AsyncComputeQueue&) = delete;
+	AsyncComputeQueue& operator=(const AsyncComputeQueue&) = delete;
+
+	// The previous submission of the frame must have completed, returns nullptr on failure
+	VkCommandBuffer Begin(size_t frameIndex);
+	// Returns the compute queue timeline value that is reached once the work is done, zero on failure
+	uint64_t Submit(size_t frameIndex);
+
+	// Scopes of the work recorded between Begin() and Submit()
+	GpuProfiler* GetGpuProfiler() const { return m_GpuProfiler; }
+	void		 LogStatistics() const;
+
+private:
+	const VulkanDevice*			 m_Device{ nullptr };
+	VkCommandPool				 m_CommandPool{ nullptr };
+	std::vector<VkCommandBuffer> m_CommandBuffers;
+	GpuProfiler*				 m_GpuProfiler{ nullptr };
+	size_t						 m_SubmissionCount{ 0u };
+};
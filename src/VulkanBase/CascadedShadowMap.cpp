@@ -0,0 +1,383 @@
+#include "CascadedShadowMap.h"
+
+#include "../Buffers/ImageBuffer.h"
+#include "../Misc/Utils.h"
+#include "../VR/StereoView.h"
+#include "VulkanDevice.h"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	constexpr VkFormat	 shadowMapFormat = VK_FORMAT_D32_SFLOAT;
+	constexpr uint32_t	 cascadeViewMask = (1u << Spectre::shadowCascadeCount) - 1u;
+	constexpr float		 cascadeRadiusGranularity = 16.0f; // Radii are rounded up to 1/16 m so refits rarely change the texel size
+	constexpr float		 normalOffsetTexels = 1.5f;
+	constexpr float		 depthBiasTexels = 1.0f;
+	constexpr VkExtent2D shadowMapExtent{ Spectre::shadowMapResolution, Spectre::shadowMapResolution };
+} // namespace
+
+CascadedShadowMap::CascadedShadowMap(const VulkanDevice* device) : m_Device(device)
+{
+	const VkDevice vkDevice{ device->GetVkDevice() };
+
+	// The cache is only ever copied from, the map it is copied into is what the lit shaders sample
+	m_StaticCache = new ImageBuffer(device, shadowMapExtent, shadowMapFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, Spectre::shadowCascadeCount);
+	m_ShadowMap = new ImageBuffer(device, shadowMapExtent, shadowMapFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, Spectre::shadowCascadeCount);
+
+	CreateSampler(vkDevice);
+
+	if (!device->UsesDynamicRendering())
+	{
+		CreateRenderPasses(vkDevice);
+	}
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice)
+	{
+		if (m_ShadowMapFramebuffer)
+		{
+			vkDestroyFramebuffer(vkDevice, m_ShadowMapFramebuffer, nullptr);
+		}
+
+		if (m_StaticCacheFramebuffer)
+		{
+			vkDestroyFramebuffer(vkDevice, m_StaticCacheFramebuffer, nullptr);
+		}
+
+		if (m_LoadRenderPass)
+		{
+			vkDestroyRenderPass(vkDevice, m_LoadRenderPass, nullptr);
+		}
+
+		if (m_ClearRenderPass)
+		{
+			vkDestroyRenderPass(vkDevice, m_ClearRenderPass, nullptr);
+		}
+
+		if (m_Sampler)
+		{
+			vkDestroySampler(vkDevice, m_Sampler, nullptr);
+		}
+	}
+
+	delete m_ShadowMap;
+	delete m_StaticCache;
+}
+
+void CascadedShadowMap::CreateSampler(const VkDevice& vkDevice)
+{
+	// Hardware depth comparison, with linear filtering every lookup is a 2x2 percentage closer filter
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_Device->GetVkPhysicalDevice(), shadowMapFormat, &formatProperties);
+	const bool supportsLinearFilter{ (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0u };
+
+	VkSamplerCreateInfo samplerCreateInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerCreateInfo.magFilter = supportsLinearFilter ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	samplerCreateInfo.minFilter = samplerCreateInfo.magFilter;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE; // Everything outside of a cascade is lit
+	samplerCreateInfo.compareEnable = VK_TRUE;
+	samplerCreateInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = 0.0f;
+	if (vkCreateSampler(vkDevice, &samplerCreateInfo, nullptr, &m_Sampler) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+}
+
+void CascadedShadowMap::CreateRenderPasses(const VkDevice& vkDevice)
+{
+	// One view per cascade, the cascades don't share any geometry so there is no correlation to hint at
+	const uint32_t viewMask{ cascadeViewMask };
+
+	VkRenderPassMultiviewCreateInfo renderPassMultiviewCreateInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO };
+	renderPassMultiviewCreateInfo.subpassCount = 1u;
+	renderPassMultiviewCreateInfo.pViewMasks = &viewMask;
+
+	// Layout transitions are barriers recorded by the render graph, the same as with dynamic rendering
+	VkAttachmentDescription depthAttachmentDescription{};
+	depthAttachmentDescription.format = shadowMapFormat;
+	depthAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentReference{};
+	depthAttachmentReference.attachment = 0u;
+	depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpassDescription{};
+	subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpassDescription.pDepthStencilAttachment = &depthAttachmentReference;
+
+	VkRenderPassCreateInfo renderPassCreateInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+	renderPassCreateInfo.pNext = &renderPassMultiviewCreateInfo;
+	renderPassCreateInfo.attachmentCount = 1u;
+	renderPassCreateInfo.pAttachments = &depthAttachmentDescription;
+	renderPassCreateInfo.subpassCount = 1u;
+	renderPassCreateInfo.pSubpasses = &subpassDescription;
+	if (vkCreateRenderPass(vkDevice, &renderPassCreateInfo, nullptr, &m_ClearRenderPass) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	// Only the load operation differs, so both render passes are compatible with the same pipelines
+	depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	if (vkCreateRenderPass(vkDevice, &renderPassCreateInfo, nullptr, &m_LoadRenderPass) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	VkFramebufferCreateInfo framebufferCreateInfo{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+	framebufferCreateInfo.attachmentCount = 1u;
+	framebufferCreateInfo.width = shadowMapExtent.width;
+	framebufferCreateInfo.height = shadowMapExtent.height;
+	framebufferCreateInfo.layers = 1u;
+
+	const VkImageView staticCacheImageView{ m_StaticCache->GetImageView() };
+	framebufferCreateInfo.renderPass = m_ClearRenderPass;
+	framebufferCreateInfo.pAttachments = &staticCacheImageView;
+	if (vkCreateFramebuffer(vkDevice, &framebufferCreateInfo, nullptr, &m_StaticCacheFramebuffer) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	const VkImageView shadowMapImageView{ m_ShadowMap->GetImageView() };
+	framebufferCreateInfo.renderPass = m_LoadRenderPass;
+	framebufferCreateInfo.pAttachments = &shadowMapImageView;
+	if (vkCreateFramebuffer(vkDevice, &framebufferCreateInfo, nullptr, &m_ShadowMapFramebuffer) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+}
+
+Spectre::RenderTargetLayout CascadedShadowMap::GetRenderTargetLayout() const
+{
+	Spectre::RenderTargetLayout renderTargetLayout;
+	renderTargetLayout.renderPass = m_ClearRenderPass;
+	renderTargetLayout.depthFormat = shadowMapFormat;
+	renderTargetLayout.sampleCount = VK_SAMPLE_COUNT_1_BIT;
+	renderTargetLayout.viewMask = cascadeViewMask;
+	return renderTargetLayout;
+}
+
+VkImage CascadedShadowMap::GetStaticCacheImage() const { return m_StaticCache->GetImage(); }
+
+VkImage CascadedShadowMap::GetImage() const { return m_ShadowMap->GetImage(); }
+
+VkImageView CascadedShadowMap::GetImageView() const { return m_ShadowMap->GetImageView(); }
+
+void CascadedShadowMap::Update(const StereoView* stereoView, const glm::mat4& cameraMatrix, const glm::vec3& lightDirection, UniformData& outUniformData)
+{
+	++m_FrameCount;
+
+	// Refitting on every small step of the animated sun would redraw the static cache each frame, so it moves in coarse steps
+	const glm::vec3 direction{ glm::normalize(lightDirection) };
+	const bool		hasSunMoved{ !m_HasCascades || glm::dot(direction, m_LightDirection) < std::cos(glm::radians(Spectre::shadowLightDirectionTolerance)) };
+	if (hasSunMoved)
+	{
+		m_LightDirection = direction;
+	}
+
+	// Split the shadowed depth range between uniform and logarithmic distribution, the near cascades get the most texels
+	std::array<float, Spectre::shadowCascadeCount + 1u> splits;
+	splits.front() = Spectre::nearClip;
+	for (uint32_t cascadeIndex = 1u; cascadeIndex <= Spectre::shadowCascadeCount; ++cascadeIndex)
+	{
+		const float fraction{ static_cast<float>(cascadeIndex) / static_cast<float>(Spectre::shadowCascadeCount) };
+		const float uniformSplit{ Spectre::nearClip + (Spectre::shadowDistance - Spectre::nearClip) * fraction };
+		const float logarithmicSplit{ Spectre::nearClip * std::pow(Spectre::shadowDistance / Spectre::nearClip, fraction) };
+		splits.at(cascadeIndex) = uniformSplit + (logarithmicSplit - uniformSplit) * Spectre::shadowSplitLambda;
+	}
+
+	// The four frustum edges of every eye in world space, scaled so that they reach a view depth of one
+	const size_t		   eyeCount{ stereoView->GetEyeCount() };
+	std::vector<glm::vec3> eyePositions(eyeCount);
+	std::vector<glm::vec3> edgeDirections;
+	edgeDirections.reserve(eyeCount * 4u);
+	for (size_t eyeIndex = 0u; eyeIndex < eyeCount; ++eyeIndex)
+	{
+		const glm::mat4 inverseViewMatrix{ glm::inverse(stereoView->GetEyeViewMatrix(eyeIndex) * cameraMatrix) };
+		const glm::mat4 inverseProjectionMatrix{ glm::inverse(stereoView->GetEyeProjectionMatrix(eyeIndex)) };
+		eyePositions.at(eyeIndex) = glm::vec3(inverseViewMatrix[3]);
+
+		for (const glm::vec2 corner : { glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(-1.0f, 1.0f), glm::vec2(1.0f, 1.0f) })
+		{
+			const glm::vec4 farPoint{ inverseProjectionMatrix * glm::vec4(corner, 1.0f, 1.0f) };
+			const glm::vec3 viewDirection{ glm::vec3(farPoint) / -farPoint.z };
+			edgeDirections.push_back(glm::vec3(inverseViewMatrix * glm::vec4(viewDirection, 0.0f)));
+		}
+	}
+
+	for (uint32_t cascadeIndex = 0u; cascadeIndex < Spectre::shadowCascadeCount; ++cascadeIndex)
+	{
+		// Bound the slice of both eye frustums with a sphere, unlike a box it doesn't change size when the head turns
+		std::vector<glm::vec3> corners;
+		corners.reserve(edgeDirections.size() * 2u);
+		for (size_t edgeIndex = 0u; edgeIndex < edgeDirections.size(); ++edgeIndex)
+		{
+			const glm::vec3& eyePosition{ eyePositions.at(edgeIndex / 4u) };
+			corners.push_back(eyePosition + edgeDirections.at(edgeIndex) * splits.at(cascadeIndex));
+			corners.push_back(eyePosition + edgeDirections.at(edgeIndex) * splits.at(cascadeIndex + 1u));
+		}
+
+		glm::vec3 center{ 0.0f };
+		for (const glm::vec3& corner : corners)
+		{
+			center += corner;
+		}
+		center /= static_cast<float>(corners.size());
+
+		float radius{ 0.0f };
+		for (const glm::vec3& corner : corners)
+		{
+			radius = std::max(radius, glm::length(corner - center));
+		}
+
+		// Keep the cached cascade as long as it still covers the slice, its static casters don't have to be drawn again
+		Cascade& cascade{ m_Cascades.at(cascadeIndex) };
+		if (hasSunMoved || glm::length(center - cascade.center) + radius > cascade.radius)
+		{
+			FitCascade(cascade, center, radius);
+			m_IsStaticCacheDirty = true;
+		}
+
+		outUniformData.cascadeMatrices.at(cascadeIndex) = cascade.matrix;
+		outUniformData.cascadeSplits[cascadeIndex] = splits.at(cascadeIndex + 1u);
+		outUniformData.cascadeTexelSizes[cascadeIndex] = cascade.texelSize * normalOffsetTexels;
+		outUniformData.cascadeDepthBiases[cascadeIndex] = cascade.texelSize * depthBiasTexels / cascade.depthRange;
+	}
+	outUniformData.parameters = glm::vec4(1.0f / static_cast<float>(Spectre::shadowMapResolution), 0.0f, 0.0f, 0.0f);
+
+	m_HasCascades = true;
+}
+
+void CascadedShadowMap::FitCascade(Cascade& cascade, const glm::vec3& center, float radius) const
+{
+	cascade.radius = std::ceil(radius * (1.0f + Spectre::shadowCascadeMargin) * cascadeRadiusGranularity) / cascadeRadiusGranularity;
+	cascade.texelSize = 2.0f * cascade.radius / static_cast<float>(Spectre::shadowMapResolution);
+	cascade.depthRange = 2.0f * cascade.radius + Spectre::shadowCasterDistance;
+
+	// Move the center in whole texels of the light's view so the shadow edges don't crawl when a cascade is refitted
+	const glm::vec3 up{ std::abs(m_LightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f) };
+	const glm::mat4 lightRotation{ glm::lookAt(glm::vec3(0.0f), m_LightDirection, up) };
+	glm::vec3		lightSpaceCenter{ lightRotation * glm::vec4(center, 1.0f) };
+	lightSpaceCenter.x = std::floor(lightSpaceCenter.x / cascade.texelSize) * cascade.texelSize;
+	lightSpaceCenter.y = std::floor(lightSpaceCenter.y / cascade.texelSize) * cascade.texelSize;
+	cascade.center = glm::vec3(glm::inverse(lightRotation) * glm::vec4(lightSpaceCenter, 1.0f));
+
+	// Casters between the sun and the cascade still have to land in the map, so the near plane is pulled back towards the sun
+	const glm::mat4 viewMatrix{ glm::lookAt(cascade.center - m_LightDirection * (cascade.radius + Spectre::shadowCasterDistance), cascade.center, up) };
+	const glm::mat4 projectionMatrix{ glm::orthoRH_ZO(-cascade.radius, cascade.radius, -cascade.radius, cascade.radius, 0.0f, cascade.depthRange) };
+	cascade.matrix = projectionMatrix * viewMatrix;
+}
+
+void CascadedShadowMap::BeginStaticPass(VkCommandBuffer commandBuffer) const { BeginPass(commandBuffer, m_StaticCache, m_ClearRenderPass, m_StaticCacheFramebuffer, VK_ATTACHMENT_LOAD_OP_CLEAR); }
+
+void CascadedShadowMap::EndStaticPass(VkCommandBuffer commandBuffer)
+{
+	EndPass(commandBuffer);
+
+	m_IsStaticCacheDirty = false;
+	++m_StaticPassCount;
+}
+
+void CascadedShadowMap::CopyStaticCache(VkCommandBuffer commandBuffer) const
+{
+	VkImageCopy imageCopy{};
+	imageCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	imageCopy.srcSubresource.mipLevel = 0u;
+	imageCopy.srcSubresource.baseArrayLayer = 0u;
+	imageCopy.srcSubresource.layerCount = Spectre::shadowCascadeCount;
+	imageCopy.dstSubresource = imageCopy.srcSubresource;
+	imageCopy.extent = { shadowMapExtent.width, shadowMapExtent.height, 1u };
+	vkCmdCopyImage(commandBuffer, m_StaticCache->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ShadowMap->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &imageCopy);
+}
+
+void CascadedShadowMap::BeginDynamicPass(VkCommandBuffer commandBuffer) const { BeginPass(commandBuffer, m_ShadowMap, m_LoadRenderPass, m_ShadowMapFramebuffer, VK_ATTACHMENT_LOAD_OP_LOAD); }
+
+void CascadedShadowMap::EndDynamicPass(VkCommandBuffer commandBuffer) const { EndPass(commandBuffer); }
+
+void CascadedShadowMap::BeginPass(VkCommandBuffer commandBuffer, const ImageBuffer* imageBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer, VkAttachmentLoadOp loadOp) const
+{
+	VkRect2D renderArea;
+	renderArea.offset = { 0, 0 };
+	renderArea.extent = shadowMapExtent;
+
+	VkClearValue clearValue;
+	clearValue.depthStencil = { 1.0f, 0u };
+
+	if (m_Device->UsesDynamicRendering())
+	{
+		VkRenderingAttachmentInfo depthAttachmentInfo{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+		depthAttachmentInfo.imageView = imageBuffer->GetImageView();
+		depthAttachmentInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachmentInfo.loadOp = loadOp;
+		depthAttachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachmentInfo.clearValue = clearValue;
+
+		VkRenderingInfo renderingInfo{ VK_STRUCTURE_TYPE_RENDERING_INFO };
+		renderingInfo.renderArea = renderArea;
+		renderingInfo.layerCount = 1u;
+		renderingInfo.viewMask = cascadeViewMask;
+		renderingInfo.pDepthAttachment = &depthAttachmentInfo;
+		vkCmdBeginRendering(commandBuffer, &renderingInfo);
+
+		// Shadow casters are drawn from both sides and always write depth, whatever their materials do in the color pass
+		vkCmdSetCullMode(commandBuffer, VK_CULL_MODE_NONE);
+		vkCmdSetDepthTestEnable(commandBuffer, VK_TRUE);
+		vkCmdSetDepthWriteEnable(commandBuffer, VK_TRUE);
+		vkCmdSetDepthCompareOp(commandBuffer, VK_COMPARE_OP_LESS);
+	}
+	else
+	{
+		VkRenderPassBeginInfo renderPassBeginInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		renderPassBeginInfo.renderPass = renderPass;
+		renderPassBeginInfo.framebuffer = framebuffer;
+		renderPassBeginInfo.renderArea = renderArea;
+		renderPassBeginInfo.clearValueCount = 1u;
+		renderPassBeginInfo.pClearValues = &clearValue;
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	VkViewport viewport;
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(shadowMapExtent.width);
+	viewport.height = static_cast<float>(shadowMapExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0u, 1u, &viewport);
+	vkCmdSetScissor(commandBuffer, 0u, 1u, &renderArea);
+}
+
+void CascadedShadowMap::EndPass(VkCommandBuffer commandBuffer) const
+{
+	if (m_Device->UsesDynamicRendering())
+	{
+		vkCmdEndRendering(commandBuffer);
+	}
+	else
+	{
+		vkCmdEndRenderPass(commandBuffer);
+	}
+}
+
+void CascadedShadowMap::LogStatistics() const { std::cout << "Shadow map: static casters were drawn in " << m_StaticPassCount << " of " << m_FrameCount << " frame(s)" << std::endl; }
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "VulkanPipeline.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+class VulkanDevice;
+class ImageBuffer;
+class StereoView;
+
+namespace Spectre
+{
+	// One multiview layer per cascade, must match shaders/Shadows.glsl
+	constexpr uint32_t shadowCascadeCount = 4u;
+	constexpr uint32_t shadowMapResolution = 2048u;
+	constexpr float	   shadowDistance = 60.0f;				 // View depth at which the last cascade ends
+	constexpr float	   shadowSplitLambda = 0.75f;			 // Blends uniform (0) and logarithmic (1) split distances
+	constexpr float	   shadowCasterDistance = 50.0f;		 // How far towards the sun casters outside a cascade still cast into it
+	constexpr float	   shadowCascadeMargin = 0.25f;			 // Extra cascade radius so small head movements keep the cached cascades
+	constexpr float	   shadowLightDirectionTolerance = 1.0f; // Degrees the sun may move before the cascades are refitted, shadows follow it in steps
+	const std::string  shadowMapVertShaderName = "shaders/ShadowMap.vert.spv";
+} // namespace Spectre
+
+/*
+ * The cascaded shadow map holds the shadows of the sun in one depth layer per cascade. Every cascade is fitted to the
+ * combined frustum slice of both eyes and all cascades are rendered in a single multiview pass, one view per layer.
+ * Static casters are rendered into a separate cache that is only redrawn when the sun has moved or the view has left
+ * the margin around a cascade. Every frame the cache is copied into the sampled map and only the dynamic casters are
+ * drawn on top of it, so the shadow cost stays bounded by the dynamic geometry.
+ */
+class CascadedShadowMap final
+{
+public:
+	// Matches the Shadows uniform block in shaders/Shadows.glsl
+	struct UniformData
+	{
+		std::array<glm::mat4, Spectre::shadowCascadeCount> cascadeMatrices;		// World to shadow clip space
+		glm::vec4											cascadeSplits;		// Far view depth of each cascade
+		glm::vec4											cascadeTexelSizes;	// World space size of a shadow map texel
+		glm::vec4											cascadeDepthBiases;	// In shadow depth units
+		glm::vec4											parameters;			// x = texel size in texture space
+	};
+
+	CascadedShadowMap(const VulkanDevice* device);
+	~CascadedShadowMap();
+	CascadedShadowMap(const CascadedShadowMap&) = delete;
+	CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+	// Fits the cascades to both eye frustums, refitting them marks the static cache dirty
+	void Update(const StereoView* stereoView, const glm::mat4& cameraMatrix, const glm::vec3& lightDirection, UniformData& outUniformData);
+	// Static casters have been added, removed or moved
+	void InvalidateStaticCache() { m_IsStaticCacheDirty = true; }
+	bool IsStaticCacheDirty() const { return m_IsStaticCacheDirty; }
+
+	// Each step is a render graph pass, the graph transitions the images between them
+	void BeginStaticPass(VkCommandBuffer commandBuffer) const;
+	void EndStaticPass(VkCommandBuffer commandBuffer);
+	void CopyStaticCache(VkCommandBuffer commandBuffer) const;
+	void BeginDynamicPass(VkCommandBuffer commandBuffer) const;
+	void EndDynamicPass(VkCommandBuffer commandBuffer) const;
+
+	Spectre::RenderTargetLayout GetRenderTargetLayout() const;
+	VkImage						GetStaticCacheImage() const;
+	VkImage						GetImage() const;
+	VkImageView					GetImageView() const;
+	VkSampler					GetSampler() const { return m_Sampler; }
+	void						LogStatistics() const;
+
+private:
+	struct Cascade
+	{
+		glm::vec3 center{ 0.0f };
+		float	  radius{ 0.0f };
+		float	  texelSize{ 0.0f };
+		float	  depthRange{ 0.0f };
+		glm::mat4 matrix{ 1.0f };
+	};
+
+	const VulkanDevice* m_Device{ nullptr };
+	ImageBuffer*		m_StaticCache{ nullptr };
+	ImageBuffer*		m_ShadowMap{ nullptr };
+	VkSampler			m_Sampler{ nullptr };
+	VkRenderPass		m_ClearRenderPass{ nullptr }, m_LoadRenderPass{ nullptr };
+	VkFramebuffer		m_StaticCacheFramebuffer{ nullptr }, m_ShadowMapFramebuffer{ nullptr };
+
+	std::array<Cascade, Spectre::shadowCascadeCount> m_Cascades;
+	glm::vec3										 m_LightDirection{ 0.0f };
+	bool											 m_HasCascades{ false };
+	bool											 m_IsStaticCacheDirty{ true };
+	size_t											 m_FrameCount{ 0u };
+	size_t											 m_StaticPassCount{ 0u };
+
+	void CreateRenderPasses(const VkDevice& vkDevice);
+	void CreateSampler(const VkDevice& vkDevice);
+	void FitCascade(Cascade& cascade, const glm::vec3& center, float radius) const;
+	void BeginPass(VkCommandBuffer commandBuffer, const ImageBuffer* imageBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer, VkAttachmentLoadOp loadOp) const;
+	void EndPass(VkCommandBuffer commandBuffer) const;
+};
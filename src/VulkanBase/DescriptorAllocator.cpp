@@ -0,0 +1,277 @@
+#include "DescriptorAllocator.h"
+
+#include "../Misc/Utils.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	bool IsImageDescriptor(VkDescriptorType type) { return type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE || type == VK_DESCRIPTOR_TYPE_SAMPLER; }
+} // namespace
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device, size_t framesInFlightCount) : m_Device(device) { m_FrameSetCounts.resize(framesInFlightCount, 0u); }
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	if (m_Device)
+	{
+		for (auto& [layout, layoutChains] : m_Layouts)
+		{
+			std::vector<PoolChain*> chains{ &layoutChains.persistentChain };
+			for (PoolChain& frameChain : layoutChains.frameChains)
+			{
+				chains.push_back(&frameChain);
+			}
+
+			for (const PoolChain* chain : chains)
+			{
+				for (VkDescriptorPool pool : chain->pools)
+				{
+					vkDestroyDescriptorPool(m_Device, pool, nullptr);
+				}
+
+				for (VkDescriptorPool pool : chain->freePools)
+				{
+					vkDestroyDescriptorPool(m_Device, pool, nullptr);
+				}
+			}
+		}
+	}
+}
+
+void DescriptorAllocator::RegisterLayout(VkDescriptorSetLayout layout, const VkDescriptorSetLayoutCreateInfo& createInfo)
+{
+	LayoutChains& layoutChains{ m_Layouts[layout] };
+	layoutChains.frameChains.resize(m_FrameSetCounts.size());
+
+	// Bindings of the same type share a pool size
+	layoutChains.descriptorsPerSet.clear();
+	for (uint32_t bindingIndex = 0u; bindingIndex < createInfo.bindingCount; ++bindingIndex)
+	{
+		const VkDescriptorSetLayoutBinding& binding{ createInfo.pBindings[bindingIndex] };
+		const auto							it{ std::find_if(layoutChains.descriptorsPerSet.begin(), layoutChains.descriptorsPerSet.end(), [&binding](const VkDescriptorPoolSize& poolSize) { return poolSize.type == binding.descriptorType; }) };
+		if (it != layoutChains.descriptorsPerSet.end())
+		{
+			it->descriptorCount += binding.descriptorCount;
+		}
+		else
+		{
+			layoutChains.descriptorsPerSet.push_back({ binding.descriptorType, binding.descriptorCount });
+		}
+	}
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+{
+	LayoutChains& layoutChains{ m_Layouts.at(layout) };
+	return Allocate(layoutChains.persistentChain, layout, layoutChains.descriptorsPerSet);
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateForFrame(VkDescriptorSetLayout layout, size_t frameIndex)
+{
+	LayoutChains&		  layoutChains{ m_Layouts.at(layout) };
+	const VkDescriptorSet descriptorSet{ Allocate(layoutChains.frameChains.at(frameIndex), layout, layoutChains.descriptorsPerSet) };
+
+	size_t& frameSetCount{ m_FrameSetCounts.at(frameIndex) };
+	m_PeakFrameSetCount = std::max(m_PeakFrameSetCount, ++frameSetCount);
+	return descriptorSet;
+}
+
+VkDescriptorSet DescriptorAllocator::GetCached(VkDescriptorSetLayout layout, const std::vector<Binding>& bindings)
+{
+	CacheKey   key{ layout, bindings };
+	const auto it{ m_CachedSets.find(key) };
+	if (it != m_CachedSets.end())
+	{
+		++m_CacheHitCount;
+		return it->second;
+	}
+
+	const VkDescriptorSet descriptorSet{ Allocate(layout) };
+
+	std::vector<VkWriteDescriptorSet> writeDescriptorSets(bindings.size(), { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET });
+	for (size_t bindingIndex = 0u; bindingIndex < bindings.size(); ++bindingIndex)
+	{
+		const Binding&		  binding{ bindings.at(bindingIndex) };
+		VkWriteDescriptorSet& writeDescriptorSet{ writeDescriptorSets.at(bindingIndex) };
+		writeDescriptorSet.dstSet = descriptorSet;
+		writeDescriptorSet.dstBinding = binding.binding;
+		writeDescriptorSet.descriptorCount = 1u;
+		writeDescriptorSet.descriptorType = binding.type;
+		if (IsImageDescriptor(binding.type))
+		{
+			writeDescriptorSet.pImageInfo = &binding.imageInfo;
+		}
+		else
+		{
+			writeDescriptorSet.pBufferInfo = &binding.bufferInfo;
+		}
+	}
+	vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0u, nullptr);
+
+	m_CachedSets.emplace(std::move(key), descriptorSet);
+	return descriptorSet;
+}
+
+void DescriptorAllocator::ResetFrame(size_t frameIndex)
+{
+	size_t& frameSetCount{ m_FrameSetCounts.at(frameIndex) };
+	if (frameSetCount == 0u)
+	{
+		return;
+	}
+
+	// Resetting a pool frees all of its sets at once, the pool itself is kept for the next frames
+	for (auto& [layout, layoutChains] : m_Layouts)
+	{
+		PoolChain& chain{ layoutChains.frameChains.at(frameIndex) };
+		for (VkDescriptorPool pool : chain.pools)
+		{
+			if (vkResetDescriptorPool(m_Device, pool, 0u) != VK_SUCCESS)
+			{
+				utils::ThrowError(EError::GenericVulkan);
+			}
+			chain.freePools.push_back(pool);
+		}
+		chain.pools.clear();
+		chain.setCount = 0u;
+	}
+	frameSetCount = 0u;
+	++m_ResetCount;
+}
+
+void DescriptorAllocator::LogStatistics() const
+{
+	size_t persistentSetCount{ 0u };
+	for (const auto& [layout, layoutChains] : m_Layouts)
+	{
+		persistentSetCount += layoutChains.persistentChain.setCount;
+	}
+
+	std::cout << "Descriptor allocator: " << m_Layouts.size() << " layout(s), " << m_PoolCount << " pool(s), " << persistentSetCount << " persistent set(s) of which " << m_CachedSets.size() << " cached with " << m_CacheHitCount << " cache hit(s), at most " << m_PeakFrameSetCount << " set(s) per frame, " << m_ResetCount << " frame reset(s)" << std::endl;
+}
+
+bool DescriptorAllocator::CacheKey::operator==(const CacheKey& other) const
+{
+	if (layout != other.layout || bindings.size() != other.bindings.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0u; i < bindings.size(); ++i)
+	{
+		const Binding& a{ bindings[i] };
+		const Binding& b{ other.bindings[i] };
+		if (a.binding != b.binding || a.type != b.type)
+		{
+			return false;
+		}
+
+		if (IsImageDescriptor(a.type))
+		{
+			if (a.imageInfo.sampler != b.imageInfo.sampler || a.imageInfo.imageView != b.imageInfo.imageView || a.imageInfo.imageLayout != b.imageInfo.imageLayout)
+			{
+				return false;
+			}
+		}
+		else if (a.bufferInfo.buffer != b.bufferInfo.buffer || a.bufferInfo.offset != b.bufferInfo.offset || a.bufferInfo.range != b.bufferInfo.range)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t DescriptorAllocator::CacheKeyHasher::operator()(const CacheKey& key) const
+{
+	size_t seed{ 0u };
+	utils::HashCombine(seed, key.layout);
+
+	for (const Binding& binding : key.bindings)
+	{
+		utils::HashCombine(seed, binding.binding);
+		utils::HashCombine(seed, static_cast<int>(binding.type));
+		if (IsImageDescriptor(binding.type))
+		{
+			utils::HashCombine(seed, binding.imageInfo.sampler);
+			utils::HashCombine(seed, binding.imageInfo.imageView);
+			utils::HashCombine(seed, static_cast<int>(binding.imageInfo.imageLayout));
+		}
+		else
+		{
+			utils::HashCombine(seed, binding.bufferInfo.buffer);
+			utils::HashCombine(seed, binding.bufferInfo.offset);
+			utils::HashCombine(seed, binding.bufferInfo.range);
+		}
+	}
+
+	return seed;
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(PoolChain& chain, VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& descriptorsPerSet)
+{
+	if (chain.pools.empty())
+	{
+		Grow(chain, descriptorsPerSet);
+	}
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	descriptorSetAllocateInfo.descriptorPool = chain.pools.back();
+	descriptorSetAllocateInfo.descriptorSetCount = 1u;
+	descriptorSetAllocateInfo.pSetLayouts = &layout;
+	VkDescriptorSet descriptorSet{ nullptr };
+	VkResult		result{ vkAllocateDescriptorSets(m_Device, &descriptorSetAllocateInfo, &descriptorSet) };
+
+	// The current pool is full, the chain continues with the next one
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+	{
+		Grow(chain, descriptorsPerSet);
+		descriptorSetAllocateInfo.descriptorPool = chain.pools.back();
+		result = vkAllocateDescriptorSets(m_Device, &descriptorSetAllocateInfo, &descriptorSet);
+	}
+
+	if (result != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	++chain.setCount;
+	return descriptorSet;
+}
+
+void DescriptorAllocator::Grow(PoolChain& chain, const std::vector<VkDescriptorPoolSize>& descriptorsPerSet)
+{
+	if (!chain.freePools.empty())
+	{
+		chain.pools.push_back(chain.freePools.back());
+		chain.freePools.pop_back();
+		return;
+	}
+
+	chain.pools.push_back(CreatePool(descriptorsPerSet, chain.nextSetCount));
+	chain.nextSetCount = std::min(chain.nextSetCount * 2u, Spectre::descriptorPoolMaxSetCount);
+}
+
+VkDescriptorPool DescriptorAllocator::CreatePool(const std::vector<VkDescriptorPoolSize>& descriptorsPerSet, uint32_t setCount)
+{
+	std::vector<VkDescriptorPoolSize> descriptorPoolSizes{ descriptorsPerSet };
+	for (VkDescriptorPoolSize& descriptorPoolSize : descriptorPoolSizes)
+	{
+		descriptorPoolSize.descriptorCount *= setCount;
+	}
+
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
+	descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
+	descriptorPoolCreateInfo.maxSets = setCount;
+	VkDescriptorPool descriptorPool{ nullptr };
+	if (vkCreateDescriptorPool(m_Device, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	++m_PoolCount;
+	return descriptorPool;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Spectre
+{
+	constexpr uint32_t descriptorPoolInitialSetCount = 64u;	// Sets of the first pool of every chain
+	constexpr uint32_t descriptorPoolMaxSetCount = 1024u;	// Every further pool doubles the sets of the last one up to this
+} // namespace Spectre
+
+/*
+ * The descriptor allocator hands out descriptor sets of any layout from chains of descriptor pools, so systems can create
+ * sets at runtime without knowing the total up front. A chain grows by creating another, larger pool whenever the current
+ * one runs out. Every registered layout has chains of its own whose pools hold exactly the descriptors of its sets, so no
+ * pool space is wasted on types the layout doesn't use. Persistent sets live until the allocator is destroyed. Every
+ * frame in flight has a chain of its own for sets that only serve that frame, its pools are reset in bulk once the GPU is
+ * done with the frame and then reused, instead of freeing single sets. Persistent sets can also be cached by layout and
+ * bindings, so identical requests share a single set.
+ */
+class DescriptorAllocator final
+{
+public:
+	// A binding of a cached set, the buffer or the image info is used depending on the type
+	struct Binding
+	{
+		uint32_t			   binding{ 0u };
+		VkDescriptorType	   type{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
+		VkDescriptorBufferInfo bufferInfo{};
+		VkDescriptorImageInfo  imageInfo{};
+	};
+
+	DescriptorAllocator(VkDevice device, size_t framesInFlightCount);
+	~DescriptorAllocator();
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+	// Pools for the layout are sized from its bindings, it has to be registered before any set of it is allocated
+	void			RegisterLayout(VkDescriptorSetLayout layout, const VkDescriptorSetLayoutCreateInfo& createInfo);
+	// Lives until the allocator is destroyed
+	VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+	// Lives until the frame is reset, the caller writes it every frame
+	VkDescriptorSet AllocateForFrame(VkDescriptorSetLayout layout, size_t frameIndex);
+	// Returns the persistent set written with the same bindings, allocates and writes it on first use
+	VkDescriptorSet GetCached(VkDescriptorSetLayout layout, const std::vector<Binding>& bindings);
+	// Returns every set of the frame to its pools at once, the GPU has to be done with the frame
+	void			ResetFrame(size_t frameIndex);
+
+	void LogStatistics() const;
+
+private:
+	struct PoolChain
+	{
+		std::vector<VkDescriptorPool> pools;	 // The last one is allocated from
+		std::vector<VkDescriptorPool> freePools; // Reset, taken again before creating a new one
+		uint32_t					  nextSetCount{ Spectre::descriptorPoolInitialSetCount };
+		size_t						  setCount{ 0u }; // Allocated since the last reset
+	};
+
+	struct LayoutChains
+	{
+		std::vector<VkDescriptorPoolSize> descriptorsPerSet; // Of every type the layout uses
+		PoolChain						  persistentChain;
+		std::vector<PoolChain>			  frameChains; // Per frame in flight
+	};
+
+	struct CacheKey
+	{
+		VkDescriptorSetLayout layout{ nullptr };
+		std::vector<Binding>  bindings;
+
+		bool operator==(const CacheKey& other) const;
+	};
+
+	struct CacheKeyHasher
+	{
+		size_t operator()(const CacheKey& key) const;
+	};
+
+	VkDevice													  m_Device{ nullptr };
+	std::unordered_map<VkDescriptorSetLayout, LayoutChains>		  m_Layouts;
+	std::unordered_map<CacheKey, VkDescriptorSet, CacheKeyHasher> m_CachedSets;
+
+	size_t				m_PoolCount{ 0u }, m_ResetCount{ 0u }, m_CacheHitCount{ 0u }, m_PeakFrameSetCount{ 0u };
+	std::vector<size_t>	m_FrameSetCounts; // Per frame in flight, allocated since the last reset
+
+	VkDescriptorSet	 Allocate(PoolChain& chain, VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& descriptorsPerSet);
+	// Takes a reset pool of the chain or creates a larger one
+	void			 Grow(PoolChain& chain, const std::vector<VkDescriptorPoolSize>& descriptorsPerSet);
+	VkDescriptorPool CreatePool(const std::vector<VkDescriptorPoolSize>& descriptorsPerSet, uint32_t setCount);
+};
@@ -0,0 +1,111 @@
+#include "Foveation.h"
+
+#include "../Misc/Utils.h"
+#include "../VR/StereoView.h"
+
+#include <glm/common.hpp>
+#include <glm/vec2.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	// The tangent of the view angle changes linearly across the image, from the first to the last pixel edge
+	float GetEdgeTangent(float firstTangent, float lastTangent, int32_t edge, uint32_t pixelCount) { return firstTangent + (lastTangent - firstTangent) * static_cast<float>(edge) / static_cast<float>(pixelCount); }
+
+	// The field of view of the part of an eye image that is covered by the rect, rows count downwards from the top
+	XrFovf GetRectFov(const XrFovf& eyeFov, const VkRect2D& rect, const VkExtent2D& eyeResolution)
+	{
+		const float l{ std::tan(eyeFov.angleLeft) };
+		const float r{ std::tan(eyeFov.angleRight) };
+		const float d{ std::tan(eyeFov.angleDown) };
+		const float u{ std::tan(eyeFov.angleUp) };
+
+		XrFovf fov;
+		fov.angleLeft = std::atan(GetEdgeTangent(l, r, rect.offset.x, eyeResolution.width));
+		fov.angleRight = std::atan(GetEdgeTangent(l, r, rect.offset.x + static_cast<int32_t>(rect.extent.width), eyeResolution.width));
+		fov.angleUp = std::atan(GetEdgeTangent(u, d, rect.offset.y, eyeResolution.height));
+		fov.angleDown = std::atan(GetEdgeTangent(u, d, rect.offset.y + static_cast<int32_t>(rect.extent.height), eyeResolution.height));
+		return fov;
+	}
+
+	// Centered on the pixel the lens axis goes through, kept inside of the image
+	int32_t GetInsetOffset(float firstTangent, float lastTangent, uint32_t insetSize, uint32_t pixelCount)
+	{
+		const float axisPixel{ -firstTangent / (lastTangent - firstTangent) * static_cast<float>(pixelCount) };
+		const float offset{ std::round(axisPixel - 0.5f * static_cast<float>(insetSize)) };
+		return static_cast<int32_t>(std::clamp(offset, 0.0f, static_cast<float>(pixelCount - insetSize)));
+	}
+
+	uint32_t ScaleExtent(uint32_t size, float scale) { return std::max(1u, static_cast<uint32_t>(std::round(static_cast<float>(size) * scale))); }
+} // namespace
+
+void Foveation::Update(const StereoView* stereoView, EFoveationLevel level)
+{
+	const size_t levelIndex{ static_cast<size_t>(level) };
+	const float	 insetFraction{ Spectre::foveationInsetFractions.at(levelIndex) };
+	const float	 peripheryScale{ Spectre::foveationPeripheryScales.at(levelIndex) };
+
+	m_EyeResolution = stereoView->GetEyeResolution(0u);
+
+	Region& inset{ m_Regions.at(static_cast<size_t>(EFoveationRegion::Inset)) };
+	inset.extent = { ScaleExtent(m_EyeResolution.width, insetFraction), ScaleExtent(m_EyeResolution.height, insetFraction) };
+	inset.skippedRect = {};
+
+	Region& periphery{ m_Regions.at(static_cast<size_t>(EFoveationRegion::Periphery)) };
+	periphery.extent = { ScaleExtent(m_EyeResolution.width, peripheryScale), ScaleExtent(m_EyeResolution.height, peripheryScale) };
+
+	// Both eyes are drawn with the same viewport, so the periphery can only skip what the insets of both eyes cover
+	const glm::vec2 peripheryScales{ static_cast<float>(periphery.extent.width) / static_cast<float>(m_EyeResolution.width), static_cast<float>(periphery.extent.height) / static_cast<float>(m_EyeResolution.height) };
+	glm::vec2		skippedMin{ 0.0f, 0.0f };
+	glm::vec2		skippedMax{ static_cast<float>(periphery.extent.width), static_cast<float>(periphery.extent.height) };
+
+	const size_t eyeCount{ std::min(stereoView->GetEyeCount(), inset.eyeRects.size()) };
+	for (size_t eyeIndex = 0u; eyeIndex < eyeCount; ++eyeIndex)
+	{
+		const XrFovf eyeFov{ stereoView->GetEyeFov(eyeIndex) };
+
+		VkRect2D& insetRect{ inset.eyeRects.at(eyeIndex) };
+		insetRect.extent = inset.extent;
+		insetRect.offset.x = GetInsetOffset(std::tan(eyeFov.angleLeft), std::tan(eyeFov.angleRight), inset.extent.width, m_EyeResolution.width);
+		insetRect.offset.y = GetInsetOffset(std::tan(eyeFov.angleUp), std::tan(eyeFov.angleDown), inset.extent.height, m_EyeResolution.height);
+		inset.projectionMatrices.at(eyeIndex) = utils::CreateProjectionMatrix(GetRectFov(eyeFov, insetRect, m_EyeResolution), Spectre::nearClip, Spectre::farClip);
+
+		periphery.eyeRects.at(eyeIndex) = { { 0, 0 }, m_EyeResolution };
+		periphery.projectionMatrices.at(eyeIndex) = utils::CreateProjectionMatrix(eyeFov, Spectre::nearClip, Spectre::farClip);
+
+		const glm::vec2 insetMin{ static_cast<float>(insetRect.offset.x), static_cast<float>(insetRect.offset.y) };
+		const glm::vec2 insetMax{ insetMin + glm::vec2(static_cast<float>(insetRect.extent.width), static_cast<float>(insetRect.extent.height)) };
+		skippedMin = glm::max(skippedMin, glm::ceil(insetMin * peripheryScales + Spectre::foveationHoleMargin));
+		skippedMax = glm::min(skippedMax, glm::floor(insetMax * peripheryScales - Spectre::foveationHoleMargin));
+	}
+
+	periphery.skippedRect = {};
+	if (skippedMax.x > skippedMin.x && skippedMax.y > skippedMin.y)
+	{
+		periphery.skippedRect.offset = { static_cast<int32_t>(skippedMin.x), static_cast<int32_t>(skippedMin.y) };
+		periphery.skippedRect.extent = { static_cast<uint32_t>(skippedMax.x - skippedMin.x), static_cast<uint32_t>(skippedMax.y - skippedMin.y) };
+	}
+}
+
+float Foveation::GetShadedPixelFraction() const
+{
+	float shadedPixelCount{ 0.0f };
+	for (const Region& region : m_Regions)
+	{
+		shadedPixelCount += static_cast<float>(region.extent.width) * static_cast<float>(region.extent.height);
+		shadedPixelCount -= static_cast<float>(region.skippedRect.extent.width) * static_cast<float>(region.skippedRect.extent.height);
+	}
+
+	const float eyePixelCount{ static_cast<float>(m_EyeResolution.width) * static_cast<float>(m_EyeResolution.height) };
+	return eyePixelCount > 0.0f ? shadedPixelCount / eyePixelCount : 1.0f;
+}
+
+void Foveation::LogStatistics() const
+{
+	const Region& inset{ GetRegion(EFoveationRegion::Inset) };
+	const Region& periphery{ GetRegion(EFoveationRegion::Periphery) };
+	std::cout << "Foveation: " << inset.extent.width << "x" << inset.extent.height << " inset, " << periphery.extent.width << "x" << periphery.extent.height << " periphery skipping " << periphery.skippedRect.extent.width << "x" << periphery.skippedRect.extent.height << ", " << 100.0f * GetShadedPixelFraction() << "% of the eye pixels shaded" << std::endl;
+}
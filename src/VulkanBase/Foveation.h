@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+
+class StereoView;
+
+enum class EFoveationLevel
+{
+	Off,
+	Low,
+	Medium,
+	High,
+	Count
+};
+
+// Both regions are drawn with multiview into layered images of their own, one layer per eye
+enum class EFoveationRegion
+{
+	Inset,	  // Native resolution around the lens axis
+	Periphery // The whole field of view at a reduced resolution
+};
+
+namespace Spectre
+{
+	constexpr size_t foveationRegionCount = 2u;
+	constexpr float	 foveationHoleMargin = 2.0f; // Periphery texels kept around the inset for the filtered upscale
+
+	// Fraction of the eye resolution covered by the inset, and the resolution scale of the periphery
+	constexpr std::array<float, static_cast<size_t>(EFoveationLevel::Count)> foveationInsetFractions{ 1.0f, 0.7f, 0.6f, 0.5f };
+	constexpr std::array<float, static_cast<size_t>(EFoveationLevel::Count)> foveationPeripheryScales{ 1.0f, 0.6f, 0.5f, 0.4f };
+} // namespace Spectre
+
+/*
+ * Fixed foveation splits every eye into an inset around the lens axis, rendered at the native resolution, and the whole
+ * field of view rendered at a reduced resolution for the periphery. Both regions get projections of their own from the
+ * eye's field of view, cut along pixel boundaries so that the inset lines up with the eye image texel for texel. The
+ * periphery skips the part that is covered by the inset of both eyes for fragments that are depth tested before shading.
+ * The regions are only composited into the eye image afterwards, the renderer upscales the periphery over its eye rects
+ * and copies the insets.
+ */
+class Foveation final
+{
+public:
+	struct Region
+	{
+		VkExtent2D				  extent{ 0u, 0u };
+		std::array<VkRect2D, 2u>  eyeRects{}; // Covered part of each eye image in eye pixels
+		std::array<glm::mat4, 2u> projectionMatrices{};
+		VkRect2D				  skippedRect{}; // In region pixels, empty if nothing is skipped
+	};
+
+	// Called every frame, the headset may change the field of view of its eyes at any time
+	void Update(const StereoView* stereoView, EFoveationLevel level);
+
+	const Region& GetRegion(EFoveationRegion region) const { return m_Regions.at(static_cast<size_t>(region)); }
+	// Shaded pixels of both regions relative to rendering the eyes at their full resolution, assuming the skipped rect is
+	// never shaded, the fragment shader invocation statistic of the renderer gives the actual count
+	float		  GetShadedPixelFraction() const;
+
+	void LogStatistics() const;
+
+private:
+	std::array<Region, Spectre::foveationRegionCount> m_Regions;
+	VkExtent2D										   m_EyeResolution{ 0u, 0u };
+};
@@ -0,0 +1,344 @@
+#include "GpuProfiler.h"
+
+#include "../Misc/Utils.h"
+#include "VulkanDevice.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	struct StatisticName
+	{
+		VkQueryPipelineStatisticFlagBits flag;
+		const char*						 name;
+	};
+
+	// Results are written in the order of the flag bits, so this table has to stay sorted by them
+	constexpr std::array<StatisticName, 5u> statisticNames{ { { VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT, "Input assembly primitives" },
+															  { VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT, "Vertex shader invocations" },
+															  { VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT, "Clipping primitives" },
+															  { VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, "Fragment shader invocations" },
+															  { VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT, "Compute shader invocations" } } };
+
+	std::string EscapeJson(const std::string& string)
+	{
+		std::string escaped;
+		for (const char character : string)
+		{
+			if (character == '"' || character == '\\')
+			{
+				escaped += '\\';
+			}
+			escaped += character;
+		}
+		return escaped;
+	}
+} // namespace
+
+GpuProfiler::GpuProfiler(const VulkanDevice* device, const std::string& queueName, uint32_t timestampValidBits, VkQueryPipelineStatisticFlags statisticFlags, size_t frameCount, uint32_t viewCount) : m_Device(device), m_QueueName(queueName), m_QueriesPerTimestamp(std::max(viewCount, 1u))
+{
+	const VkDevice vkDevice{ device->GetVkDevice() };
+	m_Frames.resize(frameCount);
+
+	if (timestampValidBits > 0u)
+	{
+		m_TimestampMask = timestampValidBits >= 64u ? UINT64_MAX : (uint64_t{ 1u } << timestampValidBits) - 1u;
+		m_TimestampPeriod = static_cast<double>(device->GetPhysicalDeviceProperties().limits.timestampPeriod);
+
+		VkQueryPoolCreateInfo queryPoolCreateInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCreateInfo.queryCount = static_cast<uint32_t>(frameCount) * Spectre::gpuProfilerMaxScopeCount * 2u * m_QueriesPerTimestamp;
+		if (vkCreateQueryPool(vkDevice, &queryPoolCreateInfo, nullptr, &m_TimestampQueryPool) != VK_SUCCESS)
+		{
+			utils::ThrowError(EError::GenericVulkan);
+		}
+	}
+
+	// Only the statistics that can be named are collected
+	for (const StatisticName& statisticName : statisticNames)
+	{
+		if (statisticFlags & statisticName.flag)
+		{
+			m_StatisticFlags |= statisticName.flag;
+			++m_StatisticCount;
+		}
+	}
+
+	if (m_StatisticFlags)
+	{
+		VkQueryPoolCreateInfo queryPoolCreateInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		queryPoolCreateInfo.queryCount = static_cast<uint32_t>(frameCount) * Spectre::gpuProfilerMaxScopeCount;
+		queryPoolCreateInfo.pipelineStatistics = m_StatisticFlags;
+		if (vkCreateQueryPool(vkDevice, &queryPoolCreateInfo, nullptr, &m_StatisticsQueryPool) != VK_SUCCESS)
+		{
+			utils::ThrowError(EError::GenericVulkan);
+		}
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice)
+	{
+		if (m_StatisticsQueryPool)
+		{
+			vkDestroyQueryPool(vkDevice, m_StatisticsQueryPool, nullptr);
+		}
+
+		if (m_TimestampQueryPool)
+		{
+			vkDestroyQueryPool(vkDevice, m_TimestampQueryPool, nullptr);
+		}
+	}
+}
+
+void GpuProfiler::BeginFrame(size_t frameIndex, VkCommandBuffer commandBuffer)
+{
+	ReadResults(frameIndex);
+
+	m_CurrentFrameIndex = frameIndex;
+	Frame& frame{ m_Frames.at(frameIndex) };
+	frame.scopes.clear();
+	frame.openScopes.clear();
+
+	// Queries have to be reset outside of a render pass before they are written again
+	if (m_TimestampQueryPool)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_TimestampQueryPool, GetTimestampQuery(frameIndex, 0u, false), Spectre::gpuProfilerMaxScopeCount * 2u * m_QueriesPerTimestamp);
+	}
+
+	if (m_StatisticsQueryPool)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_StatisticsQueryPool, GetStatisticsQuery(frameIndex, 0u), Spectre::gpuProfilerMaxScopeCount);
+	}
+}
+
+void GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const std::string& name, bool collectStatistics)
+{
+	Frame& frame{ m_Frames.at(m_CurrentFrameIndex) };
+	if (frame.scopes.size() >= Spectre::gpuProfilerMaxScopeCount)
+	{
+		frame.openScopes.push_back(UINT32_MAX);
+		++m_DroppedScopeCount;
+		return;
+	}
+
+	const uint32_t scopeIndex{ static_cast<uint32_t>(frame.scopes.size()) };
+	frame.scopes.push_back({ name, collectStatistics && m_StatisticsQueryPool });
+	frame.openScopes.push_back(scopeIndex);
+
+	if (m_TimestampQueryPool)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampQueryPool, GetTimestampQuery(m_CurrentFrameIndex, scopeIndex, false));
+	}
+
+	if (frame.scopes.back().collectsStatistics)
+	{
+		vkCmdBeginQuery(commandBuffer, m_StatisticsQueryPool, GetStatisticsQuery(m_CurrentFrameIndex, scopeIndex), 0u);
+	}
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer)
+{
+	Frame& frame{ m_Frames.at(m_CurrentFrameIndex) };
+	if (frame.openScopes.empty())
+	{
+		return;
+	}
+
+	const uint32_t scopeIndex{ frame.openScopes.back() };
+	frame.openScopes.pop_back();
+	if (scopeIndex == UINT32_MAX)
+	{
+		return;
+	}
+
+	if (frame.scopes.at(scopeIndex).collectsStatistics)
+	{
+		vkCmdEndQuery(commandBuffer, m_StatisticsQueryPool, GetStatisticsQuery(m_CurrentFrameIndex, scopeIndex));
+	}
+
+	if (m_TimestampQueryPool)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampQueryPool, GetTimestampQuery(m_CurrentFrameIndex, scopeIndex, true));
+	}
+
+	frame.isPending = true;
+}
+
+uint32_t GpuProfiler::GetTimestampQuery(size_t frameIndex, uint32_t scopeIndex, bool isEnd) const
+{
+	const uint32_t firstFrameQuery{ static_cast<uint32_t>(frameIndex) * Spectre::gpuProfilerMaxScopeCount * 2u * m_QueriesPerTimestamp };
+	return firstFrameQuery + (scopeIndex * 2u + (isEnd ? 1u : 0u)) * m_QueriesPerTimestamp;
+}
+
+uint32_t GpuProfiler::GetStatisticsQuery(size_t frameIndex, uint32_t scopeIndex) const { return static_cast<uint32_t>(frameIndex) * Spectre::gpuProfilerMaxScopeCount + scopeIndex; }
+
+void GpuProfiler::ReadResults(size_t frameIndex)
+{
+	m_LatestStatistics.clear();
+
+	Frame& frame{ m_Frames.at(frameIndex) };
+	if (!frame.isPending)
+	{
+		return;
+	}
+	frame.isPending = false;
+
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	for (uint32_t scopeIndex = 0u; scopeIndex < static_cast<uint32_t>(frame.scopes.size()); ++scopeIndex)
+	{
+		const Scope& scope{ frame.scopes.at(scopeIndex) };
+		TraceEvent	 traceEvent;
+		traceEvent.name = scope.name;
+
+		// Only the first query of a multiview timestamp holds the value, so the begin and end are read separately
+		uint64_t beginTimestamp{ 0u }, endTimestamp{ 0u };
+		if (m_TimestampQueryPool &&
+			vkGetQueryPoolResults(vkDevice, m_TimestampQueryPool, GetTimestampQuery(frameIndex, scopeIndex, false), 1u, sizeof(beginTimestamp), &beginTimestamp, sizeof(beginTimestamp), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS &&
+			vkGetQueryPoolResults(vkDevice, m_TimestampQueryPool, GetTimestampQuery(frameIndex, scopeIndex, true), 1u, sizeof(endTimestamp), &endTimestamp, sizeof(endTimestamp), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		{
+			// Timestamps wrap around after their valid bits
+			const double milliseconds{ static_cast<double>((endTimestamp - beginTimestamp) & m_TimestampMask) * m_TimestampPeriod * 1e-6 };
+			traceEvent.startMicroseconds = static_cast<double>(beginTimestamp & m_TimestampMask) * m_TimestampPeriod * 1e-3;
+			traceEvent.durationMicroseconds = milliseconds * 1e3;
+
+			auto [it, isNewScope]{ m_ScopeHistories.try_emplace(scope.name) };
+			if (isNewScope)
+			{
+				m_ScopeOrder.push_back(scope.name);
+			}
+
+			ScopeHistory& history{ it->second };
+			history.milliseconds.push_back(milliseconds);
+			history.millisecondSum += milliseconds;
+			if (history.milliseconds.size() > Spectre::gpuProfilerAverageFrameCount)
+			{
+				history.millisecondSum -= history.milliseconds.front();
+				history.milliseconds.pop_front();
+			}
+		}
+
+		if (scope.collectsStatistics)
+		{
+			std::vector<uint64_t> statistics(m_StatisticCount);
+			const size_t		  dataSize{ statistics.size() * sizeof(uint64_t) };
+			if (vkGetQueryPoolResults(vkDevice, m_StatisticsQueryPool, GetStatisticsQuery(frameIndex, scopeIndex), 1u, dataSize, statistics.data(), dataSize, VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+			{
+				traceEvent.statistics = statistics;
+				m_LatestStatistics[scope.name] = statistics;
+			}
+		}
+
+		if (m_TraceEvents.size() < Spectre::gpuProfilerMaxTraceEventCount)
+		{
+			m_TraceEvents.push_back(traceEvent);
+		}
+	}
+}
+
+bool GpuProfiler::GetLatestStatistic(const std::string& scopeName, VkQueryPipelineStatisticFlagBits statistic, uint64_t& outValue) const
+{
+	const auto it{ m_LatestStatistics.find(scopeName) };
+	if (it == m_LatestStatistics.end() || !(m_StatisticFlags & statistic))
+	{
+		return false;
+	}
+
+	// Find the position of the statistic among the collected ones
+	size_t resultIndex{ 0u };
+	for (const StatisticName& statisticName : statisticNames)
+	{
+		if (statisticName.flag == statistic)
+		{
+			outValue = it->second.at(resultIndex);
+			return true;
+		}
+
+		if (m_StatisticFlags & statisticName.flag)
+		{
+			++resultIndex;
+		}
+	}
+
+	return false;
+}
+
+void GpuProfiler::LogStatistics() const
+{
+	std::cout << "GPU profiler (" << m_QueueName << "): average of the last " << Spectre::gpuProfilerAverageFrameCount << " frames";
+	if (m_DroppedScopeCount > 0u)
+	{
+		std::cout << ", " << m_DroppedScopeCount << " scope(s) over the limit were not measured";
+	}
+	std::cout << std::endl;
+
+	for (const std::string& scopeName : m_ScopeOrder)
+	{
+		const ScopeHistory& history{ m_ScopeHistories.at(scopeName) };
+		std::cout << "  " << scopeName << ": " << history.millisecondSum / static_cast<double>(history.milliseconds.size()) << " ms" << std::endl;
+	}
+}
+
+bool GpuProfiler::WriteChromeTrace(const std::string& filename, const std::vector<const GpuProfiler*>& profilers)
+{
+	// Queues of the same device share the timestamp clock, the trace starts at the earliest scope
+	double originMicroseconds{ -1.0 };
+	for (const GpuProfiler* profiler : profilers)
+	{
+		for (const TraceEvent& traceEvent : profiler->m_TraceEvents)
+		{
+			if (originMicroseconds < 0.0 || traceEvent.startMicroseconds < originMicroseconds)
+			{
+				originMicroseconds = traceEvent.startMicroseconds;
+			}
+		}
+	}
+
+	std::ofstream file(filename, std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "Failed to write the GPU trace to \"" << filename << "\"" << std::endl;
+		return false;
+	}
+
+	file << "{\"traceEvents\":[";
+	bool isFirstEvent{ true };
+	for (size_t profilerIndex = 0u; profilerIndex < profilers.size(); ++profilerIndex)
+	{
+		const GpuProfiler* profiler{ profilers.at(profilerIndex) };
+
+		// Names the track of the queue
+		file << (isFirstEvent ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << profilerIndex << ",\"args\":{\"name\":\"" << EscapeJson(profiler->m_QueueName) << "\"}}";
+		isFirstEvent = false;
+
+		for (const TraceEvent& traceEvent : profiler->m_TraceEvents)
+		{
+			file << ",\n{\"name\":\"" << EscapeJson(traceEvent.name) << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << profilerIndex << ",\"ts\":" << traceEvent.startMicroseconds - originMicroseconds << ",\"dur\":" << traceEvent.durationMicroseconds;
+			if (!traceEvent.statistics.empty())
+			{
+				file << ",\"args\":{";
+				size_t resultIndex{ 0u };
+				for (const StatisticName& statisticName : statisticNames)
+				{
+					if (profiler->m_StatisticFlags & statisticName.flag)
+					{
+						file << (resultIndex > 0u ? "," : "") << "\"" << statisticName.name << "\":" << traceEvent.statistics.at(resultIndex);
+						++resultIndex;
+					}
+				}
+				file << "}";
+			}
+			file << "}";
+		}
+	}
+	file << "\n]}" << std::endl;
+
+	std::cout << "Wrote the GPU trace to \"" << filename << "\"" << std::endl;
+	return true;
+}
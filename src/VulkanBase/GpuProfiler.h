@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VulkanDevice;
+
+namespace Spectre
+{
+	constexpr uint32_t gpuProfilerMaxScopeCount = 64u;		  // Per frame, further scopes are not measured
+	constexpr size_t   gpuProfilerAverageFrameCount = 120u;	  // Window of the rolling averages
+	constexpr size_t   gpuProfilerMaxTraceEventCount = 100000u; // Later scopes only update the rolling averages
+	const std::string  gpuTraceFilename = "GpuTrace.json";
+} // namespace Spectre
+
+/*
+ * The GPU profiler measures named scopes of the command buffers submitted to one queue. A scope writes a timestamp when
+ * it begins and ends and can optionally collect pipeline statistics like fragment shader invocations. Each frame in
+ * flight has its own queries, they are read back when the frame comes around again and its previous submission has
+ * completed, so reading them never stalls. Scope durations are kept as rolling averages and as trace events that can
+ * be exported to a Chrome trace file for chrome://tracing or Perfetto.
+ */
+class GpuProfiler final
+{
+public:
+	// Timestamps are skipped without valid bits, statistics are skipped without flags. Timestamps inside a multiview render
+	// pass take one query per view, so viewCount is the most views of any render pass the scopes are used in
+	GpuProfiler(const VulkanDevice* device, const std::string& queueName, uint32_t timestampValidBits, VkQueryPipelineStatisticFlags statisticFlags, size_t frameCount, uint32_t viewCount = 1u);
+	~GpuProfiler();
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	// The previous submission of the frame must have completed, its results are read back before it is recorded anew
+	void BeginFrame(size_t frameIndex, VkCommandBuffer commandBuffer);
+	// Scopes nest, statistics are only collected for scopes that begin and end outside of a render pass
+	void BeginScope(VkCommandBuffer commandBuffer, const std::string& name, bool collectStatistics = false);
+	void EndScope(VkCommandBuffer commandBuffer);
+
+	// Statistic of the frame that was read back by the last BeginFrame() call, if the scope collected it
+	bool GetLatestStatistic(const std::string& scopeName, VkQueryPipelineStatisticFlagBits statistic, uint64_t& outValue) const;
+	void LogStatistics() const;
+
+	// Writes the scopes of all profilers into one trace, each queue gets its own track
+	static bool WriteChromeTrace(const std::string& filename, const std::vector<const GpuProfiler*>& profilers);
+
+private:
+	struct Scope
+	{
+		std::string name;
+		bool		collectsStatistics{ false };
+	};
+
+	struct Frame
+	{
+		std::vector<Scope>	  scopes;
+		std::vector<uint32_t> openScopes; // Stack of scope indices, UINT32_MAX for scopes over the limit
+		bool				  isPending{ false };
+	};
+
+	struct TraceEvent
+	{
+		std::string			  name;
+		double				  startMicroseconds{ 0.0 };
+		double				  durationMicroseconds{ 0.0 };
+		std::vector<uint64_t> statistics;
+	};
+
+	struct ScopeHistory
+	{
+		std::deque<double> milliseconds;
+		double			   millisecondSum{ 0.0 };
+	};
+
+	const VulkanDevice* m_Device{ nullptr };
+	std::string			m_QueueName;
+	uint64_t			m_TimestampMask{ 0u };
+	double				m_TimestampPeriod{ 0.0 }; // Nanoseconds per tick
+
+	VkQueryPool					  m_TimestampQueryPool{ nullptr };
+	uint32_t					  m_QueriesPerTimestamp{ 1u };
+	VkQueryPool					  m_StatisticsQueryPool{ nullptr };
+	VkQueryPipelineStatisticFlags m_StatisticFlags{ 0u };
+	uint32_t					  m_StatisticCount{ 0u };
+
+	std::vector<Frame> m_Frames;
+	size_t			   m_CurrentFrameIndex{ 0u };
+	size_t			   m_DroppedScopeCount{ 0u };
+
+	std::vector<TraceEvent>								   m_TraceEvents;
+	std::unordered_map<std::string, ScopeHistory>		   m_ScopeHistories;
+	std::vector<std::string>							   m_ScopeOrder; // Scope names in the order they were first measured
+	std::unordered_map<std::string, std::vector<uint64_t>> m_LatestStatistics;
+
+	uint32_t GetTimestampQuery(size_t frameIndex, uint32_t scopeIndex, bool isEnd) const;
+	uint32_t GetStatisticsQuery(size_t frameIndex, uint32_t scopeIndex) const;
+	void	 ReadResults(size_t frameIndex);
+};
@@ -0,0 +1,62 @@
+#include "LightCulling.h"
+
+#include "../Misc/Utils.h"
+#include "PipelineCache.h"
+#include "ShaderModuleCache.h"
+#include "VulkanDevice.h"
+
+#include <sstream>
+
+namespace
+{
+	constexpr uint32_t workgroupSize = 64u; // Must match local_size_x in shaders/LightCulling.comp
+} // namespace
+
+LightCulling::LightCulling(const VulkanDevice* device, PipelineCache* pipelineCache, ShaderModuleCache* shaderModuleCache, VkPipelineLayout pipelineLayout, uint32_t eyeCount) : m_Device(device), m_PipelineLayout(pipelineLayout)
+{
+	m_ClusterCount = Spectre::clusterCountX * Spectre::clusterCountY * Spectre::clusterCountZ * eyeCount;
+
+	shaderModuleCache->Retain(Spectre::lightCullingShaderName);
+	const VkShaderModule computeShaderModule{ shaderModuleCache->Get(Spectre::lightCullingShaderName) };
+	if (!computeShaderModule)
+	{
+		shaderModuleCache->Release(Spectre::lightCullingShaderName);
+
+		std::stringstream s;
+		s << "Compute shader \"" << Spectre::lightCullingShaderName << "\"";
+		utils::ThrowError(EError::FileMissing, s.str());
+	}
+
+	VkComputePipelineCreateInfo computePipelineCreateInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+	computePipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	computePipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	computePipelineCreateInfo.stage.module = computeShaderModule;
+	computePipelineCreateInfo.stage.pName = "main";
+	computePipelineCreateInfo.layout = pipelineLayout;
+
+	const VkPipelineCache vkPipelineCache{ pipelineCache ? pipelineCache->GetVkPipelineCache() : VK_NULL_HANDLE };
+	const VkResult		  result{ vkCreateComputePipelines(device->GetVkDevice(), vkPipelineCache, 1u, &computePipelineCreateInfo, nullptr, &m_Pipeline) };
+	shaderModuleCache->Release(Spectre::lightCullingShaderName);
+	if (result != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+}
+
+LightCulling::~LightCulling()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice && m_Pipeline)
+	{
+		vkDestroyPipeline(vkDevice, m_Pipeline, nullptr);
+	}
+}
+
+void LightCulling::Dispatch(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet) const
+{
+	// The set is shared with the draws, its dynamic world matrix offset is unused here
+	constexpr uint32_t dynamicOffset{ 0u };
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0u, 1u, &descriptorSet, 1u, &dynamicOffset);
+	vkCmdDispatch(commandBuffer, (m_ClusterCount + workgroupSize - 1u) / workgroupSize, 1u, 1u);
+}
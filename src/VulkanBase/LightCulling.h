@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+
+class VulkanDevice;
+class PipelineCache;
+class ShaderModuleCache;
+
+namespace Spectre
+{
+	// Froxel grid per eye, must match the cluster lookup in shaders/Lighting.glsl
+	constexpr uint32_t clusterCountX = 16u;
+	constexpr uint32_t clusterCountY = 9u;
+	constexpr uint32_t clusterCountZ = 24u;
+	constexpr uint32_t maxLightCount = 1024u;
+	constexpr uint32_t maxLightsPerCluster = 63u; // Every cluster stores its light count followed by its light indices
+	const std::string  lightCullingShaderName = "shaders/LightCulling.comp.spv";
+} // namespace Spectre
+
+/*
+ * Light culling assigns the local lights to the froxel clusters of both eyes with a compute pass at the start of every
+ * frame. The clusters are slices of the view frustum, exponentially spaced in depth, so a fragment only has to evaluate
+ * the handful of lights whose range overlaps its cluster. The pass shares the descriptor set and pipeline layout of
+ * the renderer, the light and cluster buffers live with the other per-frame data of a render process.
+ */
+class LightCulling final
+{
+public:
+	LightCulling(const VulkanDevice* device, PipelineCache* pipelineCache, ShaderModuleCache* shaderModuleCache, VkPipelineLayout pipelineLayout, uint32_t eyeCount);
+	~LightCulling();
+	LightCulling(const LightCulling&) = delete;
+	LightCulling& operator=(const LightCulling&) = delete;
+
+	// Records the culling dispatch into a draw or async compute command buffer, the render graph or the timeline semaphore
+	// the draw queue waits on makes the cluster lights visible to the fragment shaders
+	void Dispatch(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet) const;
+
+	uint32_t GetClusterCount() const { return m_ClusterCount; }
+
+	static VkDeviceSize GetClusterLightBufferSize(uint32_t eyeCount) { return static_cast<VkDeviceSize>(Spectre::clusterCountX * Spectre::clusterCountY * Spectre::clusterCountZ * eyeCount) * (Spectre::maxLightsPerCluster + 1u) * sizeof(uint32_t); }
+
+private:
+	const VulkanDevice* m_Device{ nullptr };
+	VkPipelineLayout	m_PipelineLayout{ nullptr };
+	VkPipeline			m_Pipeline{ nullptr };
+	uint32_t			m_ClusterCount{ 0u };
+};
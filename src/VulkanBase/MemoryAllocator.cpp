@@ -0,0 +1,507 @@
+#include "MemoryAllocator.h"
+
+#include "../Misc/Utils.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	// A block smaller than this fraction of its heap would starve the other memory types on it
+	constexpr VkDeviceSize minBlocksPerHeap = 8u;
+
+	float ToMegabytes(VkDeviceSize size) { return static_cast<float>(size) / (1024.0f * 1024.0f); }
+} // namespace
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, bool supportsMemoryBudget) : m_Device(device), m_PhysicalDevice(physicalDevice), m_SupportsMemoryBudget(supportsMemoryBudget)
+{
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+
+	VkPhysicalDeviceProperties physicalDeviceProperties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+	m_MaxDeviceMemoryCount = physicalDeviceProperties.limits.maxMemoryAllocationCount;
+
+	m_BlockSizes.resize(m_MemoryProperties.memoryTypeCount);
+	for (uint32_t memoryTypeIndex = 0u; memoryTypeIndex < m_MemoryProperties.memoryTypeCount; ++memoryTypeIndex)
+	{
+		const VkDeviceSize heapSize{ m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size };
+
+		VkDeviceSize blockSize{ Spectre::memoryBlockSize };
+		while (blockSize > Spectre::memoryMinAllocationSize && blockSize * minBlocksPerHeap > heapSize)
+		{
+			blockSize /= 2u;
+		}
+		m_BlockSizes.at(memoryTypeIndex) = blockSize;
+	}
+
+	m_HeapStatistics.resize(m_MemoryProperties.memoryHeapCount);
+	m_HeapBudgets.resize(m_MemoryProperties.memoryHeapCount);
+	m_CategoryUsages.resize(static_cast<size_t>(EMemoryCategory::Count));
+	UpdateBudget();
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	for (uint32_t blockIndex = 0u; blockIndex < static_cast<uint32_t>(m_Blocks.size()); ++blockIndex)
+	{
+		if (m_Blocks.at(blockIndex))
+		{
+			ReleaseBlock(blockIndex);
+		}
+	}
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties, EMemoryCategory category)
+{
+	VkBufferMemoryRequirementsInfo2 requirementsInfo{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2 };
+	requirementsInfo.buffer = buffer;
+
+	VkMemoryDedicatedRequirements dedicatedRequirements{ VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+	VkMemoryRequirements2		  requirements{ VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
+	requirements.pNext = &dedicatedRequirements;
+	vkGetBufferMemoryRequirements2(m_Device, &requirementsInfo, &requirements);
+
+	const Allocation allocation{ Allocate(requirements.memoryRequirements, properties, EResourceKind::Buffer, category, dedicatedRequirements.prefersDedicatedAllocation, buffer, nullptr) };
+	if (vkBindBufferMemory(m_Device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	return allocation;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateForImage(VkImage image, VkMemoryPropertyFlags properties, EMemoryCategory category, bool isDedicated)
+{
+	VkImageMemoryRequirementsInfo2 requirementsInfo{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2 };
+	requirementsInfo.image = image;
+
+	VkMemoryDedicatedRequirements dedicatedRequirements{ VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+	VkMemoryRequirements2		  requirements{ VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
+	requirements.pNext = &dedicatedRequirements;
+	vkGetImageMemoryRequirements2(m_Device, &requirementsInfo, &requirements);
+
+	const bool		 prefersDedicated{ isDedicated || dedicatedRequirements.prefersDedicatedAllocation };
+	const Allocation allocation{ Allocate(requirements.memoryRequirements, properties, EResourceKind::Image, category, prefersDedicated, nullptr, image) };
+	if (vkBindImageMemory(m_Device, image, allocation.memory, allocation.offset) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	return allocation;
+}
+
+void MemoryAllocator::Free(const Allocation& allocation)
+{
+	if (!allocation.memory)
+	{
+		return;
+	}
+
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	HeapStatistics&					  heapStatistics{ m_HeapStatistics.at(m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].heapIndex) };
+	m_CategoryUsages.at(static_cast<size_t>(allocation.category)) -= allocation.size;
+
+	// Freeing the memory unmaps it as well
+	if (allocation.blockIndex == UINT32_MAX)
+	{
+		vkFreeMemory(m_Device, allocation.memory, nullptr);
+		--heapStatistics.dedicatedCount;
+		heapStatistics.dedicatedSize -= allocation.size;
+		--m_DeviceMemoryCount;
+		return;
+	}
+
+	Block* block{ m_Blocks.at(allocation.blockIndex) };
+	FreeBuddy(*block, allocation.offset);
+	--heapStatistics.allocationCount;
+	heapStatistics.usedSize -= allocation.size;
+
+	// One empty block per memory type stays around, so short lived staging buffers don't allocate a new block every time
+	if (IsBlockEmpty(*block))
+	{
+		for (uint32_t blockIndex = 0u; blockIndex < static_cast<uint32_t>(m_Blocks.size()); ++blockIndex)
+		{
+			const Block* otherBlock{ m_Blocks.at(blockIndex) };
+			if (blockIndex != allocation.blockIndex && otherBlock && otherBlock->memoryTypeIndex == block->memoryTypeIndex && otherBlock->resourceKind == block->resourceKind && IsBlockEmpty(*otherBlock))
+			{
+				ReleaseBlock(allocation.blockIndex);
+				break;
+			}
+		}
+	}
+}
+
+void MemoryAllocator::UpdateBudget()
+{
+	std::vector<HeapBudget>		  heapBudgets;
+	std::vector<PressureCallback> pressureCallbacks;
+	{
+		const std::lock_guard<std::mutex> lock(m_Mutex);
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT memoryBudgetProperties{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT };
+		if (m_SupportsMemoryBudget)
+		{
+			VkPhysicalDeviceMemoryProperties2 memoryProperties2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2 };
+			memoryProperties2.pNext = &memoryBudgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &memoryProperties2);
+		}
+
+		for (uint32_t heapIndex = 0u; heapIndex < m_MemoryProperties.memoryHeapCount; ++heapIndex)
+		{
+			const HeapStatistics& heapStatistics{ m_HeapStatistics.at(heapIndex) };
+			HeapBudget&			  heapBudget{ m_HeapBudgets.at(heapIndex) };
+			heapBudget.engineUsage = heapStatistics.blockSize + heapStatistics.dedicatedSize;
+			if (m_SupportsMemoryBudget)
+			{
+				heapBudget.budget = memoryBudgetProperties.heapBudget[heapIndex];
+				heapBudget.usage = memoryBudgetProperties.heapUsage[heapIndex];
+			}
+			else
+			{
+				heapBudget.budget = static_cast<VkDeviceSize>(Spectre::fallbackMemoryBudget * static_cast<float>(m_MemoryProperties.memoryHeaps[heapIndex].size));
+				heapBudget.usage = heapBudget.engineUsage;
+			}
+		}
+
+		heapBudgets = m_HeapBudgets;
+		for (const auto& [callbackId, callback] : m_PressureCallbacks)
+		{
+			pressureCallbacks.push_back(callback);
+		}
+	}
+
+	// Called without holding the lock, so the callbacks can free memory right away
+	for (uint32_t heapIndex = 0u; heapIndex < static_cast<uint32_t>(heapBudgets.size()); ++heapIndex)
+	{
+		const HeapBudget& heapBudget{ heapBudgets.at(heapIndex) };
+		const float		  budget{ static_cast<float>(heapBudget.budget) };
+		if (heapBudget.budget == 0u || static_cast<float>(heapBudget.usage) < Spectre::memoryPressureThreshold * budget)
+		{
+			continue;
+		}
+
+		const VkDeviceSize excessSize{ heapBudget.usage - static_cast<VkDeviceSize>(Spectre::memoryPressureTarget * budget) };
+		for (const PressureCallback& pressureCallback : pressureCallbacks)
+		{
+			pressureCallback(heapIndex, excessSize);
+		}
+	}
+}
+
+uint32_t MemoryAllocator::AddPressureCallback(const PressureCallback& callback)
+{
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	m_PressureCallbacks.emplace_back(m_NextCallbackId, callback);
+	return m_NextCallbackId++;
+}
+
+void MemoryAllocator::RemovePressureCallback(uint32_t callbackId)
+{
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	std::erase_if(m_PressureCallbacks, [callbackId](const std::pair<uint32_t, PressureCallback>& pressureCallback) { return pressureCallback.first == callbackId; });
+}
+
+MemoryAllocator::HeapBudget MemoryAllocator::GetHeapBudget(uint32_t heapIndex) const
+{
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_HeapBudgets.at(heapIndex);
+}
+
+VkDeviceSize MemoryAllocator::GetCategoryUsage(EMemoryCategory category) const
+{
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_CategoryUsages.at(static_cast<size_t>(category));
+}
+
+void MemoryAllocator::LogStatistics() const
+{
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	std::cout << "Memory allocator: " << m_DeviceMemoryCount << " device memory allocation(s), " << m_PeakDeviceMemoryCount << " at peak, the device allows " << m_MaxDeviceMemoryCount << std::endl;
+
+	for (uint32_t heapIndex = 0u; heapIndex < static_cast<uint32_t>(m_HeapStatistics.size()); ++heapIndex)
+	{
+		const HeapStatistics& heapStatistics{ m_HeapStatistics.at(heapIndex) };
+		if (heapStatistics.peakSize == 0u)
+		{
+			continue;
+		}
+
+		const VkMemoryHeap& heap{ m_MemoryProperties.memoryHeaps[heapIndex] };
+		std::cout << "Memory heap " << heapIndex << " (" << ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device local" : "host") << ", " << ToMegabytes(heap.size) << " MB): " << heapStatistics.allocationCount << " allocation(s) use "
+				  << ToMegabytes(heapStatistics.usedSize) << " of " << ToMegabytes(heapStatistics.blockSize) << " MB in " << heapStatistics.blockCount << " block(s), " << heapStatistics.dedicatedCount << " dedicated allocation(s) use "
+				  << ToMegabytes(heapStatistics.dedicatedSize) << " MB, " << ToMegabytes(heapStatistics.peakSize) << " MB at peak" << std::endl;
+
+		const HeapBudget& heapBudget{ m_HeapBudgets.at(heapIndex) };
+		std::cout << "Memory heap " << heapIndex << " budget: " << ToMegabytes(heapBudget.usage) << " of " << ToMegabytes(heapBudget.budget) << " MB in use" << (m_SupportsMemoryBudget ? " by the process" : " (estimated)") << ", " << ToMegabytes(heapBudget.engineUsage)
+				  << " MB of it by the engine" << std::endl;
+	}
+
+	std::cout << "Memory categories:";
+	for (size_t categoryIndex = 0u; categoryIndex < m_CategoryUsages.size(); ++categoryIndex)
+	{
+		std::cout << (categoryIndex > 0u ? ", " : " ") << GetCategoryName(static_cast<EMemoryCategory>(categoryIndex)) << " " << ToMegabytes(m_CategoryUsages.at(categoryIndex)) << " MB";
+	}
+	std::cout << std::endl;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EResourceKind resourceKind, EMemoryCategory category, bool isDedicated, VkBuffer dedicatedBuffer, VkImage dedicatedImage)
+{
+	uint32_t suitableMemoryTypeIndex{ UINT32_MAX };
+	for (uint32_t memoryTypeIndex = 0u; memoryTypeIndex < m_MemoryProperties.memoryTypeCount; ++memoryTypeIndex)
+	{
+		if ((requirements.memoryTypeBits & (1u << memoryTypeIndex)) && (m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & properties) == properties)
+		{
+			suitableMemoryTypeIndex = memoryTypeIndex;
+			break;
+		}
+	}
+
+	if (suitableMemoryTypeIndex == UINT32_MAX)
+	{
+		utils::ThrowError(EError::FeatureNotSupported, "Suitable memory type");
+	}
+
+	const std::lock_guard<std::mutex> lock(m_Mutex);
+	m_CategoryUsages.at(static_cast<size_t>(category)) += requirements.size;
+	if (isDedicated || requirements.size > m_BlockSizes.at(suitableMemoryTypeIndex) / Spectre::dedicatedAllocationDivisor)
+	{
+		Allocation allocation{ AllocateDedicated(requirements, suitableMemoryTypeIndex, dedicatedBuffer, dedicatedImage) };
+		allocation.category = category;
+		return allocation;
+	}
+
+	// A buddy is aligned to its own size, so rounding up to the alignment is all it takes to satisfy it
+	const VkDeviceSize buddySize{ std::max(requirements.size, requirements.alignment) };
+
+	Allocation allocation;
+	allocation.blockIndex = UINT32_MAX;
+	for (uint32_t blockIndex = 0u; blockIndex < static_cast<uint32_t>(m_Blocks.size()); ++blockIndex)
+	{
+		Block* block{ m_Blocks.at(blockIndex) };
+		if (block && block->memoryTypeIndex == suitableMemoryTypeIndex && block->resourceKind == resourceKind && AllocateBuddy(*block, buddySize, allocation.offset))
+		{
+			allocation.blockIndex = blockIndex;
+			break;
+		}
+	}
+
+	if (allocation.blockIndex == UINT32_MAX)
+	{
+		allocation.blockIndex = CreateBlock(suitableMemoryTypeIndex, resourceKind);
+		if (!AllocateBuddy(*m_Blocks.at(allocation.blockIndex), buddySize, allocation.offset))
+		{
+			utils::ThrowError(EError::OutOfMemory, "Buddy in a new memory block");
+		}
+	}
+
+	const Block* block{ m_Blocks.at(allocation.blockIndex) };
+	allocation.memory = block->memory;
+	allocation.size = requirements.size;
+	allocation.mappedData = block->mappedData ? static_cast<char*>(block->mappedData) + allocation.offset : nullptr;
+	allocation.memoryTypeIndex = suitableMemoryTypeIndex;
+	allocation.category = category;
+
+	HeapStatistics& heapStatistics{ m_HeapStatistics.at(m_MemoryProperties.memoryTypes[suitableMemoryTypeIndex].heapIndex) };
+	++heapStatistics.allocationCount;
+	heapStatistics.usedSize += requirements.size;
+	return allocation;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, VkBuffer dedicatedBuffer, VkImage dedicatedImage)
+{
+	VkMemoryDedicatedAllocateInfo dedicatedAllocateInfo{ VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+	dedicatedAllocateInfo.buffer = dedicatedBuffer;
+	dedicatedAllocateInfo.image = dedicatedImage;
+
+	VkMemoryAllocateInfo memoryAllocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	memoryAllocateInfo.pNext = &dedicatedAllocateInfo;
+	memoryAllocateInfo.allocationSize = requirements.size;
+	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+	Allocation allocation;
+	if (vkAllocateMemory(m_Device, &memoryAllocateInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+	{
+		std::stringstream s;
+		s << requirements.size << " bytes for dedicated allocation";
+		utils::ThrowError(EError::OutOfMemory, s.str());
+	}
+
+	allocation.size = requirements.size;
+	allocation.mappedData = MapMemory(allocation.memory, memoryTypeIndex);
+	allocation.memoryTypeIndex = memoryTypeIndex;
+
+	HeapStatistics& heapStatistics{ m_HeapStatistics.at(m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex) };
+	++heapStatistics.dedicatedCount;
+	heapStatistics.dedicatedSize += requirements.size;
+	++m_DeviceMemoryCount;
+	UpdatePeak(memoryTypeIndex);
+	return allocation;
+}
+
+uint32_t MemoryAllocator::CreateBlock(uint32_t memoryTypeIndex, EResourceKind resourceKind)
+{
+	Block* block{ new Block };
+	block->size = m_BlockSizes.at(memoryTypeIndex);
+	block->memoryTypeIndex = memoryTypeIndex;
+	block->resourceKind = resourceKind;
+
+	VkMemoryAllocateInfo memoryAllocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	memoryAllocateInfo.allocationSize = block->size;
+	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+	if (vkAllocateMemory(m_Device, &memoryAllocateInfo, nullptr, &block->memory) != VK_SUCCESS)
+	{
+		std::stringstream s;
+		s << block->size << " bytes for memory block";
+		delete block;
+		utils::ThrowError(EError::OutOfMemory, s.str());
+	}
+	block->mappedData = MapMemory(block->memory, memoryTypeIndex);
+
+	// The whole block starts out as a single free buddy of the highest order
+	block->freeOffsets.resize(GetOrder(block->size) + 1u);
+	block->freeOffsets.back().push_back(0u);
+
+	HeapStatistics& heapStatistics{ m_HeapStatistics.at(m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex) };
+	++heapStatistics.blockCount;
+	heapStatistics.blockSize += block->size;
+	++m_DeviceMemoryCount;
+
+	const auto	   emptySlot{ std::find(m_Blocks.begin(), m_Blocks.end(), nullptr) };
+	const uint32_t blockIndex{ static_cast<uint32_t>(std::distance(m_Blocks.begin(), emptySlot)) };
+	if (emptySlot == m_Blocks.end())
+	{
+		m_Blocks.push_back(block);
+	}
+	else
+	{
+		*emptySlot = block;
+	}
+
+	UpdatePeak(memoryTypeIndex);
+	return blockIndex;
+}
+
+void MemoryAllocator::ReleaseBlock(uint32_t blockIndex)
+{
+	Block* block{ m_Blocks.at(blockIndex) };
+	vkFreeMemory(m_Device, block->memory, nullptr);
+
+	HeapStatistics& heapStatistics{ m_HeapStatistics.at(m_MemoryProperties.memoryTypes[block->memoryTypeIndex].heapIndex) };
+	--heapStatistics.blockCount;
+	heapStatistics.blockSize -= block->size;
+	--m_DeviceMemoryCount;
+
+	delete block;
+	m_Blocks.at(blockIndex) = nullptr;
+}
+
+void* MemoryAllocator::MapMemory(VkDeviceMemory memory, uint32_t memoryTypeIndex) const
+{
+	if (!(m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+	{
+		return nullptr;
+	}
+
+	void* data;
+	if (vkMapMemory(m_Device, memory, 0u, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	return data;
+}
+
+void MemoryAllocator::UpdatePeak(uint32_t memoryTypeIndex)
+{
+	HeapStatistics& heapStatistics{ m_HeapStatistics.at(m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex) };
+	heapStatistics.peakSize = std::max(heapStatistics.peakSize, heapStatistics.blockSize + heapStatistics.dedicatedSize);
+	m_PeakDeviceMemoryCount = std::max(m_PeakDeviceMemoryCount, m_DeviceMemoryCount);
+}
+
+bool MemoryAllocator::AllocateBuddy(Block& block, VkDeviceSize size, VkDeviceSize& outOffset)
+{
+	const uint32_t order{ GetOrder(size) };
+	const uint32_t orderCount{ static_cast<uint32_t>(block.freeOffsets.size()) };
+
+	uint32_t freeOrder{ order };
+	while (freeOrder < orderCount && block.freeOffsets.at(freeOrder).empty())
+	{
+		++freeOrder;
+	}
+
+	if (freeOrder >= orderCount)
+	{
+		return false;
+	}
+
+	const VkDeviceSize offset{ block.freeOffsets.at(freeOrder).back() };
+	block.freeOffsets.at(freeOrder).pop_back();
+
+	// Split the larger buddy down to the requested order, the upper halves become free
+	while (freeOrder > order)
+	{
+		--freeOrder;
+		block.freeOffsets.at(freeOrder).push_back(offset + (Spectre::memoryMinAllocationSize << freeOrder));
+	}
+
+	block.allocatedOrders.emplace(offset, order);
+	outOffset = offset;
+	return true;
+}
+
+void MemoryAllocator::FreeBuddy(Block& block, VkDeviceSize offset)
+{
+	const auto allocatedOrder{ block.allocatedOrders.find(offset) };
+	uint32_t   order{ allocatedOrder->second };
+	block.allocatedOrders.erase(allocatedOrder);
+
+	// Merge with the buddy for as long as it is free as well
+	while (order + 1u < static_cast<uint32_t>(block.freeOffsets.size()))
+	{
+		std::vector<VkDeviceSize>& freeOffsets{ block.freeOffsets.at(order) };
+		const VkDeviceSize		   buddyOffset{ offset ^ (Spectre::memoryMinAllocationSize << order) };
+		const auto				   buddy{ std::find(freeOffsets.begin(), freeOffsets.end(), buddyOffset) };
+		if (buddy == freeOffsets.end())
+		{
+			break;
+		}
+
+		*buddy = freeOffsets.back();
+		freeOffsets.pop_back();
+		offset = std::min(offset, buddyOffset);
+		++order;
+	}
+
+	block.freeOffsets.at(order).push_back(offset);
+}
+
+uint32_t MemoryAllocator::GetOrder(VkDeviceSize size)
+{
+	uint32_t order{ 0u };
+	while ((Spectre::memoryMinAllocationSize << order) < size)
+	{
+		++order;
+	}
+
+	return order;
+}
+
+const char* MemoryAllocator::GetCategoryName(EMemoryCategory category)
+{
+	switch (category)
+	{
+	case EMemoryCategory::Geometry:
+		return "geometry";
+	case EMemoryCategory::Texture:
+		return "textures";
+	case EMemoryCategory::Attachment:
+		return "attachments";
+	case EMemoryCategory::Uniform:
+		return "uniforms";
+	case EMemoryCategory::Staging:
+		return "staging";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Spectre
+{
+	constexpr VkDeviceSize memoryBlockSize = 64u * 1024u * 1024u; // Halved on heaps too small to hold eight blocks
+	constexpr VkDeviceSize memoryMinAllocationSize = 256u;		  // Smaller requests still take a whole buddy of this size
+	constexpr VkDeviceSize dedicatedAllocationDivisor = 4u;		  // Resources larger than a block divided by this get memory of their own
+	constexpr float		   memoryPressureThreshold = 0.9f;		  // Fraction of a heap budget in use at which the pressure callbacks fire
+	constexpr float		   memoryPressureTarget = 0.8f;			  // Fraction of a heap budget the pressure callbacks are asked to get back to
+	constexpr float		   fallbackMemoryBudget = 0.8f;			  // Fraction of a heap assumed to be available without VK_EXT_memory_budget
+} // namespace Spectre
+
+// What the memory is used for, the budget figures are broken down by it
+enum class EMemoryCategory
+{
+	Geometry,
+	Texture,
+	Attachment,
+	Uniform, // Uniform and storage buffers
+	Staging,
+	Count
+};
+
+/*
+ * The memory allocator backs all buffers and images with a few large device memory blocks per memory type, rather than
+ * an allocation of their own, which would run into maxMemoryAllocationCount and pad every resource to the allocation
+ * granularity. Each block is split with a buddy allocator: requests round up to a power of two that also satisfies their
+ * alignment, and freed buddies merge again with their neighbour. Large resources and attachments the driver would rather
+ * keep apart get a dedicated allocation. Host visible memory stays mapped for the lifetime of its block.
+ *
+ * The allocator also keeps track of the memory budget per heap, which on a headset is shared with the compositor. With
+ * VK_EXT_memory_budget the driver reports the budget and the usage of the whole process, otherwise a fixed fraction of
+ * every heap is assumed to be available and only the allocator's own memory counts as used. UpdateBudget() runs once per
+ * frame and calls the pressure callbacks for every heap that gets close to its budget, so streaming systems can evict
+ * before the driver starts paging.
+ */
+class MemoryAllocator final
+{
+public:
+	struct Allocation
+	{
+		VkDeviceMemory	memory{ nullptr };
+		VkDeviceSize	offset{ 0u };
+		VkDeviceSize	size{ 0u };				  // As requested by the resource, the buddy may be larger
+		void*			mappedData{ nullptr };	  // Already offset, null unless the memory is host visible
+		uint32_t		memoryTypeIndex{ 0u };
+		uint32_t		blockIndex{ UINT32_MAX }; // Dedicated allocations belong to no block
+		EMemoryCategory	category{ EMemoryCategory::Geometry };
+	};
+
+	struct HeapBudget
+	{
+		VkDeviceSize budget{ 0u };
+		VkDeviceSize usage{ 0u };		// Of the whole process when the driver reports it
+		VkDeviceSize engineUsage{ 0u }; // Blocks and dedicated allocations of this allocator
+	};
+
+	// Receives the heap and how much has to be freed to get back to the target fraction of its budget
+	using PressureCallback = std::function<void(uint32_t heapIndex, VkDeviceSize excessSize)>;
+
+	MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, bool supportsMemoryBudget);
+	~MemoryAllocator();
+	MemoryAllocator(const MemoryAllocator&) = delete;
+	MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+	// Allocates memory for the resource and binds it, throws when no suitable memory is left
+	Allocation AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties, EMemoryCategory category);
+	// Attachments should be dedicated, some drivers only compress them or place them optimally in memory of their own
+	Allocation AllocateForImage(VkImage image, VkMemoryPropertyFlags properties, EMemoryCategory category, bool isDedicated = false);
+	void	   Free(const Allocation& allocation);
+
+	// Refreshes the budget of every heap and calls the pressure callbacks, they may free memory from within the callback
+	void		 UpdateBudget();
+	uint32_t	 AddPressureCallback(const PressureCallback& callback);
+	void		 RemovePressureCallback(uint32_t callbackId);
+	uint32_t	 GetHeapCount() const { return m_MemoryProperties.memoryHeapCount; }
+	uint32_t	 GetHeapIndex(uint32_t memoryTypeIndex) const { return m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex; }
+	HeapBudget	 GetHeapBudget(uint32_t heapIndex) const;
+	// Sizes as requested by the resources
+	VkDeviceSize GetCategoryUsage(EMemoryCategory category) const;
+
+	void LogStatistics() const;
+
+private:
+	// Buffers and optimally tiled images never share a block, so bufferImageGranularity never has to be honored
+	enum class EResourceKind
+	{
+		Buffer,
+		Image
+	};
+
+	struct Block
+	{
+		VkDeviceMemory memory{ nullptr };
+		void*		   mappedData{ nullptr };
+		VkDeviceSize   size{ 0u };
+		uint32_t	   memoryTypeIndex{ 0u };
+		EResourceKind  resourceKind{ EResourceKind::Buffer };
+		// Offsets of the free buddies per order, a buddy of order n spans the minimum allocation size times two to the n
+		std::vector<std::vector<VkDeviceSize>>	   freeOffsets;
+		std::unordered_map<VkDeviceSize, uint32_t> allocatedOrders;
+	};
+
+	struct HeapStatistics
+	{
+		size_t		 blockCount{ 0u }, allocationCount{ 0u }, dedicatedCount{ 0u };
+		VkDeviceSize blockSize{ 0u }, usedSize{ 0u }, dedicatedSize{ 0u };
+		VkDeviceSize peakSize{ 0u }; // Highest sum of block and dedicated sizes
+	};
+
+	VkDevice						 m_Device{ nullptr };
+	VkPhysicalDevice				 m_PhysicalDevice{ nullptr };
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+	std::vector<VkDeviceSize>		 m_BlockSizes; // Per memory type
+	std::vector<Block*>				 m_Blocks;	   // Released blocks leave an empty slot behind
+	std::vector<HeapStatistics>		 m_HeapStatistics;
+	size_t							 m_DeviceMemoryCount{ 0u }, m_PeakDeviceMemoryCount{ 0u };
+	uint32_t						 m_MaxDeviceMemoryCount{ 0u };
+	mutable std::mutex				 m_Mutex;
+
+	bool											   m_SupportsMemoryBudget{ false };
+	std::vector<HeapBudget>							   m_HeapBudgets;	 // As of the last UpdateBudget()
+	std::vector<VkDeviceSize>						   m_CategoryUsages; // Per category
+	std::vector<std::pair<uint32_t, PressureCallback>> m_PressureCallbacks;
+	uint32_t										   m_NextCallbackId{ 0u };
+
+	Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EResourceKind resourceKind, EMemoryCategory category, bool isDedicated, VkBuffer dedicatedBuffer, VkImage dedicatedImage);
+	Allocation AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, VkBuffer dedicatedBuffer, VkImage dedicatedImage);
+	uint32_t   CreateBlock(uint32_t memoryTypeIndex, EResourceKind resourceKind);
+	void	   ReleaseBlock(uint32_t blockIndex);
+	void*	   MapMemory(VkDeviceMemory memory, uint32_t memoryTypeIndex) const;
+	void	   UpdatePeak(uint32_t memoryTypeIndex);
+
+	static bool		   IsBlockEmpty(const Block& block) { return block.allocatedOrders.empty(); }
+	static bool		   AllocateBuddy(Block& block, VkDeviceSize size, VkDeviceSize& outOffset);
+	static void		   FreeBuddy(Block& block, VkDeviceSize offset);
+	static uint32_t	   GetOrder(VkDeviceSize size);
+	static const char* GetCategoryName(EMemoryCategory category);
+};
@@ -0,0 +1,185 @@
+#include "PipelineCache.h"
+
+#include "../Misc/Utils.h"
+#include "VulkanDevice.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t cacheFileMagic{ 0x43505053u }; // "SPPC"
+	constexpr uint32_t cacheFileVersion{ 1u };
+} // namespace
+
+PipelineCache::PipelineCache(const VulkanDevice* device, const std::string& filename) : m_Device(device), m_Filename(filename)
+{
+	// Seed the cache with the blob from the previous run if it was written by this exact device and driver
+	std::string initialData;
+	if (!LoadFromFile(initialData))
+	{
+		initialData.clear();
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	pipelineCacheCreateInfo.initialDataSize = initialData.size();
+	pipelineCacheCreateInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+	if (vkCreatePipelineCache(device->GetVkDevice(), &pipelineCacheCreateInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+}
+
+PipelineCache::~PipelineCache()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice && m_PipelineCache)
+	{
+		vkDestroyPipelineCache(vkDevice, m_PipelineCache, nullptr);
+	}
+}
+
+bool PipelineCache::Save() const
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+
+	size_t dataSize{ 0u };
+	if (vkGetPipelineCacheData(vkDevice, m_PipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0u)
+	{
+		return false;
+	}
+
+	std::vector<char> data(dataSize);
+	if (vkGetPipelineCacheData(vkDevice, m_PipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	// Write to a temporary file first so a crash mid-write never leaves a truncated cache behind
+	const std::string temporaryFilename{ m_Filename + ".tmp" };
+	{
+		std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		const FileHeader header{ MakeHeader(static_cast<uint64_t>(dataSize)) };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(data.data(), static_cast<std::streamsize>(dataSize));
+		if (!file.good())
+		{
+			return false;
+		}
+	}
+
+	std::remove(m_Filename.c_str());
+	if (std::rename(temporaryFilename.c_str(), m_Filename.c_str()) != 0)
+	{
+		return false;
+	}
+
+	std::cout << "Pipeline cache: saved " << dataSize << " bytes to \"" << m_Filename << "\"" << std::endl;
+	return true;
+}
+
+void PipelineCache::RecordCreationFeedback(const VkPipelineCreationFeedback& feedback)
+{
+	if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT))
+	{
+		++m_UnreportedCount;
+	}
+	else if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+	{
+		++m_HitCount;
+	}
+	else
+	{
+		++m_MissCount;
+	}
+}
+
+void PipelineCache::LogStatistics() const
+{
+	std::cout << "Pipeline cache: " << m_HitCount << " hit(s), " << m_MissCount << " miss(es)";
+	if (m_UnreportedCount > 0u)
+	{
+		std::cout << ", " << m_UnreportedCount << " not reported by the driver";
+	}
+	std::cout << std::endl;
+}
+
+bool PipelineCache::LoadFromFile(std::string& outInitialData) const
+{
+	std::ifstream file(m_Filename, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "Pipeline cache: no cache found at \"" << m_Filename << "\", starting empty" << std::endl;
+		return false;
+	}
+
+	const size_t fileSize{ static_cast<size_t>(file.tellg()) };
+	if (fileSize < sizeof(FileHeader))
+	{
+		std::cout << "Pipeline cache: \"" << m_Filename << "\" is truncated, discarding" << std::endl;
+		return false;
+	}
+
+	FileHeader header{};
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!IsValidHeader(header, fileSize))
+	{
+		std::cout << "Pipeline cache: \"" << m_Filename << "\" was written by another device or driver, discarding" << std::endl;
+		return false;
+	}
+
+	outInitialData.resize(static_cast<size_t>(header.dataSize));
+	file.read(outInitialData.data(), static_cast<std::streamsize>(header.dataSize));
+	if (!file.good() || !IsValidCacheData(outInitialData))
+	{
+		std::cout << "Pipeline cache: \"" << m_Filename << "\" holds invalid cache data, discarding" << std::endl;
+		return false;
+	}
+
+	std::cout << "Pipeline cache: loaded " << header.dataSize << " bytes from \"" << m_Filename << "\"" << std::endl;
+	return true;
+}
+
+bool PipelineCache::IsValidHeader(const FileHeader& header, size_t fileSize) const
+{
+	const FileHeader expected{ MakeHeader(header.dataSize) };
+	return header.magic == expected.magic && header.version == expected.version && header.vendorID == expected.vendorID && header.deviceID == expected.deviceID && header.driverVersion == expected.driverVersion && memcmp(header.deviceUUID, expected.deviceUUID, VK_UUID_SIZE) == 0 && sizeof(FileHeader) + header.dataSize == fileSize;
+}
+
+bool PipelineCache::IsValidCacheData(const std::string& data) const
+{
+	// Drivers should reject foreign data themselves, but not all of them do so gracefully
+	VkPipelineCacheHeaderVersionOne cacheHeader;
+	if (data.size() < sizeof(cacheHeader))
+	{
+		return false;
+	}
+	memcpy(&cacheHeader, data.data(), sizeof(cacheHeader));
+
+	const VkPhysicalDeviceProperties& properties{ m_Device->GetPhysicalDeviceProperties() };
+	return cacheHeader.headerSize >= sizeof(cacheHeader) && cacheHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && cacheHeader.vendorID == properties.vendorID && cacheHeader.deviceID == properties.deviceID && memcmp(cacheHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+PipelineCache::FileHeader PipelineCache::MakeHeader(uint64_t dataSize) const
+{
+	const VkPhysicalDeviceProperties& properties{ m_Device->GetPhysicalDeviceProperties() };
+
+	FileHeader header{};
+	header.magic = cacheFileMagic;
+	header.version = cacheFileVersion;
+	header.vendorID = properties.vendorID;
+	header.deviceID = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	memcpy(header.deviceUUID, m_Device->GetDeviceUUID().data(), VK_UUID_SIZE);
+	header.dataSize = dataSize;
+	return header;
+}
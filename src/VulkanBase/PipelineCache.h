@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class VulkanDevice;
+
+/*
+ * The pipeline cache class wraps a Vulkan pipeline cache that is persisted to disk between runs. The blob on disk is
+ * prefixed with a small header holding the device UUID and driver version, so a cache written by another GPU or driver
+ * version is discarded instead of being handed to the driver. Pipeline creation feedback is used to count how many
+ * pipelines were served from the cache.
+ */
+class PipelineCache final
+{
+public:
+	PipelineCache(const VulkanDevice* device, const std::string& filename);
+	~PipelineCache();
+
+	bool Save() const;
+	void RecordCreationFeedback(const VkPipelineCreationFeedback& feedback);
+	void LogStatistics() const;
+
+	VkPipelineCache GetVkPipelineCache() const { return m_PipelineCache; }
+
+private:
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t	 deviceUUID[VK_UUID_SIZE];
+		uint32_t reserved; // Would otherwise be padding, written as zero so identical caches give identical files
+		uint64_t dataSize;
+	};
+	static_assert(sizeof(FileHeader) == 48u, "The file header must not contain any padding");
+
+	const VulkanDevice* m_Device{ nullptr };
+	VkPipelineCache		m_PipelineCache{ nullptr };
+	std::string			m_Filename;
+
+	std::atomic<uint32_t> m_HitCount{ 0u }, m_MissCount{ 0u }, m_UnreportedCount{ 0u };
+
+	bool	   LoadFromFile(std::string& outInitialData) const;
+	bool	   IsValidHeader(const FileHeader& header, size_t fileSize) const;
+	bool	   IsValidCacheData(const std::string& data) const;
+	FileHeader MakeHeader(uint64_t dataSize) const;
+};
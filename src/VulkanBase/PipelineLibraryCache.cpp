@@ -0,0 +1,78 @@
+#include "PipelineLibraryCache.h"
+
+#include "../Misc/Utils.h"
+#include "VulkanDevice.h"
+
+#include <iostream>
+
+bool PipelineLibraryCache::LibraryKey::operator==(const LibraryKey& other) const
+{
+	return part == other.part && shaderName == other.shaderName && pipelineLayout == other.pipelineLayout && renderTargetLayout == other.renderTargetLayout && fixedFunctionState == other.fixedFunctionState;
+}
+
+size_t PipelineLibraryCache::LibraryKeyHasher::operator()(const LibraryKey& key) const
+{
+	size_t seed{ 0u };
+	utils::HashCombine(seed, key.part);
+	utils::HashCombine(seed, key.shaderName);
+	utils::HashCombine(seed, key.pipelineLayout);
+
+	const Spectre::RenderTargetLayout& renderTargetLayout{ key.renderTargetLayout };
+	utils::HashCombine(seed, renderTargetLayout.renderPass);
+	utils::HashCombine(seed, static_cast<int>(renderTargetLayout.colorFormat));
+	utils::HashCombine(seed, static_cast<int>(renderTargetLayout.depthFormat));
+	utils::HashCombine(seed, static_cast<int>(renderTargetLayout.sampleCount));
+	utils::HashCombine(seed, renderTargetLayout.viewMask);
+
+	for (const uint32_t value : key.fixedFunctionState)
+	{
+		utils::HashCombine(seed, value);
+	}
+	return seed;
+}
+
+PipelineLibraryCache::PipelineLibraryCache(const VulkanDevice* device) : m_Device(device) {}
+
+PipelineLibraryCache::~PipelineLibraryCache()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	for (const auto& [key, library] : m_Libraries)
+	{
+		vkDestroyPipeline(vkDevice, library, nullptr);
+	}
+}
+
+VkPipeline PipelineLibraryCache::GetOrCreate(const LibraryKey& key, const std::function<VkPipeline()>& createLibrary)
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		const auto it{ m_Libraries.find(key) };
+		if (it != m_Libraries.end())
+		{
+			++m_ReusedCount;
+			return it->second;
+		}
+	}
+
+	// Build outside the lock so workers compiling unrelated libraries don't wait on each other
+	const VkPipeline library{ createLibrary() };
+
+	std::lock_guard lock{ m_Mutex };
+	const auto [it, isInserted]{ m_Libraries.emplace(key, library) };
+	if (!isInserted)
+	{
+		// Another worker built the same library in the meantime
+		vkDestroyPipeline(m_Device->GetVkDevice(), library, nullptr);
+		++m_ReusedCount;
+		return it->second;
+	}
+
+	++m_CreatedCount;
+	return library;
+}
+
+void PipelineLibraryCache::LogStatistics() const
+{
+	std::lock_guard lock{ m_Mutex };
+	std::cout << "Pipeline libraries: " << m_CreatedCount << " created, " << m_ReusedCount << " reused" << std::endl;
+}
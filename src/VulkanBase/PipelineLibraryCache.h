@@ -0,0 +1,55 @@
+#pragma once
+
+#include "VulkanPipeline.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VulkanDevice;
+
+/*
+ * The pipeline library cache owns the graphics pipeline libraries built through VK_EXT_graphics_pipeline_library. A
+ * library only covers one part of a pipeline (vertex input, pre-rasterization, fragment shader or fragment output), so
+ * most pipelines share the bulk of their libraries and each part is only compiled once.
+ */
+class PipelineLibraryCache final
+{
+public:
+	// Everything a library part is built from, parts only fill in the state they depend on
+	struct LibraryKey
+	{
+		VkGraphicsPipelineLibraryFlagsEXT part{ 0u };
+		std::string						  shaderName; // Empty for the parts without a shader stage
+		VkPipelineLayout				  pipelineLayout{ nullptr };
+		Spectre::RenderTargetLayout		  renderTargetLayout;
+		std::vector<uint32_t>			  fixedFunctionState; // Vertex layout, cull, depth and blend state, flattened
+
+		bool operator==(const LibraryKey& other) const;
+	};
+
+	PipelineLibraryCache(const VulkanDevice* device);
+	~PipelineLibraryCache();
+
+	// Returns the library for this key, building it with createLibrary on first use. Safe to call from any thread
+	VkPipeline GetOrCreate(const LibraryKey& key, const std::function<VkPipeline()>& createLibrary);
+
+	void LogStatistics() const;
+
+private:
+	struct LibraryKeyHasher
+	{
+		size_t operator()(const LibraryKey& key) const;
+	};
+
+	const VulkanDevice* m_Device{ nullptr };
+
+	mutable std::mutex											  m_Mutex;
+	std::unordered_map<LibraryKey, VkPipeline, LibraryKeyHasher>  m_Libraries;
+	uint32_t													  m_CreatedCount{ 0u }, m_ReusedCount{ 0u };
+};
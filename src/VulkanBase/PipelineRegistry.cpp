@@ -0,0 +1,107 @@
+#include "PipelineRegistry.h"
+
+#include "../Misc/Utils.h"
+
+bool PipelineRegistry::PipelineKey::operator==(const PipelineKey& other) const
+{
+	if (vertShaderName != other.vertShaderName || fragShaderName != other.fragShaderName || !(materialPayload == other.materialPayload) || !(renderTargetLayout == other.renderTargetLayout) || pipelineLayout != other.pipelineLayout)
+	{
+		return false;
+	}
+
+	if (vertexInputBindingDescriptions.size() != other.vertexInputBindingDescriptions.size() || vertexInputAttributeDescriptions.size() != other.vertexInputAttributeDescriptions.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0u; i < vertexInputBindingDescriptions.size(); ++i)
+	{
+		const VkVertexInputBindingDescription& a{ vertexInputBindingDescriptions[i] };
+		const VkVertexInputBindingDescription& b{ other.vertexInputBindingDescriptions[i] };
+		if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate)
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0u; i < vertexInputAttributeDescriptions.size(); ++i)
+	{
+		const VkVertexInputAttributeDescription& a{ vertexInputAttributeDescriptions[i] };
+		const VkVertexInputAttributeDescription& b{ other.vertexInputAttributeDescriptions[i] };
+		if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t PipelineRegistry::PipelineKeyHasher::operator()(const PipelineKey& key) const
+{
+	size_t seed{ 0u };
+	utils::HashCombine(seed, key.vertShaderName);
+	utils::HashCombine(seed, key.fragShaderName);
+
+	const Spectre::PipelineMaterialPayload& payload{ key.materialPayload };
+	utils::HashCombine(seed, static_cast<int>(payload.srcColorBlendFactor));
+	utils::HashCombine(seed, static_cast<int>(payload.dstColorBlendFactor));
+	utils::HashCombine(seed, static_cast<int>(payload.colorBlendOp));
+	utils::HashCombine(seed, static_cast<int>(payload.srcAlphaBlendFactor));
+	utils::HashCombine(seed, static_cast<int>(payload.dstAlphaBlendFactor));
+	utils::HashCombine(seed, static_cast<int>(payload.alphaBlendOp));
+	utils::HashCombine(seed, static_cast<int>(payload.cullMode));
+	utils::HashCombine(seed, payload.depthTestEnable);
+	utils::HashCombine(seed, payload.depthWriteEnable);
+	utils::HashCombine(seed, static_cast<int>(payload.depthCompareOp));
+	utils::HashCombine(seed, payload.colorWriteMask);
+
+	for (const VkVertexInputBindingDescription& binding : key.vertexInputBindingDescriptions)
+	{
+		utils::HashCombine(seed, binding.binding);
+		utils::HashCombine(seed, binding.stride);
+		utils::HashCombine(seed, static_cast<int>(binding.inputRate));
+	}
+
+	for (const VkVertexInputAttributeDescription& attribute : key.vertexInputAttributeDescriptions)
+	{
+		utils::HashCombine(seed, attribute.location);
+		utils::HashCombine(seed, attribute.binding);
+		utils::HashCombine(seed, static_cast<int>(attribute.format));
+		utils::HashCombine(seed, attribute.offset);
+	}
+
+	const Spectre::RenderTargetLayout& renderTargetLayout{ key.renderTargetLayout };
+	utils::HashCombine(seed, renderTargetLayout.renderPass);
+	utils::HashCombine(seed, static_cast<int>(renderTargetLayout.colorFormat));
+	utils::HashCombine(seed, static_cast<int>(renderTargetLayout.depthFormat));
+	utils::HashCombine(seed, static_cast<int>(renderTargetLayout.sampleCount));
+	utils::HashCombine(seed, renderTargetLayout.viewMask);
+	utils::HashCombine(seed, key.pipelineLayout);
+	return seed;
+}
+
+PipelineRegistry::PipelineRegistry(const VulkanDevice* device, PipelineCache* pipelineCache, ShaderModuleCache* shaderModuleCache, PipelineLibraryCache* pipelineLibraryCache) : m_Device(device), m_PipelineCache(pipelineCache), m_ShaderModuleCache(shaderModuleCache), m_PipelineLibraryCache(pipelineLibraryCache) {}
+
+PipelineRegistry::~PipelineRegistry()
+{
+	for (const auto& [key, pipeline] : m_Pipelines)
+	{
+		delete pipeline;
+	}
+}
+
+VulkanPipeline* PipelineRegistry::Acquire(const PipelineKey& key, bool& outIsNew)
+{
+	const auto it{ m_Pipelines.find(key) };
+	if (it != m_Pipelines.end())
+	{
+		outIsNew = false;
+		return it->second;
+	}
+
+	VulkanPipeline* pipeline{ new VulkanPipeline(m_Device, m_PipelineCache, m_ShaderModuleCache, m_PipelineLibraryCache, key.pipelineLayout, key.renderTargetLayout, key.vertShaderName, key.fragShaderName, key.vertexInputBindingDescriptions, key.vertexInputAttributeDescriptions, key.materialPayload) };
+	m_Pipelines.emplace(key, pipeline);
+	outIsNew = true;
+	return pipeline;
+}
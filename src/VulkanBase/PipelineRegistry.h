@@ -0,0 +1,57 @@
+#pragma once
+
+#include "VulkanPipeline.h"
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VulkanDevice;
+class PipelineCache;
+class ShaderModuleCache;
+class PipelineLibraryCache;
+
+/*
+ * The pipeline registry owns every graphics pipeline and hands out one pipeline per unique combination of shaders,
+ * material payload, vertex layout, render target and pipeline layout. Materials with identical state share a pipeline,
+ * so the number of pipeline objects scales with the number of unique states rather than the number of materials.
+ */
+class PipelineRegistry final
+{
+public:
+	struct PipelineKey
+	{
+		std::string									   vertShaderName;
+		std::string									   fragShaderName;
+		Spectre::PipelineMaterialPayload			   materialPayload;
+		std::vector<VkVertexInputBindingDescription>   vertexInputBindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;
+		Spectre::RenderTargetLayout					   renderTargetLayout;
+		VkPipelineLayout							   pipelineLayout{ nullptr };
+
+		bool operator==(const PipelineKey& other) const;
+	};
+
+	PipelineRegistry(const VulkanDevice* device, PipelineCache* pipelineCache, ShaderModuleCache* shaderModuleCache, PipelineLibraryCache* pipelineLibraryCache);
+	~PipelineRegistry();
+
+	// Returns the pipeline for this key, outIsNew is set when it was just created and still has to be compiled
+	VulkanPipeline* Acquire(const PipelineKey& key, bool& outIsNew);
+
+	size_t GetPipelineCount() const { return m_Pipelines.size(); }
+
+private:
+	struct PipelineKeyHasher
+	{
+		size_t operator()(const PipelineKey& key) const;
+	};
+
+	const VulkanDevice*	  m_Device{ nullptr };
+	PipelineCache*		  m_PipelineCache{ nullptr };
+	ShaderModuleCache*	  m_ShaderModuleCache{ nullptr };
+	PipelineLibraryCache* m_PipelineLibraryCache{ nullptr };
+
+	std::unordered_map<PipelineKey, VulkanPipeline*, PipelineKeyHasher> m_Pipelines;
+};
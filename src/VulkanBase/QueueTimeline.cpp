@@ -0,0 +1,113 @@
+#include "QueueTimeline.h"
+
+#include "../Misc/Utils.h"
+
+QueueTimeline::QueueTimeline(VkDevice device, VkQueue queue) : m_Device(device), m_Queue(queue)
+{
+	VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+	semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	semaphoreTypeCreateInfo.initialValue = m_LastSubmittedValue;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+	semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+	if (vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_Semaphore) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+}
+
+QueueTimeline::~QueueTimeline()
+{
+	if (m_Device && m_Semaphore)
+	{
+		vkDestroySemaphore(m_Device, m_Semaphore, nullptr);
+	}
+}
+
+uint64_t QueueTimeline::Submit(const std::vector<VkCommandBuffer>& commandBuffers, const std::vector<Wait>& waits, const std::vector<VkSemaphore>& binarySignalSemaphores)
+{
+	std::vector<VkSemaphore>		  waitSemaphores;
+	std::vector<uint64_t>			  waitValues;
+	std::vector<VkPipelineStageFlags> waitStages;
+	for (const Wait& wait : waits)
+	{
+		waitSemaphores.push_back(wait.semaphore);
+		waitValues.push_back(wait.value);
+		waitStages.push_back(wait.stages);
+	}
+
+	// The values of binary semaphores are ignored, the timeline value is signaled last
+	const uint64_t			 signalValue{ m_LastSubmittedValue + 1u };
+	std::vector<VkSemaphore> signalSemaphores{ binarySignalSemaphores };
+	std::vector<uint64_t>	 signalValues(signalSemaphores.size(), 0u);
+	signalSemaphores.push_back(m_Semaphore);
+	signalValues.push_back(signalValue);
+
+	VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+	timelineSemaphoreSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineSemaphoreSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineSemaphoreSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineSemaphoreSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+
+	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.pNext = &timelineSemaphoreSubmitInfo;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+	submitInfo.pCommandBuffers = commandBuffers.data();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+	submitInfo.pSignalSemaphores = signalSemaphores.data();
+	if (vkQueueSubmit(m_Queue, 1u, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		return 0u;
+	}
+
+	m_LastSubmittedValue = signalValue;
+	return signalValue;
+}
+
+bool QueueTimeline::IsReached(uint64_t value) const
+{
+	if (value <= m_ReachedValue.load(std::memory_order_relaxed))
+	{
+		return true;
+	}
+
+	uint64_t counterValue{ 0u };
+	if (vkGetSemaphoreCounterValue(m_Device, m_Semaphore, &counterValue) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	UpdateReachedValue(counterValue);
+	return value <= counterValue;
+}
+
+bool QueueTimeline::WaitFor(uint64_t value) const
+{
+	if (IsReached(value))
+	{
+		return true;
+	}
+
+	VkSemaphoreWaitInfo semaphoreWaitInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+	semaphoreWaitInfo.semaphoreCount = 1u;
+	semaphoreWaitInfo.pSemaphores = &m_Semaphore;
+	semaphoreWaitInfo.pValues = &value;
+	if (vkWaitSemaphores(m_Device, &semaphoreWaitInfo, UINT64_MAX) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	UpdateReachedValue(value);
+	return true;
+}
+
+void QueueTimeline::UpdateReachedValue(uint64_t value) const
+{
+	uint64_t reachedValue{ m_ReachedValue.load(std::memory_order_relaxed) };
+	while (reachedValue < value && !m_ReachedValue.compare_exchange_weak(reachedValue, value, std::memory_order_relaxed))
+	{
+	}
+}
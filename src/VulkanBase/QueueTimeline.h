@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The queue timeline pairs a queue with a timeline semaphore whose value counts the submissions to it. Every submission
+ * signals the next value, so the value a submission returns identifies it for as long as the application runs. Other
+ * queues wait on that value instead of on a binary semaphore, and the CPU checks or waits for it instead of using a
+ * fence per frame or draining the whole queue. Resources used by a submission can be recycled once its value has been
+ * reached, which costs a single counter read.
+ */
+class QueueTimeline final
+{
+public:
+	// Binary semaphores are waited on with a value of zero
+	struct Wait
+	{
+		VkSemaphore			 semaphore{ nullptr };
+		uint64_t			 value{ 0u };
+		VkPipelineStageFlags stages{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+	};
+
+	QueueTimeline(VkDevice device, VkQueue queue);
+	~QueueTimeline();
+	QueueTimeline(const QueueTimeline&) = delete;
+	QueueTimeline& operator=(const QueueTimeline&) = delete;
+
+	// Signals the binary semaphores as well as the next timeline value, returns that value or zero on failure
+	uint64_t Submit(const std::vector<VkCommandBuffer>& commandBuffers, const std::vector<Wait>& waits = {}, const std::vector<VkSemaphore>& binarySignalSemaphores = {});
+	// Value zero is reached from the start, it stands for work that was never submitted
+	bool	 IsReached(uint64_t value) const;
+	bool	 WaitFor(uint64_t value) const;
+
+	VkQueue		GetVkQueue() const { return m_Queue; }
+	VkSemaphore GetSemaphore() const { return m_Semaphore; }
+	uint64_t	GetLastSubmittedValue() const { return m_LastSubmittedValue; }
+
+private:
+	VkDevice	m_Device{ nullptr };
+	VkQueue		m_Queue{ nullptr };
+	VkSemaphore m_Semaphore{ nullptr };
+	uint64_t	m_LastSubmittedValue{ 0u };
+	// Counter reads are skipped for values that are already known to be reached, checked from any thread
+	mutable std::atomic<uint64_t> m_ReachedValue{ 0u };
+
+	// Only ever raises the value, a thread that read an older counter value must not lower it again
+	void UpdateReachedValue(uint64_t value) const;
+};
@@ -0,0 +1,686 @@
+#include "RenderGraph.h"
+
+#include "../Misc/Utils.h"
+#include "GpuProfiler.h"
+#include "VulkanDevice.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+namespace
+{
+	struct UsageInfo
+	{
+		VkPipelineStageFlags stages{ 0u };
+		VkAccessFlags		 access{ 0u };
+		VkImageLayout		 layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkImageUsageFlags	 imageUsage{ 0u };
+	};
+
+	UsageInfo GetUsageInfo(RenderGraph::EResourceUsage usage, VkImageAspectFlags aspect)
+	{
+		switch (usage)
+		{
+		case RenderGraph::EResourceUsage::ColorAttachment:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+		case RenderGraph::EResourceUsage::DepthAttachment:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+		case RenderGraph::EResourceUsage::FragmentShaderRead:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT };
+		case RenderGraph::EResourceUsage::ComputeShaderWrite:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+		case RenderGraph::EResourceUsage::TransferSource:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+		case RenderGraph::EResourceUsage::TransferDestination:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+		}
+
+		return {};
+	}
+
+	VkImageMemoryBarrier MakeImageBarrier(VkImage image, VkImageAspectFlags aspect)
+	{
+		VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = aspect;
+		barrier.subresourceRange.baseMipLevel = 0u;
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer = 0u;
+		barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		return barrier;
+	}
+
+	// Attachments that are only used within a single pass never have to be stored to memory
+	bool IsLazilyAllocatable(VkImageUsageFlags usage, uint32_t firstPass, uint32_t lastPass)
+	{
+		constexpr VkImageUsageFlags attachmentUsage{ VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+		return (usage & ~attachmentUsage) == 0u && firstPass == lastPass;
+	}
+
+	bool AreLifetimesOverlapping(uint32_t firstPassA, uint32_t lastPassA, uint32_t firstPassB, uint32_t lastPassB) { return firstPassA <= lastPassB && firstPassB <= lastPassA; }
+
+	float ToMegabytes(VkDeviceSize size) { return static_cast<float>(size) / (1024.0f * 1024.0f); }
+} // namespace
+
+RenderGraph::Pass& RenderGraph::Pass::Read(ResourceHandle resource, EResourceUsage usage)
+{
+	m_Accesses.push_back({ resource, usage, false });
+	return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Write(ResourceHandle resource, EResourceUsage usage)
+{
+	m_Accesses.push_back({ resource, usage, true });
+	return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::SetExecute(std::function<void(VkCommandBuffer)> execute)
+{
+	m_Execute = std::move(execute);
+	return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::KeepAlive()
+{
+	m_IsKeptAlive = true;
+	return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::CollectStatistics()
+{
+	m_CollectsStatistics = true;
+	return *this;
+}
+
+RenderGraph::RenderGraph(const VulkanDevice* device, GpuProfiler* gpuProfiler) : m_Device(device), m_GpuProfiler(gpuProfiler) {}
+
+RenderGraph::~RenderGraph() { DestroyTransientImages(); }
+
+void RenderGraph::Reset()
+{
+	m_Resources.clear();
+	m_Passes.clear();
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportImage(const std::string& name, VkImage image, VkImageAspectFlags aspect, bool preserveContents, VkImageLayout finalLayout)
+{
+	Resource resource;
+	resource.name = name;
+	resource.image = image;
+	resource.aspect = aspect;
+	resource.preserveContents = preserveContents;
+	resource.finalLayout = finalLayout;
+
+	const auto it{ m_ImageStates.find(image) };
+	if (it != m_ImageStates.end())
+	{
+		resource.state = it->second;
+	}
+
+	// Discarding the contents still waits for the previous frame to be done with them
+	if (!preserveContents)
+	{
+		resource.state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	m_Resources.push_back(resource);
+	return static_cast<ResourceHandle>(m_Resources.size() - 1u);
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportBuffer(const std::string& name, VkBuffer buffer)
+{
+	Resource resource;
+	resource.name = name;
+	resource.buffer = buffer;
+
+	const auto it{ m_BufferStates.find(buffer) };
+	if (it != m_BufferStates.end())
+	{
+		resource.state = it->second;
+	}
+
+	m_Resources.push_back(resource);
+	return static_cast<ResourceHandle>(m_Resources.size() - 1u);
+}
+
+RenderGraph::ResourceHandle RenderGraph::CreateImage(const std::string& name, const TransientImageDescription& description)
+{
+	Resource resource;
+	resource.name = name;
+	resource.aspect = description.aspect;
+	resource.isTransient = true;
+	resource.preserveContents = false;
+	resource.description = description;
+
+	m_Resources.push_back(resource);
+	return static_cast<ResourceHandle>(m_Resources.size() - 1u);
+}
+
+RenderGraph::Pass& RenderGraph::AddPass(const std::string& name) { return m_Passes.emplace_back(name); }
+
+void RenderGraph::Execute(VkCommandBuffer commandBuffer)
+{
+	++m_FrameCount;
+
+	const std::vector<bool> isPassAlive{ CullPasses() };
+	AllocateTransientImages(isPassAlive);
+
+	for (size_t passIndex = 0u; passIndex < m_Passes.size(); ++passIndex)
+	{
+		if (!isPassAlive.at(passIndex))
+		{
+			++m_CulledPassCount;
+			continue;
+		}
+
+		const Pass& pass{ m_Passes.at(passIndex) };
+		RecordBarriers(commandBuffer, pass);
+		if (!pass.m_Execute)
+		{
+			continue;
+		}
+
+		// The barriers are left out of the scope so it only measures the work of the pass
+		if (m_GpuProfiler)
+		{
+			m_GpuProfiler->BeginScope(commandBuffer, pass.m_Name, pass.m_CollectsStatistics);
+		}
+		pass.m_Execute(commandBuffer);
+		if (m_GpuProfiler)
+		{
+			m_GpuProfiler->EndScope(commandBuffer);
+		}
+	}
+
+	RecordFinalBarriers(commandBuffer);
+
+	// The next frame continues from here
+	for (const Resource& resource : m_Resources)
+	{
+		if (resource.isTransient)
+		{
+			continue;
+		}
+
+		if (resource.buffer)
+		{
+			m_BufferStates[resource.buffer] = resource.state;
+		}
+		else
+		{
+			m_ImageStates[resource.image] = resource.state;
+		}
+	}
+}
+
+std::vector<bool> RenderGraph::CullPasses() const
+{
+	// Imported resources are seen outside of the graph, transients only matter once a pass that is kept uses them
+	std::vector<bool> isResourceNeeded(m_Resources.size());
+	for (size_t resourceIndex = 0u; resourceIndex < m_Resources.size(); ++resourceIndex)
+	{
+		isResourceNeeded.at(resourceIndex) = !m_Resources.at(resourceIndex).isTransient;
+	}
+
+	std::vector<bool> isPassAlive(m_Passes.size(), false);
+	for (size_t passIndex = m_Passes.size(); passIndex-- > 0u;)
+	{
+		const Pass& pass{ m_Passes.at(passIndex) };
+
+		bool isAlive{ pass.m_IsKeptAlive };
+		for (const Pass::Access& access : pass.m_Accesses)
+		{
+			isAlive = isAlive || (access.isWrite && isResourceNeeded.at(access.resource));
+		}
+
+		if (!isAlive)
+		{
+			continue;
+		}
+
+		// Attachments may be loaded, so earlier writers of anything a kept pass touches are needed as well
+		isPassAlive.at(passIndex) = true;
+		for (const Pass::Access& access : pass.m_Accesses)
+		{
+			isResourceNeeded.at(access.resource) = true;
+		}
+	}
+
+	return isPassAlive;
+}
+
+void RenderGraph::AllocateTransientImages(const std::vector<bool>& isPassAlive)
+{
+	// Gather the usage and lifetime of every transient image from the passes that are kept
+	std::vector<TransientImage> transientImages;
+	uint32_t					alivePassIndex{ 0u };
+	for (size_t passIndex = 0u; passIndex < m_Passes.size(); ++passIndex)
+	{
+		if (!isPassAlive.at(passIndex))
+		{
+			continue;
+		}
+
+		for (const Pass::Access& access : m_Passes.at(passIndex).m_Accesses)
+		{
+			Resource& resource{ m_Resources.at(access.resource) };
+			if (!resource.isTransient)
+			{
+				continue;
+			}
+
+			if (resource.transientIndex == SIZE_MAX)
+			{
+				resource.transientIndex = transientImages.size();
+
+				TransientImage& transientImage{ transientImages.emplace_back() };
+				transientImage.description = resource.description;
+				transientImage.firstPass = alivePassIndex;
+			}
+
+			TransientImage& transientImage{ transientImages.at(resource.transientIndex) };
+			transientImage.usage |= GetUsageInfo(access.usage, resource.aspect).imageUsage;
+			transientImage.lastPass = alivePassIndex;
+		}
+
+		++alivePassIndex;
+	}
+
+	if (CanReuseTransientImages(transientImages))
+	{
+		for (size_t transientIndex = 0u; transientIndex < transientImages.size(); ++transientIndex)
+		{
+			m_TransientImages.at(transientIndex).firstPass = transientImages.at(transientIndex).firstPass;
+			m_TransientImages.at(transientIndex).lastPass = transientImages.at(transientIndex).lastPass;
+		}
+	}
+	else
+	{
+		// Rare, the frames in flight may still be using the previous images
+		if (!m_TransientImages.empty())
+		{
+			m_Device->Sync();
+			DestroyTransientImages();
+		}
+
+		const VkDevice vkDevice{ m_Device->GetVkDevice() };
+		m_TransientImages = transientImages;
+
+		// Create the images first, their memory requirements decide which of them can share memory
+		std::vector<VkMemoryRequirements> memoryRequirements(m_TransientImages.size());
+		for (size_t transientIndex = 0u; transientIndex < m_TransientImages.size(); ++transientIndex)
+		{
+			TransientImage&					 transientImage{ m_TransientImages.at(transientIndex) };
+			const TransientImageDescription& description{ transientImage.description };
+
+			VkImageCreateInfo imageCreateInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.extent = { description.extent.width, description.extent.height, 1u };
+			imageCreateInfo.mipLevels = 1u;
+			imageCreateInfo.arrayLayers = description.layerCount;
+			imageCreateInfo.format = description.format;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageCreateInfo.usage = transientImage.usage;
+			imageCreateInfo.samples = description.samples;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			if (IsLazilyAllocatable(transientImage.usage, transientImage.firstPass, transientImage.lastPass))
+			{
+				imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			}
+			if (vkCreateImage(vkDevice, &imageCreateInfo, nullptr, &transientImage.image) != VK_SUCCESS)
+			{
+				utils::ThrowError(EError::GenericVulkan);
+			}
+
+			vkGetImageMemoryRequirements(vkDevice, transientImage.image, &memoryRequirements.at(transientIndex));
+		}
+
+		// Larger images claim memory first so smaller ones can fit into it later
+		std::vector<size_t> allocationOrder(m_TransientImages.size());
+		std::iota(allocationOrder.begin(), allocationOrder.end(), size_t{ 0u });
+		std::stable_sort(allocationOrder.begin(), allocationOrder.end(), [&memoryRequirements](size_t a, size_t b) { return memoryRequirements.at(a).size > memoryRequirements.at(b).size; });
+
+		std::vector<uint32_t> memoryTypeIndices;
+		std::vector<bool>	  isPlaced(m_TransientImages.size(), false);
+		m_TransientRequiredSize = 0u;
+		m_TransientAllocatedSize = 0u;
+		m_TransientLazySize = 0u;
+		for (const size_t transientIndex : allocationOrder)
+		{
+			isPlaced.at(transientIndex) = true;
+			TransientImage&				transientImage{ m_TransientImages.at(transientIndex) };
+			const VkMemoryRequirements& requirements{ memoryRequirements.at(transientIndex) };
+			m_TransientRequiredSize += requirements.size;
+
+			uint32_t lazyMemoryTypeIndex{ 0u };
+			if (IsLazilyAllocatable(transientImage.usage, transientImage.firstPass, transientImage.lastPass) && utils::FindSuitableMemoryTypeIndex(m_Device->GetVkPhysicalDevice(), requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, lazyMemoryTypeIndex))
+			{
+				transientImage.memoryIndex = m_TransientMemory.size();
+
+				TransientMemory& transientMemory{ m_TransientMemory.emplace_back() };
+				transientMemory.size = requirements.size;
+				transientMemory.memoryTypeBits = requirements.memoryTypeBits;
+				transientMemory.isLazilyAllocated = true;
+				memoryTypeIndices.push_back(lazyMemoryTypeIndex);
+				continue;
+			}
+
+			// Memory is shared with every image placed in it so far, as long as none of them is alive at the same time
+			size_t memoryIndex{ 0u };
+			for (; memoryIndex < m_TransientMemory.size(); ++memoryIndex)
+			{
+				const TransientMemory& transientMemory{ m_TransientMemory.at(memoryIndex) };
+				if (transientMemory.isLazilyAllocated || (transientMemory.memoryTypeBits & requirements.memoryTypeBits) == 0u)
+				{
+					continue;
+				}
+
+				bool isMemoryFree{ true };
+				for (size_t otherIndex = 0u; otherIndex < m_TransientImages.size(); ++otherIndex)
+				{
+					const TransientImage& otherImage{ m_TransientImages.at(otherIndex) };
+					if (otherIndex != transientIndex && isPlaced.at(otherIndex) && otherImage.memoryIndex == memoryIndex && AreLifetimesOverlapping(transientImage.firstPass, transientImage.lastPass, otherImage.firstPass, otherImage.lastPass))
+					{
+						isMemoryFree = false;
+						break;
+					}
+				}
+
+				if (isMemoryFree)
+				{
+					break;
+				}
+			}
+
+			if (memoryIndex == m_TransientMemory.size())
+			{
+				m_TransientMemory.emplace_back();
+				memoryTypeIndices.push_back(0u);
+			}
+
+			TransientMemory& transientMemory{ m_TransientMemory.at(memoryIndex) };
+			transientMemory.size = std::max(transientMemory.size, requirements.size);
+			transientMemory.memoryTypeBits = transientMemory.memoryTypeBits ? (transientMemory.memoryTypeBits & requirements.memoryTypeBits) : requirements.memoryTypeBits;
+			transientImage.memoryIndex = memoryIndex;
+		}
+
+		// Every image is bound at the start of its memory, alignment is only a concern for the size
+		for (size_t memoryIndex = 0u; memoryIndex < m_TransientMemory.size(); ++memoryIndex)
+		{
+			TransientMemory& transientMemory{ m_TransientMemory.at(memoryIndex) };
+
+			uint32_t memoryTypeIndex{ memoryTypeIndices.at(memoryIndex) };
+			if (!transientMemory.isLazilyAllocated)
+			{
+				VkMemoryRequirements requirements{};
+				requirements.size = transientMemory.size;
+				requirements.memoryTypeBits = transientMemory.memoryTypeBits;
+				if (!utils::FindSuitableMemoryTypeIndex(m_Device->GetVkPhysicalDevice(), requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryTypeIndex))
+				{
+					utils::ThrowError(EError::FeatureNotSupported, "Suitable transient image memory type");
+				}
+			}
+
+			VkMemoryAllocateInfo memoryAllocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+			memoryAllocateInfo.allocationSize = transientMemory.size;
+			memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+			if (vkAllocateMemory(vkDevice, &memoryAllocateInfo, nullptr, &transientMemory.memory) != VK_SUCCESS)
+			{
+				std::stringstream s;
+				s << transientMemory.size << " bytes for transient images";
+				utils::ThrowError(EError::OutOfMemory, s.str());
+			}
+
+			if (transientMemory.isLazilyAllocated)
+			{
+				m_TransientLazySize += transientMemory.size;
+			}
+			else
+			{
+				m_TransientAllocatedSize += transientMemory.size;
+			}
+		}
+
+		for (TransientImage& transientImage : m_TransientImages)
+		{
+			if (vkBindImageMemory(vkDevice, transientImage.image, m_TransientMemory.at(transientImage.memoryIndex).memory, 0u) != VK_SUCCESS)
+			{
+				utils::ThrowError(EError::GenericVulkan);
+			}
+
+			const TransientImageDescription& description{ transientImage.description };
+			utils::CreateImageView(transientImage.image, description.format, description.layerCount, description.aspect, vkDevice, transientImage.imageView);
+		}
+
+		++m_TransientGeneration;
+	}
+
+	for (Resource& resource : m_Resources)
+	{
+		if (resource.isTransient && resource.transientIndex != SIZE_MAX)
+		{
+			resource.image = m_TransientImages.at(resource.transientIndex).image;
+		}
+	}
+}
+
+bool RenderGraph::CanReuseTransientImages(const std::vector<TransientImage>& transientImages) const
+{
+	if (transientImages.size() != m_TransientImages.size())
+	{
+		return false;
+	}
+
+	for (size_t transientIndex = 0u; transientIndex < transientImages.size(); ++transientIndex)
+	{
+		const TransientImage&			 requested{ transientImages.at(transientIndex) };
+		const TransientImage&			 existing{ m_TransientImages.at(transientIndex) };
+		const TransientImageDescription& a{ requested.description };
+		const TransientImageDescription& b{ existing.description };
+		if (a.extent.width != b.extent.width || a.extent.height != b.extent.height || a.format != b.format || a.samples != b.samples || a.aspect != b.aspect || a.layerCount != b.layerCount || requested.usage != existing.usage)
+		{
+			return false;
+		}
+
+		// Passes may come and go between frames, that is fine as long as the images sharing memory still don't overlap
+		const TransientMemory& transientMemory{ m_TransientMemory.at(existing.memoryIndex) };
+		if (transientMemory.isLazilyAllocated && !IsLazilyAllocatable(requested.usage, requested.firstPass, requested.lastPass))
+		{
+			return false;
+		}
+
+		for (size_t otherIndex = transientIndex + 1u; otherIndex < transientImages.size(); ++otherIndex)
+		{
+			const TransientImage& other{ transientImages.at(otherIndex) };
+			if (m_TransientImages.at(otherIndex).memoryIndex == existing.memoryIndex && AreLifetimesOverlapping(requested.firstPass, requested.lastPass, other.firstPass, other.lastPass))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void RenderGraph::DestroyTransientImages()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice)
+	{
+		for (const TransientImage& transientImage : m_TransientImages)
+		{
+			if (transientImage.imageView)
+			{
+				vkDestroyImageView(vkDevice, transientImage.imageView, nullptr);
+			}
+
+			if (transientImage.image)
+			{
+				vkDestroyImage(vkDevice, transientImage.image, nullptr);
+			}
+		}
+
+		for (const TransientMemory& transientMemory : m_TransientMemory)
+		{
+			if (transientMemory.memory)
+			{
+				vkFreeMemory(vkDevice, transientMemory.memory, nullptr);
+			}
+		}
+	}
+
+	m_TransientImages.clear();
+	m_TransientMemory.clear();
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const Pass& pass)
+{
+	VkPipelineStageFlags			  srcStages{ 0u }, dstStages{ 0u };
+	std::vector<VkImageMemoryBarrier>  imageBarriers;
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+	for (const Pass::Access& access : pass.m_Accesses)
+	{
+		Resource&		resource{ m_Resources.at(access.resource) };
+		ResourceState&	state{ resource.state };
+		const UsageInfo usageInfo{ GetUsageInfo(access.usage, resource.aspect) };
+
+		// A transient image starts out undefined but has to wait for whatever used its memory before
+		if (resource.isTransient && !resource.isAccessed)
+		{
+			const ResourceState& memoryState{ m_TransientMemory.at(m_TransientImages.at(resource.transientIndex).memoryIndex).state };
+			state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			state.writeStages = memoryState.writeStages | memoryState.readStages;
+			state.writeAccess = memoryState.writeAccess;
+			state.readStages = 0u;
+		}
+		resource.isAccessed = true;
+
+		// Reads only wait once per stage for the last write, writes and layout transitions also wait for the reads since
+		const bool			 isImage{ resource.buffer == nullptr };
+		const bool			 isLayoutTransition{ isImage && state.layout != usageInfo.layout };
+		const bool			 isOrdered{ access.isWrite || isLayoutTransition };
+		VkPipelineStageFlags waitStages{ isOrdered ? (state.writeStages | state.readStages) : state.writeStages };
+		if (!isOrdered && (state.readStages & usageInfo.stages) == usageInfo.stages)
+		{
+			waitStages = 0u;
+		}
+
+		if (waitStages != 0u || isLayoutTransition)
+		{
+			// With nothing to wait for, the transition still waits on its own stages so a semaphore wait on them is chained
+			srcStages |= waitStages ? waitStages : usageInfo.stages;
+			dstStages |= usageInfo.stages;
+
+			if (isImage)
+			{
+				VkImageMemoryBarrier barrier{ MakeImageBarrier(resource.image, resource.aspect) };
+				barrier.oldLayout = state.layout;
+				barrier.newLayout = usageInfo.layout;
+				barrier.srcAccessMask = state.writeAccess;
+				barrier.dstAccessMask = usageInfo.access;
+				imageBarriers.push_back(barrier);
+			}
+			else
+			{
+				VkBufferMemoryBarrier barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+				barrier.srcAccessMask = state.writeAccess;
+				barrier.dstAccessMask = usageInfo.access;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.buffer = resource.buffer;
+				barrier.offset = 0u;
+				barrier.size = VK_WHOLE_SIZE;
+				bufferBarriers.push_back(barrier);
+			}
+		}
+
+		if (isOrdered)
+		{
+			// A layout transition counts as a write that later reads in other stages have to wait for
+			state.layout = isImage ? usageInfo.layout : state.layout;
+			state.writeStages = usageInfo.stages;
+			state.writeAccess = access.isWrite ? usageInfo.access : 0u;
+			state.readStages = access.isWrite ? 0u : usageInfo.stages;
+		}
+		else
+		{
+			state.readStages |= usageInfo.stages;
+		}
+
+		if (resource.isTransient)
+		{
+			m_TransientMemory.at(m_TransientImages.at(resource.transientIndex).memoryIndex).state = state;
+		}
+	}
+
+	if (imageBarriers.empty() && bufferBarriers.empty())
+	{
+		return;
+	}
+
+	// One batch per pass, however many resources it transitions
+	vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0u, 0u, nullptr, static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	m_BarrierCount += imageBarriers.size() + bufferBarriers.size();
+}
+
+void RenderGraph::RecordFinalBarriers(VkCommandBuffer commandBuffer)
+{
+	VkPipelineStageFlags			 srcStages{ 0u };
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+
+	for (Resource& resource : m_Resources)
+	{
+		ResourceState& state{ resource.state };
+		if (resource.isTransient || resource.buffer || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || state.layout == resource.finalLayout)
+		{
+			continue;
+		}
+
+		VkImageMemoryBarrier barrier{ MakeImageBarrier(resource.image, resource.aspect) };
+		barrier.oldLayout = state.layout;
+		barrier.newLayout = resource.finalLayout;
+		barrier.srcAccessMask = state.writeAccess;
+		barrier.dstAccessMask = 0u;
+		imageBarriers.push_back(barrier);
+		srcStages |= state.writeStages | state.readStages;
+
+		// Whoever uses the image next, the transition has to be done by then
+		state.layout = resource.finalLayout;
+		state.writeStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		state.writeAccess = 0u;
+		state.readStages = 0u;
+	}
+
+	if (imageBarriers.empty())
+	{
+		return;
+	}
+
+	// Queue submission and presentation wait for everything submitted before them, no later stage needs to wait here
+	vkCmdPipelineBarrier(commandBuffer, srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0u, 0u, nullptr, 0u, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	m_BarrierCount += imageBarriers.size();
+}
+
+VkImage RenderGraph::GetImage(ResourceHandle resource) const { return m_Resources.at(resource).image; }
+
+VkImageView RenderGraph::GetImageView(ResourceHandle resource) const
+{
+	const Resource& graphResource{ m_Resources.at(resource) };
+	if (!graphResource.isTransient || graphResource.transientIndex == SIZE_MAX)
+	{
+		return nullptr;
+	}
+
+	return m_TransientImages.at(graphResource.transientIndex).imageView;
+}
+
+void RenderGraph::LogStatistics() const
+{
+	std::cout << "Render graph: " << m_BarrierCount << " barrier(s) and " << m_CulledPassCount << " culled pass(es) in " << m_FrameCount << " frame(s), transient images need " << ToMegabytes(m_TransientRequiredSize) << " MB, allocated " << ToMegabytes(m_TransientAllocatedSize) << " MB plus " << ToMegabytes(m_TransientLazySize) << " MB lazily, reallocated " << m_TransientGeneration << " time(s)" << std::endl;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GpuProfiler;
+class VulkanDevice;
+
+/*
+ * The render graph records the passes of a frame from what they declare instead of hand-written barriers. Every pass
+ * states which resources it reads and writes and how, the graph culls passes whose results nobody uses and records the
+ * minimal barriers and layout transitions in front of each remaining pass. Imported resources belong to their owners
+ * and keep their state from one frame to the next, transient images are created by the graph itself. Transients whose
+ * lifetimes don't overlap share memory, and those that never leave the pass they are used in are lazily allocated where
+ * the device supports it, so on tiled GPUs they don't take up any memory at all. The graph is declared anew every frame,
+ * the transient images are only reallocated when their descriptions or lifetimes change. With a GPU profiler every pass
+ * is measured in a scope of its own name.
+ */
+class RenderGraph final
+{
+public:
+	using ResourceHandle = uint32_t;
+
+	// Decides the pipeline stages, access mask and image layout of the barriers around a pass
+	enum class EResourceUsage
+	{
+		ColorAttachment,
+		DepthAttachment,
+		FragmentShaderRead, // Sampled image or storage buffer
+		ComputeShaderWrite, // Storage buffer
+		TransferSource,
+		TransferDestination
+	};
+
+	struct TransientImageDescription
+	{
+		VkExtent2D			  extent{ 0u, 0u };
+		VkFormat			  format{ VK_FORMAT_UNDEFINED };
+		VkSampleCountFlagBits samples{ VK_SAMPLE_COUNT_1_BIT };
+		VkImageAspectFlags	  aspect{ VK_IMAGE_ASPECT_COLOR_BIT };
+		uint32_t			  layerCount{ 1u };
+	};
+
+	class Pass final
+	{
+	public:
+		Pass(const std::string& name) : m_Name(name) {}
+
+		Pass& Read(ResourceHandle resource, EResourceUsage usage);
+		Pass& Write(ResourceHandle resource, EResourceUsage usage);
+		// Records the work of the pass, barriers have already been recorded when it is called
+		Pass& SetExecute(std::function<void(VkCommandBuffer)> execute);
+		// Passes with effects outside of the graph are never culled
+		Pass& KeepAlive();
+		// Pipeline statistics are collected for the scope of the pass when the graph has a GPU profiler
+		Pass& CollectStatistics();
+
+	private:
+		friend class RenderGraph;
+
+		struct Access
+		{
+			ResourceHandle resource{ 0u };
+			EResourceUsage usage{ EResourceUsage::FragmentShaderRead };
+			bool		   isWrite{ false };
+		};
+
+		std::string							  m_Name;
+		std::vector<Access>					  m_Accesses;
+		std::function<void(VkCommandBuffer)> m_Execute;
+		bool								  m_IsKeptAlive{ false };
+		bool								  m_CollectsStatistics{ false };
+	};
+
+	RenderGraph(const VulkanDevice* device, GpuProfiler* gpuProfiler = nullptr);
+	~RenderGraph();
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	// Drops the resources and passes declared for the previous frame
+	void Reset();
+
+	// Images that are overwritten every frame don't preserve their contents, the final layout is left as is when undefined
+	ResourceHandle ImportImage(const std::string& name, VkImage image, VkImageAspectFlags aspect, bool preserveContents, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+	ResourceHandle ImportBuffer(const std::string& name, VkBuffer buffer);
+	ResourceHandle CreateImage(const std::string& name, const TransientImageDescription& description);
+	// The returned pass is valid until the graph is reset
+	Pass& AddPass(const std::string& name);
+
+	// Owners call these before destroying an imported resource, a new one that reuses the handle starts out undefined
+	void ForgetImage(VkImage image) { m_ImageStates.erase(image); }
+	void ForgetBuffer(VkBuffer buffer) { m_BufferStates.erase(buffer); }
+
+	// Culls unused passes, allocates the transient images and records the passes with their barriers in declaration order
+	void Execute(VkCommandBuffer commandBuffer);
+
+	// Transient images are only valid while the graph executes
+	VkImage		GetImage(ResourceHandle resource) const;
+	VkImageView GetImageView(ResourceHandle resource) const;
+	// Increases whenever the transient images have been reallocated, views from before are invalid since then
+	uint64_t GetTransientGeneration() const { return m_TransientGeneration; }
+	void	 LogStatistics() const;
+
+private:
+	struct ResourceState
+	{
+		VkImageLayout		 layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkPipelineStageFlags writeStages{ 0u }; // Stages of the last write or layout transition
+		VkAccessFlags		 writeAccess{ 0u };
+		VkPipelineStageFlags readStages{ 0u }; // Stages that have already waited on the last write
+	};
+
+	struct Resource
+	{
+		std::string				  name;
+		VkImage					  image{ nullptr };
+		VkBuffer				  buffer{ nullptr };
+		VkImageAspectFlags		  aspect{ 0u };
+		bool					  isTransient{ false };
+		bool					  preserveContents{ true };
+		VkImageLayout			  finalLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		TransientImageDescription description;
+		size_t					  transientIndex{ SIZE_MAX }; // Unused transients are not allocated
+		ResourceState			  state;
+		bool					  isAccessed{ false };
+	};
+
+	struct TransientImage
+	{
+		TransientImageDescription description;
+		VkImageUsageFlags		  usage{ 0u };
+		uint32_t				  firstPass{ 0u }, lastPass{ 0u };
+		VkImage					  image{ nullptr };
+		VkImageView				  imageView{ nullptr };
+		size_t					  memoryIndex{ 0u };
+	};
+
+	// Memory shared by transient images with disjoint lifetimes, tracks the state of whichever image used it last
+	struct TransientMemory
+	{
+		VkDeviceMemory memory{ nullptr };
+		VkDeviceSize   size{ 0u };
+		uint32_t	   memoryTypeBits{ 0u };
+		bool		   isLazilyAllocated{ false };
+		ResourceState  state;
+	};
+
+	const VulkanDevice*	  m_Device{ nullptr };
+	GpuProfiler*		  m_GpuProfiler{ nullptr };
+	std::vector<Resource> m_Resources;
+	std::deque<Pass>	  m_Passes;
+
+	std::vector<TransientImage>	 m_TransientImages;
+	std::vector<TransientMemory> m_TransientMemory;
+	uint64_t					 m_TransientGeneration{ 0u };
+
+	// Imported resources continue from where the previous frame left them
+	std::unordered_map<VkImage, ResourceState>	m_ImageStates;
+	std::unordered_map<VkBuffer, ResourceState> m_BufferStates;
+
+	size_t		 m_FrameCount{ 0u };
+	size_t		 m_CulledPassCount{ 0u };
+	size_t		 m_BarrierCount{ 0u };
+	VkDeviceSize m_TransientRequiredSize{ 0u }, m_TransientAllocatedSize{ 0u }, m_TransientLazySize{ 0u };
+
+	std::vector<bool> CullPasses() const;
+	void			  AllocateTransientImages(const std::vector<bool>& isPassAlive);
+	bool			  CanReuseTransientImages(const std::vector<TransientImage>& transientImages) const;
+	void			  DestroyTransientImages();
+	void			  RecordBarriers(VkCommandBuffer commandBuffer, const Pass& pass);
+	void			  RecordFinalBarriers(VkCommandBuffer commandBuffer);
+};
@@ -5,9 +5,21 @@
 #include <array>
 #include <iostream>
 
-RenderTarget::RenderTarget(VkDevice device, VkImage image, VkImageView colorImageView, VkImageView depthImageView, VkExtent2D size, VkFormat format, VkRenderPass renderPass, uint32_t layerCount) : m_Device(device), m_Image(image)
+RenderTarget::RenderTarget(VkDevice device, VkImage image, VkExtent2D size, VkFormat format, uint32_t layerCount) : m_Device(device), m_Image(image), m_Size(size) { utils::CreateImageView(image, format, layerCount, VK_IMAGE_ASPECT_COLOR_BIT, device, m_ImageView); }
+
+VkFramebuffer RenderTarget::GetFramebuffer(VkRenderPass renderPass, VkImageView colorImageView, VkImageView depthImageView, uint64_t attachmentGeneration)
 {
-	utils::CreateImageView(image, format, layerCount, VK_IMAGE_ASPECT_COLOR_BIT, device, m_ImageView);
+	if (m_Framebuffer && m_FramebufferGeneration == attachmentGeneration)
+	{
+		return m_Framebuffer;
+	}
+
+	// The previous attachments have been destroyed by now, the render graph waits for the device before reallocating
+	if (m_Framebuffer)
+	{
+		vkDestroyFramebuffer(m_Device, m_Framebuffer, nullptr);
+		m_Framebuffer = nullptr;
+	}
 
 	const std::array attachments{ colorImageView, depthImageView, m_ImageView };
 
@@ -16,13 +28,16 @@ RenderTarget::RenderTarget(VkDevice device, VkImage image, VkImageView colorImag
 	framebufferCreateInfo.renderPass = renderPass;
 	framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
 	framebufferCreateInfo.pAttachments = attachments.data();
-	framebufferCreateInfo.width = size.width;
-	framebufferCreateInfo.height = size.height;
+	framebufferCreateInfo.width = m_Size.width;
+	framebufferCreateInfo.height = m_Size.height;
 	framebufferCreateInfo.layers = 1u;
-	if (vkCreateFramebuffer(device, &framebufferCreateInfo, nullptr, &m_Framebuffer) != VK_SUCCESS)
+	if (vkCreateFramebuffer(m_Device, &framebufferCreateInfo, nullptr, &m_Framebuffer) != VK_SUCCESS)
 	{
 		utils::ThrowError(EError::GenericVulkan);
 	}
+
+	m_FramebufferGeneration = attachmentGeneration;
+	return m_Framebuffer;
 }
 
 RenderTarget::~RenderTarget()
@@ -2,22 +2,29 @@
 
 #include <vulkan/vulkan.h>
 
+#include <cstdint>
+
 /*
  * The render target class represents a convenient combination of an image and a framebuffer in Vulkan. The class is
- * used for the Vulkan swapchain images retrieved by OpenXR for the headset displays.
+ * used for the Vulkan swapchain images retrieved by OpenXR for the headset displays. The multisampled color and depth
+ * attachments are transient images of the render graph, so the framebuffer is only created once they are known and is
+ * recreated whenever the graph reallocates them. With dynamic rendering the image view is used directly instead.
  */
 class RenderTarget final
 {
 public:
-	RenderTarget(VkDevice device, VkImage image, VkImageView colorImageView, VkImageView depthImageView, VkExtent2D size, VkFormat format, VkRenderPass m_RenderPass, uint32_t layerCount);
+	RenderTarget(VkDevice device, VkImage image, VkExtent2D size, VkFormat format, uint32_t layerCount);
 	~RenderTarget();
 
 	VkImage		  GetImage() const { return m_Image; }
-	VkFramebuffer GetFramebuffer() const { return m_Framebuffer; }
+	VkImageView	  GetImageView() const { return m_ImageView; }
+	VkFramebuffer GetFramebuffer(VkRenderPass renderPass, VkImageView colorImageView, VkImageView depthImageView, uint64_t attachmentGeneration);
 
 private:
 	VkDevice	  m_Device{ nullptr };
 	VkImage		  m_Image{ nullptr };
 	VkImageView	  m_ImageView{ nullptr };
+	VkExtent2D	  m_Size{ 0u, 0u };
 	VkFramebuffer m_Framebuffer{ nullptr };
-};
\ No newline at end of file
+	uint64_t	  m_FramebufferGeneration{ 0u };
+};
@@ -0,0 +1,130 @@
+#include "ShaderModuleCache.h"
+
+#include "VulkanDevice.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// 64-bit FNV-1a, plenty to tell shader binaries apart
+	uint64_t HashContent(const std::vector<char>& content)
+	{
+		uint64_t hash{ 0xcbf29ce484222325u };
+		for (const char byte : content)
+		{
+			hash ^= static_cast<uint8_t>(byte);
+			hash *= 0x100000001b3u;
+		}
+		return hash;
+	}
+} // namespace
+
+ShaderModuleCache::ShaderModuleCache(const VulkanDevice* device) : m_Device(device) {}
+
+ShaderModuleCache::~ShaderModuleCache()
+{
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	for (const auto& [contentHash, moduleEntry] : m_Modules)
+	{
+		vkDestroyShaderModule(vkDevice, moduleEntry.module, nullptr);
+	}
+}
+
+void ShaderModuleCache::Retain(const std::string& filename)
+{
+	std::lock_guard lock{ m_Mutex };
+	++m_Files[filename].useCount;
+}
+
+VkShaderModule ShaderModuleCache::Get(const std::string& filename)
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		const FileEntry& fileEntry{ m_Files[filename] };
+		if (fileEntry.isLoaded)
+		{
+			++m_ReusedCount;
+			return m_Modules.at(fileEntry.contentHash).module;
+		}
+	}
+
+	// Read outside the lock so workers building other pipelines don't wait on the disk
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+	{
+		return nullptr;
+	}
+
+	const size_t	  fileSize{ static_cast<size_t>(file.tellg()) };
+	std::vector<char> code(fileSize);
+	file.seekg(0);
+	file.read(code.data(), fileSize);
+	file.close();
+
+	const uint64_t contentHash{ HashContent(code) };
+
+	std::lock_guard lock{ m_Mutex };
+	FileEntry&		fileEntry{ m_Files[filename] };
+
+	// Another worker may have loaded the same file in the meantime
+	if (fileEntry.isLoaded)
+	{
+		++m_ReusedCount;
+		return m_Modules.at(fileEntry.contentHash).module;
+	}
+
+	ModuleEntry& moduleEntry{ m_Modules[contentHash] };
+	if (moduleEntry.module)
+	{
+		++m_ReusedCount;
+	}
+	else
+	{
+		VkShaderModuleCreateInfo shaderModuleCreateInfo{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+		shaderModuleCreateInfo.codeSize = code.size();
+		shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		if (vkCreateShaderModule(m_Device->GetVkDevice(), &shaderModuleCreateInfo, nullptr, &moduleEntry.module) != VK_SUCCESS)
+		{
+			m_Modules.erase(contentHash);
+			return nullptr;
+		}
+		++m_CreatedCount;
+	}
+
+	++moduleEntry.fileCount;
+	fileEntry.contentHash = contentHash;
+	fileEntry.isLoaded = true;
+	return moduleEntry.module;
+}
+
+void ShaderModuleCache::Release(const std::string& filename)
+{
+	std::lock_guard lock{ m_Mutex };
+
+	const auto fileIt{ m_Files.find(filename) };
+	if (fileIt == m_Files.end() || --fileIt->second.useCount > 0u)
+	{
+		return;
+	}
+
+	// No pipeline waiting to be built needs this file anymore
+	if (fileIt->second.isLoaded)
+	{
+		const auto moduleIt{ m_Modules.find(fileIt->second.contentHash) };
+		if (--moduleIt->second.fileCount == 0u)
+		{
+			vkDestroyShaderModule(m_Device->GetVkDevice(), moduleIt->second.module, nullptr);
+			m_Modules.erase(moduleIt);
+			++m_EvictedCount;
+		}
+	}
+	m_Files.erase(fileIt);
+}
+
+void ShaderModuleCache::LogStatistics() const
+{
+	std::lock_guard lock{ m_Mutex };
+	std::cout << "Shader modules: " << m_CreatedCount << " created, " << m_ReusedCount << " reused, " << m_EvictedCount << " evicted" << std::endl;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class VulkanDevice;
+
+/*
+ * The shader module cache loads every SPIR-V file once and shares the resulting shader module between all pipelines
+ * that use it. Modules are keyed by their content hash, so two paths holding identical code share one module as well.
+ * Pipelines retain the shaders they need when they are described and release them once they are compiled, a module is
+ * evicted as soon as no pipeline waiting to be built needs it anymore.
+ */
+class ShaderModuleCache final
+{
+public:
+	ShaderModuleCache(const VulkanDevice* device);
+	~ShaderModuleCache();
+
+	// Marks a shader as needed by a pipeline that has not been built yet, does not touch the disk
+	void Retain(const std::string& filename);
+	// Returns the module for a retained shader, loading it on first use. Returns a null handle when the file can't be loaded
+	VkShaderModule Get(const std::string& filename);
+	void		   Release(const std::string& filename);
+
+	void LogStatistics() const;
+
+private:
+	struct FileEntry
+	{
+		uint32_t useCount{ 0u };
+		uint64_t contentHash{ 0u };
+		bool	 isLoaded{ false };
+	};
+
+	struct ModuleEntry
+	{
+		VkShaderModule module{ nullptr };
+		uint32_t	   fileCount{ 0u };
+	};
+
+	const VulkanDevice* m_Device{ nullptr };
+
+	mutable std::mutex							 m_Mutex;
+	std::unordered_map<std::string, FileEntry>	 m_Files;
+	std::unordered_map<uint64_t, ModuleEntry>	 m_Modules;
+	uint32_t									 m_CreatedCount{ 0u }, m_ReusedCount{ 0u }, m_EvictedCount{ 0u };
+};
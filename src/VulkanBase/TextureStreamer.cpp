@@ -0,0 +1,566 @@
+#include "TextureStreamer.h"
+
+#include "../Buffers/DataBuffer.h"
+#include "../Buffers/ImageBuffer.h"
+#include "../Misc/BlockCompression.h"
+#include "../Misc/CpuProfiler.h"
+#include "../Misc/Utils.h"
+#include "DescriptorAllocator.h"
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "VulkanDevice.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	constexpr uint32_t unsampledFeedback = UINT32_MAX; // Feedback slots are reset to it before every frame
+
+	float ToMegabytes(VkDeviceSize size) { return static_cast<float>(size) / (1024.0f * 1024.0f); }
+} // namespace
+
+TextureStreamer::TextureStreamer(const VulkanDevice* device, UploadManager* uploadManager, DescriptorAllocator* descriptorAllocator, size_t framesInFlightCount) : m_Device(device), m_UploadManager(uploadManager), m_DescriptorAllocator(descriptorAllocator), m_FramesInFlightCount(framesInFlightCount)
+{
+	const VkDevice vkDevice{ device->GetVkDevice() };
+
+	// Create a descriptor set layout for the texture and its feedback slot
+	std::array<VkDescriptorSetLayoutBinding, 2u> descriptorSetLayoutBindings;
+
+	descriptorSetLayoutBindings.at(0u).binding = 0u;
+	descriptorSetLayoutBindings.at(0u).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorSetLayoutBindings.at(0u).descriptorCount = 1u;
+	descriptorSetLayoutBindings.at(0u).stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	descriptorSetLayoutBindings.at(0u).pImmutableSamplers = nullptr;
+
+	descriptorSetLayoutBindings.at(1u).binding = 1u;
+	descriptorSetLayoutBindings.at(1u).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorSetLayoutBindings.at(1u).descriptorCount = 1u;
+	descriptorSetLayoutBindings.at(1u).stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	descriptorSetLayoutBindings.at(1u).pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings.size());
+	descriptorSetLayoutCreateInfo.pBindings = descriptorSetLayoutBindings.data();
+	if (vkCreateDescriptorSetLayout(vkDevice, &descriptorSetLayoutCreateInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+	m_DescriptorAllocator->RegisterLayout(m_DescriptorSetLayout, descriptorSetLayoutCreateInfo);
+
+	// Atlases are never streamed, their layout only holds the texture
+	descriptorSetLayoutCreateInfo.bindingCount = 1u;
+	if (vkCreateDescriptorSetLayout(vkDevice, &descriptorSetLayoutCreateInfo, nullptr, &m_AtlasDescriptorSetLayout) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+	m_DescriptorAllocator->RegisterLayout(m_AtlasDescriptorSetLayout, descriptorSetLayoutCreateInfo);
+
+	// One sampler for all textures, the resident levels of an image view always start at its level zero
+	const VkPhysicalDeviceLimits& limits{ device->GetPhysicalDeviceProperties().limits };
+	VkSamplerCreateInfo			  samplerCreateInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.anisotropyEnable = device->SupportsSamplerAnisotropy() ? VK_TRUE : VK_FALSE;
+	samplerCreateInfo.maxAnisotropy = std::min(limits.maxSamplerAnisotropy, 16.0f);
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+	if (vkCreateSampler(vkDevice, &samplerCreateInfo, nullptr, &m_Sampler) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	// Each texture's descriptor sets point at a slot of their own, the host reads them back and resets them
+	m_FeedbackSlotSize = utils::Align(sizeof(uint32_t), limits.minStorageBufferOffsetAlignment);
+	const VkDeviceSize feedbackBufferSize{ m_FeedbackSlotSize * Spectre::maxStreamedTextureCount };
+	m_FeedbackBuffers.resize(framesInFlightCount);
+	for (DataBuffer*& feedbackBuffer : m_FeedbackBuffers)
+	{
+		feedbackBuffer = new DataBuffer(device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, feedbackBufferSize);
+		memset(feedbackBuffer->MapData(), 0xFF, feedbackBufferSize);
+	}
+
+	// Goes out with the first upload batch, before any frame samples it
+	m_FallbackImage = new ImageBuffer(device, { 1u, 1u }, Spectre::textureFormat, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT, 1u);
+	VkBufferImageCopy fallbackRegion{};
+	fallbackRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u };
+	fallbackRegion.imageExtent = { 1u, 1u, 1u };
+	UploadManager::Token fallbackToken;
+	memset(uploadManager->StageImage(m_FallbackImage->GetImage(), sizeof(uint32_t), { fallbackRegion }, { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u }, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, fallbackToken), 0xFF, sizeof(uint32_t));
+
+	// Only remembered here, the next update evicts
+	m_PressureCallbackId = device->GetMemoryAllocator()->AddPressureCallback(
+	  [this](uint32_t heapIndex, VkDeviceSize excessSize)
+	  {
+		  if (heapIndex == m_TextureHeapIndex)
+		  {
+			  m_PressureSize = std::max(m_PressureSize, excessSize);
+		  }
+	  });
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	m_Device->GetMemoryAllocator()->RemovePressureCallback(m_PressureCallbackId);
+
+	// Load jobs write into their texture
+	for (StreamedTexture* streamedTexture : m_Textures)
+	{
+		if (streamedTexture->loadJob.valid())
+		{
+			streamedTexture->loadJob.wait();
+		}
+
+		delete streamedTexture->texture;
+		delete streamedTexture;
+	}
+
+	for (PackedTexture* packedTexture : m_PackedTextures)
+	{
+		if (packedTexture->loadJob.valid())
+		{
+			packedTexture->loadJob.wait();
+		}
+
+		delete packedTexture->texture;
+		delete packedTexture;
+	}
+
+	for (const TextureAtlas* atlas : m_Atlases)
+	{
+		delete atlas;
+	}
+
+	delete m_FallbackImage;
+	for (const DataBuffer* feedbackBuffer : m_FeedbackBuffers)
+	{
+		delete feedbackBuffer;
+	}
+
+	// Destroying the pool frees its descriptor sets
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice)
+	{
+		if (m_Sampler)
+		{
+			vkDestroySampler(vkDevice, m_Sampler, nullptr);
+		}
+
+		if (m_DescriptorSetLayout)
+		{
+			vkDestroyDescriptorSetLayout(vkDevice, m_DescriptorSetLayout, nullptr);
+		}
+
+		if (m_AtlasDescriptorSetLayout)
+		{
+			vkDestroyDescriptorSetLayout(vkDevice, m_AtlasDescriptorSetLayout, nullptr);
+		}
+	}
+}
+
+TextureBuffer* TextureStreamer::Acquire(const std::string& filename)
+{
+	const auto it{ m_TexturesByFilename.find(filename) };
+	if (it != m_TexturesByFilename.end())
+	{
+		return it->second->texture;
+	}
+
+	if (m_Textures.size() >= Spectre::maxStreamedTextureCount)
+	{
+		utils::ThrowError(EError::OutOfMemory, "Texture streamer is out of texture slots");
+	}
+
+	StreamedTexture* streamedTexture{ new StreamedTexture };
+	streamedTexture->texture = new TextureBuffer(m_Device, filename);
+	streamedTexture->feedbackSlot = static_cast<uint32_t>(m_Textures.size());
+	streamedTexture->requestedMip = streamedTexture->targetMip = streamedTexture->texture->GetMipTail();
+	streamedTexture->lastRequestedFrame = streamedTexture->lastSampledFrame = m_FrameNumber;
+
+	// The sets come from the per-frame pools, every update allocates the set of its frame anew
+	streamedTexture->descriptorSets.resize(m_FramesInFlightCount, nullptr);
+	streamedTexture->descriptorGenerations.resize(m_FramesInFlightCount, streamedTexture->texture->GetGeneration());
+	streamedTexture->descriptorResidentMips.resize(m_FramesInFlightCount, streamedTexture->texture->GetMipCount());
+	if (m_FrameNumber > 0u)
+	{
+		// Acquired after this frame's update, it may already be drawn this frame
+		UpdateDescriptorSet(streamedTexture, m_FrameIndex);
+	}
+
+	// The mip tail is all a texture needs to be drawn, it is wanted right away
+	ScheduleLoad(streamedTexture, streamedTexture->texture->GetMipTail(), streamedTexture->texture->GetMipCount(), EJobPriority::High);
+
+	m_Textures.push_back(streamedTexture);
+	m_TexturesByFilename.emplace(filename, streamedTexture);
+	return streamedTexture->texture;
+}
+
+const TextureAtlas::Region* TextureStreamer::AcquirePacked(const std::string& filename)
+{
+	const auto it{ m_PackedTexturesByFilename.find(filename) };
+	if (it != m_PackedTexturesByFilename.end())
+	{
+		return &it->second->region;
+	}
+
+	// Only the header of the file is read to find out whether the texture fits
+	TextureBuffer*	 texture{ new TextureBuffer(m_Device, filename) };
+	const VkExtent2D extent{ texture->GetMipExtent(0u) };
+	if (std::max(extent.width, extent.height) > Spectre::textureAtlasMaxTextureSize)
+	{
+		delete texture;
+		return nullptr;
+	}
+
+	TextureAtlas*	   atlas{ GetAtlas(texture->GetFormat()) };
+	TextureAtlas::Cell cell;
+	if (!atlas->Allocate(extent, cell))
+	{
+		delete texture;
+		return nullptr;
+	}
+
+	PackedTexture* packedTexture{ new PackedTexture };
+	packedTexture->texture = texture;
+	packedTexture->cell = cell;
+	packedTexture->region = atlas->GetPlaceholderRegion();
+
+	// The whole texture is wanted right away, like a mip tail
+	++m_LoadJobCount;
+	packedTexture->loadJob = JobSystem::GetInstance().Schedule(
+	  [packedTexture, atlas]
+	  {
+		  // Atlases are built from RGBA8 texels, compressed levels are decoded first
+		  const TextureBuffer* sourceTexture{ packedTexture->texture };
+		  std::vector<uint8_t> texels{ std::move(sourceTexture->LoadMips(0u, 1u).levels.front()) };
+		  if (BlockCompression::IsCompressed(sourceTexture->GetFormat()))
+		  {
+			  texels = BlockCompression::Decode(sourceTexture->GetFormat(), texels, sourceTexture->GetMipExtent(0u));
+		  }
+		  packedTexture->loadedLevels = atlas->BuildLevels(packedTexture->cell, texels);
+	  },
+	  EJobPriority::High);
+
+	m_PackedTextures.push_back(packedTexture);
+	m_PackedTexturesByFilename.emplace(filename, packedTexture);
+	return &packedTexture->region;
+}
+
+void TextureStreamer::Update(size_t frameIndex)
+{
+	SPECTRE_PROFILE_ZONE("TextureStreamer::Update");
+
+	++m_FrameNumber;
+	m_FrameIndex = frameIndex;
+
+	// Memory pressure takes budget away at once, it is only given back gradually
+	if (m_PressureSize > 0u)
+	{
+		const VkDeviceSize residentSize{ GetResidentSize() };
+		m_Budget = std::min(m_Budget, residentSize > m_PressureSize ? residentSize - m_PressureSize : 0u);
+		m_PressureSize = 0u;
+		++m_PressureCount;
+	}
+	else
+	{
+		m_Budget = std::min(m_Budget + Spectre::textureBudgetRecoveryRate, Spectre::textureStreamingBudget);
+	}
+
+	for (StreamedTexture* streamedTexture : m_Textures)
+	{
+		ReadFeedback(streamedTexture, frameIndex);
+	}
+
+	FitBudget();
+
+	for (StreamedTexture* streamedTexture : m_Textures)
+	{
+		StreamTexture(streamedTexture);
+		UpdateDescriptorSet(streamedTexture, frameIndex);
+	}
+
+	for (PackedTexture* packedTexture : m_PackedTextures)
+	{
+		UploadPackedTexture(packedTexture);
+	}
+
+	m_PeakResidentSize = std::max(m_PeakResidentSize, GetResidentSize());
+
+	// Every slot starts out unsampled for the next frame with this index
+	memset(m_FeedbackBuffers.at(frameIndex)->MapData(), 0xFF, m_FeedbackSlotSize * Spectre::maxStreamedTextureCount);
+}
+
+void TextureStreamer::RecordFeedbackBarrier(VkCommandBuffer commandBuffer) const
+{
+	VkMemoryBarrier memoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0u, 1u, &memoryBarrier, 0u, nullptr, 0u, nullptr);
+}
+
+VkDescriptorSet TextureStreamer::GetDescriptorSet(const TextureBuffer* texture, size_t frameIndex) const { return m_TexturesByFilename.at(texture->GetFilename())->descriptorSets.at(frameIndex); }
+
+void TextureStreamer::LogStatistics() const
+{
+	std::cout << "Texture streamer: " << m_Textures.size() << " texture(s), " << ToMegabytes(GetResidentSize()) << " MB resident of a " << ToMegabytes(m_Budget) << " MB budget (peak " << ToMegabytes(m_PeakResidentSize) << " MB), " << m_LoadCount << " load(s) of "
+			  << ToMegabytes(m_LoadedSize) << " MB, " << m_EvictionCount << " eviction(s), memory pressure in " << m_PressureCount << " frame(s)" << std::endl;
+
+	std::cout << "Texture atlases: " << m_PackedTextures.size() << " texture(s) packed into " << m_Atlases.size() << " atlas(es) of " << ToMegabytes(GetAtlasSize()) << " MB" << std::endl;
+}
+
+void TextureStreamer::ReadFeedback(StreamedTexture* streamedTexture, size_t frameIndex)
+{
+	const TextureBuffer* texture{ streamedTexture->texture };
+	const uint32_t*		 feedbackData{ static_cast<const uint32_t*>(m_FeedbackBuffers.at(frameIndex)->MapData()) };
+	const uint32_t		 feedback{ feedbackData[m_FeedbackSlotSize / sizeof(uint32_t) * streamedTexture->feedbackSlot] };
+
+	// The level of detail of the fallback image says nothing about the texture
+	uint32_t	   requestedMip{ texture->GetMipTail() };
+	const uint32_t sampledResidentMip{ streamedTexture->descriptorResidentMips.at(frameIndex) };
+	if (feedback != unsampledFeedback && sampledResidentMip < texture->GetMipCount())
+	{
+		// The shaders see the most detailed level of the image view they sample as level zero
+		const int64_t mip{ static_cast<int64_t>(sampledResidentMip) + static_cast<int64_t>(feedback) - static_cast<int64_t>(Spectre::textureFeedbackLodBias) };
+		requestedMip = static_cast<uint32_t>(std::clamp<int64_t>(mip, 0, texture->GetMipTail()));
+		streamedTexture->lastSampledFrame = m_FrameNumber;
+	}
+
+	// More detail is requested right away, detail that is no longer sampled only after a delay
+	if (requestedMip <= streamedTexture->requestedMip)
+	{
+		streamedTexture->requestedMip = requestedMip;
+		streamedTexture->lastRequestedFrame = m_FrameNumber;
+	}
+	else if (m_FrameNumber - streamedTexture->lastRequestedFrame > Spectre::textureEvictionDelay)
+	{
+		streamedTexture->requestedMip = requestedMip;
+	}
+}
+
+void TextureStreamer::FitBudget()
+{
+	VkDeviceSize targetSize{ GetAtlasSize() };
+	for (StreamedTexture* streamedTexture : m_Textures)
+	{
+		streamedTexture->targetMip = streamedTexture->requestedMip;
+		targetSize += streamedTexture->texture->GetSize(streamedTexture->targetMip);
+	}
+
+	// The textures sampled least recently give up one level at a time, the mip tails and atlases always stay
+	while (targetSize > m_Budget)
+	{
+		StreamedTexture* leastRecentlySampled{ nullptr };
+		for (StreamedTexture* streamedTexture : m_Textures)
+		{
+			if (streamedTexture->targetMip < streamedTexture->texture->GetMipTail() &&
+				(!leastRecentlySampled || streamedTexture->lastSampledFrame < leastRecentlySampled->lastSampledFrame ||
+				 (streamedTexture->lastSampledFrame == leastRecentlySampled->lastSampledFrame && streamedTexture->targetMip < leastRecentlySampled->targetMip)))
+			{
+				leastRecentlySampled = streamedTexture;
+			}
+		}
+
+		if (!leastRecentlySampled)
+		{
+			break;
+		}
+
+		const TextureBuffer* texture{ leastRecentlySampled->texture };
+		targetSize -= texture->GetSize(leastRecentlySampled->targetMip) - texture->GetSize(leastRecentlySampled->targetMip + 1u);
+		++leastRecentlySampled->targetMip;
+	}
+}
+
+void TextureStreamer::StreamTexture(StreamedTexture* streamedTexture)
+{
+	TextureBuffer* texture{ streamedTexture->texture };
+	if (streamedTexture->hasFailed)
+	{
+		return;
+	}
+
+	// The resident levels don't change while a load is in flight
+	if (streamedTexture->loadJob.valid())
+	{
+		if (streamedTexture->loadJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return;
+		}
+
+		--m_LoadJobCount;
+		try
+		{
+			streamedTexture->loadJob.get();
+		}
+		catch (const std::exception& e)
+		{
+			// The texture keeps sampling whatever it has
+			std::cerr << "Failed to load texture \"" << texture->GetFilename() << "\": " << e.what() << std::endl;
+			streamedTexture->hasFailed = true;
+		}
+		streamedTexture->loadJob = {};
+		if (streamedTexture->hasFailed)
+		{
+			return;
+		}
+
+		// The target may have changed in the meantime, loaded levels that are no longer wanted are dropped unless the others are generated from them
+		const TextureBuffer::MipData& loadedMips{ streamedTexture->loadedMips };
+		const uint32_t				  previousResidentMip{ texture->GetResidentMip() };
+		const uint32_t				  residentMip{ loadedMips.isPartial ? loadedMips.firstMip : std::max(loadedMips.firstMip, std::min(streamedTexture->targetMip, previousResidentMip)) };
+		texture->SetResidentMip(residentMip, loadedMips, m_UploadManager);
+		streamedTexture->loadedMips = {};
+
+		++m_LoadCount;
+		m_LoadedSize += texture->GetSize(residentMip) - texture->GetSize(previousResidentMip);
+		if (m_TextureHeapIndex == UINT32_MAX)
+		{
+			m_TextureHeapIndex = m_Device->GetMemoryAllocator()->GetHeapIndex(texture->GetMemoryTypeIndex());
+		}
+		return;
+	}
+
+	const uint32_t residentMip{ texture->GetResidentMip() };
+	if (streamedTexture->targetMip > residentMip)
+	{
+		texture->SetResidentMip(streamedTexture->targetMip, {}, m_UploadManager);
+		++m_EvictionCount;
+	}
+	else if (streamedTexture->targetMip < residentMip && m_LoadJobCount < Spectre::maxTextureLoadJobCount)
+	{
+		ScheduleLoad(streamedTexture, streamedTexture->targetMip, residentMip, EJobPriority::Low);
+	}
+}
+
+void TextureStreamer::ScheduleLoad(StreamedTexture* streamedTexture, uint32_t firstMip, uint32_t endMip, EJobPriority priority)
+{
+	++m_LoadJobCount;
+	streamedTexture->loadJob = JobSystem::GetInstance().Schedule([streamedTexture, firstMip, endMip] { streamedTexture->loadedMips = streamedTexture->texture->LoadMips(firstMip, endMip); }, priority);
+}
+
+void TextureStreamer::UploadPackedTexture(PackedTexture* packedTexture)
+{
+	if (!packedTexture->loadJob.valid() || packedTexture->loadJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	--m_LoadJobCount;
+	bool hasFailed{ false };
+	try
+	{
+		packedTexture->loadJob.get();
+	}
+	catch (const std::exception& e)
+	{
+		// The texture keeps sampling the placeholder
+		std::cerr << "Failed to load texture \"" << packedTexture->texture->GetFilename() << "\": " << e.what() << std::endl;
+		hasFailed = true;
+	}
+	packedTexture->loadJob = {};
+
+	// The upload goes out ahead of the frame that first samples the cell
+	if (!hasFailed)
+	{
+		TextureAtlas* atlas{ packedTexture->region.atlas };
+		atlas->Upload(packedTexture->cell, packedTexture->loadedLevels, m_UploadManager);
+		packedTexture->region = atlas->GetRegion(packedTexture->cell);
+	}
+	packedTexture->loadedLevels = {};
+}
+
+TextureAtlas* TextureStreamer::GetAtlas(VkFormat format)
+{
+	for (TextureAtlas* atlas : m_Atlases)
+	{
+		if (atlas->GetFormat() == format)
+		{
+			return atlas;
+		}
+	}
+
+	TextureAtlas* atlas{ new TextureAtlas(m_Device, format, m_UploadManager) };
+
+	// The atlas never replaces its image, so its set is written once
+	std::vector<DescriptorAllocator::Binding> bindings(1u);
+	bindings.at(0u).binding = 0u;
+	bindings.at(0u).type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings.at(0u).imageInfo = { m_Sampler, atlas->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+	m_Atlases.push_back(atlas);
+	m_AtlasDescriptorSets.emplace(atlas, m_DescriptorAllocator->GetCached(m_AtlasDescriptorSetLayout, bindings));
+	return atlas;
+}
+
+void TextureStreamer::UpdateDescriptorSet(StreamedTexture* streamedTexture, size_t frameIndex) const
+{
+	// The previous set of the frame went back to its pool with the frame, the fallback image is sampled until the mip tail is resident
+	TextureBuffer*		  texture{ streamedTexture->texture };
+	const bool			  hasImage{ texture->GetImageView() != VK_NULL_HANDLE };
+	const VkDescriptorSet descriptorSet{ m_DescriptorAllocator->AllocateForFrame(m_DescriptorSetLayout, frameIndex) };
+
+	VkDescriptorImageInfo descriptorImageInfo;
+	descriptorImageInfo.sampler = m_Sampler;
+	descriptorImageInfo.imageView = hasImage ? texture->GetImageView() : m_FallbackImage->GetImageView();
+	descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorBufferInfo descriptorBufferInfo;
+	descriptorBufferInfo.buffer = m_FeedbackBuffers.at(frameIndex)->getBuffer();
+	descriptorBufferInfo.offset = m_FeedbackSlotSize * streamedTexture->feedbackSlot;
+	descriptorBufferInfo.range = sizeof(uint32_t);
+
+	std::array<VkWriteDescriptorSet, 2u> writeDescriptorSets;
+	writeDescriptorSets.at(0u) = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	writeDescriptorSets.at(0u).dstSet = descriptorSet;
+	writeDescriptorSets.at(0u).dstBinding = 0u;
+	writeDescriptorSets.at(0u).descriptorCount = 1u;
+	writeDescriptorSets.at(0u).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writeDescriptorSets.at(0u).pImageInfo = &descriptorImageInfo;
+
+	writeDescriptorSets.at(1u) = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	writeDescriptorSets.at(1u).dstSet = descriptorSet;
+	writeDescriptorSets.at(1u).dstBinding = 1u;
+	writeDescriptorSets.at(1u).descriptorCount = 1u;
+	writeDescriptorSets.at(1u).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeDescriptorSets.at(1u).pBufferInfo = &descriptorBufferInfo;
+
+	vkUpdateDescriptorSets(m_Device->GetVkDevice(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0u, nullptr);
+
+	streamedTexture->descriptorSets.at(frameIndex) = descriptorSet;
+	streamedTexture->descriptorGenerations.at(frameIndex) = texture->GetGeneration();
+	streamedTexture->descriptorResidentMips.at(frameIndex) = hasImage ? texture->GetResidentMip() : texture->GetMipCount();
+
+	// Replaced images can go once no set of any frame points at them anymore
+	const std::vector<uint64_t>& descriptorGenerations{ streamedTexture->descriptorGenerations };
+	if (std::all_of(descriptorGenerations.begin(), descriptorGenerations.end(), [texture](uint64_t generation) { return generation == texture->GetGeneration(); }))
+	{
+		texture->ReleaseRetiredImages(m_UploadManager);
+	}
+}
+
+VkDeviceSize TextureStreamer::GetAtlasSize() const
+{
+	VkDeviceSize atlasSize{ 0u };
+	for (const TextureAtlas* atlas : m_Atlases)
+	{
+		atlasSize += atlas->GetSize();
+	}
+	return atlasSize;
+}
+
+VkDeviceSize TextureStreamer::GetResidentSize() const
+{
+	VkDeviceSize residentSize{ GetAtlasSize() };
+	for (const StreamedTexture* streamedTexture : m_Textures)
+	{
+		residentSize += streamedTexture->texture->GetSize(streamedTexture->texture->GetResidentMip());
+	}
+	return residentSize;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../Buffers/TextureAtlas.h"
+#include "../Buffers/TextureBuffer.h"
+#include "../Misc/JobSystem.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class DataBuffer;
+class DescriptorAllocator;
+class ImageBuffer;
+class UploadManager;
+class VulkanDevice;
+
+namespace Spectre
+{
+	constexpr VkDeviceSize textureStreamingBudget = 256u * 1024u * 1024u; // Resident texture and atlas memory the streamer stays within
+	constexpr VkDeviceSize textureBudgetRecoveryRate = 1024u * 1024u;	  // Budget given back per frame once memory pressure has taken some away
+	constexpr uint32_t	   maxStreamedTextureCount = 256u;				  // Feedback slots are allocated up front for this many
+	constexpr size_t	   maxTextureLoadJobCount = 2u;					  // Leaves the other workers to pipeline compilation
+	constexpr size_t	   textureEvictionDelay = 120u;					  // Frames a texture keeps detail it no longer samples
+	constexpr uint32_t	   textureFeedbackLodBias = 16u;				  // Keeps the feedback positive where more detail is wanted, must match shaders/Textured.frag
+} // namespace Spectre
+
+/*
+ * The texture streamer keeps the resident mip levels of all textures within a memory budget. Every texture starts out
+ * with just its mip tail, anything more detailed is streamed in on demand: the textured shaders write the most detailed
+ * level they sample into a feedback buffer, which is read back once the frame has completed. Missing levels are decoded
+ * on worker threads and uploaded through the upload manager, levels that have not been sampled for a while are evicted
+ * again. When the wanted levels don't fit the budget, the textures sampled least recently give up detail first, and
+ * memory pressure on the heap the textures live in shrinks the budget for as long as it lasts. Small textures are not
+ * streamed at all, they are packed into the atlas of their format whole and stay there.
+ */
+class TextureStreamer final
+{
+public:
+	TextureStreamer(const VulkanDevice* device, UploadManager* uploadManager, DescriptorAllocator* descriptorAllocator, size_t framesInFlightCount);
+	~TextureStreamer();
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// Returns the texture of the image file, the first call starts loading its mip tail in the background
+	TextureBuffer*				Acquire(const std::string& filename);
+	// Packs a small texture into the atlas of its format, returns nullptr if it is too large or the atlas is full
+	const TextureAtlas::Region* AcquirePacked(const std::string& filename);
+
+	// Reads back the feedback of the frame, streams levels in and out and allocates the frame's descriptor sets for the current images, after the frame's descriptor pools were reset
+	void Update(size_t frameIndex);
+	// Makes the feedback written by the frame visible to the readback
+	void RecordFeedbackBarrier(VkCommandBuffer commandBuffer) const;
+
+	// Set 1 of the textured shaders
+	VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+	VkDescriptorSet		  GetDescriptorSet(const TextureBuffer* texture, size_t frameIndex) const;
+	// Set 1 of the atlas shaders, they write no feedback
+	VkDescriptorSetLayout GetAtlasDescriptorSetLayout() const { return m_AtlasDescriptorSetLayout; }
+	// Serves every frame, the atlas never replaces its image
+	VkDescriptorSet		  GetDescriptorSet(const TextureAtlas* atlas) const { return m_AtlasDescriptorSets.at(atlas); }
+
+	void LogStatistics() const;
+
+private:
+	struct StreamedTexture
+	{
+		TextureBuffer*				 texture{ nullptr };
+		uint32_t					 feedbackSlot{ 0u };
+		std::vector<VkDescriptorSet> descriptorSets;		 // Per frame in flight, allocated anew every frame
+		std::vector<uint64_t>		 descriptorGenerations;	 // Per frame in flight, generation of the image view the set points to
+		std::vector<uint32_t>		 descriptorResidentMips; // Per frame in flight, resident mip of that image view
+		uint32_t					 requestedMip{ 0u };	 // Most detailed level the feedback asks for
+		uint32_t					 targetMip{ 0u };		 // Requested level after fitting all textures into the budget
+		size_t						 lastRequestedFrame{ 0u };
+		size_t						 lastSampledFrame{ 0u };
+		std::shared_future<void>	 loadJob;
+		TextureBuffer::MipData		 loadedMips; // Written by the load job
+		bool						 hasFailed{ false };
+	};
+
+	struct PackedTexture
+	{
+		TextureBuffer*					  texture{ nullptr }; // Only reads the texels, never gets an image of its own
+		TextureAtlas::Cell				  cell;
+		TextureAtlas::Region			  region; // Points at the placeholder until the cell has been uploaded
+		std::shared_future<void>		  loadJob;
+		std::vector<std::vector<uint8_t>> loadedLevels; // Written by the load job
+	};
+
+	const VulkanDevice*		 m_Device{ nullptr };
+	UploadManager*			 m_UploadManager{ nullptr };
+	size_t					 m_FramesInFlightCount{ 0u };
+	size_t					 m_FrameNumber{ 0u };
+	size_t					 m_FrameIndex{ 0u }; // Of the last update
+	DescriptorAllocator*	 m_DescriptorAllocator{ nullptr };
+	VkDescriptorSetLayout	 m_DescriptorSetLayout{ nullptr };
+	VkDescriptorSetLayout	 m_AtlasDescriptorSetLayout{ nullptr };
+	VkSampler				 m_Sampler{ nullptr };
+	ImageBuffer*			 m_FallbackImage{ nullptr }; // White, sampled until a texture has its mip tail
+	std::vector<DataBuffer*> m_FeedbackBuffers;			 // Per frame in flight, one slot per texture
+	VkDeviceSize			 m_FeedbackSlotSize{ 0u };
+
+	std::vector<StreamedTexture*>					  m_Textures;
+	std::unordered_map<std::string, StreamedTexture*> m_TexturesByFilename;
+	size_t											  m_LoadJobCount{ 0u };
+
+	std::vector<TextureAtlas*>								 m_Atlases;
+	std::unordered_map<const TextureAtlas*, VkDescriptorSet> m_AtlasDescriptorSets;
+	std::vector<PackedTexture*>								 m_PackedTextures;
+	std::unordered_map<std::string, PackedTexture*>			 m_PackedTexturesByFilename;
+
+	VkDeviceSize m_Budget{ Spectre::textureStreamingBudget };
+	VkDeviceSize m_PressureSize{ 0u }; // Reported by the last pressure callback since the previous update
+	uint32_t	 m_PressureCallbackId{ 0u };
+	uint32_t	 m_TextureHeapIndex{ UINT32_MAX };
+
+	size_t		 m_LoadCount{ 0u }, m_EvictionCount{ 0u }, m_PressureCount{ 0u };
+	VkDeviceSize m_LoadedSize{ 0u }, m_PeakResidentSize{ 0u };
+
+	void		  ReadFeedback(StreamedTexture* streamedTexture, size_t frameIndex);
+	void		  FitBudget();
+	void		  StreamTexture(StreamedTexture* streamedTexture);
+	void		  ScheduleLoad(StreamedTexture* streamedTexture, uint32_t firstMip, uint32_t endMip, EJobPriority priority);
+	void		  UploadPackedTexture(PackedTexture* packedTexture);
+	// Creates the atlas on first use
+	TextureAtlas* GetAtlas(VkFormat format);
+	void		  UpdateDescriptorSet(StreamedTexture* streamedTexture, size_t frameIndex) const;
+	// Atlases are allocated whole up front and count against the budget like the mip tails
+	VkDeviceSize  GetAtlasSize() const;
+	VkDeviceSize  GetResidentSize() const;
+};
@@ -0,0 +1,421 @@
+#include "UploadManager.h"
+
+#include "../Buffers/DataBuffer.h"
+#include "../Misc/CpuProfiler.h"
+#include "../Misc/Utils.h"
+#include "QueueTimeline.h"
+#include "VulkanDevice.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+namespace
+{
+	float ToMegabytes(VkDeviceSize size) { return static_cast<float>(size) / (1024.0f * 1024.0f); }
+} // namespace
+
+UploadManager::UploadManager(const VulkanDevice* device) : m_Device(device)
+{
+	VkCommandPoolCreateInfo commandPoolCreateInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	commandPoolCreateInfo.queueFamilyIndex = device->GetVkDrawQueueFamilyIndex();
+	if (vkCreateCommandPool(device->GetVkDevice(), &commandPoolCreateInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	m_StagingBuffer = new DataBuffer(device, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, Spectre::uploadStagingSize);
+	m_StagingData = static_cast<char*>(m_StagingBuffer->MapData());
+}
+
+UploadManager::~UploadManager()
+{
+	// Uploads that were never flushed are submitted anyway, their resources may outlive the manager
+	Flush();
+	if (!m_SubmittedBatches.empty())
+	{
+		m_Device->GetDrawQueueTimeline()->WaitFor(m_SubmittedBatches.back()->timelineValue);
+	}
+	RetireCompletedBatches();
+
+	delete m_StagingBuffer;
+
+	// Destroying the pool frees its command buffers
+	const VkDevice vkDevice{ m_Device->GetVkDevice() };
+	if (vkDevice && m_CommandPool)
+	{
+		vkDestroyCommandPool(vkDevice, m_CommandPool, nullptr);
+	}
+}
+
+void* UploadManager::StageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, Token& outToken)
+{
+	VkBuffer	 stagingBuffer;
+	VkDeviceSize stagingOffset;
+	void*		 stagingData;
+	const Batch* batch{ BeginUpload(size, stagingBuffer, stagingOffset, stagingData) };
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = stagingOffset;
+	copyRegion.dstOffset = offset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(batch->commandBuffer, stagingBuffer, buffer, 1u, &copyRegion);
+
+	outToken = batch->token;
+	return stagingData;
+}
+
+void* UploadManager::StageImage(VkImage image, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, Token& outToken, VkImageLayout initialLayout)
+{
+	VkBuffer	 stagingBuffer;
+	VkDeviceSize stagingOffset;
+	void*		 stagingData;
+	const Batch* batch{ BeginUpload(size, stagingBuffer, stagingOffset, stagingData) };
+
+	// The previous contents of the range are discarded unless they are in a defined layout, the rest of the image is left alone
+	VkImageMemoryBarrier imageMemoryBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	imageMemoryBarrier.srcAccessMask = 0u;
+	imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageMemoryBarrier.oldLayout = initialLayout;
+	imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarrier.image = image;
+	imageMemoryBarrier.subresourceRange = subresourceRange;
+	// Frames submitted earlier may still be reading the range when it keeps its contents
+	const VkPipelineStageFlags sourceStage{ initialLayout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+	vkCmdPipelineBarrier(batch->commandBuffer, sourceStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
+
+	std::vector<VkBufferImageCopy> stagingRegions{ regions };
+	for (VkBufferImageCopy& stagingRegion : stagingRegions)
+	{
+		stagingRegion.bufferOffset += stagingOffset;
+	}
+	vkCmdCopyBufferToImage(batch->commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(stagingRegions.size()), stagingRegions.data());
+
+	imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageMemoryBarrier.newLayout = finalLayout;
+	vkCmdPipelineBarrier(batch->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
+
+	outToken = batch->token;
+	return stagingData;
+}
+
+void UploadManager::CopyImage(VkImage source, VkImageLayout sourceLayout, const VkImageSubresourceRange& sourceRange, VkImage destination, const VkImageSubresourceRange& destinationRange, const std::vector<VkImageCopy>& regions, VkImageLayout finalLayout, Token& outToken)
+{
+	RetireCompletedBatches();
+	++m_CopyCount;
+	const Batch* batch{ GetPendingBatch() };
+
+	// Frames submitted before the batch may still be reading the source
+	std::array<VkImageMemoryBarrier, 2u> imageMemoryBarriers;
+	imageMemoryBarriers.at(0u) = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	imageMemoryBarriers.at(0u).srcAccessMask = 0u;
+	imageMemoryBarriers.at(0u).dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageMemoryBarriers.at(0u).oldLayout = sourceLayout;
+	imageMemoryBarriers.at(0u).newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageMemoryBarriers.at(0u).srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarriers.at(0u).dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarriers.at(0u).image = source;
+	imageMemoryBarriers.at(0u).subresourceRange = sourceRange;
+
+	imageMemoryBarriers.at(1u) = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	imageMemoryBarriers.at(1u).srcAccessMask = 0u;
+	imageMemoryBarriers.at(1u).dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageMemoryBarriers.at(1u).oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageMemoryBarriers.at(1u).newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageMemoryBarriers.at(1u).srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarriers.at(1u).dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarriers.at(1u).image = destination;
+	imageMemoryBarriers.at(1u).subresourceRange = destinationRange;
+	vkCmdPipelineBarrier(batch->commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 0u, nullptr, static_cast<uint32_t>(imageMemoryBarriers.size()), imageMemoryBarriers.data());
+
+	vkCmdCopyImage(batch->commandBuffer, source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+	imageMemoryBarriers.at(0u).srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageMemoryBarriers.at(0u).dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	imageMemoryBarriers.at(0u).oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageMemoryBarriers.at(0u).newLayout = sourceLayout;
+
+	imageMemoryBarriers.at(1u).srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageMemoryBarriers.at(1u).dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	imageMemoryBarriers.at(1u).oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageMemoryBarriers.at(1u).newLayout = finalLayout;
+	vkCmdPipelineBarrier(batch->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0u, 0u, nullptr, 0u, nullptr, static_cast<uint32_t>(imageMemoryBarriers.size()), imageMemoryBarriers.data());
+
+	outToken = batch->token;
+}
+
+void UploadManager::GenerateMips(VkImage image, VkExtent2D extent, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, Token& outToken)
+{
+	RetireCompletedBatches();
+	const Batch* batch{ GetPendingBatch() };
+
+	VkImageMemoryBarrier imageMemoryBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarrier.image = image;
+	imageMemoryBarrier.subresourceRange = subresourceRange;
+	imageMemoryBarrier.subresourceRange.levelCount = 1u;
+
+	// Each level is the source of the next one as soon as it has been written
+	for (uint32_t level = 1u; level < subresourceRange.levelCount; ++level)
+	{
+		const uint32_t mip{ subresourceRange.baseMipLevel + level };
+		imageMemoryBarrier.srcAccessMask = 0u;
+		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		imageMemoryBarrier.subresourceRange.baseMipLevel = mip;
+		vkCmdPipelineBarrier(batch->commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
+
+		const VkExtent2D sourceExtent{ std::max(extent.width >> (level - 1u), 1u), std::max(extent.height >> (level - 1u), 1u) };
+		const VkExtent2D destinationExtent{ std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+
+		VkImageBlit imageBlit{};
+		imageBlit.srcSubresource = { subresourceRange.aspectMask, mip - 1u, subresourceRange.baseArrayLayer, subresourceRange.layerCount };
+		imageBlit.srcOffsets[1] = { static_cast<int32_t>(sourceExtent.width), static_cast<int32_t>(sourceExtent.height), 1 };
+		imageBlit.dstSubresource = { subresourceRange.aspectMask, mip, subresourceRange.baseArrayLayer, subresourceRange.layerCount };
+		imageBlit.dstOffsets[1] = { static_cast<int32_t>(destinationExtent.width), static_cast<int32_t>(destinationExtent.height), 1 };
+		vkCmdBlitImage(batch->commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &imageBlit, VK_FILTER_LINEAR);
+
+		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		vkCmdPipelineBarrier(batch->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
+		++m_GeneratedMipCount;
+	}
+
+	imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageMemoryBarrier.newLayout = finalLayout;
+	imageMemoryBarrier.subresourceRange = subresourceRange;
+	vkCmdPipelineBarrier(batch->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0u, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
+
+	outToken = batch->token;
+}
+
+uint64_t UploadManager::Flush()
+{
+	if (!m_PendingBatch)
+	{
+		return 0u;
+	}
+
+	SPECTRE_PROFILE_ZONE("UploadManager::Flush");
+
+	// The first scope covers every command submitted before, the second every command submitted after
+	VkMemoryBarrier memoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	vkCmdPipelineBarrier(m_PendingBatch->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0u, 1u, &memoryBarrier, 0u, nullptr, 0u, nullptr);
+
+	if (vkEndCommandBuffer(m_PendingBatch->commandBuffer) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	const uint64_t timelineValue{ m_Device->GetDrawQueueTimeline()->Submit({ m_PendingBatch->commandBuffer }) };
+	if (timelineValue == 0u)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	m_PendingBatch->timelineValue = timelineValue;
+	m_SubmittedBatches.push_back(m_PendingBatch);
+	m_PendingBatch = nullptr;
+	++m_SubmissionCount;
+	return timelineValue;
+}
+
+bool UploadManager::IsComplete(Token token)
+{
+	if (m_PendingBatch && token >= m_PendingBatch->token)
+	{
+		return false;
+	}
+
+	// Batches complete in order, so every token older than the oldest batch still in flight is complete
+	RetireCompletedBatches();
+	return m_SubmittedBatches.empty() || token < m_SubmittedBatches.front()->token;
+}
+
+void UploadManager::WaitFor(Token token)
+{
+	if (m_PendingBatch && token >= m_PendingBatch->token)
+	{
+		Flush();
+	}
+
+	for (const Batch* batch : m_SubmittedBatches)
+	{
+		if (batch->token >= token)
+		{
+			m_Device->GetDrawQueueTimeline()->WaitFor(batch->timelineValue);
+			break;
+		}
+	}
+	RetireCompletedBatches();
+}
+
+void UploadManager::LogStatistics() const
+{
+	std::cout << "Upload manager: " << m_UploadCount << " upload(s) of " << ToMegabytes(m_StagedSize) << " MB, " << m_CopyCount << " image copies and " << m_GeneratedMipCount << " generated mip levels in " << m_SubmissionCount << " submission(s), waited for staging memory " << m_StallCount << " time(s)" << std::endl;
+}
+
+UploadManager::Batch* UploadManager::BeginUpload(VkDeviceSize size, VkBuffer& outStagingBuffer, VkDeviceSize& outStagingOffset, void*& outStagingData)
+{
+	RetireCompletedBatches();
+	++m_UploadCount;
+	m_StagedSize += size;
+
+	const VkDeviceSize alignedSize{ utils::Align(size, Spectre::uploadStagingAlignment) };
+	if (alignedSize > Spectre::uploadStagingSize)
+	{
+		DataBuffer* oversizedBuffer{ new DataBuffer(m_Device, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, size) };
+		Batch*		batch{ GetPendingBatch() };
+		batch->oversizedBuffers.push_back(oversizedBuffer);
+
+		outStagingBuffer = oversizedBuffer->getBuffer();
+		outStagingOffset = 0u;
+		outStagingData = oversizedBuffer->MapData();
+		return batch;
+	}
+
+	// Wait for the oldest batch until there is room, the pending batch is submitted first when it holds all of the ring
+	VkDeviceSize stagingOffset, consumedSize;
+	while (!AllocateStaging(alignedSize, stagingOffset, consumedSize))
+	{
+		if (m_SubmittedBatches.empty())
+		{
+			Flush();
+		}
+
+		SPECTRE_PROFILE_ZONE("UploadManager::Stall");
+		++m_StallCount;
+		m_Device->GetDrawQueueTimeline()->WaitFor(m_SubmittedBatches.front()->timelineValue);
+		RetireCompletedBatches();
+	}
+
+	Batch* batch{ GetPendingBatch() };
+	batch->stagingEnd = m_StagingHead;
+	batch->stagingSize += consumedSize;
+
+	outStagingBuffer = m_StagingBuffer->getBuffer();
+	outStagingOffset = stagingOffset;
+	outStagingData = m_StagingData + stagingOffset;
+	return batch;
+}
+
+UploadManager::Batch* UploadManager::GetPendingBatch()
+{
+	if (m_PendingBatch)
+	{
+		return m_PendingBatch;
+	}
+
+	VkCommandBuffer commandBuffer{ nullptr };
+	if (m_FreeCommandBuffers.empty())
+	{
+		VkCommandBufferAllocateInfo commandBufferAllocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		commandBufferAllocateInfo.commandPool = m_CommandPool;
+		commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandBufferAllocateInfo.commandBufferCount = 1u;
+		if (vkAllocateCommandBuffers(m_Device->GetVkDevice(), &commandBufferAllocateInfo, &commandBuffer) != VK_SUCCESS)
+		{
+			utils::ThrowError(EError::GenericVulkan);
+		}
+	}
+	else
+	{
+		commandBuffer = m_FreeCommandBuffers.back();
+		m_FreeCommandBuffers.pop_back();
+	}
+
+	// Beginning implicitly resets a recycled command buffer
+	VkCommandBufferBeginInfo commandBufferBeginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	m_PendingBatch = new Batch;
+	m_PendingBatch->token = m_NextToken++;
+	m_PendingBatch->commandBuffer = commandBuffer;
+	m_PendingBatch->stagingEnd = m_StagingHead;
+	return m_PendingBatch;
+}
+
+bool UploadManager::AllocateStaging(VkDeviceSize size, VkDeviceSize& outOffset, VkDeviceSize& outConsumedSize)
+{
+	constexpr VkDeviceSize capacity{ Spectre::uploadStagingSize };
+	if (m_StagingUsedSize == 0u)
+	{
+		m_StagingHead = m_StagingTail = 0u;
+	}
+	else if (m_StagingUsedSize == capacity)
+	{
+		return false;
+	}
+
+	// The used part of the ring either lies in front of the head or wraps around the end
+	if (m_StagingHead >= m_StagingTail)
+	{
+		if (m_StagingHead + size <= capacity)
+		{
+			outOffset = m_StagingHead;
+			outConsumedSize = size;
+		}
+		else if (size <= m_StagingTail)
+		{
+			outOffset = 0u;
+			outConsumedSize = capacity - m_StagingHead + size;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if (m_StagingHead + size <= m_StagingTail)
+	{
+		outOffset = m_StagingHead;
+		outConsumedSize = size;
+	}
+	else
+	{
+		return false;
+	}
+
+	m_StagingHead = outOffset + size;
+	m_StagingUsedSize += outConsumedSize;
+	return true;
+}
+
+void UploadManager::RetireCompletedBatches()
+{
+	while (!m_SubmittedBatches.empty() && m_Device->GetDrawQueueTimeline()->IsReached(m_SubmittedBatches.front()->timelineValue))
+	{
+		RetireBatch(m_SubmittedBatches.front());
+		m_SubmittedBatches.pop_front();
+	}
+}
+
+void UploadManager::RetireBatch(Batch* batch)
+{
+	for (const DataBuffer* oversizedBuffer : batch->oversizedBuffers)
+	{
+		delete oversizedBuffer;
+	}
+
+	// Batches retire in the order they took their staging memory
+	m_StagingTail = batch->stagingEnd;
+	m_StagingUsedSize -= batch->stagingSize;
+	m_FreeCommandBuffers.push_back(batch->commandBuffer);
+	delete batch;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class DataBuffer;
+class VulkanDevice;
+
+namespace Spectre
+{
+	constexpr VkDeviceSize uploadStagingSize = 32u * 1024u * 1024u;	// Larger uploads get a staging buffer of their own
+	constexpr VkDeviceSize uploadStagingAlignment = 16u;			// Covers the texel size of every format, compressed blocks included
+} // namespace Spectre
+
+/*
+ * The upload manager copies data into device local buffers and images through a persistently mapped staging ring. Callers
+ * write their data straight into the staging memory it hands out, and the copy is recorded into the current batch right
+ * away. Flush() submits the whole batch to the draw queue at once, the renderer does so once per frame ahead of the frame
+ * itself, so uploads issued while loading end up in a single submission. The batch ends with a barrier that makes the
+ * copies visible to everything submitted after it. Every upload returns a token to poll or wait for, the staging memory
+ * of a batch is recycled once the batch has completed.
+ */
+class UploadManager final
+{
+public:
+	// Identifies the batch an upload went into, zero is complete from the start
+	using Token = uint64_t;
+
+	explicit UploadManager(const VulkanDevice* device);
+	~UploadManager();
+	UploadManager(const UploadManager&) = delete;
+	UploadManager& operator=(const UploadManager&) = delete;
+
+	// Returns staging memory to write the data to, it has to be written before the next flush
+	void* StageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, Token& outToken);
+	// The regions' buffer offsets are relative to the returned staging memory, the subresource range covers them and ends up in the final layout, it keeps its contents if the initial layout is defined
+	void* StageImage(VkImage image, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, Token& outToken,
+					 VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+	// Copies between two images in the same batch, the source returns to its layout and the destination range ends up in the final layout
+	void  CopyImage(VkImage source, VkImageLayout sourceLayout, const VkImageSubresourceRange& sourceRange, VkImage destination, const VkImageSubresourceRange& destinationRange, const std::vector<VkImageCopy>& regions, VkImageLayout finalLayout, Token& outToken);
+	// Blits every level of the range from the one before it, the first level holds the texels and is in the transfer source layout, the extent is its own
+	void  GenerateMips(VkImage image, VkExtent2D extent, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, Token& outToken);
+
+	// Submits the pending batch if there is one, returns the draw queue timeline value it signals or zero
+	uint64_t Flush();
+	bool	 IsComplete(Token token);
+	// Flushes the batch of the token first if it is still pending
+	void	 WaitFor(Token token);
+
+	void LogStatistics() const;
+
+private:
+	struct Batch
+	{
+		Token					 token{ 0u };
+		VkCommandBuffer			 commandBuffer{ nullptr };
+		uint64_t				 timelineValue{ 0u };
+		VkDeviceSize			 stagingEnd{ 0u };	// Ring offset right behind the last staging memory of the batch
+		VkDeviceSize			 stagingSize{ 0u };	// Including the end of the ring skipped when wrapping around
+		std::vector<DataBuffer*> oversizedBuffers;	// Staging buffers for uploads that don't fit the ring
+	};
+
+	const VulkanDevice*			 m_Device{ nullptr };
+	VkCommandPool				 m_CommandPool{ nullptr };
+	std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+	DataBuffer*					 m_StagingBuffer{ nullptr };
+	char*						 m_StagingData{ nullptr };
+	VkDeviceSize				 m_StagingHead{ 0u }, m_StagingTail{ 0u }, m_StagingUsedSize{ 0u };
+	Batch*						 m_PendingBatch{ nullptr };
+	std::deque<Batch*>			 m_SubmittedBatches; // Oldest first
+	Token						 m_NextToken{ 1u };
+
+	size_t		 m_UploadCount{ 0u }, m_CopyCount{ 0u }, m_GeneratedMipCount{ 0u }, m_SubmissionCount{ 0u }, m_StallCount{ 0u };
+	VkDeviceSize m_StagedSize{ 0u };
+
+	// Returns the batch uploads are recorded into and where in the staging buffer their data goes
+	Batch* BeginUpload(VkDeviceSize size, VkBuffer& outStagingBuffer, VkDeviceSize& outStagingOffset, void*& outStagingData);
+	Batch* GetPendingBatch();
+	// Also returns the bytes skipped at the end of the ring, they are in use until the batch completes
+	bool   AllocateStaging(VkDeviceSize size, VkDeviceSize& outOffset, VkDeviceSize& outConsumedSize);
+	void   RetireCompletedBatches();
+	void   RetireBatch(Batch* batch);
+};
@@ -6,9 +6,19 @@
 	#include <array>
 #endif
 #include "../Misc/Utils.h"
+#include "MemoryAllocator.h"
+#include "QueueTimeline.h"
 
-VulkanDevice::VulkanDevice()
+VulkanDevice::VulkanDevice(bool isHeadless) : m_IsHeadless(isHeadless)
 {
+	// Nothing is presented, so no instance extensions are required
+	if (isHeadless)
+	{
+		std::vector<const char*> vulkanInstanceExtensions;
+		CreateVulkanInstance(vulkanInstanceExtensions);
+		return;
+	}
+
 	// Initialize GLFW
 	if (!glfwInit())
 	{
@@ -150,6 +160,10 @@ VulkanDevice::~VulkanDevice()
 	}
 
 	// Clean up Vulkan
+	delete m_ComputeQueueTimeline;
+	delete m_DrawQueueTimeline;
+	delete m_MemoryAllocator;
+
 	if (m_Device)
 	{
 		vkDestroyDevice(m_Device, nullptr);
@@ -161,6 +175,24 @@ VulkanDevice::~VulkanDevice()
 	}
 }
 
+bool VulkanDevice::SupportsLinearBlit(VkFormat format) const
+{
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, format, &formatProperties);
+
+	constexpr VkFormatFeatureFlags requiredFeatures{ VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT };
+	return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+bool VulkanDevice::SupportsTextureFormat(VkFormat format) const
+{
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, format, &formatProperties);
+
+	constexpr VkFormatFeatureFlags requiredFeatures{ VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT };
+	return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
 void VulkanDevice::CheckSupportedBlendMode(XrResult& result)
 {
 
@@ -301,23 +333,11 @@ bool VulkanDevice::CreateXRDevice(VkSurfaceKHR mirrorSurface)
 	// Pick the present queue family index
 	GetPresentQueueFamilyIndex(mirrorSurface);
 
-	// Get all supported Vulkan device extensions
-	std::vector<VkExtensionProperties> supportedVulkanDeviceExtensions;
-	{
-		uint32_t deviceExtensionCount;
-		if (vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &deviceExtensionCount, nullptr) != VK_SUCCESS)
-		{
-			utils::ThrowError(EError::GenericVulkan);
-			return false;
-		}
+	// Look for a dedicated compute queue family, whether it is used is decided when creating the device
+	FindComputeQueueFamilyIndex();
 
-		supportedVulkanDeviceExtensions.resize(deviceExtensionCount);
-		if (vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &deviceExtensionCount, supportedVulkanDeviceExtensions.data()) != VK_SUCCESS)
-		{
-			utils::ThrowError(EError::GenericVulkan);
-			return false;
-		}
-	}
+	// Get all supported Vulkan device extensions
+	const std::vector<VkExtensionProperties> supportedVulkanDeviceExtensions{ GetSupportedDeviceExtensions() };
 
 	// Get the required Vulkan device extensions from OpenXR
 	std::vector<const char*> vulkanDeviceExtensions;
@@ -345,6 +365,8 @@ bool VulkanDevice::CreateXRDevice(VkSurfaceKHR mirrorSurface)
 	// Add the required swapchain extension for mirror view
 	vulkanDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
+	AddOptionalDeviceExtensions(vulkanDeviceExtensions, supportedVulkanDeviceExtensions);
+
 	// Check that all Vulkan device extensions are supported
 	HandleExtentionSupportCheck(vulkanDeviceExtensions, supportedVulkanDeviceExtensions);
 
@@ -360,13 +382,79 @@ bool VulkanDevice::CreateXRDevice(VkSurfaceKHR mirrorSurface)
 		return false;
 	}
 
-	// Retrieve the queues
+	return RetrieveQueues();
+}
+
+bool VulkanDevice::CreateHeadlessDevice()
+{
+	PickHeadlessPhysicalDevice();
+	FindDrawQueueFamilyIndex();
+	FindComputeQueueFamilyIndex();
+
+	// Without a mirror view the draw queue doubles as the present queue, it is never presented from
+	m_PresentQueueFamilyIndex = m_DrawQueueFamilyIndex;
+
+	const std::vector<VkExtensionProperties> supportedVulkanDeviceExtensions{ GetSupportedDeviceExtensions() };
+	std::vector<const char*>				 vulkanDeviceExtensions;
+	AddOptionalDeviceExtensions(vulkanDeviceExtensions, supportedVulkanDeviceExtensions);
+
+	CreateDevice(vulkanDeviceExtensions);
+	return RetrieveQueues();
+}
+
+bool VulkanDevice::PickHeadlessPhysicalDevice()
+{
+	uint32_t physicalDeviceCount{ 0u };
+	if (vkEnumeratePhysicalDevices(m_VkInstance, &physicalDeviceCount, nullptr) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+		return false;
+	}
+
+	std::vector<VkPhysicalDevice> physicalDevices(physicalDeviceCount);
+	if (vkEnumeratePhysicalDevices(m_VkInstance, &physicalDeviceCount, physicalDevices.data()) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+		return false;
+	}
+
+	// Prefers a discrete GPU, but any Vulkan 1.2 device works, including software implementations like lavapipe
+	VkPhysicalDeviceProperties pickedProperties{};
+	for (const VkPhysicalDevice physicalDevice : physicalDevices)
+	{
+		VkPhysicalDeviceProperties physicalDeviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+		if (physicalDeviceProperties.apiVersion < VK_API_VERSION_1_2)
+		{
+			continue;
+		}
+
+		if (!m_PhysicalDevice || (physicalDeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU && pickedProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU))
+		{
+			m_PhysicalDevice = physicalDevice;
+			pickedProperties = physicalDeviceProperties;
+		}
+	}
+
+	if (!m_PhysicalDevice)
+	{
+		utils::ThrowError(EError::FeatureNotSupported, "Vulkan 1.2 physical device");
+		return false;
+	}
+
+	std::cout << "Rendering headless on " << pickedProperties.deviceName << std::endl;
+	return true;
+}
+
+bool VulkanDevice::RetrieveQueues()
+{
 	vkGetDeviceQueue(m_Device, m_DrawQueueFamilyIndex, 0u, &m_DrawQueue);
 	if (!m_DrawQueue)
 	{
 		utils::ThrowError(EError::GenericVulkan);
 		return false;
 	}
+	m_DrawQueueTimeline = new QueueTimeline(m_Device, m_DrawQueue);
 
 	vkGetDeviceQueue(m_Device, m_PresentQueueFamilyIndex, 0u, &m_PresentQueue);
 	if (!m_PresentQueue)
@@ -375,25 +463,62 @@ bool VulkanDevice::CreateXRDevice(VkSurfaceKHR mirrorSurface)
 		return false;
 	}
 
+	if (m_HasAsyncComputeQueue)
+	{
+		vkGetDeviceQueue(m_Device, m_ComputeQueueFamilyIndex, 0u, &m_ComputeQueue);
+		if (!m_ComputeQueue)
+		{
+			utils::ThrowError(EError::GenericVulkan);
+			return false;
+		}
+		m_ComputeQueueTimeline = new QueueTimeline(m_Device, m_ComputeQueue);
+	}
+
 	return true;
 }
 
+std::vector<VkExtensionProperties> VulkanDevice::GetSupportedDeviceExtensions() const
+{
+	std::vector<VkExtensionProperties> supportedVulkanDeviceExtensions;
+
+	uint32_t deviceExtensionCount;
+	if (vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &deviceExtensionCount, nullptr) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
+	supportedVulkanDeviceExtensions.resize(deviceExtensionCount);
+	if (vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &deviceExtensionCount, supportedVulkanDeviceExtensions.data()) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+	return supportedVulkanDeviceExtensions;
+}
+
+void VulkanDevice::AddOptionalDeviceExtensions(std::vector<const char*>& vulkanDeviceExtensions, const std::vector<VkExtensionProperties>& supportedVulkanDeviceExtensions)
+{
+	// Add the optional graphics pipeline library extensions, whether the feature is usable is decided when creating the device
+	m_SupportsGraphicsPipelineLibraryExtension = Spectre::preferGraphicsPipelineLibrary && IsExtensionSupported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, supportedVulkanDeviceExtensions) && IsExtensionSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, supportedVulkanDeviceExtensions);
+	if (m_SupportsGraphicsPipelineLibraryExtension)
+	{
+		vulkanDeviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+		vulkanDeviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+	}
+
+	// The memory budget is shared with the compositor, without the extension it can only be estimated
+	m_SupportsMemoryBudget = IsExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, supportedVulkanDeviceExtensions);
+	if (m_SupportsMemoryBudget)
+	{
+		vulkanDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+}
+
 bool VulkanDevice::HandleExtentionSupportCheck(std::vector<const char*>& vulkanDeviceExtensions, std::vector<VkExtensionProperties>& supportedVulkanDeviceExtensions)
 {
 
 	for (const char* extension : vulkanDeviceExtensions)
 	{
-		bool extensionSupported{ false };
-		for (const VkExtensionProperties& supportedExtension : supportedVulkanDeviceExtensions)
-		{
-			if (strcmp(extension, supportedExtension.extensionName) == 0)
-			{
-				extensionSupported = true;
-				break;
-			}
-		}
-
-		if (!extensionSupported)
+		if (!IsExtensionSupported(extension, supportedVulkanDeviceExtensions))
 		{
 			std::stringstream s;
 			s << "Vulkan device extension \"" << extension << "\"";
@@ -404,12 +529,30 @@ bool VulkanDevice::HandleExtentionSupportCheck(std::vector<const char*>& vulkanD
 	return true;
 }
 
+bool VulkanDevice::IsExtensionSupported(const char* extension, const std::vector<VkExtensionProperties>& supportedVulkanDeviceExtensions) const
+{
+	for (const VkExtensionProperties& supportedExtension : supportedVulkanDeviceExtensions)
+	{
+		if (strcmp(extension, supportedExtension.extensionName) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 bool VulkanDevice::CreateDevice(std::vector<const char*>& vulkanDeviceExtensions)
 {
 
-	// Retrieve the physical device properties
-	VkPhysicalDeviceProperties physicalDeviceProperties;
-	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &physicalDeviceProperties);
+	// Retrieve the physical device properties, including the device UUID used to validate on-disk caches
+	VkPhysicalDeviceIDProperties physicalDeviceIDProperties{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES };
+	VkPhysicalDeviceProperties2	 physicalDeviceProperties2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+	physicalDeviceProperties2.pNext = &physicalDeviceIDProperties;
+	vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &physicalDeviceProperties2);
+
+	const VkPhysicalDeviceProperties& physicalDeviceProperties{ physicalDeviceProperties2.properties };
+	m_PhysicalDeviceProperties = physicalDeviceProperties;
+	memcpy(m_DeviceUUID.data(), physicalDeviceIDProperties.deviceUUID, VK_UUID_SIZE);
 	m_UniformBufferOffsetAlignment = physicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
 
 	// Determine the best supported multisample count, up to 4x MSAA
@@ -426,15 +569,41 @@ bool VulkanDevice::CreateDevice(std::vector<const char*>& vulkanDeviceExtensions
 	// Verify that the required physical device features are supported
 	VkPhysicalDeviceFeatures physicalDeviceFeatures;
 	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &physicalDeviceFeatures);
-	if (!physicalDeviceFeatures.shaderStorageImageMultisample)
+	if (!m_IsHeadless && !physicalDeviceFeatures.shaderStorageImageMultisample)
 	{
 		utils::ThrowError(EError::FeatureNotSupported, "Vulkan physical device feature \"shaderStorageImageMultisample\"");
 		return false;
 	}
 
+	// Textured shaders report the mip levels they sample back to the texture streamer
+	if (!physicalDeviceFeatures.fragmentStoresAndAtomics)
+	{
+		utils::ThrowError(EError::FeatureNotSupported, "Vulkan physical device feature \"fragmentStoresAndAtomics\"");
+		return false;
+	}
+
 	VkPhysicalDeviceFeatures2		  physicalDeviceFeatures2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
 	VkPhysicalDeviceMultiviewFeatures physicalDeviceMultiviewFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES };
+	VkPhysicalDeviceVulkan12Features  physicalDeviceVulkan12Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+	VkPhysicalDeviceVulkan13Features  physicalDeviceVulkan13Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT physicalDeviceGraphicsPipelineLibraryFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
 	physicalDeviceFeatures2.pNext = &physicalDeviceMultiviewFeatures;
+	const bool supportsVulkan12{ physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2 };
+	const bool supportsVulkan13{ physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_3 };
+	if (supportsVulkan13)
+	{
+		physicalDeviceMultiviewFeatures.pNext = &physicalDeviceVulkan13Features;
+	}
+	if (supportsVulkan12)
+	{
+		physicalDeviceVulkan12Features.pNext = physicalDeviceMultiviewFeatures.pNext;
+		physicalDeviceMultiviewFeatures.pNext = &physicalDeviceVulkan12Features;
+	}
+	if (m_SupportsGraphicsPipelineLibraryExtension)
+	{
+		physicalDeviceGraphicsPipelineLibraryFeatures.pNext = physicalDeviceMultiviewFeatures.pNext;
+		physicalDeviceMultiviewFeatures.pNext = &physicalDeviceGraphicsPipelineLibraryFeatures;
+	}
 	vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &physicalDeviceFeatures2);
 	if (!physicalDeviceMultiviewFeatures.multiview)
 	{
@@ -442,8 +611,50 @@ bool VulkanDevice::CreateDevice(std::vector<const char*>& vulkanDeviceExtensions
 		return false;
 	}
 
-	physicalDeviceFeatures.shaderStorageImageMultisample = VK_TRUE; // Needed for some OpenXR implementations
-	physicalDeviceMultiviewFeatures.multiview = VK_TRUE;			// Needed for stereo rendering
+	// Extended dynamic state is core in Vulkan 1.3, dynamic rendering only has to be enabled
+	m_UsesDynamicRendering = Spectre::preferDynamicRendering && supportsVulkan13 && physicalDeviceVulkan13Features.dynamicRendering;
+	m_UsesGraphicsPipelineLibrary = m_SupportsGraphicsPipelineLibraryExtension && physicalDeviceGraphicsPipelineLibraryFeatures.graphicsPipelineLibrary;
+	m_SupportsPipelineStatisticsQuery = physicalDeviceFeatures.pipelineStatisticsQuery; // Used to count fragment shader invocations
+	m_SupportsSamplerAnisotropy = physicalDeviceFeatures.samplerAnisotropy;
+	m_HasAsyncComputeQueue = Spectre::preferAsyncCompute && m_HasComputeQueueFamily;
+
+	// Every queue submission signals a timeline semaphore, the CPU waits on those instead of on fences or idle queues
+	if (!supportsVulkan12 || !physicalDeviceVulkan12Features.timelineSemaphore)
+	{
+		utils::ThrowError(EError::FeatureNotSupported, "Vulkan physical device feature \"timelineSemaphore\"");
+		return false;
+	}
+
+	// Software implementations may lack multisampled storage images, only the OpenXR runtimes need them
+	if (!m_IsHeadless)
+	{
+		physicalDeviceFeatures.shaderStorageImageMultisample = VK_TRUE; // Needed for some OpenXR implementations
+	}
+	physicalDeviceMultiviewFeatures.multiview = VK_TRUE; // Needed for stereo rendering
+
+	// Only enable the optional features that are actually used
+	physicalDeviceMultiviewFeatures.pNext = nullptr;
+
+	VkPhysicalDeviceVulkan13Features enabledVulkan13Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+	enabledVulkan13Features.dynamicRendering = VK_TRUE;
+	if (m_UsesDynamicRendering)
+	{
+		enabledVulkan13Features.pNext = physicalDeviceMultiviewFeatures.pNext;
+		physicalDeviceMultiviewFeatures.pNext = &enabledVulkan13Features;
+	}
+
+	VkPhysicalDeviceVulkan12Features enabledVulkan12Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+	enabledVulkan12Features.timelineSemaphore = VK_TRUE; // Needed for queue synchronization
+	enabledVulkan12Features.pNext = physicalDeviceMultiviewFeatures.pNext;
+	physicalDeviceMultiviewFeatures.pNext = &enabledVulkan12Features;
+
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT enabledGraphicsPipelineLibraryFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+	enabledGraphicsPipelineLibraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+	if (m_UsesGraphicsPipelineLibrary)
+	{
+		enabledGraphicsPipelineLibraryFeatures.pNext = physicalDeviceMultiviewFeatures.pNext;
+		physicalDeviceMultiviewFeatures.pNext = &enabledGraphicsPipelineLibraryFeatures;
+	}
 
 	constexpr float queuePriority = 1.0f;
 
@@ -461,6 +672,13 @@ bool VulkanDevice::CreateDevice(std::vector<const char*>& vulkanDeviceExtensions
 		deviceQueueCreateInfos.push_back(deviceQueueCreateInfo);
 	}
 
+	// A dedicated compute family never supports graphics, so it can't be the draw or present family
+	if (m_HasAsyncComputeQueue)
+	{
+		deviceQueueCreateInfo.queueFamilyIndex = m_ComputeQueueFamilyIndex;
+		deviceQueueCreateInfos.push_back(deviceQueueCreateInfo);
+	}
+
 	VkDeviceCreateInfo deviceCreateInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
 	deviceCreateInfo.pNext = &physicalDeviceMultiviewFeatures;
 	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(vulkanDeviceExtensions.size());
@@ -473,7 +691,9 @@ bool VulkanDevice::CreateDevice(std::vector<const char*>& vulkanDeviceExtensions
 		utils::ThrowError(EError::GenericVulkan);
 		return false;
 	}
+	m_MemoryAllocator = new MemoryAllocator(m_Device, m_PhysicalDevice, m_SupportsMemoryBudget);
 
+	std::cout << "Rendering with " << (m_UsesDynamicRendering ? "dynamic rendering and extended dynamic state" : "a render pass") << ", pipelines are " << (m_UsesGraphicsPipelineLibrary ? "linked from graphics pipeline libraries" : "built monolithically") << ", compute work runs on " << (m_HasAsyncComputeQueue ? "the async compute queue" : "the draw queue") << std::endl;
 	return true;
 }
 
@@ -548,6 +768,7 @@ bool VulkanDevice::FindDrawQueueFamilyIndex()
 		if (queueFamilyCandidate.queueFlags & VK_QUEUE_GRAPHICS_BIT)
 		{
 			m_DrawQueueFamilyIndex = static_cast<uint32_t>(queueFamilyIndexCandidate);
+			m_DrawQueueTimestampValidBits = queueFamilyCandidate.timestampValidBits;
 			drawQueueFamilyIndexFound = true;
 			break;
 		}
@@ -559,4 +780,39 @@ bool VulkanDevice::FindDrawQueueFamilyIndex()
 		return false;
 	}
 	return true;
+}
+
+bool VulkanDevice::FindComputeQueueFamilyIndex()
+{
+	// Retrieve the queue families
+	std::vector<VkQueueFamilyProperties> queueFamilies;
+	uint32_t							 queueFamilyCount;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+
+	queueFamilies.resize(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	m_HasComputeQueueFamily = false;
+	for (size_t queueFamilyIndexCandidate = 0u; queueFamilyIndexCandidate < queueFamilies.size(); ++queueFamilyIndexCandidate)
+	{
+		const VkQueueFamilyProperties& queueFamilyCandidate = queueFamilies.at(queueFamilyIndexCandidate);
+
+		// Check that the queue family includes actual queues
+		if (queueFamilyCandidate.queueCount == 0u)
+		{
+			continue;
+		}
+
+		// Only a family without graphics support runs next to the draw queue instead of sharing its hardware queue
+		if ((queueFamilyCandidate.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilyCandidate.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			m_ComputeQueueFamilyIndex = static_cast<uint32_t>(queueFamilyIndexCandidate);
+			m_ComputeQueueTimestampValidBits = queueFamilyCandidate.timestampValidBits;
+			m_HasComputeQueueFamily = true;
+			break;
+		}
+	}
+
+	// Not having one is fine, compute work is recorded on the draw queue then
+	return m_HasComputeQueueFamily;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstring>
 #include <iostream>
 #include <sstream>
@@ -13,15 +14,27 @@ namespace Spectre
 {
 	constexpr XrViewConfigurationType viewType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
 	constexpr XrEnvironmentBlendMode  environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+
+	// Render with dynamic rendering and extended dynamic state when the device supports it, otherwise use a render pass
+	constexpr bool preferDynamicRendering = true;
+	// Build pipelines from shared graphics pipeline libraries when the device supports it
+	constexpr bool preferGraphicsPipelineLibrary = true;
+	// Run compute work on a dedicated compute queue family when the device has one, otherwise it stays on the draw queue
+	constexpr bool preferAsyncCompute = true;
 } // namespace
 
+class MemoryAllocator;
+class QueueTimeline;
+
 class VulkanDevice final
 {
 public:
-	VulkanDevice();
+	// A headless device needs neither GLFW nor an OpenXR runtime, it is created with CreateHeadlessDevice() instead
+	explicit VulkanDevice(bool isHeadless = false);
 	~VulkanDevice();
 
 	bool CreateXRDevice(VkSurfaceKHR mirrorSurface);
+	bool CreateHeadlessDevice();
 
 	void					Sync() const { vkDeviceWaitIdle(m_Device); }
 	XrViewConfigurationType GetXrViewType() const { return Spectre::viewType; }
@@ -30,11 +43,35 @@ public:
 	VkInstance				GetVkInstance() const { return m_VkInstance; }
 	VkPhysicalDevice		GetVkPhysicalDevice() const { return m_PhysicalDevice; }
 	uint32_t				GetVkDrawQueueFamilyIndex() const { return m_DrawQueueFamilyIndex; }
+	uint32_t				GetVkComputeQueueFamilyIndex() const { return m_ComputeQueueFamilyIndex; }
 	VkDevice				GetVkDevice() const { return m_Device; }
 	VkQueue					GetVkDrawQueue() const { return m_DrawQueue; }
 	VkQueue					GetVkPresentQueue() const { return m_PresentQueue; }
+	VkQueue					GetVkComputeQueue() const { return m_ComputeQueue; }
+	// Every submission to the draw or compute queue goes through its timeline, the compute one only exists with async compute
+	QueueTimeline*			GetDrawQueueTimeline() const { return m_DrawQueueTimeline; }
+	QueueTimeline*			GetComputeQueueTimeline() const { return m_ComputeQueueTimeline; }
+	// Every buffer and image allocates its memory through it, it also tracks the memory budget
+	MemoryAllocator*		GetMemoryAllocator() const { return m_MemoryAllocator; }
 	VkDeviceSize			GetUniformBufferOffsetAlignment() const { return m_UniformBufferOffsetAlignment; }
 	VkSampleCountFlagBits	GetMultisampleCount() const { return m_MultisampleCount; }
+	bool					UsesDynamicRendering() const { return m_UsesDynamicRendering; }
+	bool					UsesGraphicsPipelineLibrary() const { return m_UsesGraphicsPipelineLibrary; }
+	bool					SupportsPipelineStatisticsQuery() const { return m_SupportsPipelineStatisticsQuery; }
+	bool					SupportsSamplerAnisotropy() const { return m_SupportsSamplerAnisotropy; }
+	// Optimally tiled images of the format can be downsampled by blitting with linear filtering
+	bool					SupportsLinearBlit(VkFormat format) const;
+	// Optimally tiled images of the format can be uploaded, copied and sampled with linear filtering
+	bool					SupportsTextureFormat(VkFormat format) const;
+	bool					HasAsyncComputeQueue() const { return m_HasAsyncComputeQueue; }
+	bool					SupportsMemoryBudget() const { return m_SupportsMemoryBudget; }
+	bool					IsHeadless() const { return m_IsHeadless; }
+	// Zero when the queue family can't write timestamps
+	uint32_t				GetDrawQueueTimestampValidBits() const { return m_DrawQueueTimestampValidBits; }
+	uint32_t				GetComputeQueueTimestampValidBits() const { return m_ComputeQueueTimestampValidBits; }
+
+	const VkPhysicalDeviceProperties&		 GetPhysicalDeviceProperties() const { return m_PhysicalDeviceProperties; }
+	const std::array<uint8_t, VK_UUID_SIZE>& GetDeviceUUID() const { return m_DeviceUUID; }
 
 private:
 	// Extension function pointers
@@ -48,18 +85,37 @@ private:
 
 	VkInstance			  m_VkInstance{ nullptr };
 	VkPhysicalDevice	  m_PhysicalDevice{ nullptr };
-	uint32_t			  m_DrawQueueFamilyIndex{ 0u }, m_PresentQueueFamilyIndex{ 0u };
+	uint32_t			  m_DrawQueueFamilyIndex{ 0u }, m_PresentQueueFamilyIndex{ 0u }, m_ComputeQueueFamilyIndex{ 0u };
+	uint32_t			  m_DrawQueueTimestampValidBits{ 0u }, m_ComputeQueueTimestampValidBits{ 0u };
 	VkDevice			  m_Device{ nullptr };
-	VkQueue				  m_DrawQueue{ nullptr }, m_PresentQueue{ nullptr };
+	VkQueue				  m_DrawQueue{ nullptr }, m_PresentQueue{ nullptr }, m_ComputeQueue{ nullptr };
+	QueueTimeline*		  m_DrawQueueTimeline{ nullptr }, *m_ComputeQueueTimeline{ nullptr };
+	MemoryAllocator*	  m_MemoryAllocator{ nullptr };
 	VkDeviceSize		  m_UniformBufferOffsetAlignment{ 0u };
 	VkSampleCountFlagBits m_MultisampleCount{ VK_SAMPLE_COUNT_1_BIT };
+	bool				  m_UsesDynamicRendering{ false };
+	bool				  m_SupportsGraphicsPipelineLibraryExtension{ false }, m_UsesGraphicsPipelineLibrary{ false };
+	bool				  m_SupportsPipelineStatisticsQuery{ false };
+	bool				  m_SupportsSamplerAnisotropy{ false };
+	bool				  m_SupportsMemoryBudget{ false };
+	bool				  m_HasComputeQueueFamily{ false }, m_HasAsyncComputeQueue{ false };
+	bool				  m_IsHeadless{ false };
+
+	VkPhysicalDeviceProperties		  m_PhysicalDeviceProperties{};
+	std::array<uint8_t, VK_UUID_SIZE> m_DeviceUUID{};
 
-	void CreateVulkanInstance(std::vector<const char*>& vulkanInstanceExtensions);
-	void AddOpenXRExtentions(XrResult& result, std::vector<const char*>& vulkanInstanceExtensions);
-	void CreateXRInstance(std::vector<XrExtensionProperties>& supportedOpenXRInstanceExtensions);
-	bool CreateDevice(std::vector<const char*>& vulkanDeviceExtensions);
-	bool GetPresentQueueFamilyIndex(const VkSurfaceKHR& mirrorSurface);
-	bool FindDrawQueueFamilyIndex();
-	void CheckSupportedBlendMode(XrResult& result);
-	bool HandleExtentionSupportCheck(std::vector<const char*>& vulkanDeviceExtensions, std::vector<VkExtensionProperties>& supportedVulkanDeviceExtensions);
+	void							   CreateVulkanInstance(std::vector<const char*>& vulkanInstanceExtensions);
+	void							   AddOpenXRExtentions(XrResult& result, std::vector<const char*>& vulkanInstanceExtensions);
+	void							   CreateXRInstance(std::vector<XrExtensionProperties>& supportedOpenXRInstanceExtensions);
+	bool							   CreateDevice(std::vector<const char*>& vulkanDeviceExtensions);
+	bool							   RetrieveQueues();
+	bool							   PickHeadlessPhysicalDevice();
+	void							   AddOptionalDeviceExtensions(std::vector<const char*>& vulkanDeviceExtensions, const std::vector<VkExtensionProperties>& supportedVulkanDeviceExtensions);
+	std::vector<VkExtensionProperties> GetSupportedDeviceExtensions() const;
+	bool							   GetPresentQueueFamilyIndex(const VkSurfaceKHR& mirrorSurface);
+	bool							   FindDrawQueueFamilyIndex();
+	bool							   FindComputeQueueFamilyIndex();
+	void							   CheckSupportedBlendMode(XrResult& result);
+	bool							   HandleExtentionSupportCheck(std::vector<const char*>& vulkanDeviceExtensions, std::vector<VkExtensionProperties>& supportedVulkanDeviceExtensions);
+	bool							   IsExtensionSupported(const char* extension, const std::vector<VkExtensionProperties>& supportedVulkanDeviceExtensions) const;
 };
\ No newline at end of file
@@ -1,33 +1,50 @@
 #include "VulkanPipeline.h"
 
+#include "../Misc/JobSystem.h"
 #include "../Misc/Utils.h"
 #include "../VulkanBase/VulkanDevice.h"
+#include "PipelineCache.h"
+#include "PipelineLibraryCache.h"
+#include "ShaderModuleCache.h"
 
 #include <array>
 #include <sstream>
 
-VulkanPipeline::VulkanPipeline(const VulkanDevice* device, VkPipelineLayout pipelineLayout, VkRenderPass renderPass, const std::string& vertexFilename, const std::string& fragmentFilename, const std::vector<VkVertexInputBindingDescription>& vertexInputBindingDescriptions, const std::vector<VkVertexInputAttributeDescription>& vertexInputAttributeDescriptions, Spectre::PipelineMaterialPayload& materialPayload)
-	: m_Device(device), m_VertShaderName{ vertexFilename }, m_FragShaderName{ fragmentFilename }, m_PipelineData{ materialPayload }
+VulkanPipeline::VulkanPipeline(const VulkanDevice* device, PipelineCache* pipelineCache, ShaderModuleCache* shaderModuleCache, PipelineLibraryCache* pipelineLibraryCache, VkPipelineLayout pipelineLayout, const Spectre::RenderTargetLayout& renderTargetLayout, const std::string& vertexFilename, const std::string& fragmentFilename, const std::vector<VkVertexInputBindingDescription>& vertexInputBindingDescriptions, const std::vector<VkVertexInputAttributeDescription>& vertexInputAttributeDescriptions, const Spectre::PipelineMaterialPayload& materialPayload)
+	: m_Device(device), m_PipelineCache(pipelineCache), m_ShaderModuleCache(shaderModuleCache), m_PipelineLibraryCache(pipelineLibraryCache), m_PipelineLayout(pipelineLayout), m_VertShaderName{ vertexFilename }, m_FragShaderName{ fragmentFilename }, m_VertexInputBindingDescriptions(vertexInputBindingDescriptions), m_VertexInputAttributeDescriptions(vertexInputAttributeDescriptions), m_RenderTargetLayout(renderTargetLayout), m_PipelineData{ materialPayload }
 {
+	// Keep the shaders loaded until this pipeline has been built
+	m_ShaderModuleCache->Retain(m_VertShaderName);
+	if (HasFragmentStage())
+	{
+		m_ShaderModuleCache->Retain(m_FragShaderName);
+	}
+}
+
+void VulkanPipeline::Compile()
+{
+	if (IsReady())
+	{
+		return;
+	}
 
 	const VkDevice vkDevice{ m_Device->GetVkDevice() };
-	this->m_PipelineData = materialPayload;
 
 	// Load the vertex shader
-	VkShaderModule vertexShaderModule;
-	if (!utils::LoadShaderFromFile(vkDevice, vertexFilename, vertexShaderModule))
+	const VkShaderModule vertexShaderModule{ m_ShaderModuleCache->Get(m_VertShaderName) };
+	if (!vertexShaderModule)
 	{
 		std::stringstream s;
-		s << "Vertex shader \"" << vertexFilename << "\"";
+		s << "Vertex shader \"" << m_VertShaderName << "\"";
 		utils::ThrowError(EError::FileMissing, s.str());
 	}
 
-	// Load the fragment shader
-	VkShaderModule fragmentShaderModule;
-	if (!utils::LoadShaderFromFile(vkDevice, fragmentFilename, fragmentShaderModule))
+	// Load the fragment shader, depth-only pipelines have none
+	const VkShaderModule fragmentShaderModule{ HasFragmentStage() ? m_ShaderModuleCache->Get(m_FragShaderName) : VK_NULL_HANDLE };
+	if (HasFragmentStage() && !fragmentShaderModule)
 	{
 		std::stringstream s;
-		s << "Fragment shader \"" << fragmentFilename << "\"";
+		s << "Fragment shader \"" << m_FragShaderName << "\"";
 		utils::ThrowError(EError::FileMissing, s.str());
 	}
 
@@ -42,13 +59,14 @@ VulkanPipeline::VulkanPipeline(const VulkanDevice* device, VkPipelineLayout pipe
 	pipelineShaderStageCreateInfoFragment.pName = "main";
 
 	const std::array shaderStages{ pipelineShaderStageCreateInfoVertex, pipelineShaderStageCreateInfoFragment };
+	const uint32_t	 shaderStageCount{ HasFragmentStage() ? 2u : 1u };
 
 	VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
 
-	pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexInputBindingDescriptions.size());
-	pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = vertexInputBindingDescriptions.data();
-	pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInputAttributeDescriptions.size());
-	pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexInputAttributeDescriptions.data();
+	pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(m_VertexInputBindingDescriptions.size());
+	pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = m_VertexInputBindingDescriptions.data();
+	pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_VertexInputAttributeDescriptions.size());
+	pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = m_VertexInputAttributeDescriptions.data();
 
 	VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
 	pipelineInputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -64,11 +82,13 @@ VulkanPipeline::VulkanPipeline(const VulkanDevice* device, VkPipelineLayout pipe
 	pipelineRasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 
 	VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
-	pipelineMultisampleStateCreateInfo.rasterizationSamples = m_Device->GetMultisampleCount();
+	pipelineMultisampleStateCreateInfo.rasterizationSamples = m_RenderTargetLayout.sampleCount;
+
+	const bool hasColorAttachment{ m_RenderTargetLayout.colorFormat != VK_FORMAT_UNDEFINED };
 
 	VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
 	VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
-	pipelineColorBlendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	pipelineColorBlendAttachmentState.colorWriteMask = m_PipelineData.colorWriteMask;
 	pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
 	pipelineColorBlendAttachmentState.srcColorBlendFactor = m_PipelineData.srcColorBlendFactor;
 	pipelineColorBlendAttachmentState.dstColorBlendFactor = m_PipelineData.dstColorBlendFactor;
@@ -77,23 +97,49 @@ VulkanPipeline::VulkanPipeline(const VulkanDevice* device, VkPipelineLayout pipe
 	pipelineColorBlendAttachmentState.dstAlphaBlendFactor = m_PipelineData.dstAlphaBlendFactor;
 	pipelineColorBlendAttachmentState.alphaBlendOp = m_PipelineData.alphaBlendOp;
 
-	pipelineColorBlendStateCreateInfo.attachmentCount = 1;
+	pipelineColorBlendStateCreateInfo.attachmentCount = hasColorAttachment ? 1u : 0u;
 	pipelineColorBlendStateCreateInfo.pAttachments = &pipelineColorBlendAttachmentState;
 
+	// With dynamic rendering the cull mode and depth state are set while recording, so one pipeline serves many materials
 	VkPipelineDynamicStateCreateInfo pipelineDynamicStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
-	constexpr std::array			 dynamicStates{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-	pipelineDynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-	pipelineDynamicStateCreateInfo.pDynamicStates = dynamicStates.data();
+	constexpr std::array			 staticStateDynamicStates{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	constexpr std::array			 extendedDynamicStates{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_CULL_MODE, VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP };
+	if (m_RenderTargetLayout.UsesDynamicRendering())
+	{
+		pipelineDynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(extendedDynamicStates.size());
+		pipelineDynamicStateCreateInfo.pDynamicStates = extendedDynamicStates.data();
+	}
+	else
+	{
+		pipelineDynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(staticStateDynamicStates.size());
+		pipelineDynamicStateCreateInfo.pDynamicStates = staticStateDynamicStates.data();
+	}
 
 	VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
 	pipelineDepthStencilStateCreateInfo.depthTestEnable = m_PipelineData.depthTestEnable;
 	pipelineDepthStencilStateCreateInfo.depthWriteEnable = m_PipelineData.depthWriteEnable;
-	pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+	pipelineDepthStencilStateCreateInfo.depthCompareOp = m_PipelineData.depthCompareOp;
+
+	// Ask the driver whether the pipeline was served from the pipeline cache
+	VkPipelineCreationFeedback			 pipelineCreationFeedback{};
+	VkPipelineCreationFeedbackCreateInfo pipelineCreationFeedbackCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+	pipelineCreationFeedbackCreateInfo.pPipelineCreationFeedback = &pipelineCreationFeedback;
+
+	// Without a render pass the attachment formats are declared on the pipeline itself
+	VkPipelineRenderingCreateInfo pipelineRenderingCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+	pipelineRenderingCreateInfo.viewMask = m_RenderTargetLayout.viewMask;
+	pipelineRenderingCreateInfo.colorAttachmentCount = hasColorAttachment ? 1u : 0u;
+	pipelineRenderingCreateInfo.pColorAttachmentFormats = &m_RenderTargetLayout.colorFormat;
+	pipelineRenderingCreateInfo.depthAttachmentFormat = m_RenderTargetLayout.depthFormat;
+	if (m_RenderTargetLayout.UsesDynamicRendering())
+	{
+		pipelineCreationFeedbackCreateInfo.pNext = &pipelineRenderingCreateInfo;
+	}
 
 	VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
-	graphicsPipelineCreateInfo.flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
-	graphicsPipelineCreateInfo.layout = pipelineLayout;
-	graphicsPipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	graphicsPipelineCreateInfo.pNext = &pipelineCreationFeedbackCreateInfo;
+	graphicsPipelineCreateInfo.layout = m_PipelineLayout;
+	graphicsPipelineCreateInfo.stageCount = shaderStageCount;
 	graphicsPipelineCreateInfo.pStages = shaderStages.data();
 	graphicsPipelineCreateInfo.pVertexInputState = &pipelineVertexInputStateCreateInfo;
 	graphicsPipelineCreateInfo.pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo;
@@ -103,22 +149,216 @@ VulkanPipeline::VulkanPipeline(const VulkanDevice* device, VkPipelineLayout pipe
 	graphicsPipelineCreateInfo.pColorBlendState = &pipelineColorBlendStateCreateInfo;
 	graphicsPipelineCreateInfo.pDynamicState = &pipelineDynamicStateCreateInfo;
 	graphicsPipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilStateCreateInfo;
-	graphicsPipelineCreateInfo.renderPass = renderPass;
-	if (vkCreateGraphicsPipelines(vkDevice, nullptr, 1u, &graphicsPipelineCreateInfo, nullptr, &m_Pipeline) != VK_SUCCESS)
+	graphicsPipelineCreateInfo.renderPass = m_RenderTargetLayout.renderPass;
+
+	if (m_PipelineLibraryCache)
+	{
+		// Build or reuse the four library parts and fast-link them so the pipeline is usable right away
+		CreateLibraries(graphicsPipelineCreateInfo, m_RenderTargetLayout.UsesDynamicRendering() ? &pipelineRenderingCreateInfo : nullptr);
+		m_Pipeline.store(LinkLibraries(0u, &pipelineCreationFeedback), std::memory_order_release);
+
+		// The optimized pipeline replaces the fast-linked one once it is done
+		m_OptimizeJob = JobSystem::GetInstance().Schedule([this] { Optimize(); }, EJobPriority::Low);
+	}
+	else
+	{
+		const VkPipelineCache vkPipelineCache{ m_PipelineCache ? m_PipelineCache->GetVkPipelineCache() : VK_NULL_HANDLE };
+		VkPipeline			  pipeline{ nullptr };
+		if (vkCreateGraphicsPipelines(vkDevice, vkPipelineCache, 1u, &graphicsPipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
+		{
+			utils::ThrowError(EError::GenericVulkan);
+		}
+		m_Pipeline.store(pipeline, std::memory_order_release);
+	}
+
+	if (m_PipelineCache)
+	{
+		m_PipelineCache->RecordCreationFeedback(pipelineCreationFeedback);
+	}
+
+	// The shader modules are evicted once no other pipeline waiting to be built needs them
+	m_ShaderModuleCache->Release(m_VertShaderName);
+	if (HasFragmentStage())
+	{
+		m_ShaderModuleCache->Release(m_FragShaderName);
+	}
+
+	m_IsReady.store(true, std::memory_order_release);
+}
+
+void VulkanPipeline::CreateLibraries(const VkGraphicsPipelineCreateInfo& completeCreateInfo, const VkPipelineRenderingCreateInfo* pipelineRenderingCreateInfo)
+{
+	const VkDevice		  vkDevice{ m_Device->GetVkDevice() };
+	const VkPipelineCache vkPipelineCache{ m_PipelineCache ? m_PipelineCache->GetVkPipelineCache() : VK_NULL_HANDLE };
+	const bool			  usesDynamicState{ m_RenderTargetLayout.UsesDynamicRendering() };
+
+	// Every part is keyed only on the state it is built from, so pipelines that agree on that state share the library
+	PipelineLibraryCache::LibraryKey vertexInputKey;
+	vertexInputKey.part = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+	vertexInputKey.fixedFunctionState.push_back(static_cast<uint32_t>(m_VertexInputBindingDescriptions.size()));
+	for (const VkVertexInputBindingDescription& binding : m_VertexInputBindingDescriptions)
+	{
+		vertexInputKey.fixedFunctionState.insert(vertexInputKey.fixedFunctionState.end(), { binding.binding, binding.stride, static_cast<uint32_t>(binding.inputRate) });
+	}
+	vertexInputKey.fixedFunctionState.push_back(static_cast<uint32_t>(m_VertexInputAttributeDescriptions.size()));
+	for (const VkVertexInputAttributeDescription& attribute : m_VertexInputAttributeDescriptions)
+	{
+		vertexInputKey.fixedFunctionState.insert(vertexInputKey.fixedFunctionState.end(), { attribute.location, attribute.binding, static_cast<uint32_t>(attribute.format), attribute.offset });
+	}
+
+	PipelineLibraryCache::LibraryKey preRasterizationKey;
+	preRasterizationKey.part = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+	preRasterizationKey.shaderName = m_VertShaderName;
+	preRasterizationKey.pipelineLayout = m_PipelineLayout;
+	preRasterizationKey.renderTargetLayout = m_RenderTargetLayout;
+	preRasterizationKey.fixedFunctionState = { usesDynamicState ? 0u : static_cast<uint32_t>(m_PipelineData.cullMode) };
+
+	PipelineLibraryCache::LibraryKey fragmentShaderKey;
+	fragmentShaderKey.part = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+	fragmentShaderKey.shaderName = m_FragShaderName;
+	fragmentShaderKey.pipelineLayout = m_PipelineLayout;
+	fragmentShaderKey.renderTargetLayout = m_RenderTargetLayout;
+	if (!usesDynamicState)
+	{
+		fragmentShaderKey.fixedFunctionState = { m_PipelineData.depthTestEnable, m_PipelineData.depthWriteEnable, static_cast<uint32_t>(m_PipelineData.depthCompareOp) };
+	}
+
+	PipelineLibraryCache::LibraryKey fragmentOutputKey;
+	fragmentOutputKey.part = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+	fragmentOutputKey.renderTargetLayout = m_RenderTargetLayout;
+	fragmentOutputKey.fixedFunctionState = { static_cast<uint32_t>(m_PipelineData.srcColorBlendFactor), static_cast<uint32_t>(m_PipelineData.dstColorBlendFactor), static_cast<uint32_t>(m_PipelineData.colorBlendOp), static_cast<uint32_t>(m_PipelineData.srcAlphaBlendFactor), static_cast<uint32_t>(m_PipelineData.dstAlphaBlendFactor), static_cast<uint32_t>(m_PipelineData.alphaBlendOp), m_PipelineData.colorWriteMask };
+
+	// Dynamic state has to be declared by the part that owns the state
+	std::vector<VkDynamicState> preRasterizationDynamicStates{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	std::vector<VkDynamicState> fragmentShaderDynamicStates;
+	if (usesDynamicState)
+	{
+		preRasterizationDynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE);
+		fragmentShaderDynamicStates = { VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP };
+	}
+
+	VkPipelineDynamicStateCreateInfo preRasterizationDynamicStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+	preRasterizationDynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(preRasterizationDynamicStates.size());
+	preRasterizationDynamicStateCreateInfo.pDynamicStates = preRasterizationDynamicStates.data();
+
+	VkPipelineDynamicStateCreateInfo fragmentShaderDynamicStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+	fragmentShaderDynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(fragmentShaderDynamicStates.size());
+	fragmentShaderDynamicStateCreateInfo.pDynamicStates = fragmentShaderDynamicStates.data();
+
+	const auto createLibrary = [&](VkGraphicsPipelineLibraryFlagsEXT part, VkGraphicsPipelineCreateInfo libraryCreateInfo)
+	{
+		VkGraphicsPipelineLibraryCreateInfoEXT graphicsPipelineLibraryCreateInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT };
+		graphicsPipelineLibraryCreateInfo.pNext = libraryCreateInfo.pNext;
+		graphicsPipelineLibraryCreateInfo.flags = part;
+		libraryCreateInfo.pNext = &graphicsPipelineLibraryCreateInfo;
+		libraryCreateInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+		VkPipeline library{ nullptr };
+		if (vkCreateGraphicsPipelines(vkDevice, vkPipelineCache, 1u, &libraryCreateInfo, nullptr, &library) != VK_SUCCESS)
+		{
+			utils::ThrowError(EError::GenericVulkan);
+		}
+		return library;
+	};
+
+	VkGraphicsPipelineCreateInfo vertexInputCreateInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	vertexInputCreateInfo.pVertexInputState = completeCreateInfo.pVertexInputState;
+	vertexInputCreateInfo.pInputAssemblyState = completeCreateInfo.pInputAssemblyState;
+
+	VkGraphicsPipelineCreateInfo preRasterizationCreateInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	preRasterizationCreateInfo.pNext = pipelineRenderingCreateInfo;
+	preRasterizationCreateInfo.layout = completeCreateInfo.layout;
+	preRasterizationCreateInfo.renderPass = completeCreateInfo.renderPass;
+	preRasterizationCreateInfo.stageCount = 1u;
+	preRasterizationCreateInfo.pStages = &completeCreateInfo.pStages[0];
+	preRasterizationCreateInfo.pViewportState = completeCreateInfo.pViewportState;
+	preRasterizationCreateInfo.pRasterizationState = completeCreateInfo.pRasterizationState;
+	preRasterizationCreateInfo.pDynamicState = &preRasterizationDynamicStateCreateInfo;
+
+	VkGraphicsPipelineCreateInfo fragmentShaderCreateInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	fragmentShaderCreateInfo.pNext = pipelineRenderingCreateInfo;
+	fragmentShaderCreateInfo.layout = completeCreateInfo.layout;
+	fragmentShaderCreateInfo.renderPass = completeCreateInfo.renderPass;
+	fragmentShaderCreateInfo.stageCount = completeCreateInfo.stageCount - 1u;
+	fragmentShaderCreateInfo.pStages = fragmentShaderCreateInfo.stageCount > 0u ? &completeCreateInfo.pStages[1] : nullptr;
+	fragmentShaderCreateInfo.pMultisampleState = completeCreateInfo.pMultisampleState;
+	fragmentShaderCreateInfo.pDepthStencilState = completeCreateInfo.pDepthStencilState;
+	fragmentShaderCreateInfo.pDynamicState = fragmentShaderDynamicStates.empty() ? nullptr : &fragmentShaderDynamicStateCreateInfo;
+
+	VkGraphicsPipelineCreateInfo fragmentOutputCreateInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	fragmentOutputCreateInfo.pNext = pipelineRenderingCreateInfo;
+	fragmentOutputCreateInfo.renderPass = completeCreateInfo.renderPass;
+	fragmentOutputCreateInfo.pMultisampleState = completeCreateInfo.pMultisampleState;
+	fragmentOutputCreateInfo.pColorBlendState = completeCreateInfo.pColorBlendState;
+
+	m_Libraries.at(0u) = m_PipelineLibraryCache->GetOrCreate(vertexInputKey, [&] { return createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, vertexInputCreateInfo); });
+	m_Libraries.at(1u) = m_PipelineLibraryCache->GetOrCreate(preRasterizationKey, [&] { return createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, preRasterizationCreateInfo); });
+	m_Libraries.at(2u) = m_PipelineLibraryCache->GetOrCreate(fragmentShaderKey, [&] { return createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, fragmentShaderCreateInfo); });
+	m_Libraries.at(3u) = m_PipelineLibraryCache->GetOrCreate(fragmentOutputKey, [&] { return createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, fragmentOutputCreateInfo); });
+}
+
+VkPipeline VulkanPipeline::LinkLibraries(VkPipelineCreateFlags flags, VkPipelineCreationFeedback* outFeedback) const
+{
+	VkPipelineCreationFeedbackCreateInfo pipelineCreationFeedbackCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+	pipelineCreationFeedbackCreateInfo.pPipelineCreationFeedback = outFeedback;
+
+	VkPipelineLibraryCreateInfoKHR pipelineLibraryCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR };
+	pipelineLibraryCreateInfo.pNext = outFeedback ? &pipelineCreationFeedbackCreateInfo : nullptr;
+	pipelineLibraryCreateInfo.libraryCount = static_cast<uint32_t>(m_Libraries.size());
+	pipelineLibraryCreateInfo.pLibraries = m_Libraries.data();
+
+	VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	graphicsPipelineCreateInfo.pNext = &pipelineLibraryCreateInfo;
+	graphicsPipelineCreateInfo.flags = flags;
+	graphicsPipelineCreateInfo.layout = m_PipelineLayout;
+
+	const VkPipelineCache vkPipelineCache{ m_PipelineCache ? m_PipelineCache->GetVkPipelineCache() : VK_NULL_HANDLE };
+	VkPipeline			  pipeline{ nullptr };
+	if (vkCreateGraphicsPipelines(m_Device->GetVkDevice(), vkPipelineCache, 1u, &graphicsPipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
 	{
 		utils::ThrowError(EError::GenericVulkan);
 	}
+	return pipeline;
+}
+
+void VulkanPipeline::Optimize()
+{
+	const VkPipeline optimizedPipeline{ LinkLibraries(VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT, nullptr) };
 
-	// These shader modules can now be destroyed
-	vkDestroyShaderModule(vkDevice, vertexShaderModule, nullptr);
-	vkDestroyShaderModule(vkDevice, fragmentShaderModule, nullptr);
+	// Command buffers still in flight may reference the fast-linked pipeline, so it lives until the pipeline is destroyed
+	m_RetiredPipelines.push_back(m_Pipeline.exchange(optimizedPipeline, std::memory_order_acq_rel));
 }
 
 VulkanPipeline::~VulkanPipeline()
 {
+	// The optimization job still uses this pipeline's libraries
+	if (m_OptimizeJob.valid())
+	{
+		m_OptimizeJob.wait();
+	}
+
+	// A pipeline that never finished compiling still holds on to its shaders
+	if (!IsReady())
+	{
+		m_ShaderModuleCache->Release(m_VertShaderName);
+		if (HasFragmentStage())
+		{
+			m_ShaderModuleCache->Release(m_FragShaderName);
+		}
+	}
+
 	const VkDevice vkDevice{ m_Device->GetVkDevice() };
-	if (vkDevice && m_Pipeline)
+	if (vkDevice)
 	{
-		vkDestroyPipeline(vkDevice, m_Pipeline, nullptr);
+		const VkPipeline pipeline{ m_Pipeline.load() };
+		if (pipeline)
+		{
+			vkDestroyPipeline(vkDevice, pipeline, nullptr);
+		}
+
+		for (const VkPipeline retiredPipeline : m_RetiredPipelines)
+		{
+			vkDestroyPipeline(vkDevice, retiredPipeline, nullptr);
+		}
 	}
-}
\ No newline at end of file
+}
@@ -2,49 +2,103 @@
 
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <atomic>
+#include <future>
 #include <string>
 #include <vector>
 
 class VulkanDevice;
+class PipelineCache;
+class ShaderModuleCache;
+class PipelineLibraryCache;
 
 namespace Spectre
 {
 	struct PipelineMaterialPayload
 	{
-		VkBlendFactor	   srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-		VkBlendFactor	   dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-		VkBlendOp		   colorBlendOp = VK_BLEND_OP_ADD;
-		VkBlendFactor	   srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		VkBlendFactor	   dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		VkBlendOp		   alphaBlendOp = VK_BLEND_OP_ADD;
-		VkCullModeFlagBits cullMode = VkCullModeFlagBits::VK_CULL_MODE_NONE;
-		VkBool32		   depthTestEnable = VK_TRUE;
-		VkBool32		   depthWriteEnable = VK_TRUE;
+		VkBlendFactor		  srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		VkBlendFactor		  dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		VkBlendOp			  colorBlendOp = VK_BLEND_OP_ADD;
+		VkBlendFactor		  srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		VkBlendFactor		  dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		VkBlendOp			  alphaBlendOp = VK_BLEND_OP_ADD;
+		VkCullModeFlagBits	  cullMode = VkCullModeFlagBits::VK_CULL_MODE_NONE;
+		VkBool32			  depthTestEnable = VK_TRUE;
+		VkBool32			  depthWriteEnable = VK_TRUE;
+		VkCompareOp			  depthCompareOp = VK_COMPARE_OP_LESS;
+		VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 
 		bool operator==(const PipelineMaterialPayload& other) const
 		{
-			return (srcColorBlendFactor == other.srcColorBlendFactor) && (dstColorBlendFactor == other.dstColorBlendFactor) && (colorBlendOp == other.colorBlendOp) && (srcAlphaBlendFactor == other.srcAlphaBlendFactor) && (dstAlphaBlendFactor == other.dstAlphaBlendFactor) && (alphaBlendOp == other.alphaBlendOp) && (cullMode == other.cullMode) && (depthTestEnable == other.depthTestEnable) && (depthWriteEnable == other.depthWriteEnable);
+			return (srcColorBlendFactor == other.srcColorBlendFactor) && (dstColorBlendFactor == other.dstColorBlendFactor) && (colorBlendOp == other.colorBlendOp) && (srcAlphaBlendFactor == other.srcAlphaBlendFactor) && (dstAlphaBlendFactor == other.dstAlphaBlendFactor) && (alphaBlendOp == other.alphaBlendOp) && (cullMode == other.cullMode) && (depthTestEnable == other.depthTestEnable) && (depthWriteEnable == other.depthWriteEnable) && (depthCompareOp == other.depthCompareOp) && (colorWriteMask == other.colorWriteMask);
 		}
-	};																																																																																																				  
+	};
+
+	// The attachments a pipeline renders into, a null render pass selects dynamic rendering with extended dynamic state
+	struct RenderTargetLayout
+	{
+		VkRenderPass		  renderPass = nullptr;
+		VkFormat			  colorFormat = VK_FORMAT_UNDEFINED;
+		VkFormat			  depthFormat = VK_FORMAT_UNDEFINED;
+		VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
+		uint32_t			  viewMask = 0u;
+
+		bool UsesDynamicRendering() const { return renderPass == nullptr; }
+
+		bool operator==(const RenderTargetLayout& other) const
+		{
+			return (renderPass == other.renderPass) && (colorFormat == other.colorFormat) && (depthFormat == other.depthFormat) && (sampleCount == other.sampleCount) && (viewMask == other.viewMask);
+		}
+	};
 } // namespace Spectre
 
+/*
+ * A pipeline is described up front and compiled later, usually on a job system worker. Until Compile() has finished the
+ * pipeline reports itself as not ready and draws should fall back to another pipeline. With graphics pipeline libraries
+ * the pipeline is fast-linked from shared library parts first and swapped for a link-time optimized version once that
+ * has been built in the background.
+ */
 class VulkanPipeline final
 {
 public:
-	VulkanPipeline(const VulkanDevice* device, VkPipelineLayout pipelineLayout, VkRenderPass renderPass, const std::string& vertexFilename, const std::string& fragmentFilename, const std::vector<VkVertexInputBindingDescription>& vertexInputBindingDescriptions, const std::vector<VkVertexInputAttributeDescription>& vertexInputAttributeDescriptions, Spectre::PipelineMaterialPayload& materialPayload);
+	VulkanPipeline(const VulkanDevice* device, PipelineCache* pipelineCache, ShaderModuleCache* shaderModuleCache, PipelineLibraryCache* pipelineLibraryCache, VkPipelineLayout pipelineLayout, const Spectre::RenderTargetLayout& renderTargetLayout, const std::string& vertexFilename, const std::string& fragmentFilename, const std::vector<VkVertexInputBindingDescription>& vertexInputBindingDescriptions, const std::vector<VkVertexInputAttributeDescription>& vertexInputAttributeDescriptions, const Spectre::PipelineMaterialPayload& materialPayload);
 	~VulkanPipeline();
 
-	void Bind(VkCommandBuffer m_CommandBuffer) const { vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline); };
+	// Creates the Vulkan pipeline, safe to call from any thread
+	void Compile();
+	bool IsReady() const { return m_IsReady.load(std::memory_order_acquire); }
+	// Depth-only pipelines are built without a fragment shader
+	bool HasFragmentStage() const { return !m_FragShaderName.empty(); }
+
+	void Bind(VkCommandBuffer m_CommandBuffer) const { vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline.load(std::memory_order_acquire)); };
 
 	const std::string						GetVertShaderName() const { return m_VertShaderName; }
 	const std::string						GetFragShaderName() const { return m_FragShaderName; }
 	const Spectre::PipelineMaterialPayload& GetPipelineMaterialData() const { return m_PipelineData; }
 
 private:
-	const VulkanDevice* m_Device{ nullptr };
-	VkPipeline			m_Pipeline{ nullptr };
-	std::string			m_VertShaderName;
-	std::string			m_FragShaderName;
+	const VulkanDevice*		m_Device{ nullptr };
+	PipelineCache*			m_PipelineCache{ nullptr };
+	ShaderModuleCache*		m_ShaderModuleCache{ nullptr };
+	PipelineLibraryCache*	m_PipelineLibraryCache{ nullptr };
+	VkPipelineLayout		m_PipelineLayout{ nullptr };
+	std::atomic<VkPipeline>	m_Pipeline{ nullptr };
+	std::atomic<bool>		m_IsReady{ false };
+	std::string				m_VertShaderName;
+	std::string				m_FragShaderName;
+
+	std::array<VkPipeline, 4> m_Libraries{};
+	std::vector<VkPipeline>	  m_RetiredPipelines;
+	std::shared_future<void>  m_OptimizeJob;
 
+	std::vector<VkVertexInputBindingDescription>   m_VertexInputBindingDescriptions;
+	std::vector<VkVertexInputAttributeDescription> m_VertexInputAttributeDescriptions;
+
+	Spectre::RenderTargetLayout		 m_RenderTargetLayout;
 	Spectre::PipelineMaterialPayload m_PipelineData;
+
+	void	   CreateLibraries(const VkGraphicsPipelineCreateInfo& completeCreateInfo, const VkPipelineRenderingCreateInfo* pipelineRenderingCreateInfo);
+	VkPipeline LinkLibraries(VkPipelineCreateFlags flags, VkPipelineCreationFeedback* outFeedback) const;
+	void	   Optimize();
 };
\ No newline at end of file
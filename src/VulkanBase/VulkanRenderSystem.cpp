@@ -2,11 +2,14 @@
 
 #include "../Buffers/DataBuffer.h"
 #include "../Misc/Utils.h"
+#include "DescriptorAllocator.h"
+#include "LightCulling.h"
 #include "VulkanDevice.h"
 
+#include <algorithm>
 #include <cstring>
 
-VulkanRenderSystem::VulkanRenderSystem(const VulkanDevice* device, VkCommandPool commandPool, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, size_t modelCount) : m_Device(device)
+VulkanRenderSystem::VulkanRenderSystem(const VulkanDevice* device, VkCommandPool commandPool, DescriptorAllocator* descriptorAllocator, VkDescriptorSetLayout descriptorSetLayout, const CascadedShadowMap* shadowMap, size_t modelCount, size_t eyeCount) : m_Device(device)
 {
 	// Initialize the uniform buffer data
 	InitUBO(modelCount);
@@ -23,7 +26,7 @@ VulkanRenderSystem::VulkanRenderSystem(const VulkanDevice* device, VkCommandPool
 		utils::ThrowError(EError::GenericVulkan);
 	}
 
-	// Create semaphores
+	// Create semaphores, acquiring and presenting the mirror view image only works with binary ones
 	VkSemaphoreCreateInfo semaphoreCreateInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
 	if (vkCreateSemaphore(vkDevice, &semaphoreCreateInfo, nullptr, &m_DrawableSemaphore) != VK_SUCCESS)
 	{
@@ -35,15 +38,7 @@ VulkanRenderSystem::VulkanRenderSystem(const VulkanDevice* device, VkCommandPool
 		utils::ThrowError(EError::GenericVulkan);
 	}
 
-	// Create a memory fence
-	VkFenceCreateInfo fenceCreateInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
-	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Make sure the fence starts off signaled
-	if (vkCreateFence(vkDevice, &fenceCreateInfo, nullptr, &m_BusyFence) != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
-	}
-
-	CreateDescriptorWithBuffer(device, modelCount, descriptorPool, descriptorSetLayout, vkDevice);
+	CreateDescriptorWithBuffer(device, shadowMap, modelCount, eyeCount, descriptorAllocator, descriptorSetLayout, vkDevice);
 }
 
 void VulkanRenderSystem::InitUBO(const size_t& modelCount)
@@ -58,16 +53,20 @@ void VulkanRenderSystem::InitUBO(const size_t& modelCount)
 	{
 		viewProjectionMatrix = glm::mat4(1.0f);
 	}
+	foveatedVertexUniformData.fill(staticVertexUniformData);
 
 	staticFragmentUniformData.time = 0.0f;
+
+	clusterUniformData = {};
+	shadowUniformData = {};
 }
 
-void VulkanRenderSystem::CreateDescriptorWithBuffer(const VulkanDevice* device, const size_t& modelCount, const VkDescriptorPool& descriptorPool, VkDescriptorSetLayout& descriptorSetLayout, const VkDevice& vkDevice)
+void VulkanRenderSystem::CreateDescriptorWithBuffer(const VulkanDevice* device, const CascadedShadowMap* shadowMap, const size_t& modelCount, const size_t& eyeCount, DescriptorAllocator* descriptorAllocator, VkDescriptorSetLayout& descriptorSetLayout, const VkDevice& vkDevice)
 {
 	const VkDeviceSize uniformBufferOffsetAlignment{ device->GetUniformBufferOffsetAlignment() };
 
 	// Partition the uniform buffer data
-	std::array<VkDescriptorBufferInfo, 3u> descriptorBufferInfos;
+	std::array<VkDescriptorBufferInfo, 5u> descriptorBufferInfos;
 
 	descriptorBufferInfos.at(0u).offset = 0u;
 	descriptorBufferInfos.at(0u).range = sizeof(DynamicVertexUniformData);
@@ -78,23 +77,55 @@ void VulkanRenderSystem::CreateDescriptorWithBuffer(const VulkanDevice* device,
 	descriptorBufferInfos.at(2u).offset = descriptorBufferInfos.at(1u).offset + utils::Align(descriptorBufferInfos.at(1u).range, uniformBufferOffsetAlignment);
 	descriptorBufferInfos.at(2u).range = sizeof(StaticFragmentUniformData);
 
+	descriptorBufferInfos.at(3u).offset = descriptorBufferInfos.at(2u).offset + utils::Align(descriptorBufferInfos.at(2u).range, uniformBufferOffsetAlignment);
+	descriptorBufferInfos.at(3u).range = sizeof(ClusterUniformData);
+
+	descriptorBufferInfos.at(4u).offset = descriptorBufferInfos.at(3u).offset + utils::Align(descriptorBufferInfos.at(3u).range, uniformBufferOffsetAlignment);
+	descriptorBufferInfos.at(4u).range = sizeof(CascadedShadowMap::UniformData);
+
+	// The static vertex data of every foveated eye region follows at the end
+	std::array<VkDescriptorBufferInfo, Spectre::foveationRegionCount> foveatedBufferInfos;
+	VkDeviceSize													  foveatedOffset{ descriptorBufferInfos.at(4u).offset + utils::Align(descriptorBufferInfos.at(4u).range, uniformBufferOffsetAlignment) };
+	for (VkDescriptorBufferInfo& foveatedBufferInfo : foveatedBufferInfos)
+	{
+		foveatedBufferInfo.offset = foveatedOffset;
+		foveatedBufferInfo.range = sizeof(StaticVertexUniformData);
+		foveatedOffset += utils::Align(foveatedBufferInfo.range, uniformBufferOffsetAlignment);
+	}
+
 	// Create an empty uniform buffer
-	const VkDeviceSize uniformBufferSize{ descriptorBufferInfos.at(2u).offset + descriptorBufferInfos.at(2u).range };
-	m_UniformBuffer = new DataBuffer(device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBufferSize);
+	const VkDeviceSize uniformBufferSize{ foveatedBufferInfos.back().offset + foveatedBufferInfos.back().range };
+	m_UniformBuffer = new DataBuffer(device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBufferSize, true);
 
 	// Map the uniform buffer memory
 	m_UniformBufferMemory = m_UniformBuffer->MapData();
 
+	// The local lights are written by the CPU every frame, the cluster light lists only ever by the light culling pass
+	// Light culling may run on the async compute queue, so everything it reads or writes is shared with it
+	const VkDeviceSize lightBufferSize{ static_cast<VkDeviceSize>(Spectre::maxLightCount) * sizeof(LightSystem::Light) };
+	m_LightBuffer = new DataBuffer(device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, lightBufferSize, true);
+	m_LightBufferMemory = m_LightBuffer->MapData();
+
+	const VkDeviceSize clusterLightBufferSize{ LightCulling::GetClusterLightBufferSize(static_cast<uint32_t>(eyeCount)) };
+	m_ClusterLightBuffer = new DataBuffer(device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, clusterLightBufferSize, true);
+
+	std::array<VkDescriptorBufferInfo, 2u> storageBufferInfos;
+	storageBufferInfos.at(0u).buffer = m_LightBuffer->getBuffer();
+	storageBufferInfos.at(0u).offset = 0u;
+	storageBufferInfos.at(0u).range = lightBufferSize;
+
+	storageBufferInfos.at(1u).buffer = m_ClusterLightBuffer->getBuffer();
+	storageBufferInfos.at(1u).offset = 0u;
+	storageBufferInfos.at(1u).range = clusterLightBufferSize;
+
+	// The shadow map is shared by all render processes, its dynamic casters are drawn before the lit shaders sample it
+	VkDescriptorImageInfo shadowMapImageInfo;
+	shadowMapImageInfo.sampler = shadowMap->GetSampler();
+	shadowMapImageInfo.imageView = shadowMap->GetImageView();
+	shadowMapImageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
 	// Allocate a descriptor set
-	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-	descriptorSetAllocateInfo.descriptorPool = descriptorPool;
-	descriptorSetAllocateInfo.descriptorSetCount = 1u;
-	descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
-	const VkResult result = vkAllocateDescriptorSets(vkDevice, &descriptorSetAllocateInfo, &m_DescriptorSet);
-	if (result != VK_SUCCESS)
-	{
-		utils::ThrowError(EError::GenericVulkan);
-	}
+	m_DescriptorSet = descriptorAllocator->Allocate(descriptorSetLayout);
 
 	// Associate the uniform buffer with each descriptor buffer info
 	for (VkDescriptorBufferInfo& descriptorBufferInfo : descriptorBufferInfos)
@@ -102,8 +133,13 @@ void VulkanRenderSystem::CreateDescriptorWithBuffer(const VulkanDevice* device,
 		descriptorBufferInfo.buffer = m_UniformBuffer->getBuffer();
 	}
 
+	for (VkDescriptorBufferInfo& foveatedBufferInfo : foveatedBufferInfos)
+	{
+		foveatedBufferInfo.buffer = m_UniformBuffer->getBuffer();
+	}
+
 	// Update the descriptor sets
-	std::array<VkWriteDescriptorSet, 3u> writeDescriptorSets;
+	std::array<VkWriteDescriptorSet, 8u> writeDescriptorSets;
 
 	writeDescriptorSets.at(0u).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	writeDescriptorSets.at(0u).pNext = nullptr;
@@ -138,25 +174,87 @@ void VulkanRenderSystem::CreateDescriptorWithBuffer(const VulkanDevice* device,
 	writeDescriptorSets.at(2u).pImageInfo = nullptr;
 	writeDescriptorSets.at(2u).pTexelBufferView = nullptr;
 
+	writeDescriptorSets.at(3u).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeDescriptorSets.at(3u).pNext = nullptr;
+	writeDescriptorSets.at(3u).dstSet = m_DescriptorSet;
+	writeDescriptorSets.at(3u).dstBinding = 3u;
+	writeDescriptorSets.at(3u).dstArrayElement = 0u;
+	writeDescriptorSets.at(3u).descriptorCount = 1u;
+	writeDescriptorSets.at(3u).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeDescriptorSets.at(3u).pBufferInfo = &storageBufferInfos.at(0u);
+	writeDescriptorSets.at(3u).pImageInfo = nullptr;
+	writeDescriptorSets.at(3u).pTexelBufferView = nullptr;
+
+	writeDescriptorSets.at(4u).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeDescriptorSets.at(4u).pNext = nullptr;
+	writeDescriptorSets.at(4u).dstSet = m_DescriptorSet;
+	writeDescriptorSets.at(4u).dstBinding = 4u;
+	writeDescriptorSets.at(4u).dstArrayElement = 0u;
+	writeDescriptorSets.at(4u).descriptorCount = 1u;
+	writeDescriptorSets.at(4u).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeDescriptorSets.at(4u).pBufferInfo = &storageBufferInfos.at(1u);
+	writeDescriptorSets.at(4u).pImageInfo = nullptr;
+	writeDescriptorSets.at(4u).pTexelBufferView = nullptr;
+
+	writeDescriptorSets.at(5u).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeDescriptorSets.at(5u).pNext = nullptr;
+	writeDescriptorSets.at(5u).dstSet = m_DescriptorSet;
+	writeDescriptorSets.at(5u).dstBinding = 5u;
+	writeDescriptorSets.at(5u).dstArrayElement = 0u;
+	writeDescriptorSets.at(5u).descriptorCount = 1u;
+	writeDescriptorSets.at(5u).descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	writeDescriptorSets.at(5u).pBufferInfo = &descriptorBufferInfos.at(3u);
+	writeDescriptorSets.at(5u).pImageInfo = nullptr;
+	writeDescriptorSets.at(5u).pTexelBufferView = nullptr;
+
+	writeDescriptorSets.at(6u).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeDescriptorSets.at(6u).pNext = nullptr;
+	writeDescriptorSets.at(6u).dstSet = m_DescriptorSet;
+	writeDescriptorSets.at(6u).dstBinding = 6u;
+	writeDescriptorSets.at(6u).dstArrayElement = 0u;
+	writeDescriptorSets.at(6u).descriptorCount = 1u;
+	writeDescriptorSets.at(6u).descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	writeDescriptorSets.at(6u).pBufferInfo = &descriptorBufferInfos.at(4u);
+	writeDescriptorSets.at(6u).pImageInfo = nullptr;
+	writeDescriptorSets.at(6u).pTexelBufferView = nullptr;
+
+	writeDescriptorSets.at(7u).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeDescriptorSets.at(7u).pNext = nullptr;
+	writeDescriptorSets.at(7u).dstSet = m_DescriptorSet;
+	writeDescriptorSets.at(7u).dstBinding = 7u;
+	writeDescriptorSets.at(7u).dstArrayElement = 0u;
+	writeDescriptorSets.at(7u).descriptorCount = 1u;
+	writeDescriptorSets.at(7u).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writeDescriptorSets.at(7u).pBufferInfo = nullptr;
+	writeDescriptorSets.at(7u).pImageInfo = &shadowMapImageInfo;
+	writeDescriptorSets.at(7u).pTexelBufferView = nullptr;
+
 	vkUpdateDescriptorSets(vkDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0u, nullptr);
+
+	// The sets of the foveated eye regions only differ in the static vertex data
+	for (size_t regionIndex = 0u; regionIndex < m_FoveatedDescriptorSets.size(); ++regionIndex)
+	{
+		VkDescriptorSet& foveatedDescriptorSet{ m_FoveatedDescriptorSets.at(regionIndex) };
+		foveatedDescriptorSet = descriptorAllocator->Allocate(descriptorSetLayout);
+		for (VkWriteDescriptorSet& writeDescriptorSet : writeDescriptorSets)
+		{
+			writeDescriptorSet.dstSet = foveatedDescriptorSet;
+		}
+		writeDescriptorSets.at(1u).pBufferInfo = &foveatedBufferInfos.at(regionIndex);
+
+		vkUpdateDescriptorSets(vkDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0u, nullptr);
+	}
 }
 
 VulkanRenderSystem::~VulkanRenderSystem()
 {
-	if (m_UniformBuffer)
-	{
-		m_UniformBuffer->UnmapData();
-	}
 	delete m_UniformBuffer;
+	delete m_LightBuffer;
+	delete m_ClusterLightBuffer;
 
 	const VkDevice vkDevice{ m_Device->GetVkDevice() };
 	if (vkDevice)
 	{
-		if (m_BusyFence)
-		{
-			vkDestroyFence(vkDevice, m_BusyFence, nullptr);
-		}
-
 		if (m_PresentableSemaphore)
 		{
 			vkDestroySemaphore(vkDevice, m_PresentableSemaphore, nullptr);
@@ -192,4 +290,34 @@ void VulkanRenderSystem::UpdateUniformBufferData() const
 
 	length = sizeof(StaticFragmentUniformData);
 	memcpy(offset, &staticFragmentUniformData, length);
+	offset += utils::Align(length, uniformBufferOffsetAlignment);
+
+	length = sizeof(ClusterUniformData);
+	memcpy(offset, &clusterUniformData, length);
+	offset += utils::Align(length, uniformBufferOffsetAlignment);
+
+	length = sizeof(CascadedShadowMap::UniformData);
+	memcpy(offset, &shadowUniformData, length);
+	offset += utils::Align(length, uniformBufferOffsetAlignment);
+
+	length = sizeof(StaticVertexUniformData);
+	for (const StaticVertexUniformData& foveatedData : foveatedVertexUniformData)
+	{
+		memcpy(offset, &foveatedData, length);
+		offset += utils::Align(length, uniformBufferOffsetAlignment);
+	}
+}
+
+VkBuffer VulkanRenderSystem::GetClusterLightBuffer() const { return m_ClusterLightBuffer->getBuffer(); }
+
+uint32_t VulkanRenderSystem::UpdateLightData(const std::vector<LightSystem::Light>& lights) const
+{
+	if (!m_LightBufferMemory)
+	{
+		return 0u;
+	}
+
+	const uint32_t lightCount{ static_cast<uint32_t>(std::min(lights.size(), static_cast<size_t>(Spectre::maxLightCount))) };
+	memcpy(m_LightBufferMemory, lights.data(), lightCount * sizeof(LightSystem::Light));
+	return lightCount;
 }
\ No newline at end of file
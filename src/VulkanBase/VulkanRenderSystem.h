@@ -1,11 +1,16 @@
 #pragma once
+#include "../Light/LightSystem.h"
+#include "CascadedShadowMap.h"
+#include "Foveation.h"
 #include <array>
 #include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
 #include <vector>
 #include <vulkan/vulkan.h>
 
 class VulkanDevice;
 class DataBuffer;
+class DescriptorAllocator;
 
 class VulkanRenderSystem final
 {
@@ -14,6 +19,8 @@ public:
 	{
 		glm::mat4 worldMatrix;
 		glm::vec4 colorMultiplier = glm::vec4(1.0f);
+		glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f); // Scale in xy, offset in zw, places a packed texture in its atlas layer
+		uint32_t  textureLayer = 0u;
 	};
 	std::vector<DynamicVertexUniformData> dynamicVertexUniformData;
 
@@ -21,6 +28,8 @@ public:
 	{
 		std::array<glm::mat4, 2u> viewProjectionMatrices; // 0 = left eye, 1 = right eye
 	} staticVertexUniformData;
+	// Replaces the static vertex data for the passes of the foveated eye regions
+	std::array<StaticVertexUniformData, Spectre::foveationRegionCount> foveatedVertexUniformData;
 
 	struct StaticFragmentUniformData
 	{
@@ -30,25 +39,50 @@ public:
 		float z;
 	} staticFragmentUniformData;
 
-	VulkanRenderSystem(const VulkanDevice* m_Device, VkCommandPool m_CommandPool, VkDescriptorPool m_DescriptorPool, VkDescriptorSetLayout m_DescriptorSetLayout, size_t modelCount);
+	// Matches the Clusters uniform block in shaders/Lighting.glsl
+	struct ClusterUniformData
+	{
+		std::array<glm::mat4, 2u> viewMatrices;
+		std::array<glm::mat4, 2u> inverseProjectionMatrices;
+		std::array<glm::mat4, 2u> projectionMatrices; // Of the whole eye image, also for the foveated eye regions
+		glm::uvec4				  gridSize;			  // xyz = clusters per eye along each axis, w = light count
+		glm::vec4				  sliceParameters;	  // x = near clip, y = far clip, z = slice scale, w = slice bias
+		glm::vec4				  screenSize;		  // xy = eye resolution in pixels, zw = cluster size in pixels
+	} clusterUniformData;
+
+	CascadedShadowMap::UniformData shadowUniformData;
+
+	VulkanRenderSystem(const VulkanDevice* m_Device, VkCommandPool m_CommandPool, DescriptorAllocator* m_DescriptorAllocator, VkDescriptorSetLayout m_DescriptorSetLayout, const CascadedShadowMap* shadowMap, size_t modelCount, size_t eyeCount);
 	~VulkanRenderSystem();
 
 	VkCommandBuffer GetCommandBuffer() const { return m_CommandBuffer; }
 	VkSemaphore		GetDrawableSemaphore() const { return m_DrawableSemaphore; }
 	VkSemaphore		GetPresentableSemaphore() const { return m_PresentableSemaphore; }
-	VkFence			GetBusyFence() const { return m_BusyFence; }
+	// Draw queue timeline value of the last submission of this render process, zero before the first one
+	uint64_t		GetSubmittedValue() const { return m_SubmittedValue; }
+	void			SetSubmittedValue(uint64_t submittedValue) { m_SubmittedValue = submittedValue; }
 	VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+	// Same as the descriptor set, but with the view projection matrices of the region
+	VkDescriptorSet GetDescriptorSet(EFoveationRegion region) const { return m_FoveatedDescriptorSets.at(static_cast<size_t>(region)); }
+	VkBuffer		GetClusterLightBuffer() const;
 	void			UpdateUniformBufferData() const;
+	// Copies the local lights into this frame's light buffer, returns how many of them fit
+	uint32_t		UpdateLightData(const std::vector<LightSystem::Light>& lights) const;
 
 private:
 	const VulkanDevice* m_Device{ nullptr };
 	VkCommandBuffer		m_CommandBuffer{ nullptr };
 	VkSemaphore			m_DrawableSemaphore{ nullptr }, m_PresentableSemaphore{ nullptr };
-	VkFence				m_BusyFence{ nullptr };
+	uint64_t			m_SubmittedValue{ 0u };
 	DataBuffer*			m_UniformBuffer{ nullptr };
 	void*				m_UniformBufferMemory{ nullptr };
+	DataBuffer*			m_LightBuffer{ nullptr };
+	void*				m_LightBufferMemory{ nullptr };
+	DataBuffer*			m_ClusterLightBuffer{ nullptr };
 	VkDescriptorSet		m_DescriptorSet{ nullptr };
 
+	std::array<VkDescriptorSet, Spectre::foveationRegionCount> m_FoveatedDescriptorSets{};
+
 	void InitUBO(const size_t& modelCount);
-	void CreateDescriptorWithBuffer(const VulkanDevice* device, const size_t& modelCount, const VkDescriptorPool& descriptorPool, VkDescriptorSetLayout& descriptorSetLayout, const VkDevice& vkDevice);
+	void CreateDescriptorWithBuffer(const VulkanDevice* device, const CascadedShadowMap* shadowMap, const size_t& modelCount, const size_t& eyeCount, DescriptorAllocator* descriptorAllocator, VkDescriptorSetLayout& descriptorSetLayout, const VkDevice& vkDevice);
 };
\ No newline at end of file
@@ -1,19 +1,71 @@
 #include "VulkanRenderer.h"
 
 #include "../Buffers/DataBuffer.h"
+#include "../Misc/CpuProfiler.h"
+#include "../Misc/JobSystem.h"
 #include "../Misc/Utils.h"
 #include "../Scene/GameData.h"
 #include "../Scene/MeshData.h"
-#include "../VR/Headset.h"
+#include "../VR/StereoView.h"
 #include "../VulkanBase/RenderTarget.h"
+#include "AsyncComputeQueue.h"
+#include "CascadedShadowMap.h"
+#include "DescriptorAllocator.h"
+#include "GpuProfiler.h"
+#include "LightCulling.h"
+#include "MemoryAllocator.h"
+#include "PipelineCache.h"
+#include "PipelineLibraryCache.h"
+#include "PipelineRegistry.h"
+#include "QueueTimeline.h"
+#include "RenderGraph.h"
+#include "ShaderModuleCache.h"
+#include "TextureStreamer.h"
+#include "UploadManager.h"
 #include "VulkanDevice.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
 namespace Spectre
 {
 	constexpr size_t m_FramesInFlightCount = 2u;
+	const std::string pipelineCacheFilename = "PipelineCache.bin";
+	const std::string fallbackVertShaderName = "shaders/Diffuse.vert.spv";
+	const std::string fallbackFragShaderName = "shaders/Diffuse.frag.spv";
+	const std::string depthPrepassVertShaderName = "shaders/DepthPrepass.vert.spv";
+	const std::string texturedFragShaderName = "shaders/Textured.frag.spv";
+	const std::string texturedAtlasVertShaderName = "shaders/TexturedAtlas.vert.spv";
+	const std::string texturedAtlasFragShaderName = "shaders/TexturedAtlas.frag.spv";
+	const std::string eyePassName = "Eyes";
+	// Indexed by EFoveationRegion, together they take the place of the eye pass
+	const std::array<std::string, foveationRegionCount> foveatedEyePassNames{ "Eyes (foveated inset)", "Eyes (foveated periphery)" };
 } // namespace Spectre
 
-VulkanRenderer::VulkanRenderer(const VulkanDevice* device, const Headset* headset, const MeshData* meshData, const std::vector<Material*>& materials, const std::vector<GameObject*>& gameObjects) : m_Device(device), m_Headset(headset), m_GameObjects(gameObjects), m_Materials(materials)
+namespace
+{
+	// Only opaque materials that write depth themselves can have it laid down ahead of time
+	bool IsDepthPrepassCandidate(const Material* material) { return material->renderBucket == ERenderBucket::Opaque && material->pipelineData.depthTestEnable && material->pipelineData.depthWriteEnable; }
+
+	// Transparent and overlay objects don't block the sun
+	bool IsShadowCaster(const GameObject* gameObject) { return gameObject->IsVisible && gameObject->Material->castsShadows && gameObject->Material->renderBucket == ERenderBucket::Opaque; }
+
+	// The color pass draws the buckets in this order, each in a GPU profiler scope of this name
+	constexpr std::array<std::pair<ERenderBucket, const char*>, 3u> colorPassBuckets{ { { ERenderBucket::Opaque, "Opaque bucket" }, { ERenderBucket::Transparent, "Transparent bucket" }, { ERenderBucket::Overlay, "Overlay bucket" } } };
+
+	// After the prepass the depth buffer already holds the nearest surface, shading only what matches it exactly
+	Spectre::PipelineMaterialPayload MakeDepthEqualPayload(const Spectre::PipelineMaterialPayload& materialPayload)
+	{
+		Spectre::PipelineMaterialPayload depthEqualPayload{ materialPayload };
+		depthEqualPayload.depthWriteEnable = VK_FALSE;
+		depthEqualPayload.depthCompareOp = VK_COMPARE_OP_EQUAL;
+		return depthEqualPayload;
+	}
+} // namespace
+
+VulkanRenderer::VulkanRenderer(const VulkanDevice* device, const StereoView* stereoView, const MeshData* meshData, const std::vector<Material*>& materials, const std::vector<GameObject*>& gameObjects) : m_Device(device), m_StereoView(stereoView), m_GameObjects(gameObjects), m_Materials(materials)
 {
 	const VkDevice vkDevice = device->GetVkDevice();
 
@@ -28,33 +80,51 @@ VulkanRenderer::VulkanRenderer(const VulkanDevice* device, const Headset* headse
 
 	CreateDescriptors(vkDevice);
 
-	CreatePipelines(vkDevice, device, materials);
+	// Load the pipeline cache from the previous run, this makes pipeline creation nearly free after the first launch
+	m_PipelineCache = new PipelineCache(device, Spectre::pipelineCacheFilename);
 
-	CreateVertexIndexBuffer(meshData, m_Device);
-}
+	// The render processes reference the shadow map in their descriptor sets
+	m_CascadedShadowMap = new CascadedShadowMap(device);
 
-void VulkanRenderer::CreateDescriptors(const VkDevice& vkDevice)
-{
-	// Create a descriptor pool
-	std::array<VkDescriptorPoolSize, 2u> descriptorPoolSizes;
+	// Every render graph pass becomes a profiler scope, the statistics are only collected by the passes that ask for them
+	VkQueryPipelineStatisticFlags statisticFlags{ 0u };
+	if (device->SupportsPipelineStatisticsQuery())
+	{
+		statisticFlags = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+						 VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+	}
+	m_GpuProfiler = new GpuProfiler(device, "Draw queue", device->GetDrawQueueTimestampValidBits(), statisticFlags, Spectre::m_FramesInFlightCount, static_cast<uint32_t>(m_StereoView->GetEyeCount()));
+	m_RenderGraph = new RenderGraph(device, m_GpuProfiler);
+
+	// Startup uploads are batched and go out with the first frame
+	m_UploadManager = new UploadManager(device);
 
-	descriptorPoolSizes.at(0u).type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	descriptorPoolSizes.at(0u).descriptorCount = static_cast<uint32_t>(Spectre::m_FramesInFlightCount);
+	// The textured shaders sample from descriptor sets the streamer owns, so its layout is part of the pipeline layout
+	m_TextureStreamer = new TextureStreamer(device, m_UploadManager, m_DescriptorAllocator, Spectre::m_FramesInFlightCount);
+	for (Material* material : materials)
+	{
+		AcquireTextures(material);
+	}
 
-	descriptorPoolSizes.at(1u).type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	descriptorPoolSizes.at(1u).descriptorCount = static_cast<uint32_t>(Spectre::m_FramesInFlightCount * 2u);
+	CreatePipelines(vkDevice, device, materials);
 
-	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
-	descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
-	descriptorPoolCreateInfo.maxSets = static_cast<uint32_t>(Spectre::m_FramesInFlightCount);
-	if (vkCreateDescriptorPool(vkDevice, &descriptorPoolCreateInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+	// Assigns the local lights to clusters before the lit shaders read them
+	m_LightCulling = new LightCulling(device, m_PipelineCache, m_ShaderModuleCache, m_PipelineLayout, static_cast<uint32_t>(stereoView->GetEyeCount()));
+	if (device->HasAsyncComputeQueue())
 	{
-		utils::ThrowError(EError::GenericVulkan);
+		m_AsyncComputeQueue = new AsyncComputeQueue(device, m_RenderProcesses.size());
 	}
 
-	// Create a descriptor set layout
-	std::array<VkDescriptorSetLayoutBinding, 3u> descriptorSetLayoutBindings;
+	CreateVertexIndexBuffer(meshData, m_Device);
+}
+
+void VulkanRenderer::CreateDescriptors(const VkDevice& vkDevice)
+{
+	// Descriptor sets of the render processes, the texture streamer and passes added later all come from the same growing pools
+	m_DescriptorAllocator = new DescriptorAllocator(vkDevice, Spectre::m_FramesInFlightCount);
+
+	// Create a descriptor set layout, the light culling compute pass shares it with the draws
+	std::array<VkDescriptorSetLayoutBinding, 8u> descriptorSetLayoutBindings;
 
 	descriptorSetLayoutBindings.at(0u).binding = 0u;
 	descriptorSetLayoutBindings.at(0u).descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
@@ -74,6 +144,36 @@ void VulkanRenderer::CreateDescriptors(const VkDevice& vkDevice)
 	descriptorSetLayoutBindings.at(2u).stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	descriptorSetLayoutBindings.at(2u).pImmutableSamplers = nullptr;
 
+	descriptorSetLayoutBindings.at(3u).binding = 3u;
+	descriptorSetLayoutBindings.at(3u).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorSetLayoutBindings.at(3u).descriptorCount = 1u;
+	descriptorSetLayoutBindings.at(3u).stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+	descriptorSetLayoutBindings.at(3u).pImmutableSamplers = nullptr;
+
+	descriptorSetLayoutBindings.at(4u).binding = 4u;
+	descriptorSetLayoutBindings.at(4u).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorSetLayoutBindings.at(4u).descriptorCount = 1u;
+	descriptorSetLayoutBindings.at(4u).stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+	descriptorSetLayoutBindings.at(4u).pImmutableSamplers = nullptr;
+
+	descriptorSetLayoutBindings.at(5u).binding = 5u;
+	descriptorSetLayoutBindings.at(5u).descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorSetLayoutBindings.at(5u).descriptorCount = 1u;
+	descriptorSetLayoutBindings.at(5u).stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+	descriptorSetLayoutBindings.at(5u).pImmutableSamplers = nullptr;
+
+	descriptorSetLayoutBindings.at(6u).binding = 6u;
+	descriptorSetLayoutBindings.at(6u).descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorSetLayoutBindings.at(6u).descriptorCount = 1u;
+	descriptorSetLayoutBindings.at(6u).stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	descriptorSetLayoutBindings.at(6u).pImmutableSamplers = nullptr;
+
+	descriptorSetLayoutBindings.at(7u).binding = 7u;
+	descriptorSetLayoutBindings.at(7u).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorSetLayoutBindings.at(7u).descriptorCount = 1u;
+	descriptorSetLayoutBindings.at(7u).stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	descriptorSetLayoutBindings.at(7u).pImmutableSamplers = nullptr;
+
 	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
 	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings.size());
 	descriptorSetLayoutCreateInfo.pBindings = descriptorSetLayoutBindings.data();
@@ -81,24 +181,34 @@ void VulkanRenderer::CreateDescriptors(const VkDevice& vkDevice)
 	{
 		utils::ThrowError(EError::GenericVulkan);
 	}
+	m_DescriptorAllocator->RegisterLayout(m_DescriptorSetLayout, descriptorSetLayoutCreateInfo);
 }
 
 void VulkanRenderer::CreatePipelines(const VkDevice& vkDevice, const VulkanDevice* device, const std::vector<Material*>& materials)
 {
-	// Create a pipeline layout
-	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-	pipelineLayoutCreateInfo.pSetLayouts = &m_DescriptorSetLayout;
-	pipelineLayoutCreateInfo.setLayoutCount = 1u;
+	// Create a pipeline layout, set 1 holds the albedo texture of textured materials
+	const std::array<VkDescriptorSetLayout, 2u> descriptorSetLayouts{ m_DescriptorSetLayout, m_TextureStreamer->GetDescriptorSetLayout() };
+	VkPipelineLayoutCreateInfo					pipelineLayoutCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+	pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
+	pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 	if (vkCreatePipelineLayout(vkDevice, &pipelineLayoutCreateInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
 	{
 		utils::ThrowError(EError::GenericVulkan);
 	}
 
+	// Atlas materials sample a set without the feedback binding, set 0 stays compatible so it doesn't have to be rebound
+	const std::array<VkDescriptorSetLayout, 2u> atlasDescriptorSetLayouts{ m_DescriptorSetLayout, m_TextureStreamer->GetAtlasDescriptorSetLayout() };
+	pipelineLayoutCreateInfo.pSetLayouts = atlasDescriptorSetLayouts.data();
+	if (vkCreatePipelineLayout(vkDevice, &pipelineLayoutCreateInfo, nullptr, &m_AtlasPipelineLayout) != VK_SUCCESS)
+	{
+		utils::ThrowError(EError::GenericVulkan);
+	}
+
 	// Create a render process for each frame in flight
 	m_RenderProcesses.resize(Spectre::m_FramesInFlightCount);
 	for (VulkanRenderSystem*& renderProcess : m_RenderProcesses)
 	{
-		renderProcess = new VulkanRenderSystem(device, m_CommandPool, m_DescriptorPool, m_DescriptorSetLayout, m_GameObjects.size());
+		renderProcess = new VulkanRenderSystem(device, m_CommandPool, m_DescriptorAllocator, m_DescriptorSetLayout, m_CascadedShadowMap, m_GameObjects.size(), m_StereoView->GetEyeCount());
 	}
 
 	// Description for 3D Pipeline
@@ -106,6 +216,7 @@ void VulkanRenderer::CreatePipelines(const VkDevice& vkDevice, const VulkanDevic
 	vertexInputBindingDescription.binding = 0u;
 	vertexInputBindingDescription.stride = sizeof(Vertex);
 	vertexInputBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	m_VertexInputBindingDescriptions = { vertexInputBindingDescription };
 
 	VkVertexInputAttributeDescription vertexInputAttributePosition{};
 	vertexInputAttributePosition.binding = 0u;
@@ -125,24 +236,290 @@ void VulkanRenderer::CreatePipelines(const VkDevice& vkDevice, const VulkanDevic
 	vertexInputAttributeColor.format = VK_FORMAT_R32G32B32_SFLOAT;
 	vertexInputAttributeColor.offset = offsetof(Vertex, color);
 
-	m_Pipelines.resize(3);
+	VkVertexInputAttributeDescription vertexInputAttributeUv{};
+	vertexInputAttributeUv.binding = 0u;
+	vertexInputAttributeUv.location = 3u;
+	vertexInputAttributeUv.format = VK_FORMAT_R32G32_SFLOAT;
+	vertexInputAttributeUv.offset = offsetof(Vertex, uv);
+	m_VertexInputAttributeDescriptions = { vertexInputAttributePosition, vertexInputAttributeNormal, vertexInputAttributeColor, vertexInputAttributeUv };
+
+	// The depth prepass only fetches positions from the same vertex buffer
+	m_DepthPrepassAttributeDescriptions = { vertexInputAttributePosition };
+
+	const auto pipelineStartTime{ std::chrono::high_resolution_clock::now() };
+	m_ShaderModuleCache = new ShaderModuleCache(m_Device);
+	if (m_Device->UsesGraphicsPipelineLibrary())
+	{
+		m_PipelineLibraryCache = new PipelineLibraryCache(m_Device);
+	}
+	m_PipelineRegistry = new PipelineRegistry(m_Device, m_PipelineCache, m_ShaderModuleCache, m_PipelineLibraryCache);
+
+	// Pin the fallback shaders until every material has been scheduled, they are likely shared with some of them
+	m_ShaderModuleCache->Retain(Spectre::fallbackVertShaderName);
+	m_ShaderModuleCache->Retain(Spectre::fallbackFragShaderName);
+
+	// The fallback pipeline is compiled right away, draws use it while the pipeline of their material is still compiling
+	bool isNewPipeline{ false };
+	m_FallbackPipeline = m_PipelineRegistry->Acquire(MakePipelineKey(Spectre::fallbackVertShaderName, Spectre::fallbackFragShaderName, Spectre::PipelineMaterialPayload{}), isNewPipeline);
+	m_FallbackPipeline->Compile();
+
+	// Visible materials are scheduled first so a pipeline shared with a hidden material still gets high priority
+	std::vector<Material*> sortedMaterials{ materials };
+	std::stable_partition(sortedMaterials.begin(), sortedMaterials.end(), [this](const Material* material) { return IsMaterialVisible(material); });
+
+	// Only wait for the pipelines that are drawn with in the first frame, the others keep compiling in the background
+	std::vector<std::shared_future<void>> firstFrameJobs;
+	for (Material* material : sortedMaterials)
+	{
+		const bool isNeededForFirstFrame{ IsMaterialVisible(material) };
+		const std::shared_future<void> job{ SchedulePipeline(material, isNeededForFirstFrame ? EJobPriority::High : EJobPriority::Low) };
+		if (isNeededForFirstFrame)
+		{
+			firstFrameJobs.push_back(job);
+		}
+	}
+
+	// All cascades are drawn by one depth-only pipeline that renders a view per cascade
+	Spectre::PipelineMaterialPayload shadowPayload{};
+	shadowPayload.cullMode = VK_CULL_MODE_NONE;
+	shadowPayload.colorWriteMask = 0u;
+	PipelineRegistry::PipelineKey shadowKey{ MakePipelineKey(Spectre::shadowMapVertShaderName, std::string{}, shadowPayload) };
+	shadowKey.vertexInputAttributeDescriptions = m_DepthPrepassAttributeDescriptions;
+	shadowKey.renderTargetLayout = m_CascadedShadowMap->GetRenderTargetLayout();
+	firstFrameJobs.push_back(SchedulePipeline(shadowKey, EJobPriority::High, m_ShadowPipeline));
+
+	m_ShaderModuleCache->Release(Spectre::fallbackVertShaderName);
+	m_ShaderModuleCache->Release(Spectre::fallbackFragShaderName);
+
+	for (const std::shared_future<void>& job : firstFrameJobs)
+	{
+		job.get();
+	}
+
+	const float pipelineCreationTime{ std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - pipelineStartTime).count() };
+	std::cout << "Created first frame pipelines in " << pipelineCreationTime << " ms, " << materials.size() << " materials share " << m_PipelineRegistry->GetPipelineCount() << " unique pipelines" << std::endl;
+}
+
+PipelineRegistry::PipelineKey VulkanRenderer::MakePipelineKey(const std::string& vertShaderName, const std::string& fragShaderName, const Spectre::PipelineMaterialPayload& materialPayload) const
+{
+	PipelineRegistry::PipelineKey key;
+	key.vertShaderName = vertShaderName;
+	key.fragShaderName = fragShaderName;
+	key.materialPayload = materialPayload;
+	key.vertexInputBindingDescriptions = m_VertexInputBindingDescriptions;
+	key.vertexInputAttributeDescriptions = m_VertexInputAttributeDescriptions;
+	key.renderTargetLayout = m_StereoView->GetRenderTargetLayout();
+	key.pipelineLayout = fragShaderName == Spectre::texturedAtlasFragShaderName ? m_AtlasPipelineLayout : m_PipelineLayout;
+
+	// State that is set while recording does not make pipelines different, leave it out so these materials share one
+	if (key.renderTargetLayout.UsesDynamicRendering())
+	{
+		const Spectre::PipelineMaterialPayload defaultPayload{};
+		key.materialPayload.cullMode = defaultPayload.cullMode;
+		key.materialPayload.depthTestEnable = defaultPayload.depthTestEnable;
+		key.materialPayload.depthWriteEnable = defaultPayload.depthWriteEnable;
+		key.materialPayload.depthCompareOp = defaultPayload.depthCompareOp;
+	}
+
+	return key;
+}
+
+std::shared_future<void> VulkanRenderer::SchedulePipeline(Material* material, EJobPriority priority)
+{
+	const std::shared_future<void> job{ SchedulePipeline(MakePipelineKey(material->vertShaderName, material->fragShaderName, material->pipelineData), priority, material->pipeline) };
+	if (!IsDepthPrepassCandidate(material))
+	{
+		return job;
+	}
+
+	// The depth prepass only saves work, its pipelines are never waited on and the material draws normally until they are done
+	Spectre::PipelineMaterialPayload depthPrepassPayload{ material->pipelineData };
+	depthPrepassPayload.colorWriteMask = 0u;
+	PipelineRegistry::PipelineKey depthPrepassKey{ MakePipelineKey(Spectre::depthPrepassVertShaderName, std::string{}, depthPrepassPayload) };
+	depthPrepassKey.vertexInputAttributeDescriptions = m_DepthPrepassAttributeDescriptions;
+	SchedulePipeline(depthPrepassKey, EJobPriority::Low, material->depthPrepassPipeline);
+
+	// With extended dynamic state this resolves to the material's own pipeline
+	SchedulePipeline(MakePipelineKey(material->vertShaderName, material->fragShaderName, MakeDepthEqualPayload(material->pipelineData)), EJobPriority::Low, material->depthEqualPipeline);
+
+	return job;
+}
+
+std::shared_future<void> VulkanRenderer::SchedulePipeline(const PipelineRegistry::PipelineKey& key, EJobPriority priority, VulkanPipeline*& outPipeline)
+{
+	bool			isNewPipeline{ false };
+	VulkanPipeline* pipeline{ m_PipelineRegistry->Acquire(key, isNewPipeline) };
+	outPipeline = pipeline;
+
+	// Materials with identical state share the pipeline and its compilation job
+	if (!isNewPipeline)
+	{
+		const auto it{ m_PipelineJobs.find(pipeline) };
+		if (it != m_PipelineJobs.end())
+		{
+			return it->second;
+		}
+
+		// Shares the fallback pipeline, which was compiled up front
+		std::promise<void> compiled;
+		compiled.set_value();
+		return compiled.get_future().share();
+	}
+
+	const std::shared_future<void> job{ JobSystem::GetInstance().Schedule(
+	  [pipeline]
+	  {
+		  try
+		  {
+			  pipeline->Compile();
+		  }
+		  catch (const std::exception& e)
+		  {
+			  // Nobody might be waiting on background jobs, make sure the failure is visible
+			  std::cerr << "Failed to compile pipeline \"" << pipeline->GetVertShaderName() << "\" + \"" << pipeline->GetFragShaderName() << "\": " << e.what() << std::endl;
+			  throw;
+		  }
+	  },
+	  priority) };
+
+	m_PipelineJobs.emplace(pipeline, job);
+	return job;
+}
+
+void VulkanRenderer::AddMaterial(Material* material)
+{
+	// New materials compile in the background, their objects are drawn with the fallback pipeline in the meantime
+	m_Materials.push_back(material);
+	AcquireTextures(material);
+	SchedulePipeline(material, EJobPriority::Low);
+}
+
+void VulkanRenderer::AcquireTextures(Material* material)
+{
+	if (material->albedoTextureName.empty())
+	{
+		return;
+	}
 
-	for (size_t i = 0; i < materials.size(); i++)
+	// Small textures of the textured shaders share an atlas with the others of their format, the atlas variant samples it
+	if (material->fragShaderName == Spectre::texturedFragShaderName)
 	{
-		m_Pipelines.emplace_back(new VulkanPipeline(m_Device, m_PipelineLayout, m_Headset->GetVkRenderPass(), materials[i]->vertShaderName, materials[i]->fragShaderName, { vertexInputBindingDescription }, { vertexInputAttributePosition, vertexInputAttributeNormal, vertexInputAttributeColor }, materials[i]->pipelineData));
-		materials[i]->pipeline = m_Pipelines[m_Pipelines.size() - 1];
+		material->albedoRegion = m_TextureStreamer->AcquirePacked(material->albedoTextureName);
+		if (material->albedoRegion)
+		{
+			material->vertShaderName = Spectre::texturedAtlasVertShaderName;
+			material->fragShaderName = Spectre::texturedAtlasFragShaderName;
+			return;
+		}
 	}
+
+	material->albedoTexture = m_TextureStreamer->Acquire(material->albedoTextureName);
+}
+
+void VulkanRenderer::WaitForPipelines() const
+{
+	for (const auto& [pipeline, job] : m_PipelineJobs)
+	{
+		job.get();
+	}
+}
+
+void VulkanRenderer::InvalidateStaticShadows() { m_CascadedShadowMap->InvalidateStaticCache(); }
+
+bool VulkanRenderer::IsMaterialVisible(const Material* material) const
+{
+	for (const GameObject* gameObject : m_GameObjects)
+	{
+		if (gameObject->Material == material && gameObject->IsVisible)
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 VulkanRenderer::~VulkanRenderer()
 {
+	// While every resource is still alive
+	if (m_Device)
+	{
+		m_Device->GetMemoryAllocator()->LogStatistics();
+	}
+
+	// Describes the regions of the last foveated frame
+	if (m_Device && IsFoveationEnabled())
+	{
+		m_Foveation.LogStatistics();
+	}
+
+	// Waits for the uploads, the streamer's images may still be copied from
+	if (m_UploadManager)
+	{
+		m_UploadManager->LogStatistics();
+		delete m_UploadManager;
+	}
+
+	if (m_TextureStreamer)
+	{
+		m_TextureStreamer->LogStatistics();
+		delete m_TextureStreamer;
+	}
 	delete m_VertexIndexBuffer;
+	delete m_LightCulling;
+
+	// Both queues go into one trace so their overlap can be inspected
+	if (m_GpuProfiler)
+	{
+		std::vector<const GpuProfiler*> gpuProfilers{ m_GpuProfiler };
+		if (m_AsyncComputeQueue)
+		{
+			gpuProfilers.push_back(m_AsyncComputeQueue->GetGpuProfiler());
+		}
+		GpuProfiler::WriteChromeTrace(Spectre::gpuTraceFilename, gpuProfilers);
+		m_GpuProfiler->LogStatistics();
+	}
+
+	if (m_AsyncComputeQueue)
+	{
+		m_AsyncComputeQueue->LogStatistics();
+		delete m_AsyncComputeQueue;
+	}
+
+	if (m_CascadedShadowMap)
+	{
+		m_CascadedShadowMap->LogStatistics();
+	}
+
+	// Background compilation jobs still reference their pipelines
+	for (const auto& [pipeline, job] : m_PipelineJobs)
+	{
+		job.wait();
+	}
+	delete m_PipelineRegistry;
 
-	for (size_t i = 0; i < m_Pipelines.size(); i++)
+	if (m_PipelineLibraryCache)
 	{
-		delete m_Pipelines[i];
+		m_PipelineLibraryCache->LogStatistics();
+		delete m_PipelineLibraryCache;
 	}
 
+	if (m_ShaderModuleCache)
+	{
+		m_ShaderModuleCache->LogStatistics();
+		delete m_ShaderModuleCache;
+	}
+
+	// Persist the pipeline cache for the next run
+	if (m_PipelineCache)
+	{
+		m_PipelineCache->LogStatistics();
+		m_PipelineCache->Save();
+		delete m_PipelineCache;
+	}
+
+	delete m_GpuProfiler;
+
 	const VkDevice vkDevice{ m_Device->GetVkDevice() };
 	if (vkDevice)
 	{
@@ -151,21 +528,36 @@ VulkanRenderer::~VulkanRenderer()
 			vkDestroyPipelineLayout(vkDevice, m_PipelineLayout, nullptr);
 		}
 
-		if (m_DescriptorSetLayout)
+		if (m_AtlasPipelineLayout)
 		{
-			vkDestroyDescriptorSetLayout(vkDevice, m_DescriptorSetLayout, nullptr);
+			vkDestroyPipelineLayout(vkDevice, m_AtlasPipelineLayout, nullptr);
 		}
 
-		if (m_DescriptorPool)
+		if (m_DescriptorSetLayout)
 		{
-			vkDestroyDescriptorPool(vkDevice, m_DescriptorPool, nullptr);
+			vkDestroyDescriptorSetLayout(vkDevice, m_DescriptorSetLayout, nullptr);
 		}
+
+	}
+
+	// Sets need not be freed, destroying the pools takes them along
+	if (m_DescriptorAllocator)
+	{
+		m_DescriptorAllocator->LogStatistics();
+		delete m_DescriptorAllocator;
 	}
 
 	for (const VulkanRenderSystem* renderProcess : m_RenderProcesses)
 	{
 		delete renderProcess;
 	}
+	delete m_CascadedShadowMap;
+
+	if (m_RenderGraph)
+	{
+		m_RenderGraph->LogStatistics();
+		delete m_RenderGraph;
+	}
 
 	if (vkDevice && m_CommandPool)
 	{
@@ -176,33 +568,48 @@ VulkanRenderer::~VulkanRenderer()
 void VulkanRenderer::CreateVertexIndexBuffer(const MeshData* meshData, const VulkanDevice* m_Device)
 {
 	const VkDeviceSize bufferSize{ static_cast<VkDeviceSize>(meshData->GetSize()) };
-	DataBuffer*		   stagingBuffer{ new DataBuffer(m_Device, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, bufferSize) };
-
-	char* bufferData{ static_cast<char*>(stagingBuffer->MapData()) };
-
-	meshData->WriteTo(bufferData);
-	stagingBuffer->UnmapData();
-
 	m_VertexIndexBuffer = new DataBuffer(m_Device, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, bufferSize);
 
-	stagingBuffer->CopyTo(*m_VertexIndexBuffer, m_RenderProcesses.at(0u)->GetCommandBuffer(), m_Device->GetVkDrawQueue());
-	delete stagingBuffer;
+	// The meshes are written straight into staging memory, the copy completes before the first frame reads them
+	UploadManager::Token uploadToken;
+	meshData->WriteTo(static_cast<char*>(m_UploadManager->StageBuffer(m_VertexIndexBuffer->getBuffer(), 0u, bufferSize, uploadToken)));
 
 	m_IndexOffset = meshData->GetIndexOffset();
 }
 
-void VulkanRenderer::Render(const glm::mat4& cameraMatrix, size_t swapchainImageIndex, float time, glm::vec3 lightDirection)
+void VulkanRenderer::Render(const glm::mat4& cameraMatrix, size_t swapchainImageIndex, float time, glm::vec3 lightDirection, const std::vector<LightSystem::Light>& lights)
 {
+	SPECTRE_PROFILE_ZONE("VulkanRenderer::Render");
+
 	m_CurrentRenderProcessIndex = (m_CurrentRenderProcessIndex + 1u) % m_RenderProcesses.size();
 
 	VulkanRenderSystem* renderProcess{ m_RenderProcesses.at(m_CurrentRenderProcessIndex) };
 
-	const VkFence m_BusyFence{ renderProcess->GetBusyFence() };
-	if (vkResetFences(m_Device->GetVkDevice(), 1u, &m_BusyFence) != VK_SUCCESS)
+	// The command buffer and queries of this render process are reused, wait until the GPU is done with its last frame
+	if (!m_Device->GetDrawQueueTimeline()->WaitFor(renderProcess->GetSubmittedValue()))
 	{
 		return;
 	}
 
+	// Sets allocated for the last frame of this render process are no longer in use
+	m_DescriptorAllocator->ResetFrame(m_CurrentRenderProcessIndex);
+
+	// Streaming systems evict in their pressure callbacks before the driver has to page memory out
+	m_Device->GetMemoryAllocator()->UpdateBudget();
+
+	// The feedback of the last frame of this render process is complete, streamed levels are staged for this frame
+	m_TextureStreamer->Update(m_CurrentRenderProcessIndex);
+
+	// Packed textures move from the placeholder to their own cell once it has been uploaded
+	for (Material* material : m_Materials)
+	{
+		if (material->albedoRegion)
+		{
+			material->dynamicUniformData.uvTransform = material->albedoRegion->uvTransform;
+			material->dynamicUniformData.textureLayer = material->albedoRegion->layer;
+		}
+	}
+
 	const VkCommandBuffer commandBuffer{ renderProcess->GetCommandBuffer() };
 	if (vkResetCommandBuffer(commandBuffer, 0u) != VK_SUCCESS)
 	{
@@ -215,6 +622,9 @@ void VulkanRenderer::Render(const glm::mat4& cameraMatrix, size_t swapchainImage
 		return;
 	}
 
+	// The last frame of this render process has finished, so its scopes are read back without waiting
+	m_GpuProfiler->BeginFrame(m_CurrentRenderProcessIndex, commandBuffer);
+
 	UpdateUniformBuffers(renderProcess, cameraMatrix);
 
 	renderProcess->staticFragmentUniformData.time = time;
@@ -222,54 +632,481 @@ void VulkanRenderer::Render(const glm::mat4& cameraMatrix, size_t swapchainImage
 	renderProcess->staticFragmentUniformData.y = lightDirection.y;
 	renderProcess->staticFragmentUniformData.z = lightDirection.z;
 
+	UpdateClusterUniformData(renderProcess, cameraMatrix, renderProcess->UpdateLightData(lights));
+	m_CascadedShadowMap->Update(m_StereoView, cameraMatrix, lightDirection, renderProcess->shadowUniformData);
+
 	renderProcess->UpdateUniformBufferData();
+	UpdateDepthPrepassMaterials();
 
-	const std::array clearValues{ VkClearValue({ 0.01f, 0.01f, 0.01f, 1.0f }), VkClearValue({ 1.0f, 0u }) };
+	// Light culling only needs this frame's uniforms, on the async compute queue it overlaps with the previous frame's draws
+	m_ComputeWaitValue = 0u;
+	if (IsAsyncComputeEnabled())
+	{
+		const VkCommandBuffer computeCommandBuffer{ m_AsyncComputeQueue->Begin(m_CurrentRenderProcessIndex) };
+		if (!computeCommandBuffer)
+		{
+			return;
+		}
 
-	VkRenderPassBeginInfo renderPassBeginInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-	renderPassBeginInfo.renderPass = m_Headset->GetVkRenderPass();
-	renderPassBeginInfo.framebuffer = m_Headset->GetRenderTarget(swapchainImageIndex)->GetFramebuffer();
-	renderPassBeginInfo.renderArea.offset = { 0, 0 };
-	renderPassBeginInfo.renderArea.extent = m_Headset->GetEyeResolution(0u);
-	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-	renderPassBeginInfo.pClearValues = clearValues.data();
+		GpuProfiler* computeProfiler{ m_AsyncComputeQueue->GetGpuProfiler() };
+		computeProfiler->BeginScope(computeCommandBuffer, "Light culling", true);
+		m_LightCulling->Dispatch(computeCommandBuffer, renderProcess->GetDescriptorSet());
+		computeProfiler->EndScope(computeCommandBuffer);
+		m_ComputeWaitValue = m_AsyncComputeQueue->Submit(m_CurrentRenderProcessIndex);
+		if (m_ComputeWaitValue == 0u)
+		{
+			return;
+		}
+	}
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	// Opened past the early returns so it is always closed on submission, separate names keep the frame times with and
+	// without async light culling apart
+	m_GpuProfiler->BeginScope(commandBuffer, IsAsyncComputeEnabled() ? "Frame (async light culling)" : "Frame");
 
+	// Bound once for all graphics passes of the frame
+	VkDeviceSize   vertexOffset = 0u;
+	const VkBuffer buffer = m_VertexIndexBuffer->getBuffer();
+	vkCmdBindVertexBuffers(commandBuffer, 0u, 1u, &buffer, &vertexOffset);
+	vkCmdBindIndexBuffer(commandBuffer, buffer, m_IndexOffset, VK_INDEX_TYPE_UINT32);
+
+	// The passes are only recorded on submission, after the mirror view has added its own
+	m_RenderGraph->Reset();
+	DeclareRenderPasses(renderProcess, swapchainImageIndex);
+}
+
+void VulkanRenderer::DeclareRenderPasses(VulkanRenderSystem* renderProcess, size_t swapchainImageIndex)
+{
+	RenderTarget*					  renderTarget{ m_StereoView->GetRenderTarget(swapchainImageIndex) };
+	const Spectre::RenderTargetLayout eyeLayout{ m_StereoView->GetRenderTargetLayout() };
+	const bool						  isMultisampled{ eyeLayout.sampleCount != VK_SAMPLE_COUNT_1_BIT };
+	const VkDescriptorSet			  descriptorSet{ renderProcess->GetDescriptorSet() };
+
+	const RenderGraph::ResourceHandle clusterLights{ m_RenderGraph->ImportBuffer("Cluster lights", renderProcess->GetClusterLightBuffer()) };
+	const RenderGraph::ResourceHandle staticShadowCache{ m_RenderGraph->ImportImage("Static shadow cache", m_CascadedShadowMap->GetStaticCacheImage(), VK_IMAGE_ASPECT_DEPTH_BIT, true) };
+	const RenderGraph::ResourceHandle shadowMap{ m_RenderGraph->ImportImage("Shadow map", m_CascadedShadowMap->GetImage(), VK_IMAGE_ASPECT_DEPTH_BIT, false) };
+
+	// OpenXR expects the swapchain image back as a color attachment
+	m_EyeImage = m_RenderGraph->ImportImage("Eye swapchain image", renderTarget->GetImage(), VK_IMAGE_ASPECT_COLOR_BIT, false, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	// The multisampled attachments never leave the eye pass
+	RenderGraph::TransientImageDescription attachmentDescription;
+	attachmentDescription.extent = m_StereoView->GetEyeResolution(0u);
+	attachmentDescription.samples = eyeLayout.sampleCount;
+	attachmentDescription.layerCount = static_cast<uint32_t>(m_StereoView->GetEyeCount());
+	attachmentDescription.format = eyeLayout.depthFormat;
+	attachmentDescription.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	const RenderGraph::ResourceHandle depthBuffer{ m_RenderGraph->CreateImage("Depth buffer", attachmentDescription) };
+
+	attachmentDescription.format = eyeLayout.colorFormat;
+	attachmentDescription.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	const RenderGraph::ResourceHandle colorBuffer{ isMultisampled ? m_RenderGraph->CreateImage("Color buffer", attachmentDescription) : m_EyeImage };
+
+	// Async light culling has already been submitted, the draw queue waits for it on the timeline semaphore instead
+	if (m_ComputeWaitValue == 0u)
+	{
+		m_RenderGraph->AddPass("Light culling")
+		  .Write(clusterLights, RenderGraph::EResourceUsage::ComputeShaderWrite)
+		  .CollectStatistics()
+		  .SetExecute([this, descriptorSet](VkCommandBuffer commandBuffer) { m_LightCulling->Dispatch(commandBuffer, descriptorSet); });
+	}
+
+	// Static casters are only drawn again when their cached cascades have become invalid
+	if (m_CascadedShadowMap->IsStaticCacheDirty())
+	{
+		m_RenderGraph->AddPass("Static shadows")
+		  .Write(staticShadowCache, RenderGraph::EResourceUsage::DepthAttachment)
+		  .SetExecute(
+			[this, descriptorSet](VkCommandBuffer commandBuffer)
+			{
+				m_CascadedShadowMap->BeginStaticPass(commandBuffer);
+				DrawModels(descriptorSet, commandBuffer, EDrawPass::StaticShadow, ERenderBucket::Opaque);
+				m_CascadedShadowMap->EndStaticPass(commandBuffer);
+			});
+	}
+
+	m_RenderGraph->AddPass("Shadow cache copy")
+	  .Read(staticShadowCache, RenderGraph::EResourceUsage::TransferSource)
+	  .Write(shadowMap, RenderGraph::EResourceUsage::TransferDestination)
+	  .SetExecute([this](VkCommandBuffer commandBuffer) { m_CascadedShadowMap->CopyStaticCache(commandBuffer); });
+
+	m_RenderGraph->AddPass("Dynamic shadows")
+	  .Write(shadowMap, RenderGraph::EResourceUsage::DepthAttachment)
+	  .SetExecute(
+		[this, descriptorSet](VkCommandBuffer commandBuffer)
+		{
+			m_CascadedShadowMap->BeginDynamicPass(commandBuffer);
+			DrawModels(descriptorSet, commandBuffer, EDrawPass::DynamicShadow, ERenderBucket::Opaque);
+			m_CascadedShadowMap->EndDynamicPass(commandBuffer);
+		});
+
+	if (IsFoveationEnabled())
+	{
+		DeclareFoveatedPasses(renderProcess, clusterLights, shadowMap);
+		return;
+	}
+
+	// The statistics query wraps the whole render pass, it can't begin inside of a multiview one
+	RenderGraph::Pass& eyePass{ m_RenderGraph->AddPass(Spectre::eyePassName) };
+	eyePass.CollectStatistics()
+	  .Read(clusterLights, RenderGraph::EResourceUsage::FragmentShaderRead)
+	  .Read(shadowMap, RenderGraph::EResourceUsage::FragmentShaderRead)
+	  .Write(depthBuffer, RenderGraph::EResourceUsage::DepthAttachment)
+	  .Write(m_EyeImage, RenderGraph::EResourceUsage::ColorAttachment);
+	if (isMultisampled)
+	{
+		eyePass.Write(colorBuffer, RenderGraph::EResourceUsage::ColorAttachment);
+	}
+	eyePass.SetExecute([this, renderProcess, renderTarget, colorBuffer, depthBuffer](VkCommandBuffer commandBuffer) { RecordEyePass(renderProcess, commandBuffer, renderTarget, m_RenderGraph->GetImageView(colorBuffer), m_RenderGraph->GetImageView(depthBuffer)); });
+}
+
+void VulkanRenderer::DeclareFoveatedPasses(VulkanRenderSystem* renderProcess, RenderGraph::ResourceHandle clusterLights, RenderGraph::ResourceHandle shadowMap)
+{
+	const Spectre::RenderTargetLayout eyeLayout{ m_StereoView->GetRenderTargetLayout() };
+	const bool						  isMultisampled{ eyeLayout.sampleCount != VK_SAMPLE_COUNT_1_BIT };
+	const uint32_t					  layerCount{ static_cast<uint32_t>(m_StereoView->GetEyeCount()) };
+
+	// Every region is drawn like the eye pass, but into images of its own size that are composited into the eye image afterwards
+	std::array<RenderGraph::ResourceHandle, Spectre::foveationRegionCount> regionImages;
+	for (size_t regionIndex = 0u; regionIndex < regionImages.size(); ++regionIndex)
+	{
+		const EFoveationRegion region{ static_cast<EFoveationRegion>(regionIndex) };
+		const std::string&	   passName{ Spectre::foveatedEyePassNames.at(regionIndex) };
+
+		RenderGraph::TransientImageDescription attachmentDescription;
+		attachmentDescription.extent = m_Foveation.GetRegion(region).extent;
+		attachmentDescription.layerCount = layerCount;
+		attachmentDescription.format = eyeLayout.colorFormat;
+		attachmentDescription.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		const RenderGraph::ResourceHandle regionImage{ m_RenderGraph->CreateImage(passName + " image", attachmentDescription) };
+		regionImages.at(regionIndex) = regionImage;
+
+		attachmentDescription.samples = eyeLayout.sampleCount;
+		const RenderGraph::ResourceHandle colorBuffer{ isMultisampled ? m_RenderGraph->CreateImage(passName + " color buffer", attachmentDescription) : regionImage };
+
+		attachmentDescription.format = eyeLayout.depthFormat;
+		attachmentDescription.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		const RenderGraph::ResourceHandle depthBuffer{ m_RenderGraph->CreateImage(passName + " depth buffer", attachmentDescription) };
+
+		const VkDescriptorSet descriptorSet{ renderProcess->GetDescriptorSet(region) };
+		RenderGraph::Pass&	  regionPass{ m_RenderGraph->AddPass(passName) };
+		regionPass.CollectStatistics()
+		  .Read(clusterLights, RenderGraph::EResourceUsage::FragmentShaderRead)
+		  .Read(shadowMap, RenderGraph::EResourceUsage::FragmentShaderRead)
+		  .Write(depthBuffer, RenderGraph::EResourceUsage::DepthAttachment)
+		  .Write(regionImage, RenderGraph::EResourceUsage::ColorAttachment);
+		if (isMultisampled)
+		{
+			regionPass.Write(colorBuffer, RenderGraph::EResourceUsage::ColorAttachment);
+		}
+		regionPass.SetExecute([this, descriptorSet, region, regionImage, colorBuffer, depthBuffer](VkCommandBuffer commandBuffer) { RecordFoveatedPass(descriptorSet, commandBuffer, region, m_RenderGraph->GetImageView(regionImage), m_RenderGraph->GetImageView(colorBuffer), m_RenderGraph->GetImageView(depthBuffer)); });
+	}
+
+	// The periphery is stretched over the part of the eye image it covers, filtered so its texels don't show as blocks
+	const RenderGraph::ResourceHandle peripheryImage{ regionImages.at(static_cast<size_t>(EFoveationRegion::Periphery)) };
+	const Foveation::Region&		  periphery{ m_Foveation.GetRegion(EFoveationRegion::Periphery) };
+
+	std::vector<VkImageBlit> imageBlits(layerCount);
+	for (uint32_t eyeIndex = 0u; eyeIndex < layerCount; ++eyeIndex)
+	{
+		const VkRect2D& peripheryRect{ periphery.eyeRects.at(eyeIndex) };
+		VkImageBlit&	imageBlit{ imageBlits.at(eyeIndex) };
+		imageBlit.srcOffsets[0] = { 0, 0, 0 };
+		imageBlit.srcOffsets[1] = { static_cast<int32_t>(periphery.extent.width), static_cast<int32_t>(periphery.extent.height), 1 };
+		imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageBlit.srcSubresource.mipLevel = 0u;
+		imageBlit.srcSubresource.baseArrayLayer = eyeIndex;
+		imageBlit.srcSubresource.layerCount = 1u;
+
+		imageBlit.dstOffsets[0] = { peripheryRect.offset.x, peripheryRect.offset.y, 0 };
+		imageBlit.dstOffsets[1] = { peripheryRect.offset.x + static_cast<int32_t>(peripheryRect.extent.width), peripheryRect.offset.y + static_cast<int32_t>(peripheryRect.extent.height), 1 };
+		imageBlit.dstSubresource = imageBlit.srcSubresource;
+	}
+
+	m_RenderGraph->AddPass("Foveated periphery upscale")
+	  .Read(peripheryImage, RenderGraph::EResourceUsage::TransferSource)
+	  .Write(m_EyeImage, RenderGraph::EResourceUsage::TransferDestination)
+	  .SetExecute([this, peripheryImage, imageBlits](VkCommandBuffer commandBuffer) { vkCmdBlitImage(commandBuffer, m_RenderGraph->GetImage(peripheryImage), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_RenderGraph->GetImage(m_EyeImage), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(imageBlits.size()), imageBlits.data(), VK_FILTER_LINEAR); });
+
+	// The insets have the resolution of the eye image, each one is copied over the periphery at the offset of its eye
+	const RenderGraph::ResourceHandle insetImage{ regionImages.at(static_cast<size_t>(EFoveationRegion::Inset)) };
+	const Foveation::Region&		  inset{ m_Foveation.GetRegion(EFoveationRegion::Inset) };
+
+	std::vector<VkImageCopy> imageCopies(layerCount);
+	for (uint32_t eyeIndex = 0u; eyeIndex < layerCount; ++eyeIndex)
+	{
+		const VkRect2D& insetRect{ inset.eyeRects.at(eyeIndex) };
+		VkImageCopy&	imageCopy{ imageCopies.at(eyeIndex) };
+		imageCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageCopy.srcSubresource.mipLevel = 0u;
+		imageCopy.srcSubresource.baseArrayLayer = eyeIndex;
+		imageCopy.srcSubresource.layerCount = 1u;
+		imageCopy.srcOffset = { 0, 0, 0 };
+		imageCopy.dstSubresource = imageCopy.srcSubresource;
+		imageCopy.dstOffset = { insetRect.offset.x, insetRect.offset.y, 0 };
+		imageCopy.extent = { insetRect.extent.width, insetRect.extent.height, 1u };
+	}
+
+	m_RenderGraph->AddPass("Foveated inset copy")
+	  .Read(insetImage, RenderGraph::EResourceUsage::TransferSource)
+	  .Write(m_EyeImage, RenderGraph::EResourceUsage::TransferDestination)
+	  .SetExecute([this, insetImage, imageCopies](VkCommandBuffer commandBuffer) { vkCmdCopyImage(commandBuffer, m_RenderGraph->GetImage(insetImage), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_RenderGraph->GetImage(m_EyeImage), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(imageCopies.size()), imageCopies.data()); });
+}
+
+void VulkanRenderer::RecordEyePass(VulkanRenderSystem* renderProcess, VkCommandBuffer commandBuffer, RenderTarget* renderTarget, VkImageView colorImageView, VkImageView depthImageView)
+{
+	VkRect2D renderArea;
+	renderArea.offset = { 0, 0 };
+	renderArea.extent = m_StereoView->GetEyeResolution(0u);
+
+	if (m_Device->UsesDynamicRendering())
+	{
+		BeginDynamicRendering(commandBuffer, renderTarget->GetImageView(), colorImageView, depthImageView, renderArea);
+	}
+	else
+	{
+		const std::array clearValues{ VkClearValue({ 0.01f, 0.01f, 0.01f, 1.0f }), VkClearValue({ 1.0f, 0u }) };
+
+		VkRenderPassBeginInfo renderPassBeginInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		renderPassBeginInfo.renderPass = m_StereoView->GetVkRenderPass();
+		renderPassBeginInfo.framebuffer = renderTarget->GetFramebuffer(m_StereoView->GetVkRenderPass(), colorImageView, depthImageView, m_RenderGraph->GetTransientGeneration());
+		renderPassBeginInfo.renderArea = renderArea;
+		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassBeginInfo.pClearValues = clearValues.data();
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	RecordEyeDraws(renderProcess->GetDescriptorSet(), commandBuffer, renderArea);
+
+	if (m_Device->UsesDynamicRendering())
+	{
+		vkCmdEndRendering(commandBuffer);
+	}
+	else
+	{
+		vkCmdEndRenderPass(commandBuffer);
+	}
+}
+
+void VulkanRenderer::RecordFoveatedPass(VkDescriptorSet descriptorSet, VkCommandBuffer commandBuffer, EFoveationRegion region, VkImageView targetImageView, VkImageView colorImageView, VkImageView depthImageView)
+{
+	const Foveation::Region& foveationRegion{ m_Foveation.GetRegion(region) };
+
+	VkRect2D renderArea;
+	renderArea.offset = { 0, 0 };
+	renderArea.extent = foveationRegion.extent;
+	BeginDynamicRendering(commandBuffer, targetImageView, colorImageView, depthImageView, renderArea);
+
+	// Depth at the near plane fails every depth test, so what the insets cover is only skipped by fragments that are tested
+	// before shading. Shaders with side effects need early fragment tests for that, and materials without a depth test
+	// like the 2D overlay are still shaded there
+	if (foveationRegion.skippedRect.extent.width > 0u)
+	{
+		VkClearAttachment clearAttachment{};
+		clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		clearAttachment.clearValue.depthStencil = { 0.0f, 0u };
+
+		// With multiview the clear applies to every view, so a single layer is given
+		VkClearRect clearRect;
+		clearRect.rect = foveationRegion.skippedRect;
+		clearRect.baseArrayLayer = 0u;
+		clearRect.layerCount = 1u;
+		vkCmdClearAttachments(commandBuffer, 1u, &clearAttachment, 1u, &clearRect);
+	}
+
+	RecordEyeDraws(descriptorSet, commandBuffer, renderArea);
+
+	vkCmdEndRendering(commandBuffer);
+}
+
+void VulkanRenderer::RecordEyeDraws(VkDescriptorSet descriptorSet, VkCommandBuffer commandBuffer, const VkRect2D& renderArea)
+{
 	VkViewport viewport;
-	viewport.x = static_cast<float>(renderPassBeginInfo.renderArea.offset.x);
-	viewport.y = static_cast<float>(renderPassBeginInfo.renderArea.offset.y);
-	viewport.width = static_cast<float>(renderPassBeginInfo.renderArea.extent.width);
-	viewport.height = static_cast<float>(renderPassBeginInfo.renderArea.extent.height);
+	viewport.x = static_cast<float>(renderArea.offset.x);
+	viewport.y = static_cast<float>(renderArea.offset.y);
+	viewport.width = static_cast<float>(renderArea.extent.width);
+	viewport.height = static_cast<float>(renderArea.extent.height);
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 	vkCmdSetViewport(commandBuffer, 0u, 1u, &viewport);
 
 	VkRect2D scissor;
-	scissor.offset = renderPassBeginInfo.renderArea.offset;
-	scissor.extent = renderPassBeginInfo.renderArea.extent;
+	scissor.offset = renderArea.offset;
+	scissor.extent = renderArea.extent;
 	vkCmdSetScissor(commandBuffer, 0u, 1u, &scissor);
 
-	VkDeviceSize   vertexOffset = 0u;
-	const VkBuffer buffer = m_VertexIndexBuffer->getBuffer();
-	vkCmdBindVertexBuffers(commandBuffer, 0u, 1u, &buffer, &vertexOffset);
-	vkCmdBindIndexBuffer(commandBuffer, buffer, m_IndexOffset, VK_INDEX_TYPE_UINT32);
+	// The prepass shares the render pass with the color pass, its depth is tested against right away
+	if (!m_DepthPrepassMaterials.empty())
+	{
+		DrawModels(descriptorSet, commandBuffer, EDrawPass::DepthPrepass, ERenderBucket::Opaque);
+	}
+
+	for (const auto& [renderBucket, scopeName] : colorPassBuckets)
+	{
+		m_GpuProfiler->BeginScope(commandBuffer, scopeName);
+		DrawModels(descriptorSet, commandBuffer, EDrawPass::Color, renderBucket);
+		m_GpuProfiler->EndScope(commandBuffer);
+	}
+}
+
+void VulkanRenderer::UpdateDepthPrepassMaterials()
+{
+	// Decided once per frame so a pipeline finishing halfway through recording can't leave a material without depth
+	m_DepthPrepassMaterials.clear();
+	if (!m_IsDepthPrepassEnabled)
+	{
+		return;
+	}
+
+	for (const Material* material : m_Materials)
+	{
+		if (material->depthPrepassPipeline && material->depthPrepassPipeline->IsReady() && material->depthEqualPipeline && material->depthEqualPipeline->IsReady())
+		{
+			m_DepthPrepassMaterials.insert(material);
+		}
+	}
+}
+
+bool VulkanRenderer::GetFragmentShaderInvocationCount(uint64_t& outCount) const
+{
+	if (!IsFoveationEnabled())
+	{
+		return m_GpuProfiler->GetLatestStatistic(Spectre::eyePassName, VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, outCount);
+	}
 
-	DrawModels(renderProcess, commandBuffer);
+	// The foveated eye regions together stand in for the eye pass
+	outCount = 0u;
+	for (const std::string& passName : Spectre::foveatedEyePassNames)
+	{
+		uint64_t invocationCount{ 0u };
+		if (!m_GpuProfiler->GetLatestStatistic(passName, VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, invocationCount))
+		{
+			return false;
+		}
+		outCount += invocationCount;
+	}
 
-	vkCmdEndRenderPass(commandBuffer);
+	return true;
 }
 
-void VulkanRenderer::DrawModels(VulkanRenderSystem* renderProcess, const VkCommandBuffer& commandBuffer)
+bool VulkanRenderer::IsFoveationEnabled() const { return m_Device->UsesDynamicRendering() && m_FoveationLevel != EFoveationLevel::Off; }
+
+void VulkanRenderer::BeginDynamicRendering(const VkCommandBuffer& commandBuffer, VkImageView targetImageView, VkImageView colorImageView, VkImageView depthImageView, const VkRect2D& renderArea) const
 {
-	const VkDescriptorSet descriptorSet{ renderProcess->GetDescriptorSet() };
+	const bool isMultisampled{ m_Device->GetMultisampleCount() != VK_SAMPLE_COUNT_1_BIT };
+
+	// The multisampled color is resolved straight into the target and never stored
+	VkRenderingAttachmentInfo colorAttachmentInfo{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+	colorAttachmentInfo.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachmentInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachmentInfo.clearValue.color = { { 0.01f, 0.01f, 0.01f, 1.0f } };
+	if (isMultisampled)
+	{
+		colorAttachmentInfo.imageView = colorImageView;
+		colorAttachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachmentInfo.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+		colorAttachmentInfo.resolveImageView = targetImageView;
+		colorAttachmentInfo.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	}
+	else
+	{
+		colorAttachmentInfo.imageView = targetImageView;
+		colorAttachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	}
+
+	VkRenderingAttachmentInfo depthAttachmentInfo{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+	depthAttachmentInfo.imageView = depthImageView;
+	depthAttachmentInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachmentInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachmentInfo.clearValue.depthStencil = { 1.0f, 0u };
+
+	VkRenderingInfo renderingInfo{ VK_STRUCTURE_TYPE_RENDERING_INFO };
+	renderingInfo.renderArea = renderArea;
+	renderingInfo.layerCount = 1u;
+	renderingInfo.viewMask = m_StereoView->GetRenderTargetLayout().viewMask;
+	renderingInfo.colorAttachmentCount = 1u;
+	renderingInfo.pColorAttachments = &colorAttachmentInfo;
+	renderingInfo.pDepthAttachment = &depthAttachmentInfo;
+	vkCmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+void VulkanRenderer::DrawModels(VkDescriptorSet descriptorSet, const VkCommandBuffer& commandBuffer, EDrawPass drawPass, ERenderBucket renderBucket)
+{
+	const VulkanPipeline* boundPipeline{ nullptr };
+	const Material*		  boundMaterial{ nullptr };
+	VkDescriptorSet		  boundTextureDescriptorSet{ nullptr };
 	for (size_t modelIndex = 0u; modelIndex < m_GameObjects.size(); ++modelIndex)
 	{
 		const GameObject* gameObject = m_GameObjects.at(modelIndex);
-		const uint32_t	  uniformBufferOffset = static_cast<uint32_t>(utils::Align(static_cast<VkDeviceSize>(sizeof(VulkanRenderSystem::DynamicVertexUniformData)), m_Device->GetUniformBufferOffsetAlignment()) * static_cast<VkDeviceSize>(modelIndex));
+		if (gameObject->Material->renderBucket != renderBucket)
+		{
+			continue;
+		}
+
+		const bool		  usesDepthPrepass{ m_DepthPrepassMaterials.count(gameObject->Material) > 0u };
+		const bool		  isShadowPass{ drawPass == EDrawPass::StaticShadow || drawPass == EDrawPass::DynamicShadow };
+		if (drawPass == EDrawPass::DepthPrepass && !usesDepthPrepass)
+		{
+			continue;
+		}
+		if (isShadowPass && (!IsShadowCaster(gameObject) || gameObject->IsStatic != (drawPass == EDrawPass::StaticShadow)))
+		{
+			continue;
+		}
+
+		const uint32_t uniformBufferOffset = static_cast<uint32_t>(utils::Align(static_cast<VkDeviceSize>(sizeof(VulkanRenderSystem::DynamicVertexUniformData)), m_Device->GetUniformBufferOffsetAlignment()) * static_cast<VkDeviceSize>(modelIndex));
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0u, 1u, &descriptorSet, 1u, &uniformBufferOffset);
-		gameObject->Material->pipeline->Bind(commandBuffer);
+
+		const VulkanPipeline* pipeline{ gameObject->Material->pipeline };
+		if (isShadowPass)
+		{
+			pipeline = m_ShadowPipeline;
+		}
+		else if (drawPass == EDrawPass::DepthPrepass)
+		{
+			pipeline = gameObject->Material->depthPrepassPipeline;
+		}
+		else if (usesDepthPrepass)
+		{
+			pipeline = gameObject->Material->depthEqualPipeline;
+		}
+		else if (!pipeline || !pipeline->IsReady())
+		{
+			pipeline = m_FallbackPipeline;
+		}
+		if (pipeline != boundPipeline)
+		{
+			pipeline->Bind(commandBuffer);
+			boundPipeline = pipeline;
+			++m_FrameStatistics.pipelineBindCount;
+		}
+
+		// With extended dynamic state the material's raster and depth state is command buffer state, shadow passes set their own
+		if (m_Device->UsesDynamicRendering() && !isShadowPass && gameObject->Material != boundMaterial)
+		{
+			const Spectre::PipelineMaterialPayload pipelineData{ drawPass == EDrawPass::Color && usesDepthPrepass ? MakeDepthEqualPayload(gameObject->Material->pipelineData) : gameObject->Material->pipelineData };
+			vkCmdSetCullMode(commandBuffer, pipelineData.cullMode);
+			vkCmdSetDepthTestEnable(commandBuffer, pipelineData.depthTestEnable);
+			vkCmdSetDepthWriteEnable(commandBuffer, pipelineData.depthWriteEnable);
+			vkCmdSetDepthCompareOp(commandBuffer, pipelineData.depthCompareOp);
+			boundMaterial = gameObject->Material;
+		}
+
+		// Only the color pass samples textures, set 1 stays bound across the draws of other materials and of textures packed into the same atlas
+		const Material* material{ gameObject->Material };
+		if (drawPass == EDrawPass::Color && (material->albedoTexture || material->albedoRegion))
+		{
+			const VkDescriptorSet textureDescriptorSet{ material->albedoRegion ? m_TextureStreamer->GetDescriptorSet(material->albedoRegion->atlas) : m_TextureStreamer->GetDescriptorSet(material->albedoTexture, m_CurrentRenderProcessIndex) };
+			if (textureDescriptorSet != boundTextureDescriptorSet)
+			{
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material->albedoRegion ? m_AtlasPipelineLayout : m_PipelineLayout, 1u, 1u, &textureDescriptorSet, 0u, nullptr);
+				boundTextureDescriptorSet = textureDescriptorSet;
+			}
+		}
+
 		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(gameObject->Model->IndexCount), 1u, static_cast<uint32_t>(gameObject->Model->FirstIndex), 0u, 0u);
+		++m_FrameStatistics.drawCallCount;
 	}
 }
 
@@ -279,58 +1116,91 @@ void VulkanRenderer::UpdateUniformBuffers(VulkanRenderSystem* renderProcess, con
 	{
 		renderProcess->dynamicVertexUniformData.at(modelIndex).worldMatrix = m_GameObjects.at(modelIndex)->WorldMatrix;
 		renderProcess->dynamicVertexUniformData[modelIndex].colorMultiplier = m_GameObjects.at(modelIndex)->Material->dynamicUniformData.colorMultiplier;
+		renderProcess->dynamicVertexUniformData[modelIndex].uvTransform = m_GameObjects.at(modelIndex)->Material->dynamicUniformData.uvTransform;
+		renderProcess->dynamicVertexUniformData[modelIndex].textureLayer = m_GameObjects.at(modelIndex)->Material->dynamicUniformData.textureLayer;
 	}
 
-	for (size_t eyeIndex = 0u; eyeIndex < m_Headset->GetEyeCount(); ++eyeIndex)
+	for (size_t eyeIndex = 0u; eyeIndex < m_StereoView->GetEyeCount(); ++eyeIndex)
 	{
-		renderProcess->staticVertexUniformData.viewProjectionMatrices.at(eyeIndex) = m_Headset->GetEyeProjectionMatrix(eyeIndex) * m_Headset->GetEyeViewMatrix(eyeIndex) * cameraMatrix;
+		renderProcess->staticVertexUniformData.viewProjectionMatrices.at(eyeIndex) = m_StereoView->GetEyeProjectionMatrix(eyeIndex) * m_StereoView->GetEyeViewMatrix(eyeIndex) * cameraMatrix;
 	}
-}
 
-VulkanPipeline* VulkanRenderer::FindExistingPipeline(const std::string& vertShader, const std::string& fragShader, const Spectre::PipelineMaterialPayload& pipelineData)
-{
-	for (const auto& pipeline : m_Pipelines)
+	// The foveated eye regions are drawn with projections of their own, the eyes may have changed their field of view
+	if (IsFoveationEnabled())
 	{
-		if (pipeline->GetVertShaderName() == vertShader && pipeline->GetFragShaderName() == fragShader)
+		m_Foveation.Update(m_StereoView, m_FoveationLevel);
+		for (size_t regionIndex = 0u; regionIndex < Spectre::foveationRegionCount; ++regionIndex)
 		{
-			if (pipelineData == pipeline->GetPipelineMaterialData())
+			const Foveation::Region& region{ m_Foveation.GetRegion(static_cast<EFoveationRegion>(regionIndex)) };
+			for (size_t eyeIndex = 0u; eyeIndex < m_StereoView->GetEyeCount(); ++eyeIndex)
 			{
-				return pipeline;
+				renderProcess->foveatedVertexUniformData.at(regionIndex).viewProjectionMatrices.at(eyeIndex) = region.projectionMatrices.at(eyeIndex) * m_StereoView->GetEyeViewMatrix(eyeIndex) * cameraMatrix;
 			}
 		}
 	}
-	return nullptr;
 }
 
-void VulkanRenderer::Submit(bool useSemaphores) const
+void VulkanRenderer::UpdateClusterUniformData(VulkanRenderSystem* renderProcess, const glm::mat4& cameraMatrix, uint32_t lightCount) const
 {
-	const VulkanRenderSystem* renderProcess{ m_RenderProcesses.at(m_CurrentRenderProcessIndex) };
-	const VkCommandBuffer	  commandBuffer{ renderProcess->GetCommandBuffer() };
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	VulkanRenderSystem::ClusterUniformData& clusterData{ renderProcess->clusterUniformData };
+	for (size_t eyeIndex = 0u; eyeIndex < m_StereoView->GetEyeCount(); ++eyeIndex)
 	{
-		return;
+		clusterData.viewMatrices.at(eyeIndex) = m_StereoView->GetEyeViewMatrix(eyeIndex) * cameraMatrix;
+		clusterData.inverseProjectionMatrices.at(eyeIndex) = glm::inverse(m_StereoView->GetEyeProjectionMatrix(eyeIndex));
+		clusterData.projectionMatrices.at(eyeIndex) = m_StereoView->GetEyeProjectionMatrix(eyeIndex);
 	}
 
-	constexpr VkPipelineStageFlags waitStages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	const VkSemaphore			   drawableSemaphore{ renderProcess->GetDrawableSemaphore() };
-	const VkSemaphore			   presentableSemaphore{ renderProcess->GetPresentableSemaphore() };
-	const VkFence				   busyFence{ renderProcess->GetBusyFence() };
+	// Slice k starts at near * (far / near)^(k / sliceCount), the shaders invert this with a single log
+	const float sliceCount{ static_cast<float>(Spectre::clusterCountZ) };
+	const float logDepthRange{ std::log(Spectre::farClip / Spectre::nearClip) };
+	clusterData.gridSize = glm::uvec4(Spectre::clusterCountX, Spectre::clusterCountY, Spectre::clusterCountZ, lightCount);
+	clusterData.sliceParameters = glm::vec4(Spectre::nearClip, Spectre::farClip, sliceCount / logDepthRange, -sliceCount * std::log(Spectre::nearClip) / logDepthRange);
+
+	const VkExtent2D eyeResolution{ m_StereoView->GetEyeResolution(0u) };
+	const glm::vec2	 screenSize{ static_cast<float>(eyeResolution.width), static_cast<float>(eyeResolution.height) };
+	clusterData.screenSize = glm::vec4(screenSize, screenSize / glm::vec2(Spectre::clusterCountX, Spectre::clusterCountY));
+}
+
+void VulkanRenderer::Submit(bool useSemaphores)
+{
+	SPECTRE_PROFILE_ZONE("VulkanRenderer::Submit");
+
+	VulkanRenderSystem*	  renderProcess{ m_RenderProcesses.at(m_CurrentRenderProcessIndex) };
+	const VkCommandBuffer commandBuffer{ renderProcess->GetCommandBuffer() };
+
+	// Submitted ahead of the frame, so the frame sees every upload staged until now
+	m_UploadManager->Flush();
 
-	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-	submitInfo.pWaitDstStageMask = &waitStages;
-	submitInfo.commandBufferCount = 1u;
-	submitInfo.pCommandBuffers = &commandBuffer;
+	// Records every pass of the frame together with its barriers
+	m_FrameStatistics = {};
+	const auto recordingStartTime{ std::chrono::high_resolution_clock::now() };
+	m_RenderGraph->Execute(commandBuffer);
+	m_TextureStreamer->RecordFeedbackBarrier(commandBuffer);
+	m_FrameStatistics.recordingTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - recordingStartTime).count();
+	m_GpuProfiler->EndScope(commandBuffer);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		return;
+	}
 
+	// The mirror view blit is the only pass that touches the acquired window image, the eye pass is the first to read the cluster lights
+	std::vector<QueueTimeline::Wait> waits;
+	std::vector<VkSemaphore>		 signalSemaphores;
 	if (useSemaphores)
 	{
-		submitInfo.waitSemaphoreCount = 1u;
-		submitInfo.pWaitSemaphores = &drawableSemaphore;
-		submitInfo.signalSemaphoreCount = 1u;
-		submitInfo.pSignalSemaphores = &presentableSemaphore;
+		waits.push_back({ renderProcess->GetDrawableSemaphore(), 0u, VK_PIPELINE_STAGE_TRANSFER_BIT });
+		signalSemaphores.push_back(renderProcess->GetPresentableSemaphore());
+	}
+	if (m_ComputeWaitValue > 0u)
+	{
+		waits.push_back({ m_Device->GetComputeQueueTimeline()->GetSemaphore(), m_ComputeWaitValue, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT });
 	}
 
-	if (vkQueueSubmit(m_Device->GetVkDrawQueue(), 1u, &submitInfo, busyFence) != VK_SUCCESS)
+	const uint64_t submittedValue{ m_Device->GetDrawQueueTimeline()->Submit({ commandBuffer }, waits, signalSemaphores) };
+	if (submittedValue == 0u)
 	{
 		return;
 	}
+	renderProcess->SetSubmittedValue(submittedValue);
 }
\ No newline at end of file
@@ -2,56 +2,167 @@
 
 #include <glm/fwd.hpp>
 
+#include "../Light/LightSystem.h"
+#include "../Misc/JobSystem.h"
+#include "Foveation.h"
+#include "PipelineRegistry.h"
+#include "RenderGraph.h"
 #include "VulkanPipeline.h"
 #include "VulkanRenderSystem.h"
 #include <array>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <vulkan/vulkan.h>
 
 class VulkanDevice;
 class DataBuffer;
-class Headset;
+class StereoView;
 class MeshData;
+class PipelineCache;
+class ShaderModuleCache;
+class PipelineLibraryCache;
+class LightCulling;
+class AsyncComputeQueue;
+class GpuProfiler;
+class CascadedShadowMap;
+class RenderTarget;
+class UploadManager;
+class DescriptorAllocator;
+class TextureStreamer;
+class TextureBuffer;
 struct GameObject;
 struct Material;
+enum class ERenderBucket;
 // class VulkanPipeline;
 
 class VulkanRenderer final
 {
 public:
 	VulkanRenderer(){};
-	VulkanRenderer(const VulkanDevice* m_Device, const Headset* m_Headset, const MeshData* meshData, const std::vector<Material*>& materials, const std::vector<GameObject*>& gameObjects);
+	VulkanRenderer(const VulkanDevice* m_Device, const StereoView* m_StereoView, const MeshData* meshData, const std::vector<Material*>& materials, const std::vector<GameObject*>& gameObjects);
 	~VulkanRenderer();
 
-	void Render(const glm::mat4& cameraMatrix, size_t swapchainImageIndex, float time, glm::vec3 lightDirection);
-	void Submit(bool useSemaphores) const;
+	// Declares the passes of the frame, they are recorded on submission so other systems can add passes in between
+	void Render(const glm::mat4& cameraMatrix, size_t swapchainImageIndex, float time, glm::vec3 lightDirection, const std::vector<LightSystem::Light>& lights);
+	void Submit(bool useSemaphores);
+
+	// Registers a material at runtime, its pipeline compiles in the background
+	void AddMaterial(Material* material);
+	// Blocks until every scheduled pipeline has been compiled
+	void WaitForPipelines() const;
+
+	// Opaque materials lay down depth first so the color pass only shades the visible fragments
+	void SetDepthPrepassEnabled(bool isEnabled) { m_IsDepthPrepassEnabled = isEnabled; }
+	bool IsDepthPrepassEnabled() const { return m_IsDepthPrepassEnabled; }
+	// Fragment shader invocations of the frame that was read back during the last Render() call, if any
+	bool GetFragmentShaderInvocationCount(uint64_t& outCount) const;
+
+	// Light culling runs on the async compute queue when the device has one, otherwise it is part of the draw queue work
+	void SetAsyncComputeEnabled(bool isEnabled) { m_IsAsyncComputeEnabled = isEnabled; }
+	bool IsAsyncComputeEnabled() const { return m_AsyncComputeQueue && m_IsAsyncComputeEnabled; }
+
+	// The eye periphery is rendered at a reduced resolution and upscaled, only with dynamic rendering
+	void			SetFoveationLevel(EFoveationLevel level) { m_FoveationLevel = level; }
+	EFoveationLevel GetFoveationLevel() const { return m_FoveationLevel; }
+	bool			IsFoveationEnabled() const;
+
+	// Static shadow casters are cached, moving one requires the cache to be redrawn
+	void InvalidateStaticShadows();
+
+	// Counted while the passes of the last submitted frame were recorded
+	struct FrameStatistics
+	{
+		uint32_t drawCallCount{ 0u };
+		uint32_t pipelineBindCount{ 0u };
+		float	 recordingTime{ 0.0f }; // Milliseconds spent recording the passes on the CPU
+	};
+	const FrameStatistics& GetFrameStatistics() const { return m_FrameStatistics; }
+
+	RenderGraph*				GetRenderGraph() const { return m_RenderGraph; }
+	RenderGraph::ResourceHandle GetEyeImage() const { return m_EyeImage; }
+	// Uploads staged before Submit() are flushed ahead of the frame
+	UploadManager*				GetUploadManager() const { return m_UploadManager; }
 
 	VkCommandBuffer GetCurrentCommandBuffer() const { return m_RenderProcesses.at(m_CurrentRenderProcessIndex)->GetCommandBuffer(); }
 	VkSemaphore		GetCurrentDrawableSemaphore() const { return m_RenderProcesses.at(m_CurrentRenderProcessIndex)->GetDrawableSemaphore(); }
 	VkSemaphore		GetCurrentPresentableSemaphore() const { return m_RenderProcesses.at(m_CurrentRenderProcessIndex)->GetPresentableSemaphore(); }
 
 private:
+	enum class EDrawPass
+	{
+		StaticShadow,
+		DynamicShadow,
+		DepthPrepass,
+		Color
+	};
+
 	const VulkanDevice* m_Device{ nullptr };
-	const Headset*		m_Headset{ nullptr };
+	const StereoView*	m_StereoView{ nullptr };
 
 	size_t				  m_IndexOffset{ 0u };
 	size_t				  m_CurrentRenderProcessIndex{ 0u };
 	VkCommandPool		  m_CommandPool{ nullptr };
-	VkDescriptorPool	  m_DescriptorPool{ nullptr };
+	DescriptorAllocator*  m_DescriptorAllocator{ nullptr };
 	VkDescriptorSetLayout m_DescriptorSetLayout{ nullptr };
 
 	std::vector<VulkanRenderSystem*> m_RenderProcesses;
 	VkPipelineLayout				 m_PipelineLayout{ nullptr };
+	VkPipelineLayout				 m_AtlasPipelineLayout{ nullptr };
 	DataBuffer*						 m_VertexIndexBuffer{ nullptr };
-	std::vector<VulkanPipeline*>	 m_Pipelines;
+	UploadManager*					 m_UploadManager{ nullptr };
+	TextureStreamer*				 m_TextureStreamer{ nullptr };
+	PipelineCache*					 m_PipelineCache{ nullptr };
+	ShaderModuleCache*				 m_ShaderModuleCache{ nullptr };
+	PipelineLibraryCache*			 m_PipelineLibraryCache{ nullptr };
+	PipelineRegistry*				 m_PipelineRegistry{ nullptr };
+	VulkanPipeline*					 m_FallbackPipeline{ nullptr };
+	LightCulling*					 m_LightCulling{ nullptr };
+	CascadedShadowMap*				 m_CascadedShadowMap{ nullptr };
+	VulkanPipeline*					 m_ShadowPipeline{ nullptr };
+	GpuProfiler*					 m_GpuProfiler{ nullptr };
+	AsyncComputeQueue*				 m_AsyncComputeQueue{ nullptr };
+	RenderGraph*					 m_RenderGraph{ nullptr };
+	RenderGraph::ResourceHandle		 m_EyeImage{ 0u };
+
+	std::unordered_map<const VulkanPipeline*, std::shared_future<void>> m_PipelineJobs;
+	std::vector<VkVertexInputBindingDescription>   m_VertexInputBindingDescriptions;
+	std::vector<VkVertexInputAttributeDescription> m_VertexInputAttributeDescriptions;
+	std::vector<VkVertexInputAttributeDescription> m_DepthPrepassAttributeDescriptions;
+
+	bool								m_IsDepthPrepassEnabled{ false };
+	std::unordered_set<const Material*> m_DepthPrepassMaterials;
+
+	bool	 m_IsAsyncComputeEnabled{ true };
+	uint64_t m_ComputeWaitValue{ 0u }; // Timeline value of the async compute work the current frame waits on, zero if none
+
+	EFoveationLevel m_FoveationLevel{ EFoveationLevel::Off };
+	Foveation		m_Foveation;
+
+	FrameStatistics m_FrameStatistics;
 
 	std::vector<GameObject*> m_GameObjects;
 	std::vector<Material*>	 m_Materials;
 
 	void			CreateDescriptors(const VkDevice& vkDevice);
 	void			CreatePipelines(const VkDevice& vkDevice, const VulkanDevice* device, const std::vector<Material*>& materials);
+	void			AcquireTextures(Material* material);
+	bool			IsMaterialVisible(const Material* material) const;
 	void			CreateVertexIndexBuffer(const MeshData* meshData, const VulkanDevice* m_Device);
-	void			DrawModels(VulkanRenderSystem* renderProcess, const VkCommandBuffer& commandBuffer);
+	void			DeclareRenderPasses(VulkanRenderSystem* renderProcess, size_t swapchainImageIndex);
+	void			DeclareFoveatedPasses(VulkanRenderSystem* renderProcess, RenderGraph::ResourceHandle clusterLights, RenderGraph::ResourceHandle shadowMap);
+	void			RecordEyePass(VulkanRenderSystem* renderProcess, VkCommandBuffer commandBuffer, RenderTarget* renderTarget, VkImageView colorImageView, VkImageView depthImageView);
+	void			RecordFoveatedPass(VkDescriptorSet descriptorSet, VkCommandBuffer commandBuffer, EFoveationRegion region, VkImageView targetImageView, VkImageView colorImageView, VkImageView depthImageView);
+	void			RecordEyeDraws(VkDescriptorSet descriptorSet, VkCommandBuffer commandBuffer, const VkRect2D& renderArea);
+	// The target is resolved into when multisampled and drawn into directly otherwise
+	void			BeginDynamicRendering(const VkCommandBuffer& commandBuffer, VkImageView targetImageView, VkImageView colorImageView, VkImageView depthImageView, const VkRect2D& renderArea) const;
+	void			DrawModels(VkDescriptorSet descriptorSet, const VkCommandBuffer& commandBuffer, EDrawPass drawPass, ERenderBucket renderBucket);
+	void			UpdateDepthPrepassMaterials();
 	void			UpdateUniformBuffers(VulkanRenderSystem* renderProcess, const glm::mat4& cameraMatrix);
-	VulkanPipeline* FindExistingPipeline(const std::string& vertShader, const std::string& fragShader, const Spectre::PipelineMaterialPayload& pipelineData);
+	void			UpdateClusterUniformData(VulkanRenderSystem* renderProcess, const glm::mat4& cameraMatrix, uint32_t lightCount) const;
+
+	PipelineRegistry::PipelineKey MakePipelineKey(const std::string& vertShaderName, const std::string& fragShaderName, const Spectre::PipelineMaterialPayload& materialPayload) const;
+	std::shared_future<void>	  SchedulePipeline(Material* material, EJobPriority priority);
+	std::shared_future<void>	  SchedulePipeline(const PipelineRegistry::PipelineKey& key, EJobPriority priority, VulkanPipeline*& outPipeline);
 };
\ No newline at end of file
@@ -1,8 +1,8 @@
 #include "VulkanWindow.h"
 
+#include "../Misc/CpuProfiler.h"
 #include "../Misc/Utils.h"
 #include "../VR/Headset.h"
-#include "../VulkanBase/RenderTarget.h"
 #include "../VulkanBase/VulkanDevice.h"
 #include "VulkanRenderer.h"
 
@@ -107,7 +107,7 @@ bool VulkanWindow::Connect(const Headset* headset, const VulkanRenderer* rendere
 	return true;
 }
 
-VulkanWindow::RenderResult VulkanWindow::Render(uint32_t swapchainImageIndex)
+VulkanWindow::RenderResult VulkanWindow::Render()
 {
 	if (m_SwapchainResolution.width == 0u || m_SwapchainResolution.height == 0u)
 	{
@@ -144,37 +144,10 @@ VulkanWindow::RenderResult VulkanWindow::Render(uint32_t swapchainImageIndex)
 		return RenderResult::Invisible;
 	}
 
-	const VkCommandBuffer commandBuffer{ m_Renderer->GetCurrentCommandBuffer() };
-	const VkImage		  sourceImage{ m_Headset->GetRenderTarget(swapchainImageIndex)->GetImage() };
-	const VkImage		  destinationImage{ m_SwapchainImages.at(m_DestinationImageIndex) };
-	const VkExtent2D	  eyeResolution{ m_Headset->GetEyeResolution(Spectre::mirrorEyeIndex) };
-
-	// Convert the source image layout from undefined to transfer source
-	VkImageMemoryBarrier imageMemoryBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-	imageMemoryBarrier.image = sourceImage;
-	imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	imageMemoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imageMemoryBarrier.subresourceRange.layerCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseArrayLayer = Spectre::mirrorEyeIndex;
-	imageMemoryBarrier.subresourceRange.levelCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseMipLevel = 0u;
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
-
-	// Convert the destination image layout from undefined to transfer destination
-	imageMemoryBarrier.image = destinationImage;
-	imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	imageMemoryBarrier.srcAccessMask = 0u;
-	imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imageMemoryBarrier.subresourceRange.layerCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseArrayLayer = 0u;
-	imageMemoryBarrier.subresourceRange.levelCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseMipLevel = 0u;
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
+	RenderGraph*					  renderGraph{ m_Renderer->GetRenderGraph() };
+	const RenderGraph::ResourceHandle sourceImage{ m_Renderer->GetEyeImage() };
+	const RenderGraph::ResourceHandle destinationImage{ renderGraph->ImportImage("Mirror view swapchain image", m_SwapchainImages.at(m_DestinationImageIndex), VK_IMAGE_ASPECT_COLOR_BIT, false, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) };
+	const VkExtent2D				  eyeResolution{ m_Headset->GetEyeResolution(Spectre::mirrorEyeIndex) };
 
 	// We need to crop the source image region to preserve the aspect ratio of the mirror view window
 	const glm::vec2 sourceResolution{ static_cast<float>(eyeResolution.width), static_cast<float>(eyeResolution.height) };
@@ -194,7 +167,6 @@ VulkanWindow::RenderResult VulkanWindow::Render(uint32_t swapchainImageIndex)
 		cropOffset.x = (sourceResolution.x - cropResolution.x) / 2.0f;
 	}
 
-	// Blit the source to the destination image
 	VkImageBlit imageBlit{};
 	imageBlit.srcOffsets[0] = { static_cast<int32_t>(cropOffset.x), static_cast<int32_t>(cropOffset.y), 0 };
 	imageBlit.srcOffsets[1] = { static_cast<int32_t>(cropOffset.x + cropResolution.x), static_cast<int32_t>(cropOffset.y + cropResolution.y), 1 };
@@ -209,39 +181,20 @@ VulkanWindow::RenderResult VulkanWindow::Render(uint32_t swapchainImageIndex)
 	imageBlit.dstSubresource.layerCount = 1u;
 	imageBlit.dstSubresource.baseArrayLayer = 0u;
 	imageBlit.dstSubresource.mipLevel = 0u;
-	vkCmdBlitImage(commandBuffer, sourceImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destinationImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &imageBlit, VK_FILTER_NEAREST);
-
-	// Convert the source image layout from transfer source to color attachment
-	imageMemoryBarrier.image = sourceImage;
-	imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	imageMemoryBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imageMemoryBarrier.subresourceRange.layerCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseArrayLayer = Spectre::mirrorEyeIndex;
-	imageMemoryBarrier.subresourceRange.levelCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseMipLevel = 0u;
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
-
-	// Convert the destination image layout from transfer destination to present
-	imageMemoryBarrier.image = destinationImage;
-	imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-	imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	imageMemoryBarrier.dstAccessMask = 0u;
-	imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imageMemoryBarrier.subresourceRange.layerCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseArrayLayer = 0u;
-	imageMemoryBarrier.subresourceRange.levelCount = 1u;
-	imageMemoryBarrier.subresourceRange.baseMipLevel = 0u;
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0u, nullptr, 0u, nullptr, 1u, &imageMemoryBarrier);
+
+	// Blit the source to the destination image, the render graph transitions both and hands the eye image back to OpenXR afterwards
+	renderGraph->AddPass("Mirror view")
+	  .Read(sourceImage, RenderGraph::EResourceUsage::TransferSource)
+	  .Write(destinationImage, RenderGraph::EResourceUsage::TransferDestination)
+	  .SetExecute([renderGraph, sourceImage, destinationImage, imageBlit](VkCommandBuffer commandBuffer) { vkCmdBlitImage(commandBuffer, renderGraph->GetImage(sourceImage), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, renderGraph->GetImage(destinationImage), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &imageBlit, VK_FILTER_NEAREST); });
 
 	return RenderResult::Visible;
 }
 
 void VulkanWindow::Present()
 {
+	SPECTRE_PROFILE_ZONE("VulkanWindow::Present");
+
 	const VkSemaphore presentableSemaphore{ m_Renderer->GetCurrentPresentableSemaphore() };
 
 	VkPresentInfoKHR presentInfo{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
@@ -285,6 +238,10 @@ bool VulkanWindow::RecreateSwapchain()
 	// Clean up before recreating the swapchain and render targets
 	if (m_Swapchain)
 	{
+		for (const VkImage image : m_SwapchainImages)
+		{
+			m_Renderer->GetRenderGraph()->ForgetImage(image);
+		}
 		vkDestroySwapchainKHR(vkDevice, m_Swapchain, nullptr);
 	}
 
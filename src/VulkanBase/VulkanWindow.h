@@ -32,7 +32,8 @@ public:
 	void OnWindowResize();
 	bool Connect(const Headset* headset, const VulkanRenderer* renderer);
 
-	RenderResult Render(uint32_t swapchainImageIndex);
+	// Adds the blit of the mirrored eye to the render graph of the frame
+	RenderResult Render();
 	void		 Present();
 
 	void		 ProcessWindowEvents() const { glfwPollEvents(); }
@@ -0,0 +1,22 @@
+#extension GL_EXT_multiview : enable
+
+layout(binding = 0) uniform World
+{
+    mat4 matrix;
+    vec4 colorMultiplier;
+} world;
+
+layout(binding = 1) uniform ViewProjection
+{
+    mat4 matrices[2];
+} viewProjection;
+
+layout(location = 0) in vec3 inPosition;
+
+// The color pass tests against this depth with EQUAL, so every opaque vertex shader must compute the position identically
+invariant gl_Position;
+
+void main()
+{
+  gl_Position = viewProjection.matrices[gl_ViewIndex] * (world.matrix * vec4(inPosition, 1.0));
+}
\ No newline at end of file
@@ -1,3 +1,8 @@
+#extension GL_EXT_multiview : enable
+
+#include "Lighting.glsl"
+#include "Shadows.glsl"
+
 layout(binding = 2) uniform Ubo { 
 	float time; 
 	float x; 
@@ -8,13 +13,18 @@ layout(binding = 2) uniform Ubo {
 
 layout(location = 0) in vec3 normal;
 layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 position; // In world space
 
 layout(location = 0) out vec4 outColor;
 
 void main()
 {
-  const float diffuse = clamp(dot(normal, -vec3(ubo.x, ubo.y, ubo.z)), 0.0, 1.0);
+  const uint eyeIndex = uint(gl_ViewIndex);
+  const float viewDepth = -(clusters.viewMatrices[eyeIndex] * vec4(position, 1.0)).z;
+  const float shadow = EvaluateSunShadow(position, normalize(normal), viewDepth);
+  const float diffuse = clamp(dot(normal, -vec3(ubo.x, ubo.y, ubo.z)), 0.0, 1.0) * shadow;
 
   const vec3 ambient = vec3(0.07, 0.05, 0.1);
-  outColor = vec4(ambient + color * diffuse, 1.0);
+  const vec3 localLights = EvaluateClusteredLights(position, normalize(normal), color, eyeIndex);
+  outColor = vec4(ambient + color * diffuse + localLights, 1.0);
 }
\ No newline at end of file
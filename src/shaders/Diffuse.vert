@@ -17,10 +17,16 @@ layout(location = 2) in vec3 inColor;
 
 layout(location = 0) out vec3 normal; // In world space
 layout(location = 1) out vec3 color;
+layout(location = 2) out vec3 position; // In world space
+
+// Must match the depth prepass exactly
+invariant gl_Position;
 
 void main()
 {
-  gl_Position = viewProjection.matrices[gl_ViewIndex] * world.matrix * vec4(inPosition, 1.0);
+  const vec4 worldPosition = world.matrix * vec4(inPosition, 1.0);
+  gl_Position = viewProjection.matrices[gl_ViewIndex] * worldPosition;
+  position = worldPosition.xyz;
 
   normal = normalize(vec3(world.matrix * vec4(inNormal, 0.0)));
   color = inColor * world.colorMultiplier.xyz;
@@ -1,3 +1,7 @@
+#extension GL_EXT_multiview : enable
+
+#include "Lighting.glsl"
+
 layout(binding = 2) uniform Ubo { 
 	float time; 
 	float x; 
@@ -8,6 +12,7 @@ layout(binding = 2) uniform Ubo {
 
 layout(location = 0) in vec3 normal;
 layout(location = 1) in vec4 color;
+layout(location = 2) in vec3 position; // In world space
 
 layout(location = 0) out vec4 outColor;
 
@@ -17,5 +22,7 @@ void main()
 
   const vec3 ambient = vec3(0.07, 0.05, 0.1);
 
-  outColor = vec4(ambient + color.xyz * diffuse, color.w);
+  const vec3 localLights = EvaluateClusteredLights(position, normalize(normal), color.xyz, uint(gl_ViewIndex));
+
+  outColor = vec4(ambient + color.xyz * diffuse + localLights, color.w);
 }
\ No newline at end of file
@@ -17,6 +17,9 @@ layout(location = 2) in vec3 inColor;
 layout(location = 0) out vec3 position; // In world space
 layout(location = 1) out vec3 color;
 
+// Must match the depth prepass exactly
+invariant gl_Position;
+
 void main()
 {
   vec4 pos = world.matrix * vec4(inPosition, 1.0);
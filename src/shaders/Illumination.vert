@@ -18,9 +18,12 @@ layout(location = 2) in vec3 inColor;
 layout(location = 0) out vec3 normal; // In world space
 layout(location = 1) out vec4 color;
 
+// Must match the depth prepass exactly
+invariant gl_Position;
+
 void main()
 {
-  gl_Position = viewProjection.matrices[gl_ViewIndex] * world.matrix * vec4(inPosition, 1.0);
+  gl_Position = viewProjection.matrices[gl_ViewIndex] * (world.matrix * vec4(inPosition, 1.0));
 
   normal = normalize(vec3(world.matrix * vec4(inNormal, 0.0)));
   color.xyz = inColor * world.colorMultiplier.xyz;
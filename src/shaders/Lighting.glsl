@@ -0,0 +1,91 @@
+// Clustered forward lighting shared by the light culling pass and the lit fragment shaders.
+// The grid layout must match Spectre::clusterCountX/Y/Z and Spectre::maxLightsPerCluster in LightCulling.h
+
+#define MAX_LIGHTS_PER_CLUSTER 63u
+#define CLUSTER_STRIDE (MAX_LIGHTS_PER_CLUSTER + 1u)
+
+struct Light
+{
+  vec4 positionRange;  // xyz = world position, w = distance at which the light fades out
+  vec4 colorIntensity; // rgb = color, a = intensity
+  vec4 direction;      // xyz = spot direction, w = 1 for spot lights and 0 for point lights
+  vec4 spotCosines;    // x = cosine of the inner cone, y = cosine of the outer cone
+};
+
+layout(std430, binding = 3) readonly buffer Lights
+{
+  Light lights[];
+};
+
+// Every cluster holds its light count followed by the indices of the lights that reach into it
+#ifdef LIGHT_CULLING
+layout(std430, binding = 4) writeonly buffer ClusterLights
+#else
+layout(std430, binding = 4) readonly buffer ClusterLights
+#endif
+{
+  uint clusterLights[];
+};
+
+layout(binding = 5) uniform Clusters
+{
+  mat4 viewMatrices[2];
+  mat4 inverseProjectionMatrices[2];
+  mat4 projectionMatrices[2]; // Of the whole eye image, also for the foveated eye regions
+  uvec4 gridSize;             // xyz = clusters per eye along each axis, w = light count
+  vec4 sliceParameters;       // x = near clip, y = far clip, z = slice scale, w = slice bias
+  vec4 screenSize;            // xy = eye resolution in pixels, zw = cluster size in pixels
+} clusters;
+
+uint GetClusterIndex(uvec3 cluster, uint eyeIndex)
+{
+  return ((eyeIndex * clusters.gridSize.z + cluster.z) * clusters.gridSize.y + cluster.y) * clusters.gridSize.x + cluster.x;
+}
+
+#ifndef LIGHT_CULLING
+// Depth slices are spaced exponentially so clusters stay roughly cubic along the whole frustum
+// The tile is found from the position on the whole eye image, the foveated eye regions are drawn with viewports of their own
+uint GetFragmentClusterIndex(vec3 worldPosition, uint eyeIndex)
+{
+  const vec4 viewPosition = clusters.viewMatrices[eyeIndex] * vec4(worldPosition, 1.0);
+  const float viewDepth = -viewPosition.z;
+  const uint slice = uint(clamp(log(max(viewDepth, clusters.sliceParameters.x)) * clusters.sliceParameters.z + clusters.sliceParameters.w, 0.0, float(clusters.gridSize.z - 1u)));
+  const vec4 clipPosition = clusters.projectionMatrices[eyeIndex] * viewPosition;
+  const vec2 pixel = (clipPosition.xy / clipPosition.w * 0.5 + 0.5) * clusters.screenSize.xy;
+  const uvec2 tile = uvec2(clamp(pixel / clusters.screenSize.zw, vec2(0.0), vec2(clusters.gridSize.xy - 1u)));
+  return GetClusterIndex(uvec3(tile, slice), eyeIndex);
+}
+
+// Only the lights of the fragment's own cluster are evaluated
+vec3 EvaluateClusteredLights(vec3 worldPosition, vec3 normal, vec3 albedo, uint eyeIndex)
+{
+  const uint clusterOffset = GetFragmentClusterIndex(worldPosition, eyeIndex) * CLUSTER_STRIDE;
+  const uint lightCount = clusterLights[clusterOffset];
+
+  vec3 result = vec3(0.0);
+  for (uint i = 0u; i < lightCount; ++i)
+  {
+    const Light light = lights[clusterLights[clusterOffset + 1u + i]];
+
+    const vec3 toLight = light.positionRange.xyz - worldPosition;
+    const float lightDistance = length(toLight);
+    if (lightDistance >= light.positionRange.w)
+    {
+      continue;
+    }
+
+    const vec3 lightDirection = toLight / lightDistance;
+    const float rangeFalloff = clamp(1.0 - pow(lightDistance / light.positionRange.w, 4.0), 0.0, 1.0);
+    float attenuation = rangeFalloff * rangeFalloff / (lightDistance * lightDistance + 1.0);
+    if (light.direction.w > 0.0)
+    {
+      attenuation *= smoothstep(light.spotCosines.y, light.spotCosines.x, dot(-lightDirection, light.direction.xyz));
+    }
+
+    const float diffuse = max(dot(normal, lightDirection), 0.0);
+    result += albedo * light.colorIntensity.rgb * light.colorIntensity.a * diffuse * attenuation;
+  }
+
+  return result;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#extension GL_EXT_multiview : enable
+
+#define SHADOW_CASTER
+#include "Shadows.glsl"
+
+layout(binding = 0) uniform World
+{
+    mat4 matrix;
+    vec4 colorMultiplier;
+} world;
+
+layout(location = 0) in vec3 inPosition;
+
+// Every view renders one cascade
+void main()
+{
+  gl_Position = shadows.cascadeMatrices[gl_ViewIndex] * (world.matrix * vec4(inPosition, 1.0));
+}
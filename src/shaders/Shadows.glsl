@@ -0,0 +1,48 @@
+// Cascaded shadow maps of the sun, shared by the shadow caster and the lit fragment shaders.
+// The cascade count must match Spectre::shadowCascadeCount in CascadedShadowMap.h
+
+#define SHADOW_CASCADE_COUNT 4
+
+layout(binding = 6) uniform Shadows
+{
+  mat4 cascadeMatrices[SHADOW_CASCADE_COUNT]; // World to shadow clip space
+  vec4 cascadeSplits;                         // Far view depth of each cascade
+  vec4 cascadeTexelSizes;                     // World space offset along the normal
+  vec4 cascadeDepthBiases;                    // In shadow depth units
+  vec4 parameters;                            // x = texel size in texture space
+} shadows;
+
+#ifndef SHADOW_CASTER
+layout(binding = 7) uniform sampler2DArrayShadow shadowMap;
+
+// Returns 0 for fully shadowed and 1 for fully lit fragments
+float EvaluateSunShadow(vec3 worldPosition, vec3 normal, float viewDepth)
+{
+  int cascade = 0;
+  while (cascade < SHADOW_CASCADE_COUNT && viewDepth > shadows.cascadeSplits[cascade])
+  {
+    ++cascade;
+  }
+
+  if (cascade == SHADOW_CASCADE_COUNT)
+  {
+    return 1.0;
+  }
+
+  // Offsetting along the normal removes most of the acne on surfaces at grazing angles to the sun
+  const vec4 shadowPosition = shadows.cascadeMatrices[cascade] * vec4(worldPosition + normal * shadows.cascadeTexelSizes[cascade], 1.0);
+  const vec2 uv = shadowPosition.xy * 0.5 + 0.5;
+  const float depth = shadowPosition.z - shadows.cascadeDepthBiases[cascade];
+
+  // 3x3 taps, each of which is already a bilinear 2x2 comparison
+  float lit = 0.0;
+  for (int y = -1; y <= 1; ++y)
+  {
+    for (int x = -1; x <= 1; ++x)
+    {
+      lit += texture(shadowMap, vec4(uv + vec2(x, y) * shadows.parameters.x, float(cascade), depth));
+    }
+  }
+  return lit / 9.0;
+}
+#endif
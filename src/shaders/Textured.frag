@@ -0,0 +1,55 @@
+#extension GL_EXT_multiview : enable
+
+#include "Lighting.glsl"
+#include "Shadows.glsl"
+
+// The feedback writes would otherwise force late depth tests and report texels hidden behind other geometry
+layout(early_fragment_tests) in;
+
+layout(binding = 2) uniform Ubo { 
+	float time; 
+	float x; 
+	float y; 
+	float z; 
+} ubo;
+
+layout(set = 1, binding = 0) uniform sampler2D albedoTexture;
+
+// Most detailed level of detail sampled this frame, reset to all ones by the texture streamer before every frame
+layout(set = 1, binding = 1) buffer Feedback
+{
+	uint mipLevel;
+} feedback;
+
+// Must match Spectre::textureFeedbackLodBias, levels more detailed than the resident ones come out negative
+const float feedbackLodBias = 16.0;
+// Only one fragment of every block of this many pixels squared reports, the atomics would serialize otherwise
+const uint feedbackInterval = 8;
+
+layout(location = 0) in vec3 normal;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 position; // In world space
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+  // Derivatives are only defined in uniform control flow, so the level of detail is queried before the branch
+  const float lod = textureQueryLod(albedoTexture, uv).y;
+  const uvec2 pixel = uvec2(gl_FragCoord.xy);
+  if (pixel.x % feedbackInterval == 0 && pixel.y % feedbackInterval == 0)
+  {
+    atomicMin(feedback.mipLevel, uint(clamp(lod + feedbackLodBias, 0.0, 32.0)));
+  }
+
+  const uint eyeIndex = uint(gl_ViewIndex);
+  const float viewDepth = -(clusters.viewMatrices[eyeIndex] * vec4(position, 1.0)).z;
+  const float shadow = EvaluateSunShadow(position, normalize(normal), viewDepth);
+  const float diffuse = clamp(dot(normal, -vec3(ubo.x, ubo.y, ubo.z)), 0.0, 1.0) * shadow;
+
+  const vec3 albedo = texture(albedoTexture, uv).rgb * color;
+  const vec3 ambient = vec3(0.07, 0.05, 0.1);
+  const vec3 localLights = EvaluateClusteredLights(position, normalize(normal), albedo, eyeIndex);
+  outColor = vec4(ambient * albedo + albedo * diffuse + localLights, 1.0);
+}
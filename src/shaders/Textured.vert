@@ -0,0 +1,36 @@
+#extension GL_EXT_multiview : enable
+
+layout(binding = 0) uniform World
+{
+    mat4 matrix;
+    vec4 colorMultiplier;
+} world;
+
+layout(binding = 1) uniform ViewProjection
+{
+    mat4 matrices[2];
+} viewProjection;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inColor;
+layout(location = 3) in vec2 inUv;
+
+layout(location = 0) out vec3 normal; // In world space
+layout(location = 1) out vec3 color;
+layout(location = 2) out vec3 position; // In world space
+layout(location = 3) out vec2 uv;
+
+// Must match the depth prepass exactly
+invariant gl_Position;
+
+void main()
+{
+  const vec4 worldPosition = world.matrix * vec4(inPosition, 1.0);
+  gl_Position = viewProjection.matrices[gl_ViewIndex] * worldPosition;
+  position = worldPosition.xyz;
+
+  normal = normalize(vec3(world.matrix * vec4(inNormal, 0.0)));
+  color = inColor * world.colorMultiplier.xyz;
+  uv = inUv;
+}
@@ -0,0 +1,39 @@
+#extension GL_EXT_multiview : enable
+
+#include "Lighting.glsl"
+#include "Shadows.glsl"
+
+layout(binding = 2) uniform Ubo { 
+	float time; 
+	float x; 
+	float y; 
+	float z; 
+} ubo;
+
+// Shared by every texture of the format, binding 1 is never written
+layout(set = 1, binding = 0) uniform sampler2DArray atlasTexture;
+
+layout(location = 0) in vec3 normal;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 position; // In world space
+layout(location = 3) in vec2 uv; // Of the texture, not of the atlas
+layout(location = 4) flat in vec4 uvTransform;
+layout(location = 5) flat in uint textureLayer;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+  // Packed textures don't repeat, the gutter around them only covers filtering across their edge
+  const vec2 atlasUv = uvTransform.zw + clamp(uv, 0.0, 1.0) * uvTransform.xy;
+
+  const uint eyeIndex = uint(gl_ViewIndex);
+  const float viewDepth = -(clusters.viewMatrices[eyeIndex] * vec4(position, 1.0)).z;
+  const float shadow = EvaluateSunShadow(position, normalize(normal), viewDepth);
+  const float diffuse = clamp(dot(normal, -vec3(ubo.x, ubo.y, ubo.z)), 0.0, 1.0) * shadow;
+
+  const vec3 albedo = texture(atlasTexture, vec3(atlasUv, textureLayer)).rgb * color;
+  const vec3 ambient = vec3(0.07, 0.05, 0.1);
+  const vec3 localLights = EvaluateClusteredLights(position, normalize(normal), albedo, eyeIndex);
+  outColor = vec4(ambient * albedo + albedo * diffuse + localLights, 1.0);
+}
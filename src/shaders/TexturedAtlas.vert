@@ -0,0 +1,42 @@
+#extension GL_EXT_multiview : enable
+
+layout(binding = 0) uniform World
+{
+    mat4 matrix;
+    vec4 colorMultiplier;
+    vec4 uvTransform; // Scale in xy, offset in zw, places the texture in its atlas layer
+    uint textureLayer;
+} world;
+
+layout(binding = 1) uniform ViewProjection
+{
+    mat4 matrices[2];
+} viewProjection;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inColor;
+layout(location = 3) in vec2 inUv;
+
+layout(location = 0) out vec3 normal; // In world space
+layout(location = 1) out vec3 color;
+layout(location = 2) out vec3 position; // In world space
+layout(location = 3) out vec2 uv; // Of the texture, not of the atlas
+layout(location = 4) flat out vec4 uvTransform;
+layout(location = 5) flat out uint textureLayer;
+
+// Must match the depth prepass exactly
+invariant gl_Position;
+
+void main()
+{
+  const vec4 worldPosition = world.matrix * vec4(inPosition, 1.0);
+  gl_Position = viewProjection.matrices[gl_ViewIndex] * worldPosition;
+  position = worldPosition.xyz;
+
+  normal = normalize(vec3(world.matrix * vec4(inNormal, 0.0)));
+  color = inColor * world.colorMultiplier.xyz;
+  uv = inUv;
+  uvTransform = world.uvTransform;
+  textureLayer = world.textureLayer;
+}